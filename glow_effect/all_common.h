@@ -61,7 +61,4 @@ typedef unsigned int    uint;
 
 // Global Variables
 extern int mipmap_level;
-extern int param_KeyLevel;
-extern int param_KeyScale;
-extern int default_scale;
 extern int button_id;
\ No newline at end of file
@@ -9,6 +9,26 @@
 #include <torch/torch.h>
 #include "source/imageprocessingutil.hpp"
 #include "source/trtinference.hpp"
+#include "source/VideoPipeline.hpp"
+#include "source/AdaptiveBatcher.hpp"
+#include "source/MaskPropagation.hpp"
+#include "source/SceneDetector.hpp"
+#include "source/MipmapCPU.hpp"
+#include "source/MaskStore.hpp"
+#include "source/GlowCache.hpp"
+#include "source/RenderWorker.hpp"
+#include "source/GlowParamBlock.hpp"
+#include "source/GlowClasses.hpp"
+#include "source/VideoEncoder.hpp"
+#include "source/FrameDecoder.hpp"
+#include "source/RawVideoSink.hpp"
+#include "source/SegmentRender.hpp"
+#include "source/BatchJobs.hpp"
+#include "source/Profiler.hpp"
+#include "source/LatencyHistogram.hpp"
+#include "source/KernelBench.hpp"
+#include "source/PipelineBench.hpp"
+#include "source/GoldenImages.hpp"
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <vector>
@@ -17,6 +37,9 @@
 #include <filesystem>
 #include <thread>
 #include <mutex>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
 
  // Forward declaration for the GUI control thread function.
 void set_control(void);
@@ -26,21 +49,68 @@ cv::Mat         current_original_img;
 cv::Mat         current_grayscale_mask;
 std::string     current_image_path;
 
+// Newest render of the image modes, waiting for the main thread to show it.
+cv::Mat         rendered_image;
+bool            rendered_image_new = false;
+
 // Mutex for protecting state updates.
 std::mutex state_mutex;
 
 /**
- * @brief Applies the glow effect to the current image using the loaded grayscale mask.
+ * @brief Render thread of the image modes; renders the current image with the newest parameters
+ *        and hands the result to show_rendered_image.
  */
-void updateImage() {
-	try {
-		if (!current_original_img.empty() && !current_grayscale_mask.empty()) {
-			glow_effect_image(current_image_path.c_str(), current_grayscale_mask);
+static RenderWorker& image_render_worker() {
+	static RenderWorker worker([](const GlowParams& params, const GlowCancelFn& cancelled) {
+		std::string image_path;
+		cv::Mat mask;
+		{
+			std::lock_guard<std::mutex> lock(state_mutex);
+			if (current_original_img.empty() || current_grayscale_mask.empty())
+				return true;
+			image_path = current_image_path;
+			mask = current_grayscale_mask;
+		}
+		cv::Mat result;
+		if (!glow_effect_image(image_path.c_str(), mask, params, result, cancelled))
+			return false;
+		std::lock_guard<std::mutex> lock(state_mutex);
+		rendered_image = result;
+		rendered_image_new = true;
+		return true;
+	});
+	return worker;
+}
+
+/**
+ * @brief Shows the newest render of the image modes, if there is one, and services the window.
+ *
+ * HighGUI is not thread-safe, so imshow and waitKey both stay on the main thread.
+ *
+ * @param delay_ms Wait for a key, as cv::waitKey.
+ * @return The key pressed, or -1.
+ */
+static int show_rendered_image(int delay_ms) {
+	cv::Mat image;
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		if (rendered_image_new) {
+			image = rendered_image;
+			rendered_image_new = false;
 		}
 	}
-	catch (const std::exception& e) {
-		std::cerr << "Error updating image: " << e.what() << std::endl;
-	}
+	if (!image.empty())
+		cv::imshow("Final Result", image);
+	return cv::waitKey(delay_ms);
+}
+
+/**
+ * @brief Queues the glow effect of the current image with the current parameters.
+ *
+ * Returns at once; the render worker coalesces queued updates and draws only the newest.
+ */
+void updateImage() {
+	image_render_worker().submit(glow_params.snapshot().glow);
 }
 
 /**
@@ -51,9 +121,8 @@ void updateImage() {
  * @param newValue The new key level value.
  */
 void bar_key_level_cb(int newValue) {
-	std::lock_guard<std::mutex> lock(state_mutex);
-	param_KeyLevel = newValue;
-	std::cout << "Key Level updated to: " << param_KeyLevel << std::endl;
+	glow_params.set_key_level(newValue);
+	std::cout << "Key Level updated to: " << newValue << std::endl;
 	updateImage();
 }
 
@@ -65,9 +134,8 @@ void bar_key_level_cb(int newValue) {
  * @param newValue The new key scale value.
  */
 void bar_key_scale_cb(int newValue) {
-	std::lock_guard<std::mutex> lock(state_mutex);
-	param_KeyScale = newValue;
-	std::cout << "Key Scale updated to: " << param_KeyScale << std::endl;
+	glow_params.set_key_scale(newValue);
+	std::cout << "Key Scale updated to: " << newValue << std::endl;
 	updateImage();
 }
 
@@ -79,9 +147,8 @@ void bar_key_scale_cb(int newValue) {
  * @param newValue The new default scale value.
  */
 void bar_default_scale_cb(int newValue) {
-	std::lock_guard<std::mutex> lock(state_mutex);
-	default_scale = newValue;
-	std::cout << "Default Scale updated to: " << default_scale << std::endl;
+	glow_params.set_scale(newValue);
+	std::cout << "Default Scale updated to: " << newValue << std::endl;
 	updateImage();
 }
 
@@ -89,12 +156,54 @@ void bar_default_scale_cb(int newValue) {
  * @brief Main entry point for the glow effect application.
  *
  * Processes a single image, an image directory, or a video file, and applies
- * the glow effect using CUDA, TensorRT, and OpenCV.
+ * the glow effect using CUDA, TensorRT, and OpenCV. Started with --segment-worker (by the
+ * parallel mode), it renders one segment of a video headless and exits.
  *
  * @return int Exit status.
  */
-int main() {
+int main(int argc, char** argv) {
 	try {
+		// GLOW_PROFILE=<trace.json> profiles the run: stage table at exit, Chrome trace to the file
+		const char* profile_env = std::getenv("GLOW_PROFILE");
+		const std::string profile_path = profile_env ? profile_env : "";
+
+		// GLOW_LATENCY=<prefix> writes the latency histograms of video runs to <prefix>.csv / .json;
+		// GLOW_LATENCY_EVERY=<N> prints percentiles every N frames, GLOW_LATENCY_P99_MS=<ms> judges the p99
+		if (const char* latency_env = std::getenv("GLOW_LATENCY"))
+			latency_options.output_prefix = latency_env;
+		if (const char* every_env = std::getenv("GLOW_LATENCY_EVERY"))
+			latency_options.report_every = std::max(0, std::atoi(every_env));
+		if (const char* target_env = std::getenv("GLOW_LATENCY_P99_MS"))
+			latency_options.p99_target_ms = std::max(0.0, std::atof(target_env));
+
+		SegmentWorkerArgs worker;
+		if (parse_segment_worker_args(argc, argv, worker)) {
+			ProfileSession profile(profile_path.empty() ? std::string()
+				: profile_path + "." + std::filesystem::path(worker.part).filename().string() + ".json");
+			if (worker.device >= 0) {
+#ifdef _WIN32
+				_putenv_s("CUDA_VISIBLE_DEVICES", std::to_string(worker.device).c_str());
+#else
+				setenv("CUDA_VISIBLE_DEVICES", std::to_string(worker.device).c_str(), 1);
+#endif
+			}
+			if (!glow_effect_video_segment(worker)) {
+				mark_segment_failed(worker.part);
+				return 1;
+			}
+			mark_segment_done(worker.part);
+			return 0;
+		}
+
+		// --raw-stdout-check: child of the raw stdout check in check mode
+		if (argc == 2 && std::string(argv[1]) == "--raw-stdout-check")
+			return write_raw_stdout_check() ? 0 : 1;
+
+		// --pipeline-bench [WxH] [frames] [k] [format]: end-to-end benchmark on a synthetic clip, headless
+		PipelineBenchSpec pipeline_bench;
+		if (parse_pipeline_bench_args(argc, argv, pipeline_bench))
+			return benchmark_pipeline(pipeline_bench) ? 0 : 1;
+
 		auto usage = []() {
 			printf("Usage:\n");
 			printf("   This program processes single images, directories, or video files.\n");
@@ -103,10 +212,23 @@ int main() {
 			printf("   -: display delay decreases by 30ms, min to 30ms\n");
 			printf("   p: display pauses\n");
 			printf("   q: program exits\n");
-			printf("   click bottom buttons on the control GUI to switch effect modes\n\n");
+			printf("   click bottom buttons on the control GUI to switch effect modes\n");
+			printf("Profiling:\n");
+			printf("   set GLOW_PROFILE=<trace.json> for a per-stage table and a Chrome trace of the run\n");
+			printf("   set GLOW_LATENCY=<prefix> to write the latency histograms of video runs to <prefix>.csv/.json,\n");
+			printf("   GLOW_LATENCY_EVERY=<N> for percentiles every N frames, GLOW_LATENCY_P99_MS=<ms> for a p99 target\n");
+			printf("   glow_effect --pipeline-bench [WxH] [frames] [k] [avi|y4m|raw...] renders a synthetic clip through\n");
+			printf("   the CPU segmenter and the whole glow and encode path (no video, plan or GPU) and reports fps,\n");
+			printf("   per-stage times and peak memory\n");
+			printf("Raw output:\n");
+			printf("   with stdout redirected (e.g. glow_effect | ffmpeg -i - ...), prompts and logs go to stderr and\n");
+			printf("   stdout carries only the raw stream of a video run whose raw output path is -\n\n");
 		};
 
+		// A redirected stdout may become the raw stream; keep the prompts out of it from the first one on.
+		reserve_redirected_stdout();
 		usage();
+		ProfileSession profile(profile_path);
 
 		// Launch the GUI control thread.
 		std::thread guiThread(set_control);
@@ -114,9 +236,17 @@ int main() {
 		std::string planFilePath = "D:/csi4900/TRT-Plans/mobileone_s4.edhe.plan";
 		std::string userInput;
 
-		printf("Do you want to input a single image, an image directory, or a video file? (single/directory/video): ");
+		printf("Do you want to input a single image, an image directory, or a video file? (single/directory/video/parallel/jobs/check/bench/golden): ");
 		std::cin >> userInput;
 
+		if (userInput != "check" && userInput != "c" && userInput != "bench" && userInput != "b" &&
+			userInput != "golden" && userInput != "g") {
+			std::string backend;
+			printf("Mipmap backend for the glow (gpu/cpu): ");
+			std::cin >> backend;
+			mipmap_backend = (backend == "cpu") ? MipmapBackend::Cpu : MipmapBackend::Cuda;
+		}
+
 		if (userInput == "single" || userInput == "s") {
 			printf("Enter the full path of the input image: ");
 			std::cin >> current_image_path;
@@ -144,6 +274,7 @@ int main() {
 			}
 
 			if (!grayscale_images.empty()) {
+				std::lock_guard<std::mutex> lock(state_mutex);
 				current_grayscale_mask = grayscale_images[0];
 				cv::resize(current_grayscale_mask, current_grayscale_mask, current_original_img.size());
 				updateImage();
@@ -151,9 +282,9 @@ int main() {
 
 			std::filesystem::remove(temp_path);
 
-			// Wait for user to exit.
+			// Show renders until the user exits.
 			while (true) {
-				char key = cv::waitKey(30);
+				char key = static_cast<char>(show_rendered_image(30));
 				if (key == 'q')
 					break;
 			}
@@ -214,21 +345,28 @@ int main() {
 			}
 
 			size_t current_index = 0;
+			bool index_changed = true;
 			while (true) {
-				current_image_path = img_paths[current_index];
-				current_original_img = original_images[current_index];
-
-				if (!grayscale_images.empty() && current_index < grayscale_images.size()) {
-					current_grayscale_mask = grayscale_images[current_index];
-					cv::resize(current_grayscale_mask, current_grayscale_mask, current_original_img.size());
-					updateImage();
+				// Only a new image needs a render; slider changes queue their own.
+				if (index_changed) {
+					std::lock_guard<std::mutex> lock(state_mutex);
+					current_image_path = img_paths[current_index];
+					current_original_img = original_images[current_index];
+
+					if (!grayscale_images.empty() && current_index < grayscale_images.size()) {
+						current_grayscale_mask = grayscale_images[current_index];
+						cv::resize(current_grayscale_mask, current_grayscale_mask, current_original_img.size());
+						updateImage();
+					}
+					index_changed = false;
 				}
 
-				char key = cv::waitKey(30);
+				char key = static_cast<char>(show_rendered_image(30));
 				if (key == 'q')
 					break;
 				if (key == 13) { // Enter key
 					current_index = (current_index + 1) % img_paths.size();
+					index_changed = true;
 				}
 			}
 
@@ -324,14 +462,47 @@ int main() {
 				printf("Use CUDA Graph acceleration for better performance? (y/n): ");
 				std::cin >> useGraphAcceleration;
 
+				// Keyframe segmentation: run TensorRT every Nth frame and propagate masks in between
+				int keyframeInterval = 1;
+				printf("Segment every Nth frame, propagating masks in between (1 = every frame): ");
+				std::cin >> keyframeInterval;
+
+				// Several classes can glow at once, each with its own color, blur scale and intensity
+				std::string classSpec;
+				printf("Glowing classes (class:B,G,R:scale:intensity;... or slider for the key level slider): ");
+				std::cin >> classSpec;
+				if (!parse_glow_classes(classSpec, glow_classes)) {
+					std::cout << "Could not parse the class table; using the key level slider." << std::endl;
+					glow_classes.clear();
+				}
+
+				// Raw Y4M / rawvideo stream for an external encoder, instead of or next to the MJPG .avi
+				std::string outputFormat;
+				printf("Output format (avi, y4m, y4m444, raw, raw444): ");
+				std::cin >> outputFormat;
+				if (outputFormat != "avi") {
+					if (!parse_raw_video_format(outputFormat, video_output.raw_format)) {
+						std::cout << "Unknown output format." << std::endl;
+						return 1;
+					}
+					std::string keepAvi;
+					printf("Raw output path (file, named pipe or - for stdout): ");
+					std::cin >> video_output.raw_path;
+					if (video_output.raw_path == "-")
+						reserve_stdout_for_raw_video();
+					printf("Also write the MJPG .avi? (y/n): ");
+					std::cin >> keepAvi;
+					video_output.avi = (keepAvi == "y" || keepAvi == "Y");
+				}
+
 				try {
 					if (useGraphAcceleration == "y" || useGraphAcceleration == "Y") {
 						std::cout << "Using CUDA Graph accelerated implementation..." << std::endl;
-						glow_effect_video_graph(videoPath.c_str(), planFilePath);
+						glow_effect_video_graph(videoPath.c_str(), planFilePath, keyframeInterval);
 					}
 					else {
 						std::cout << "Using standard implementation..." << std::endl;
-						glow_effect_video(videoPath.c_str(), planFilePath);
+						glow_effect_video(videoPath.c_str(), planFilePath, keyframeInterval);
 					}
 				}
 				catch (const std::exception& e) {
@@ -340,6 +511,123 @@ int main() {
 				}
 			}
 		}
+		else if (userInput == "parallel" || userInput == "p") {
+			// Segment-parallel render: one worker process per range of frames, parts concatenated at the end
+			SegmentRenderConfig config;
+			config.executable = argv[0];
+			config.job.cpu_mipmap = (mipmap_backend == MipmapBackend::Cpu);
+			std::string launch;
+			printf("Enter the full path of the video file: ");
+			std::cin >> config.job.video;
+			if (!std::filesystem::is_regular_file(config.job.video)) {
+				std::cout << "The specified path is not a valid file." << std::endl;
+				return 1;
+			}
+			printf("TensorRT plan (or cpu for the CPU segmenter): ");
+			std::cin >> config.job.plan;
+			printf("Worker processes: ");
+			std::cin >> config.workers;
+			printf("Segment every Nth frame, propagating masks in between (1 = every frame): ");
+			std::cin >> config.job.keyframe_interval;
+			printf("Output format (y4m, y4m444, raw, raw444; avi re-encodes when joining): ");
+			std::cin >> config.job.format;
+			RawVideoFormat raw_format = RawVideoFormat::Y4m420;
+			if (config.job.format != "avi" && !parse_raw_video_format(config.job.format, raw_format)) {
+				std::cout << "Unknown output format." << std::endl;
+				return 1;
+			}
+			printf("GPUs to spread the workers over (0 = do not pin): ");
+			std::cin >> config.gpus;
+			printf("Launch the workers on this machine? (y/n, n prints their commands for other nodes): ");
+			std::cin >> launch;
+			config.launch = (launch == "y" || launch == "Y");
+			config.output = "./VideoOutput/" + std::filesystem::path(config.job.video).stem().string() + "_parallel" +
+				(config.job.format == "avi" ? ".avi" : (raw_format == RawVideoFormat::Y4m420 || raw_format == RawVideoFormat::Y4m444) ? ".y4m" : ".yuv");
+			if (!run_segment_render(config))
+				return 1;
+		}
+		else if (userInput == "jobs" || userInput == "j") {
+			// Batch mode: every clip of a manifest in this process, sharing engines and worker threads
+			std::string manifestPath;
+			int concurrency = 2;
+			printf("Enter the full path of the batch manifest: ");
+			std::cin >> manifestPath;
+			printf("Clips rendered at once: ");
+			std::cin >> concurrency;
+
+			std::vector<BatchJob> jobs;
+			std::string error;
+			if (!load_batch_manifest(manifestPath, jobs, error)) {
+				std::cout << "Invalid manifest: " << error << std::endl;
+				return 1;
+			}
+			auto batch_start = std::chrono::steady_clock::now();
+			std::vector<BatchJobResult> results = run_batch_jobs(jobs, concurrency, glow_effect_video_job);
+			double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+			report_batch_jobs(jobs, results, wall);
+			EngineRegistryStats engines = TRTInference::engine_registry_stats();
+			std::cout << "Engine registry: " << engines.engines_loaded << " engines loaded, " << engines.contexts_created
+				<< " execution contexts created, " << engines.contexts_reused << " reused" << std::endl;
+			TRTInference::release_engines();
+		}
+		else if (userInput == "check" || userInput == "c") {
+			// Headless self-checks, no plan file or video needed.
+			bool passed = true;
+			passed &= verify_video_pipeline_order(101, 8, 1);
+			passed &= verify_video_pipeline_order(101, 8, 3);
+			passed &= verify_video_pipeline_order(5, 8, 2);
+			passed &= verify_video_pipeline_order(101, 8, 2, 13);
+			passed &= verify_adaptive_batcher();
+			passed &= verify_scene_detector();
+			passed &= verify_mask_propagation();
+			passed &= verify_glow_roi();
+			passed &= verify_rle_mask();
+			passed &= verify_mask_store();
+			passed &= verify_glow_cache();
+			passed &= verify_render_worker();
+			passed &= verify_param_block();
+			passed &= verify_glow_classes();
+			passed &= verify_frame_encoder();
+			passed &= verify_prefetch_decoder();
+			passed &= verify_raw_video_sink();
+			passed &= verify_raw_stdout(argv[0]);
+			passed &= verify_segment_render();
+			passed &= verify_batch_jobs();
+			passed &= verify_video_job_errors();
+			passed &= verify_profiler();
+			passed &= verify_latency_histogram();
+			passed &= verify_golden_images();
+			printf("Self-check %s\n", passed ? "passed" : "FAILED");
+		}
+		else if (userInput == "bench" || userInput == "b") {
+			// CPU stage benchmarks on generated clips, no plan file or video needed.
+			benchmark_scene_detector(240);
+			benchmark_glow_roi(3840, 2160);
+			benchmark_glow_classes(3840, 2160);
+			benchmark_prefetch_decoder(1920, 1080);
+			benchmark_raw_video_sink(1920, 1080);
+			mipmap_backend = MipmapBackend::Cpu;
+			benchmark_glow_cache(default_glow_stages(), 3840, 2160);
+			benchmark_cpu_kernels();
+			benchmark_pipeline(PipelineBenchSpec());
+		}
+		else if (userInput == "golden" || userInput == "g") {
+			// Fast paths against their reference implementations, on stored images as well.
+			GoldenOptions options;
+			std::string gpu;
+			printf("Directory of stored images to add to the corpus (- for none): ");
+			std::cin >> options.corpus_dir;
+			printf("Directory for the images of diverging cases (- for none): ");
+			std::cin >> options.diff_dir;
+			printf("Compare the GPU argmax kernel as well? (y/n): ");
+			std::cin >> gpu;
+			if (options.corpus_dir == "-")
+				options.corpus_dir.clear();
+			if (options.diff_dir == "-")
+				options.diff_dir.clear();
+			options.gpu = (gpu == "y" || gpu == "Y");
+			printf("Golden-image check %s\n", verify_golden_images(options) ? "passed" : "FAILED");
+		}
 		else {
 			printf("Invalid input. Terminating the program.\n");
 			return 0;
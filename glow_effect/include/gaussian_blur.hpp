@@ -12,6 +12,9 @@
  ********************************************************************************************************************/
 #pragma once
 #include "all_common.h"
+#include "movie_effect/include/tools_task.h"
+
+#include <mutex>
 
 template<typename _Ty>
 struct gaussian_blur_op
@@ -23,58 +26,65 @@ struct gaussian_blur_op
         for (int k = 0; k <= k_size; k++)
             kernel[k] = std::exp(-k * k / 2. / sigma2) / std::sqrt(2 * M_PI * sigma2);
 
-        _Ty* hline_buf = new _Ty[img_hsize];
-        float* vline_buf = new float[img_vsize];
         float* alpha_buf = new float[img_hsize * img_vsize];
 
-        // horizontal blur
-        for (int i = 0, m = 0; i < img_vsize; i++, m += img_hsize)
-        {
-            std::memcpy(hline_buf, din + m, sizeof(_Ty) * img_hsize);
+        // horizontal blur, bands of rows; each band owns its line buffer
+        task::parallel_rows(img_vsize, [&](const int row_bgn, const int row_end) {
+            std::vector<_Ty> hline_buf(img_hsize);
+            for (int i = row_bgn, m = row_bgn * img_hsize; i < row_end; i++, m += img_hsize)
+            {
+                std::memcpy(hline_buf.data(), din + m, sizeof(_Ty) * img_hsize);
 
-            for (int j = 0, n = i; j < img_hsize; j++, n += img_vsize) {
-                float data = kernel[0] * hline_buf[j];
-                for (int k = 1; k <= k_size; k++) {
-                    _Ty left = hline_buf[j - k < 0 ? 0 : j - k];
-                    _Ty rght = hline_buf[j + k < img_hsize ? j + k : img_hsize - 1];
-                    data += kernel[k] * (left + rght);
+                for (int j = 0, n = i; j < img_hsize; j++, n += img_vsize) {
+                    float data = kernel[0] * hline_buf[j];
+                    for (int k = 1; k <= k_size; k++) {
+                        _Ty left = hline_buf[j - k < 0 ? 0 : j - k];
+                        _Ty rght = hline_buf[j + k < img_hsize ? j + k : img_hsize - 1];
+                        data += kernel[k] * (left + rght);
+                    }
+                    alpha_buf[n] = data;
                 }
-                alpha_buf[n] = data;
             }
-        }
+        });
 
-        // vertical blur
+        // vertical blur, bands of columns; the per-band maximum is reduced afterwards
+        std::mutex max_mutex;
         float max_data = 0;
-        for (int i = 0, m = 0; i < img_hsize; i++, m += img_vsize)
-        {
-            std::memcpy(vline_buf, alpha_buf + m, sizeof(float) * img_vsize);
+        task::parallel_rows(img_hsize, [&](const int col_bgn, const int col_end) {
+            std::vector<float> vline_buf(img_vsize);
+            float band_max = 0;
+            for (int i = col_bgn, m = col_bgn * img_vsize; i < col_end; i++, m += img_vsize)
+            {
+                std::memcpy(vline_buf.data(), alpha_buf + m, sizeof(float) * img_vsize);
 
-            for (int j = 0, n = m; j < img_vsize; j++, n++) {
-                float data = kernel[0] * vline_buf[j];
-                for (int k = 1; k <= k_size; k++) {
-                    float left = vline_buf[j - k < 0 ? 0 : j - k];
-                    float rght = vline_buf[j + k < img_vsize ? j + k : img_vsize - 1];
-                    data += kernel[k] * (left + rght);
+                for (int j = 0, n = m; j < img_vsize; j++, n++) {
+                    float data = kernel[0] * vline_buf[j];
+                    for (int k = 1; k <= k_size; k++) {
+                        float left = vline_buf[j - k < 0 ? 0 : j - k];
+                        float rght = vline_buf[j + k < img_vsize ? j + k : img_vsize - 1];
+                        data += kernel[k] * (left + rght);
+                    }
+                    alpha_buf[n] = data;
+                    if (data > band_max)
+                        band_max = data;
                 }
-                alpha_buf[n] = data;
-                if (data > max_data)
-                    max_data = data;
             }
-        }
+            std::lock_guard<std::mutex> lock(max_mutex);
+            if (band_max > max_data)
+                max_data = band_max;
+        });
 
         // scaling
-        for (int i = 0, m = 0; i < img_hsize; i++, m += img_vsize)
-        {
-            std::memcpy(vline_buf, alpha_buf + m, sizeof(float) * img_vsize);
-
-            for (int j = 0, n = i; j < img_vsize; j++, n += img_hsize) {
-                _Ty data = (_Ty)(vline_buf[j] * 255 / max_data);
-                dout[n] = data;
+        task::parallel_rows(img_hsize, [&](const int col_bgn, const int col_end) {
+            for (int i = col_bgn, m = col_bgn * img_vsize; i < col_end; i++, m += img_vsize)
+            {
+                for (int j = 0, n = i; j < img_vsize; j++, n += img_hsize) {
+                    _Ty data = (_Ty)(alpha_buf[m + j] * 255 / max_data);
+                    dout[n] = data;
+                }
             }
-        }
+        });
 
-        delete[] hline_buf;
-        delete[] vline_buf;
         delete[] alpha_buf;
         delete[] kernel;
     }
@@ -0,0 +1,37 @@
+/**
+ * @file pipeline_bench_main.cpp
+ * @brief Entry point of the pipeline_bench target: the --pipeline-bench mode of glow_effect
+ *        without CUDA, TensorRT or the GUI (see CMakeLists.txt).
+ */
+
+#include "source/PipelineBench.hpp"
+#include "source/GlowParamBlock.hpp"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+// Glow parameters of the render; the defaults of the control GUI sliders (control_gui.cpp).
+GlowParamBlock glow_params(GlowParams{ 96, 600, 10 });
+
+int main(int argc, char** argv) {
+	// Same arguments as "glow_effect --pipeline-bench": [WxH] [frames] [k] [format]
+	std::string mode = "--pipeline-bench";
+	std::vector<char*> args{ argv[0], &mode[0] };
+	args.insert(args.end(), argv + 1, argv + argc);
+
+	PipelineBenchSpec spec;
+	if (!parse_pipeline_bench_args(static_cast<int>(args.size()), args.data(), spec)) {
+		printf("Usage: pipeline_bench [WxH] [frames] [k] [avi|y4m|raw...]\n");
+		printf("   renders a synthetic clip through the video pipeline with the CPU backends\n");
+		return 2;
+	}
+	try {
+		return benchmark_pipeline(spec) ? 0 : 1;
+	}
+	catch (const std::exception& e) {
+		fprintf(stderr, "Error: %s\n", e.what());
+		return 1;
+	}
+}
@@ -0,0 +1,258 @@
+/**
+ * @file AdaptiveBatcher.cpp
+ * @brief Online batch size / context count controller for the segmentation pipeline.
+ */
+
+#include "AdaptiveBatcher.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace {
+	const double kEwmaAlpha = 0.25;     // weight of the newest measurement
+	const int kProbePeriod = 16;        // decisions between two re-probes of another candidate
+	const double kProbeSlack = 1.5;     // measured candidates slower than target * slack are not re-probed
+}
+
+//--------------------------------------------------------------------------
+// Construction: enumerate candidates within the engine bounds
+//--------------------------------------------------------------------------
+AdaptiveBatcher::AdaptiveBatcher(const BatchBounds& bounds, Mode mode, double latency_target_ms, double source_fps)
+	: mode(mode), latency_target_ms(latency_target_ms),
+	frame_interval_ms(source_fps > 0.0 ? 1000.0 / source_fps : 0.0) {
+
+	const int min_batch = std::max(1, bounds.min_batch);
+	const int max_batch = std::max(min_batch, bounds.max_batch);
+
+	// Sub-batch sizes per context: the profile min/opt/max plus the powers of two in between.
+	std::vector<int> subs = { min_batch, max_batch };
+	if (bounds.opt_batch >= min_batch && bounds.opt_batch <= max_batch)
+		subs.push_back(bounds.opt_batch);
+	for (int s = 1; s <= max_batch; s *= 2)
+		if (s >= min_batch)
+			subs.push_back(s);
+	std::sort(subs.begin(), subs.end());
+	subs.erase(std::unique(subs.begin(), subs.end()), subs.end());
+
+	for (int contexts = 1; contexts <= std::max(1, bounds.max_contexts); ++contexts) {
+		for (int sub : subs) {
+			Candidate c;
+			c.plan.batch_size = sub * contexts;
+			c.plan.contexts = contexts;
+			candidates.push_back(c);
+		}
+	}
+
+	// Smallest batches first: exploration starts from the low-latency end.
+	std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+		return a.plan.batch_size < b.plan.batch_size;
+	});
+}
+
+//--------------------------------------------------------------------------
+// Estimates
+//--------------------------------------------------------------------------
+double AdaptiveBatcher::estimated_latency_ms(const Candidate& c) const {
+	// The first frame of a batch waits for the batch to fill, then for inference and post-processing.
+	return c.plan.batch_size * frame_interval_ms + c.infer_ms + c.post_ms;
+}
+
+double AdaptiveBatcher::estimated_fps(const Candidate& c) const {
+	// Inference of one batch overlaps post-processing of the previous one, so the slower stage sets the pace.
+	double period_ms = std::max(c.infer_ms, c.post_ms);
+	return period_ms > 0.0 ? c.plan.batch_size * 1000.0 / period_ms : 0.0;
+}
+
+bool AdaptiveBatcher::clearly_too_slow(const Candidate& c) const {
+	if (mode != Mode::Latency)
+		return false;
+	if (c.samples > 0)
+		return estimated_latency_ms(c) > latency_target_ms * kProbeSlack;
+
+	// Untried: a smaller batch with the same context count already misses the target.
+	for (const Candidate& other : candidates) {
+		if (other.samples > 0 && other.plan.contexts == c.plan.contexts &&
+			other.plan.batch_size < c.plan.batch_size && estimated_latency_ms(other) > latency_target_ms)
+			return true;
+	}
+	return false;
+}
+
+int AdaptiveBatcher::best_index() const {
+	int best = -1;
+	double best_fps = -1.0;
+	for (int i = 0; i < static_cast<int>(candidates.size()); ++i) {
+		const Candidate& c = candidates[i];
+		if (c.samples == 0)
+			continue;
+		if (mode == Mode::Latency && estimated_latency_ms(c) > latency_target_ms)
+			continue;
+		if (estimated_fps(c) > best_fps) {
+			best_fps = estimated_fps(c);
+			best = i;
+		}
+	}
+	if (best >= 0)
+		return best;
+
+	// Latency mode with nothing under target: take the fastest-responding candidate.
+	double best_latency = 0.0;
+	for (int i = 0; i < static_cast<int>(candidates.size()); ++i) {
+		const Candidate& c = candidates[i];
+		if (c.samples == 0)
+			continue;
+		if (best < 0 || estimated_latency_ms(c) < best_latency) {
+			best_latency = estimated_latency_ms(c);
+			best = i;
+		}
+	}
+	return best >= 0 ? best : 0;
+}
+
+//--------------------------------------------------------------------------
+// Decisions and feedback
+//--------------------------------------------------------------------------
+BatchPlan AdaptiveBatcher::next() {
+	std::lock_guard<std::mutex> lock(mutex);
+	decisions++;
+
+	for (const Candidate& c : candidates) {
+		if (c.samples == 0 && !clearly_too_slow(c))
+			return c.plan;
+	}
+
+	const int best = best_index();
+	if (decisions % kProbePeriod == 0) {
+		const int n = static_cast<int>(candidates.size());
+		for (int k = 0; k < n; ++k) {
+			int idx = probe_cursor++ % n;
+			if (idx != best && !clearly_too_slow(candidates[idx]))
+				return candidates[idx].plan;
+		}
+	}
+	return candidates[best].plan;
+}
+
+void AdaptiveBatcher::record(const BatchPlan& plan, double infer_ms, double post_ms) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (Candidate& c : candidates) {
+		if (c.plan.batch_size != plan.batch_size || c.plan.contexts != plan.contexts)
+			continue;
+		if (c.samples == 0) {
+			c.infer_ms = infer_ms;
+			c.post_ms = post_ms;
+		}
+		else {
+			c.infer_ms += kEwmaAlpha * (infer_ms - c.infer_ms);
+			c.post_ms += kEwmaAlpha * (post_ms - c.post_ms);
+		}
+		c.samples++;
+		return;
+	}
+}
+
+BatchPlan AdaptiveBatcher::best() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return candidates[best_index()].plan;
+}
+
+void AdaptiveBatcher::report() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	const int best = best_index();
+	std::cout << "Adaptive batching (" << (mode == Mode::Latency ? "latency" : "throughput") << " mode";
+	if (mode == Mode::Latency)
+		std::cout << ", target " << latency_target_ms << " ms";
+	std::cout << ")" << std::endl;
+	std::cout << "  batch  contexts  samples  infer(ms)  post(ms)  latency(ms)  fps" << std::endl;
+	for (int i = 0; i < static_cast<int>(candidates.size()); ++i) {
+		const Candidate& c = candidates[i];
+		if (c.samples == 0)
+			continue;
+		std::cout << (i == best ? "* " : "  ")
+			<< std::setw(5) << c.plan.batch_size << std::setw(10) << c.plan.contexts
+			<< std::setw(9) << c.samples << std::fixed << std::setprecision(2)
+			<< std::setw(11) << c.infer_ms << std::setw(10) << c.post_ms
+			<< std::setw(13) << estimated_latency_ms(c) << std::setw(7) << estimated_fps(c)
+			<< std::defaultfloat << std::endl;
+	}
+}
+
+//--------------------------------------------------------------------------
+// verify_adaptive_batcher: simulated cost model
+//--------------------------------------------------------------------------
+namespace {
+	// Inference: fixed launch overhead plus per-frame cost, contexts slow each other down.
+	double model_infer_ms(const BatchPlan& p) {
+		int sub = AdaptiveBatcher::sub_batch(p);
+		return 4.0 + 1.6 * sub * (1.0 + 0.35 * (p.contexts - 1));
+	}
+
+	// Post-processing: serial per-frame compositing.
+	double model_post_ms(const BatchPlan& p) {
+		return 0.8 * p.batch_size;
+	}
+
+	double model_fps(const BatchPlan& p) {
+		return p.batch_size * 1000.0 / std::max(model_infer_ms(p), model_post_ms(p));
+	}
+
+	double model_latency_ms(const BatchPlan& p, double frame_interval_ms) {
+		return p.batch_size * frame_interval_ms + model_infer_ms(p) + model_post_ms(p);
+	}
+
+	bool run_model(AdaptiveBatcher::Mode mode, const BatchBounds& bounds, double target_ms, double source_fps) {
+		AdaptiveBatcher batcher(bounds, mode, target_ms, source_fps);
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<double> noise(0.95, 1.05);
+		for (int i = 0; i < 400; ++i) {
+			BatchPlan p = batcher.next();
+			batcher.record(p, model_infer_ms(p) * noise(rng), model_post_ms(p) * noise(rng));
+		}
+
+		// Brute-force optimum of the model over the same search space.
+		const double interval = source_fps > 0.0 ? 1000.0 / source_fps : 0.0;
+		double optimum = 0.0;
+		for (int c = 1; c <= bounds.max_contexts; ++c) {
+			for (int sub = bounds.min_batch; sub <= bounds.max_batch; ++sub) {
+				BatchPlan p;
+				p.batch_size = sub * c;
+				p.contexts = c;
+				if (mode == AdaptiveBatcher::Mode::Latency && model_latency_ms(p, interval) > target_ms)
+					continue;
+				optimum = std::max(optimum, model_fps(p));
+			}
+		}
+
+		BatchPlan chosen = batcher.best();
+		bool meets_target = mode != AdaptiveBatcher::Mode::Latency || model_latency_ms(chosen, interval) <= target_ms;
+		bool ok = meets_target && model_fps(chosen) >= 0.9 * optimum;
+		std::cout << "Adaptive batcher check (" << (mode == AdaptiveBatcher::Mode::Latency ? "latency" : "throughput")
+			<< "): chose batch " << chosen.batch_size << " x " << chosen.contexts << " contexts, "
+			<< model_fps(chosen) << " fps vs optimum " << optimum << " fps: " << (ok ? "PASSED" : "FAILED") << std::endl;
+		if (!ok)
+			batcher.report();
+		return ok;
+	}
+}
+
+bool verify_adaptive_batcher() {
+	BatchBounds dynamic_bounds;
+	dynamic_bounds.min_batch = 1;
+	dynamic_bounds.opt_batch = 4;
+	dynamic_bounds.max_batch = 16;
+	dynamic_bounds.dynamic = true;
+	dynamic_bounds.max_contexts = 4;
+
+	BatchBounds fixed_bounds;
+	fixed_bounds.min_batch = fixed_bounds.opt_batch = fixed_bounds.max_batch = 4;
+	fixed_bounds.max_contexts = 4;
+
+	bool ok = true;
+	ok &= run_model(AdaptiveBatcher::Mode::Throughput, dynamic_bounds, 0.0, 0.0);
+	ok &= run_model(AdaptiveBatcher::Mode::Latency, dynamic_bounds, 120.0, 60.0);
+	ok &= run_model(AdaptiveBatcher::Mode::Throughput, fixed_bounds, 0.0, 0.0);
+	return ok;
+}
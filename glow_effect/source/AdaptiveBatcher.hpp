@@ -0,0 +1,109 @@
+#ifndef ADAPTIVE_BATCHER_HPP
+#define ADAPTIVE_BATCHER_HPP
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "VideoPipeline.hpp"   // BatchPlan
+
+/**
+ * @brief Per-context batch limits of a TensorRT engine.
+ *
+ * For a fixed-shape engine min_batch == max_batch == the built batch size; for a
+ * dynamic-shape engine they come from optimization profile 0.
+ */
+struct BatchBounds {
+	int min_batch = 1;      ///< Smallest batch one execution context accepts.
+	int opt_batch = 1;      ///< Batch the profile was optimized for.
+	int max_batch = 1;      ///< Largest batch one execution context accepts.
+	bool dynamic = false;   ///< True if the batch dimension is -1 in the engine.
+	int max_contexts = 4;   ///< Upper limit of concurrent execution contexts to consider.
+};
+
+/**
+ * @brief Online controller that picks batch size and concurrent context count.
+ *
+ * Every processed batch reports its measured inference and post-processing time.
+ * The batcher keeps an exponentially weighted estimate per candidate (batch size,
+ * contexts) and returns either the candidate with the highest throughput
+ * (Throughput mode, offline render) or the highest-throughput candidate whose
+ * estimated frame latency stays under the target (Latency mode, live preview).
+ * Candidates that were never measured are tried first, smallest batch first, and the
+ * neighbours of the current choice are re-probed periodically so the estimate follows
+ * load changes. All methods are thread-safe.
+ */
+class AdaptiveBatcher {
+public:
+	enum class Mode { Latency, Throughput };
+
+	/**
+	 * @param bounds            Engine limits (see TRTInference::get_engine_batch_bounds).
+	 * @param mode              Optimization goal.
+	 * @param latency_target_ms Max frame latency in Latency mode (ignored in Throughput mode).
+	 * @param source_fps        Frame rate of the source; adds the batch fill time to the latency
+	 *                          estimate. Use 0 when frames are available immediately.
+	 */
+	AdaptiveBatcher(const BatchBounds& bounds, Mode mode, double latency_target_ms = 100.0, double source_fps = 0.0);
+
+	/**
+	 * @brief Returns the plan for the next batch (may be an exploration step).
+	 */
+	BatchPlan next();
+
+	/**
+	 * @brief Feeds back the measured timing of a batch processed with the given plan.
+	 *
+	 * @param plan     Plan the batch was processed with.
+	 * @param infer_ms Inference time of the whole batch (all contexts).
+	 * @param post_ms  Post-processing / compositing time of the whole batch.
+	 */
+	void record(const BatchPlan& plan, double infer_ms, double post_ms);
+
+	/**
+	 * @brief Best plan according to the current estimates (no exploration).
+	 */
+	BatchPlan best() const;
+
+	/**
+	 * @brief Prints the estimate table.
+	 */
+	void report() const;
+
+	/** @brief Frames per context of a plan (rounded up), as handed to one execution context. */
+	static int sub_batch(const BatchPlan& plan) { return (plan.batch_size + plan.contexts - 1) / plan.contexts; }
+
+private:
+	struct Candidate {
+		BatchPlan plan;
+		int samples = 0;
+		double infer_ms = 0.0;
+		double post_ms = 0.0;
+	};
+
+	double estimated_latency_ms(const Candidate& c) const;
+	double estimated_fps(const Candidate& c) const;
+	bool clearly_too_slow(const Candidate& c) const;
+	int best_index() const;
+
+	Mode mode;
+	double latency_target_ms;
+	double frame_interval_ms;
+	std::vector<Candidate> candidates;
+	long long decisions = 0;
+	int probe_cursor = 0;
+	mutable std::mutex mutex;
+};
+
+/**
+ * @brief Headless check of AdaptiveBatcher against a simulated cost model.
+ *
+ * Runs the controller in both modes on a synthetic inference/post-processing cost model
+ * with noise and verifies that it settles on a plan whose true throughput is within 10%
+ * of the best feasible plan (and, in Latency mode, meets the target).
+ *
+ * @return true if the check passed.
+ */
+bool verify_adaptive_batcher();
+
+#endif // ADAPTIVE_BATCHER_HPP
@@ -0,0 +1,280 @@
+/**
+ * @file BatchJobs.cpp
+ * @brief Batch manifest parsing and the job pool of the batch mode.
+ */
+
+#include "BatchJobs.hpp"
+#include "GlowClasses.hpp"
+#include "RawVideoSink.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+	// White-space separated tokens; a token in double quotes may contain spaces. Stops at '#'.
+	bool tokenize_line(const std::string& line, std::vector<std::string>& tokens) {
+		tokens.clear();
+		size_t i = 0;
+		while (i < line.size()) {
+			while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i])))
+				++i;
+			if (i >= line.size() || line[i] == '#')
+				break;
+			std::string token;
+			if (line[i] == '"') {
+				size_t end = line.find('"', i + 1);
+				if (end == std::string::npos)
+					return false;
+				token = line.substr(i + 1, end - i - 1);
+				i = end + 1;
+			}
+			else {
+				while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i])))
+					token += line[i++];
+			}
+			tokens.push_back(token);
+		}
+		return true;
+	}
+
+	// Applies one key=value setting to job.
+	bool apply_setting(const std::string& setting, BatchJob& job, std::string& error) {
+		const size_t eq = setting.find('=');
+		if (eq == std::string::npos || eq == 0) {
+			error = "expected key=value, got \"" + setting + "\"";
+			return false;
+		}
+		const std::string key = setting.substr(0, eq);
+		const std::string value = setting.substr(eq + 1);
+		if (key == "plan") {
+			job.plan = value;
+		}
+		else if (key == "k") {
+			try {
+				job.keyframe_interval = std::stoi(value);
+			}
+			catch (const std::exception&) {
+				job.keyframe_interval = 0;
+			}
+			if (job.keyframe_interval < 1) {
+				error = "k must be a positive integer";
+				return false;
+			}
+		}
+		else if (key == "format") {
+			RawVideoFormat raw;
+			if (value != "avi" && !parse_raw_video_format(value, raw)) {
+				error = "unknown format \"" + value + "\"";
+				return false;
+			}
+			job.format = value;
+		}
+		else if (key == "classes") {
+			GlowClassTable table;
+			if (!parse_glow_classes(value, table)) {
+				error = "malformed class table \"" + value + "\"";
+				return false;
+			}
+			job.classes = value;
+		}
+		else {
+			error = "unknown key \"" + key + "\"";
+			return false;
+		}
+		return true;
+	}
+
+	double seconds_since(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+//--------------------------------------------------------------------------
+// Manifest
+//--------------------------------------------------------------------------
+bool parse_batch_manifest(std::istream& in, std::vector<BatchJob>& jobs, std::string& error) {
+	jobs.clear();
+	BatchJob defaults;
+	std::string line;
+	std::vector<std::string> tokens;
+	for (int line_no = 1; std::getline(in, line); ++line_no) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		const std::string where = "line " + std::to_string(line_no) + ": ";
+		if (!tokenize_line(line, tokens)) {
+			error = where + "unterminated quote";
+			return false;
+		}
+		if (tokens.empty())
+			continue;
+
+		const bool is_defaults = tokens[0] == "defaults";
+		if (!is_defaults && tokens.size() < 2) {
+			error = where + "expected an input and an output path";
+			return false;
+		}
+		BatchJob job = defaults;
+		for (size_t i = is_defaults ? 1 : 2; i < tokens.size(); ++i) {
+			if (!apply_setting(tokens[i], job, error)) {
+				error = where + error;
+				return false;
+			}
+		}
+		if (is_defaults) {
+			defaults = job;
+			continue;
+		}
+		job.input = tokens[0];
+		job.output = tokens[1];
+		job.line = line_no;
+		if (job.plan.empty()) {
+			error = where + "no plan (set plan= on the line or in a defaults line)";
+			return false;
+		}
+		jobs.push_back(job);
+	}
+	return true;
+}
+
+bool load_batch_manifest(const std::string& path, std::vector<BatchJob>& jobs, std::string& error) {
+	std::ifstream in(path);
+	if (!in.is_open()) {
+		error = "could not open " + path;
+		return false;
+	}
+	return parse_batch_manifest(in, jobs, error);
+}
+
+//--------------------------------------------------------------------------
+// run_batch_jobs
+//--------------------------------------------------------------------------
+std::vector<BatchJobResult> run_batch_jobs(const std::vector<BatchJob>& jobs, int concurrency, const BatchJobFn& run) {
+	std::vector<BatchJobResult> results(jobs.size());
+	if (jobs.empty())
+		return results;
+	const auto start = std::chrono::steady_clock::now();
+	std::atomic<size_t> next{ 0 };
+
+	auto worker = [&]() {
+		for (size_t i = next++; i < jobs.size(); i = next++) {
+			const double queued = seconds_since(start);
+			const auto job_start = std::chrono::steady_clock::now();
+			BatchJobResult result;
+			try {
+				result = run(jobs[i]);
+			}
+			catch (const std::exception& e) {
+				result = BatchJobResult();
+				result.error = e.what();
+			}
+			result.queued_seconds = queued;
+			result.seconds = seconds_since(job_start);
+			results[i] = result;
+		}
+	};
+
+	const int threads = std::max(1, std::min(concurrency, static_cast<int>(jobs.size())));
+	std::vector<std::thread> pool;
+	for (int t = 1; t < threads; ++t)
+		pool.emplace_back(worker);
+	worker();
+	for (std::thread& thread : pool)
+		thread.join();
+	return results;
+}
+
+//--------------------------------------------------------------------------
+// report_batch_jobs
+//--------------------------------------------------------------------------
+void report_batch_jobs(const std::vector<BatchJob>& jobs, const std::vector<BatchJobResult>& results, double wall_seconds) {
+	uint64_t frames = 0;
+	double job_seconds = 0.0;
+	size_t failed = 0;
+	std::printf("%-4s %-40s %8s %9s %9s %8s %9s %9s\n", "job", "input", "frames", "queued s", "time s", "fps",
+		"seg s", "glow s");
+	for (size_t i = 0; i < jobs.size() && i < results.size(); ++i) {
+		const BatchJobResult& r = results[i];
+		std::string name = jobs[i].input;
+		if (name.size() > 40)
+			name = "..." + name.substr(name.size() - 37);
+		std::printf("%-4zu %-40s %8llu %9.2f %9.2f %8.1f %9.2f %9.2f%s%s\n", i + 1, name.c_str(),
+			static_cast<unsigned long long>(r.frames), r.queued_seconds, r.seconds,
+			r.seconds > 0.0 ? r.frames / r.seconds : 0.0, r.segmentation_seconds, r.post_seconds,
+			r.ok ? "" : "  FAILED: ", r.ok ? "" : r.error.c_str());
+		frames += r.frames;
+		job_seconds += r.seconds;
+		failed += r.ok ? 0 : 1;
+	}
+	std::printf("Batch: %zu jobs (%zu failed), %llu frames in %.2f s wall (%.1f fps), %.2f s summed over jobs\n",
+		jobs.size(), failed, static_cast<unsigned long long>(frames), wall_seconds,
+		wall_seconds > 0.0 ? frames / wall_seconds : 0.0, job_seconds);
+}
+
+//--------------------------------------------------------------------------
+// verify_batch_jobs
+//--------------------------------------------------------------------------
+bool verify_batch_jobs() {
+	// Parser: defaults, quoted paths, comments, per-line overrides.
+	std::istringstream manifest(
+		"# clips of the batch\r\n"
+		"defaults plan=a.plan k=4 format=y4m\r\n"
+		"\"clips/race 1.mp4\" out/race1.y4m\r\n"
+		"\r\n"
+		"clips/race2.mp4 out/race2.avi format=avi classes=8:0,0,255:10:600  # one class\r\n"
+		"defaults plan=cpu\r\n"
+		"clips/race3.mp4 out/race3.yuv format=raw k=1\r\n");
+	std::vector<BatchJob> jobs;
+	std::string error;
+	bool parse_ok = parse_batch_manifest(manifest, jobs, error) && jobs.size() == 3 &&
+		jobs[0].input == "clips/race 1.mp4" && jobs[0].output == "out/race1.y4m" && jobs[0].plan == "a.plan" &&
+		jobs[0].keyframe_interval == 4 && jobs[0].format == "y4m" && jobs[0].classes.empty() && jobs[0].line == 3 &&
+		jobs[1].format == "avi" && jobs[1].classes == "8:0,0,255:10:600" && jobs[1].keyframe_interval == 4 &&
+		jobs[2].plan == "cpu" && jobs[2].format == "raw" && jobs[2].keyframe_interval == 1;
+	const char* bad[] = { "in.mp4 out.avi\n", "defaults plan=a\nin.mp4\n", "defaults plan=a\nin.mp4 out.avi speed=2\n",
+		"defaults plan=a\nin.mp4 out.avi format=mkv\n", "defaults plan=a\n\"in.mp4 out.avi\n", "defaults plan=a k=0\n" };
+	for (const char* text : bad) {
+		std::istringstream in(text);
+		std::vector<BatchJob> rejected;
+		parse_ok = parse_ok && !parse_batch_manifest(in, rejected, error) && !error.empty();
+	}
+
+	// Pool: results in manifest order, at most concurrency jobs at once, a throwing job fails alone.
+	std::vector<BatchJob> pool_jobs(7);
+	for (size_t i = 0; i < pool_jobs.size(); ++i)
+		pool_jobs[i].input = std::to_string(i);
+	std::atomic<int> running{ 0 }, max_running{ 0 };
+	std::vector<BatchJobResult> results = run_batch_jobs(pool_jobs, 3, [&](const BatchJob& job) {
+		const int now = ++running;
+		int seen = max_running.load();
+		while (now > seen && !max_running.compare_exchange_weak(seen, now)) {}
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		--running;
+		if (job.input == "4")
+			throw std::runtime_error("job 4 fails");
+		BatchJobResult result;
+		result.ok = true;
+		result.frames = std::stoul(job.input);
+		return result;
+	});
+	bool pool_ok = results.size() == pool_jobs.size() && max_running.load() >= 2 && max_running.load() <= 3;
+	for (size_t i = 0; i < results.size(); ++i) {
+		const bool should_fail = (i == 4);
+		pool_ok = pool_ok && results[i].ok != should_fail && (should_fail ? results[i].error == "job 4 fails" : results[i].frames == i) &&
+			results[i].seconds >= 0.015;
+	}
+
+	const bool passed = parse_ok && pool_ok;
+	std::cout << "Batch jobs check: manifest parser " << (parse_ok ? "ok" : "WRONG") << ", job pool "
+		<< (pool_ok ? "ok" : "WRONG") << " (" << max_running.load() << " concurrent of 3): "
+		<< (passed ? "PASSED" : "FAILED") << std::endl;
+	return passed;
+}
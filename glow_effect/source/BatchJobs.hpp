@@ -0,0 +1,87 @@
+#ifndef BATCH_JOBS_HPP
+#define BATCH_JOBS_HPP
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One clip of a batch manifest.
+ */
+struct BatchJob {
+	std::string input;             ///< Input video.
+	std::string output;            ///< Rendered video (the AVI, or the raw stream for a raw format).
+	std::string plan;              ///< TensorRT plan, or "cpu" for the CPU segmenter backend.
+	int keyframe_interval = 1;     ///< Segment every Nth frame and propagate masks in between.
+	std::string format = "avi";    ///< "avi" or a raw format name (see parse_raw_video_format).
+	std::string classes;           ///< Glow class table (see parse_glow_classes); empty for the key level slider.
+	int line = 0;                  ///< Manifest line, for messages.
+};
+
+/**
+ * @brief Outcome and timing of one job.
+ */
+struct BatchJobResult {
+	bool ok = false;
+	std::string error;                 ///< Why the job failed.
+	uint64_t frames = 0;               ///< Frames rendered.
+	double queued_seconds = 0.0;       ///< From the start of the batch until the job started.
+	double seconds = 0.0;              ///< Wall-clock time of the job.
+	double segmentation_seconds = 0.0; ///< Summed over batches (they overlap, so may exceed seconds).
+	double post_seconds = 0.0;         ///< Glow compositing, summed over batches.
+};
+
+/**
+ * @brief Parses a batch manifest.
+ *
+ * One job per line: the input and output paths followed by key=value settings, separated by
+ * white space (paths with spaces in double quotes). Keys are plan, k (keyframe interval),
+ * format and classes. A line starting with "defaults" sets key=value settings for the lines
+ * after it; '#' starts a comment. Example:
+ *
+ *     defaults plan=D:/plans/mobileone_s4.edhe.plan k=4 format=y4m
+ *     "D:/clips/race 1.mp4"  D:/out/race1.y4m
+ *     D:/clips/race2.mp4     D:/out/race2.avi  format=avi classes=8:0,0,255:10:600
+ *
+ * @param in     Manifest text.
+ * @param jobs   Receives the jobs in manifest order.
+ * @param error  Receives the first problem, with its line number.
+ * @return false on a syntax error, an unknown key or format, or a job without a plan.
+ */
+bool parse_batch_manifest(std::istream& in, std::vector<BatchJob>& jobs, std::string& error);
+
+/**
+ * @brief parse_batch_manifest on a file.
+ */
+bool load_batch_manifest(const std::string& path, std::vector<BatchJob>& jobs, std::string& error);
+
+/** @brief Renders one job; runs on a batch worker thread. */
+typedef std::function<BatchJobResult(const BatchJob&)> BatchJobFn;
+
+/**
+ * @brief Runs the jobs on concurrency worker threads of one process, in manifest order.
+ *
+ * Jobs share whatever the process keeps alive between them (TensorRT engines and contexts of
+ * the engine registry, the task scheduler, GPU buffers of the glow). A job that throws fails
+ * with the exception message; the others continue.
+ *
+ * @return One result per job, in manifest order; queued_seconds and seconds are measured here.
+ */
+std::vector<BatchJobResult> run_batch_jobs(const std::vector<BatchJob>& jobs, int concurrency, const BatchJobFn& run);
+
+/**
+ * @brief Prints a table of per-job timing and the batch totals.
+ */
+void report_batch_jobs(const std::vector<BatchJob>& jobs, const std::vector<BatchJobResult>& results, double wall_seconds);
+
+/**
+ * @brief Headless check of the manifest parser and of the worker pool (order of results,
+ *        concurrency limit, failing jobs).
+ *
+ * @return true if the check passed.
+ */
+bool verify_batch_jobs();
+
+#endif // BATCH_JOBS_HPP
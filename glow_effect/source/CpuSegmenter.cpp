@@ -0,0 +1,57 @@
+/**
+ * @file CpuSegmenter.cpp
+ * @brief Color-rule segmentation backend for runs without TensorRT.
+ */
+
+#include "CpuSegmenter.hpp"
+#include "GlowClasses.hpp"
+#include "Profiler.hpp"
+#include "movie_effect/include/tools_task.h"
+
+#include <algorithm>
+
+//--------------------------------------------------------------------------
+// segment_frame_cpu
+//--------------------------------------------------------------------------
+cv::Mat segment_frame_cpu(const cv::Mat& frame, const CpuSegmenterConfig& config) {
+	cv::Mat mask(config.mask_size, CV_8UC1, cv::Scalar(0));
+	if (frame.empty() || frame.channels() < 3)
+		return mask;
+
+	const int channels = frame.channels();
+	const uchar red = static_cast<uchar>(config.red_class * kClassLevelStep);
+	const uchar green = static_cast<uchar>(config.green_class * kClassLevelStep);
+	const uchar blue = static_cast<uchar>(config.blue_class * kClassLevelStep);
+	std::vector<int> src_x(mask.cols);
+	for (int x = 0; x < mask.cols; ++x)
+		src_x[x] = std::min(frame.cols - 1, (2 * x + 1) * frame.cols / (2 * mask.cols)) * channels;
+
+	for (int y = 0; y < mask.rows; ++y) {
+		const uchar* row = frame.ptr<uchar>(std::min(frame.rows - 1, (2 * y + 1) * frame.rows / (2 * mask.rows)));
+		uchar* out = mask.ptr<uchar>(y);
+		for (int x = 0; x < mask.cols; ++x) {
+			const uchar* px = row + src_x[x];
+			const int b = px[0], g = px[1], r = px[2];
+			const int hi = std::max(b, std::max(g, r));
+			const int lo = std::min(b, std::min(g, r));
+			if (hi - lo < config.min_saturation)
+				continue;
+			out[x] = (r == hi) ? red : (g == hi) ? green : blue;
+		}
+	}
+	return mask;
+}
+
+//--------------------------------------------------------------------------
+// segment_frames_cpu
+//--------------------------------------------------------------------------
+std::vector<cv::Mat> segment_frames_cpu(const std::vector<cv::Mat>& frames, const CpuSegmenterConfig& config) {
+	std::vector<cv::Mat> masks(frames.size());
+	task::parallel_rows(static_cast<int>(frames.size()), [&](int f0, int f1) {
+		for (int f = f0; f < f1; ++f) {
+			PROFILE_ZONE("segment");
+			masks[f] = segment_frame_cpu(frames[f], config);
+		}
+	}, 1);
+	return masks;
+}
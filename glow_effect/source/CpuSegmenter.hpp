@@ -0,0 +1,35 @@
+#ifndef CPU_SEGMENTER_HPP
+#define CPU_SEGMENTER_HPP
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Segmentation backend without TensorRT, for tests and machines without a GPU engine.
+ *
+ * Not a model: each pixel of the mask grid is classified from its color alone. Saturated red
+ * becomes class 8 (mask value 96, the default key level), saturated green class 5 and
+ * saturated blue class 2; everything else is background. Masks use the class * (255 / 21)
+ * levels of the TensorRT masks, so every later stage treats them the same way.
+ */
+struct CpuSegmenterConfig {
+	cv::Size mask_size = cv::Size(384, 384);   ///< Grid of the masks (the TensorRT output size).
+	int min_saturation = 48;                   ///< max(B,G,R) - min(B,G,R) below which a pixel is background.
+	int red_class = 8;                         ///< Class of red-dominant pixels.
+	int green_class = 5;                       ///< Class of green-dominant pixels.
+	int blue_class = 2;                        ///< Class of blue-dominant pixels.
+};
+
+/**
+ * @brief Class map of one frame (BGR or BGRA), sampled at the mask grid.
+ *
+ * @return CV_8UC1 mask of config.mask_size.
+ */
+cv::Mat segment_frame_cpu(const cv::Mat& frame, const CpuSegmenterConfig& config = CpuSegmenterConfig());
+
+/**
+ * @brief segment_frame_cpu over a batch, one task per frame on the shared scheduler.
+ */
+std::vector<cv::Mat> segment_frames_cpu(const std::vector<cv::Mat>& frames, const CpuSegmenterConfig& config = CpuSegmenterConfig());
+
+#endif // CPU_SEGMENTER_HPP
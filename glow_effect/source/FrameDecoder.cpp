@@ -0,0 +1,298 @@
+/**
+ * @file FrameDecoder.cpp
+ * @brief Read-ahead decoder thread over a ring of reused frame buffers.
+ */
+
+#include "FrameDecoder.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <set>
+
+namespace {
+	// The 8 bars of color_bars (movie_effect/include/tools_image.h), as BGR.
+	const uchar kBars[8][3] = { {250, 250, 250}, {16, 250, 250}, {250, 250, 16}, {16, 250, 16},
+		{250, 16, 250}, {16, 16, 250}, {250, 16, 16}, {16, 16, 16} };
+
+	// Color bars with a checkered box sweeping across them; pixel (0, 0) carries the frame
+	// number (B = low byte, G = high byte) so checks can tell frames apart.
+	void render_test_pattern(int index, const cv::Size& size, cv::Mat& frame) {
+		frame.create(size.height, size.width, CV_8UC3);
+		const int box = std::max(8, std::min(size.width, size.height) / 4);
+		const int range_x = std::max(1, size.width - box);
+		const int px = (index * 7) % (2 * range_x);
+		const int ox = px < range_x ? px : 2 * range_x - px;
+		const int oy = (size.height - box) / 2;
+
+		uchar* first_row = frame.ptr<uchar>(0);
+		for (int x = 0; x < size.width; ++x) {
+			const uchar* c = kBars[x * 8 / size.width];
+			first_row[x * 3] = c[0];
+			first_row[x * 3 + 1] = c[1];
+			first_row[x * 3 + 2] = c[2];
+		}
+		for (int y = 1; y < size.height; ++y)
+			std::copy(first_row, first_row + size.width * 3, frame.ptr<uchar>(y));
+		for (int y = oy; y < oy + box && y < size.height; ++y) {
+			uchar* row = frame.ptr<uchar>(y);
+			for (int x = ox; x < ox + box && x < size.width; ++x) {
+				const uchar v = ((x - ox) / 8 + (y - oy) / 8 + index) % 2 ? 255 : 0;
+				row[x * 3] = row[x * 3 + 1] = row[x * 3 + 2] = v;
+			}
+		}
+		frame.ptr<uchar>(0)[0] = static_cast<uchar>(index & 0xff);
+		frame.ptr<uchar>(0)[1] = static_cast<uchar>((index >> 8) & 0xff);
+	}
+
+	int pattern_index(const cv::Mat& frame) {
+		return frame.ptr<uchar>(0)[0] | (frame.ptr<uchar>(0)[1] << 8);
+	}
+}
+
+//--------------------------------------------------------------------------
+// PrefetchDecoder
+//--------------------------------------------------------------------------
+PrefetchDecoder::PrefetchDecoder(DecodeFrameFn decode, size_t slots)
+	: decode(std::move(decode)), ring(std::max<size_t>(2, slots)), state(ring.size(), SlotState::Free),
+	slot_seq(ring.size(), 0) {
+	thread = std::thread(&PrefetchDecoder::run, this);
+}
+
+PrefetchDecoder::~PrefetchDecoder() {
+	stop();
+}
+
+bool PrefetchDecoder::next(DecodedFrame& out) {
+	auto wait_start = std::chrono::high_resolution_clock::now();
+	std::unique_lock<std::mutex> lock(mutex);
+	if (state[read_slot] == SlotState::Lent) {
+		std::cerr << "Error: every decoder slot is lent out; release frames or use a larger ring." << std::endl;
+		return false;
+	}
+	frame_ready.wait(lock, [&] { return state[read_slot] == SlotState::Ready || end_of_stream || stopping; });
+	counters.consumer_wait_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - wait_start).count();
+	if (stopping || state[read_slot] != SlotState::Ready)
+		return false;
+
+	out.seq = slot_seq[read_slot];
+	out.slot = static_cast<int>(read_slot);
+	out.frame = ring[read_slot];
+	state[read_slot] = SlotState::Lent;
+	read_slot = (read_slot + 1) % ring.size();
+	return true;
+}
+
+void PrefetchDecoder::release(DecodedFrame& frame) {
+	frame.frame.release();
+	if (frame.slot < 0 || frame.slot >= static_cast<int>(ring.size()))
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (state[frame.slot] == SlotState::Lent)
+			state[frame.slot] = SlotState::Free;
+	}
+	frame.slot = -1;
+	slot_free.notify_one();
+}
+
+void PrefetchDecoder::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	slot_free.notify_all();
+	frame_ready.notify_all();
+	if (thread.joinable())
+		thread.join();
+}
+
+PrefetchDecoderStats PrefetchDecoder::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void PrefetchDecoder::run() {
+	profiler_set_thread_name("decoder");
+	uint64_t seq = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		auto wait_start = std::chrono::high_resolution_clock::now();
+		slot_free.wait(lock, [&] { return state[write_slot] == SlotState::Free || stopping; });
+		counters.decoder_wait_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - wait_start).count();
+		if (stopping)
+			break;
+		const size_t slot = write_slot;
+		state[slot] = SlotState::Decoding;
+		cv::Mat& buffer = ring[slot];   // untouched by next()/release() while Decoding
+		const uchar* before = buffer.data;
+		lock.unlock();
+
+		auto decode_start = std::chrono::high_resolution_clock::now();
+		bool ok = false;
+		try {
+			PROFILE_ZONE("decode");
+			ok = decode(buffer) && !buffer.empty();
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Error decoding frame " << seq << ": " << e.what() << std::endl;
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - decode_start).count();
+
+		lock.lock();
+		if (!ok) {
+			state[slot] = SlotState::Free;
+			break;
+		}
+		if (buffer.data != before)
+			counters.reallocations++;
+		counters.frames++;
+		counters.decode_ms += ms;
+		slot_seq[slot] = seq++;
+		state[slot] = SlotState::Ready;
+		write_slot = (slot + 1) % ring.size();
+		frame_ready.notify_one();
+	}
+	end_of_stream = true;
+	frame_ready.notify_all();
+}
+
+//--------------------------------------------------------------------------
+// Decode sources
+//--------------------------------------------------------------------------
+DecodeFrameFn capture_decode_source(cv::VideoCapture& video) {
+	return [&video](cv::Mat& slot) { return video.read(slot); };
+}
+
+DecodeFrameFn synthetic_decode_source(const cv::Size& size, int frame_count) {
+	int index = 0;
+	return [size, frame_count, index](cv::Mat& slot) mutable {
+		if (index >= frame_count)
+			return false;
+		render_test_pattern(index++, size, slot);
+		return true;
+	};
+}
+
+//--------------------------------------------------------------------------
+// verify_prefetch_decoder
+//--------------------------------------------------------------------------
+bool verify_prefetch_decoder() {
+	const int frames = 101;
+	const size_t slots = 6;
+	const int batch = 4;   // frames held by the consumer at once, like a segmentation batch
+
+	bool order_ok = true;
+	std::set<const uchar*> buffers;
+	int received = 0;
+	PrefetchDecoderStats stats;
+	{
+		PrefetchDecoder decoder(synthetic_decode_source(cv::Size(64, 48), frames), slots);
+		std::vector<DecodedFrame> held(batch);
+		for (;;) {
+			int n = 0;
+			while (n < batch && decoder.next(held[n])) {
+				const DecodedFrame& f = held[n];
+				order_ok = order_ok && f.seq == static_cast<uint64_t>(received) && pattern_index(f.frame) == received &&
+					f.frame.cols == 64 && f.frame.rows == 48;
+				buffers.insert(f.frame.data);
+				received++;
+				n++;
+			}
+			for (int i = 0; i < n; ++i)
+				decoder.release(held[i]);
+			if (n < batch)
+				break;
+		}
+		DecodedFrame extra;
+		order_ok = order_ok && !decoder.next(extra);
+		stats = decoder.stats();
+	}
+	const bool reuse_ok = buffers.size() <= slots && stats.reallocations <= slots;
+
+	// Stopping while the decoder waits on a full ring and the consumer holds frames must not hang.
+	bool stop_ok = true;
+	{
+		PrefetchDecoder decoder(synthetic_decode_source(cv::Size(32, 32), 1 << 20), 3);
+		DecodedFrame a, b, c;
+		stop_ok = decoder.next(a) && decoder.next(b) && pattern_index(b.frame) == 1;
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		decoder.stop();
+		stop_ok = stop_ok && !decoder.next(c);
+		decoder.release(a);
+	}
+
+	const bool passed = order_ok && received == frames && reuse_ok && stop_ok;
+	std::cout << "Prefetch decoder check: " << received << " of " << frames << " frames in order through " << slots
+		<< " slots, " << buffers.size() << " buffers, " << stats.reallocations << " allocations: "
+		<< (passed ? "PASSED" : "FAILED") << std::endl;
+	return passed;
+}
+
+//--------------------------------------------------------------------------
+// benchmark_prefetch_decoder
+//--------------------------------------------------------------------------
+void benchmark_prefetch_decoder(int width, int height) {
+	const cv::Size size(width, height);
+	const int frames = 240;
+	const int batch = 8;
+	// Codec latency on top of rendering the pattern, and the batch's segmentation + compositing
+	// (mostly GPU, so the host thread just waits).
+	const auto decode_latency = std::chrono::milliseconds(3);
+	const auto batch_work = std::chrono::milliseconds(4 * batch);
+	auto slow_source = [&]() {
+		DecodeFrameFn source = synthetic_decode_source(size, frames);
+		return [source, decode_latency](cv::Mat& slot) mutable {
+			std::this_thread::sleep_for(decode_latency);
+			return source(slot);
+		};
+	};
+
+	// Synchronous: read each frame, clone it into the batch, then process the batch.
+	auto t0 = std::chrono::high_resolution_clock::now();
+	{
+		DecodeFrameFn read = slow_source();
+		cv::Mat frame;
+		bool more = true;
+		while (more) {
+			std::vector<cv::Mat> batch_frames;
+			while (static_cast<int>(batch_frames.size()) < batch && (more = read(frame)))
+				batch_frames.push_back(frame.clone());
+			if (batch_frames.empty())
+				break;
+			std::this_thread::sleep_for(batch_work);
+		}
+	}
+	auto t1 = std::chrono::high_resolution_clock::now();
+
+	// Prefetch ring of two batches: the next batch decodes while this one is processed.
+	PrefetchDecoderStats stats;
+	{
+		PrefetchDecoder decoder(slow_source(), 2 * batch + 1);
+		std::vector<DecodedFrame> held(batch);
+		for (;;) {
+			int n = 0;
+			while (n < batch && decoder.next(held[n]))
+				n++;
+			if (n == 0)
+				break;
+			std::this_thread::sleep_for(batch_work);
+			for (int i = 0; i < n; ++i)
+				decoder.release(held[i]);
+		}
+		stats = decoder.stats();
+	}
+	auto t2 = std::chrono::high_resolution_clock::now();
+
+	auto per_frame = [&](std::chrono::high_resolution_clock::duration d) {
+		return std::chrono::duration<double, std::milli>(d).count() / frames;
+	};
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Prefetch decoder benchmark (" << width << "x" << height << ", synthetic source, batch " << batch << ")" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Read + clone per batch: " << per_frame(t1 - t0) << " ms/frame" << std::endl;
+	std::cout << "Prefetch ring:          " << per_frame(t2 - t1) << " ms/frame (decode " << stats.decode_ms / std::max<uint64_t>(1, stats.frames)
+		<< " ms/frame, consumer waited " << stats.consumer_wait_ms << " ms, " << stats.reallocations << " buffer allocations)" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+}
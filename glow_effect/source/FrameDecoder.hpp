@@ -0,0 +1,127 @@
+#ifndef FRAME_DECODER_HPP
+#define FRAME_DECODER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+/**
+ * @brief Decodes the next frame into slot, reusing its buffer when size and type match;
+ *        returns false at end of stream. Runs on the decoder thread.
+ */
+using DecodeFrameFn = std::function<bool(cv::Mat& slot)>;
+
+/**
+ * @brief A decoded frame lent out by PrefetchDecoder; valid until it is released.
+ */
+struct DecodedFrame {
+	uint64_t seq = 0;   ///< Sequence number in decode order (0, 1, ...).
+	int slot = -1;      ///< Ring slot holding the pixels.
+	cv::Mat frame;      ///< Shares the slot's pixels; do not keep it past release().
+};
+
+/**
+ * @brief Counters of a PrefetchDecoder.
+ */
+struct PrefetchDecoderStats {
+	uint64_t frames = 0;            ///< Frames decoded.
+	double decode_ms = 0.0;         ///< Total decode time on the decoder thread.
+	double consumer_wait_ms = 0.0;  ///< Time next() waited for a frame (decoder is the bottleneck).
+	double decoder_wait_ms = 0.0;   ///< Time the decoder waited for a free slot (ring is full).
+	uint64_t reallocations = 0;     ///< Decodes that had to (re)allocate a slot buffer.
+};
+
+/**
+ * @brief Decoder thread that reads ahead into a fixed ring of cv::Mat slots.
+ *
+ * The decoder fills the slots in ring order as long as they are free, so decode runs while
+ * the consumer segments and composites earlier frames. next() lends out the oldest decoded
+ * frame without copying it; release() hands its slot back for reuse. Slot buffers are
+ * allocated by the first decode into them and reused afterwards (cv::VideoCapture::read and
+ * the synthetic source both write into the existing buffer), so steady state allocates and
+ * copies nothing per frame.
+ *
+ * The consumer may hold up to slots - 1 frames at once; a batch of n frames needs a ring of
+ * more than n slots to keep decoding while the batch is processed.
+ */
+class PrefetchDecoder {
+public:
+	PrefetchDecoder(DecodeFrameFn decode, size_t slots);
+	~PrefetchDecoder();
+	PrefetchDecoder(const PrefetchDecoder&) = delete;
+	PrefetchDecoder& operator=(const PrefetchDecoder&) = delete;
+
+	/**
+	 * @brief Waits for the next frame in decode order.
+	 *
+	 * @return false at end of stream (or after stop()).
+	 */
+	bool next(DecodedFrame& out);
+
+	/** @brief Returns the frame's slot to the decoder; out.frame is reset. */
+	void release(DecodedFrame& frame);
+
+	/**
+	 * @brief Stops decoding and waits for the decoder thread, so the source can be closed.
+	 *        Frames still lent out stay valid until released or destruction.
+	 */
+	void stop();
+
+	size_t slots() const { return ring.size(); }
+
+	PrefetchDecoderStats stats() const;
+
+private:
+	enum class SlotState { Free, Decoding, Ready, Lent };
+
+	void run();
+
+	DecodeFrameFn decode;
+	std::vector<cv::Mat> ring;
+	std::vector<SlotState> state;
+	std::vector<uint64_t> slot_seq;
+	mutable std::mutex mutex;
+	std::condition_variable frame_ready;
+	std::condition_variable slot_free;
+	size_t write_slot = 0;     // next slot the decoder fills
+	size_t read_slot = 0;      // next slot next() lends out
+	bool end_of_stream = false;
+	bool stopping = false;
+	PrefetchDecoderStats counters;
+	std::thread thread;
+};
+
+/**
+ * @brief Decode source reading from an opened capture (must outlive the decoder).
+ */
+DecodeFrameFn capture_decode_source(cv::VideoCapture& video);
+
+/**
+ * @brief Decode source generating frame_count frames of a moving test pattern at size, so
+ *        the decoder stage can be checked and benchmarked without media files.
+ */
+DecodeFrameFn synthetic_decode_source(const cv::Size& size, int frame_count);
+
+/**
+ * @brief Headless check of PrefetchDecoder: every frame arrives once, in order, with its
+ *        sequence id; slot buffers are reused; stopping with a full ring does not hang.
+ *
+ * @return true if the check passed.
+ */
+bool verify_prefetch_decoder();
+
+/**
+ * @brief Times synchronous read + clone per batch against the prefetch ring on the
+ *        synthetic source, with the batch work simulated as a wait (as for TensorRT).
+ *
+ * @param width  Frame width (e.g. 1920).
+ * @param height Frame height (e.g. 1080).
+ */
+void benchmark_prefetch_decoder(int width, int height);
+
+#endif // FRAME_DECODER_HPP
@@ -0,0 +1,307 @@
+/**
+ * @file GlowCache.cpp
+ * @brief Incremental single-image glow render for slider updates.
+ */
+
+#include "GlowCache.hpp"
+#include "ImageCompare.hpp"
+#include "MipmapCPU.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+namespace {
+	// Smallest blur scale a pyramid is built for; smaller scales resample it.
+	const int kPyramidMinScale = 32;
+
+	int64_t modification_time(const std::string& path) {
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(path, ec);
+		return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+	}
+
+	// BGRA frame with a gradient and a few blocks, standing in for a loaded image.
+	cv::Mat make_source(const cv::Size& size) {
+		cv::Mat img(size, CV_8UC4);
+		for (int y = 0; y < size.height; ++y) {
+			cv::Vec4b* row = img.ptr<cv::Vec4b>(y);
+			for (int x = 0; x < size.width; ++x)
+				row[x] = cv::Vec4b(static_cast<uchar>(x * 255 / size.width), static_cast<uchar>(y * 255 / size.height),
+					static_cast<uchar>(((x / 16 + y / 16) % 2) * 200), 255);
+		}
+		return img;
+	}
+
+	// Class map with a key object and a second class.
+	cv::Mat make_mask(const cv::Size& size, int key_level, int other_level, int shift) {
+		cv::Mat mask(size, CV_8UC1, cv::Scalar(0));
+		const cv::Rect key(size.width / 3 + shift, size.height / 3, size.width / 6, size.height / 5);
+		const cv::Rect other(size.width / 10, size.height * 2 / 3, size.width / 8, size.height / 6);
+		for (int y = 0; y < size.height; ++y) {
+			uchar* row = mask.ptr<uchar>(y);
+			for (int x = 0; x < size.width; ++x) {
+				if (key.contains(cv::Point(x, y)))
+					row[x] = static_cast<uchar>(key_level);
+				else if (other.contains(cv::Point(x, y)))
+					row[x] = static_cast<uchar>(other_level);
+			}
+		}
+		return mask;
+	}
+
+	// CPU stages with the arithmetic of glow_blow and mix_images, for the check.
+	GlowStages reference_stages() {
+		GlowStages stages;
+		stages.load = [](const std::string&) { return make_source(cv::Size(320, 240)); };
+		stages.key = [](const RleMask& mask, int key_level, cv::Mat& dst_rgba, cv::Rect& region) {
+			dst_rgba = cv::Mat(mask.size(), CV_8UC4, cv::Scalar(0, 0, 0, 0));
+			KeyMatch match = mask.match_key(key_level, 10);
+			mask.paint_key(dst_rgba, key_level, 10, cv::Vec4b(128, 0, 128, 255));
+			region = match.box;
+			return match.pixels;
+		};
+		stages.pyramid = [](const cv::Mat& key_image, int, const cv::Rect& roi, const cv::Size& frame) {
+			return std::make_shared<MipmapPyramidCPU>(key_image, roi, frame);
+		};
+		stages.blend = [](const cv::Mat& src, const cv::Mat& dst, const cv::Mat& mipmap, cv::Mat& out, int key_scale) {
+			out.create(src.rows, src.cols, CV_8UC4);
+			for (int y = 0; y < src.rows; ++y) {
+				for (int x = 0; x < src.cols; ++x) {
+					int alpha = (mipmap.ptr<uchar>(y)[x] * key_scale) >> 8;
+					for (int k = 0; k < 4; ++k) {
+						int v = (src.ptr<cv::Vec4b>(y)[x][k] * (255 - alpha) + dst.ptr<cv::Vec4b>(y)[x][k] * alpha) >> 8;
+						out.ptr<cv::Vec4b>(y)[x][k] = static_cast<uchar>(std::min(255, std::max(0, v)));
+					}
+				}
+			}
+		};
+		return stages;
+	}
+}
+
+//--------------------------------------------------------------------------
+// GlowImageCache
+//--------------------------------------------------------------------------
+GlowImageCache::GlowImageCache(GlowStages stages) : stages(std::move(stages)) {}
+
+void GlowImageCache::clear() {
+	source_path.clear();
+	source_time = 0;
+	source.release();
+	mask_ref.release();
+	mask_rle = RleMask();
+	keys.clear();
+	pyramids.clear();
+	glows.clear();
+	output.release();
+	output_roi = cv::Rect();
+	output_valid = false;
+}
+
+void GlowImageCache::restore_output(const cv::Rect& roi) {
+	if (roi.area() > 0)
+		source(roi).copyTo(output(roi));
+}
+
+const cv::Mat& GlowImageCache::render(const std::string& image_path, const cv::Mat& mask, const GlowParams& params,
+	const GlowCancelFn& cancelled) {
+	static const cv::Mat none;
+	counters.renders++;
+
+	// source: everything downstream is sized by it.
+	const int64_t time = modification_time(image_path);
+	if (source.empty() || image_path != source_path || time != source_time) {
+		clear();
+		source_path = image_path;
+		source_time = time;
+		source = stages.load(image_path);
+		counters.loads++;
+		if (source.empty())
+			return output;
+	}
+
+	// mask
+	if (mask_ref.empty() || mask.data != mask_ref.data || mask.size() != mask_ref.size()) {
+		mask_ref = mask;
+		mask_rle = mask.empty() ? RleMask() : RleMask::encode(mask).resized(source.size());
+		if (mask_rle.empty())
+			mask_rle = RleMask::filled(source.size(), 0);
+		counters.encodes++;
+		keys.clear();
+		pyramids.clear();
+		glows.clear();
+		output_valid = false;
+	}
+
+	if (output_valid && params == output_params)
+		return output;
+
+	// key
+	KeyNode* key = keys.find(params.key_level);
+	if (!key) {
+		KeyNode node;
+		node.pixels = stages.key(mask_rle, params.key_level, node.dst_rgba, node.region);
+		counters.keys++;
+		key = &keys.insert(params.key_level, std::move(node));
+	}
+
+	// glow
+	if (cancelled && cancelled())
+		return none;
+	GlowNode* glow = nullptr;
+	if (key->pixels > 0) {
+		const std::pair<int, int> id(params.key_level, params.scale);
+		glow = glows.find(id);
+		if (!glow) {
+			PyramidNode* pyramid = pyramids.find(params.key_level);
+			if (!pyramid || !pyramid->pyramid || params.scale > pyramid->scale) {
+				PyramidNode node;
+				node.scale = std::max(kPyramidMinScale, 2 * params.scale);
+				node.roi = glow_roi(key->region, source.size(), static_cast<float>(node.scale));
+				node.pyramid = stages.pyramid(mask_rle.key_image(params.key_level, node.roi), params.key_level, node.roi,
+					source.size());
+				counters.pyramids++;
+				pyramid = &pyramids.insert(params.key_level, std::move(node));
+			}
+			GlowNode node;
+			node.roi = glow_roi(key->region, source.size(), static_cast<float>(params.scale));
+			if (pyramid->pyramid) {
+				PROFILE_ZONE("mipmap");
+				const cv::Rect offset(node.roi.x - pyramid->roi.x, node.roi.y - pyramid->roi.y, node.roi.width, node.roi.height);
+				node.mipmap = pyramid->pyramid->sample(static_cast<float>(params.scale), offset);
+			}
+			counters.mipmaps++;
+			glow = &glows.insert(id, std::move(node));
+		}
+	}
+
+	// output: only the glow ROI is blended; the previous ROI is restored where the new one does not cover it.
+	if (cancelled && cancelled())
+		return none;
+	const cv::Rect roi = (glow && !glow->mipmap.empty()) ? glow->roi : cv::Rect();
+	if (output.empty()) {
+		output = source.clone();
+		output_roi = cv::Rect();
+	}
+	if ((output_roi & roi) != output_roi)
+		restore_output(output_roi);
+	output_roi = cv::Rect();
+	if (roi.area() > 0) {
+		cv::Mat blended;
+		stages.blend(source(roi), key->dst_rgba(roi), glow->mipmap, blended, params.key_scale);
+		counters.blends++;
+		if (!blended.empty()) {
+			blended.copyTo(output(roi));
+			output_roi = roi;
+		}
+	}
+	output_valid = true;
+	output_params = params;
+	return output;
+}
+
+//--------------------------------------------------------------------------
+// verify_glow_cache
+//--------------------------------------------------------------------------
+bool verify_glow_cache() {
+	const GlowStages stages = reference_stages();
+	const cv::Size size = stages.load("").size();
+	const cv::Mat mask = make_mask(size, 96, 48, 0);
+	const cv::Mat moved = make_mask(size, 96, 48, 20);
+
+	struct Step {
+		const char* name;
+		GlowParams params;
+		const cv::Mat* mask;
+		GlowCacheStats expected;   // nodes recomputed by this step (renders unused)
+	};
+	const Step steps[] = {
+		{ "first render",      { 96, 600, 10 }, &mask,  { 0, 1, 1, 1, 1, 1, 1 } },
+		{ "key scale",         { 96, 300, 10 }, &mask,  { 0, 0, 0, 0, 0, 0, 1 } },
+		{ "unchanged",         { 96, 300, 10 }, &mask,  { 0, 0, 0, 0, 0, 0, 0 } },
+		{ "blur scale",        { 96, 300, 4 },  &mask,  { 0, 0, 0, 0, 0, 1, 1 } },
+		{ "larger blur scale", { 96, 300, 40 }, &mask,  { 0, 0, 0, 0, 1, 1, 1 } },
+		{ "blur scale down",   { 96, 300, 20 }, &mask,  { 0, 0, 0, 0, 0, 1, 1 } },
+		{ "key level",         { 48, 300, 4 },  &mask,  { 0, 0, 0, 1, 1, 1, 1 } },
+		{ "key level back",    { 96, 300, 4 },  &mask,  { 0, 0, 0, 0, 0, 0, 1 } },
+		{ "no key pixels",     { 200, 300, 4 }, &mask,  { 0, 0, 0, 1, 0, 0, 0 } },
+		{ "new mask",          { 96, 500, 10 }, &moved, { 0, 0, 1, 1, 1, 1, 1 } },
+	};
+
+	GlowImageCache cache(stages);
+	bool ok = true;
+	for (const Step& step : steps) {
+		const GlowCacheStats before = cache.stats();
+		const cv::Mat result = cache.render("check", *step.mask, step.params).clone();
+		const GlowCacheStats& after = cache.stats();
+		GlowImageCache fresh(stages);
+		const bool same = same_pixels(result, fresh.render("check", *step.mask, step.params));
+		const bool counts = after.loads - before.loads == step.expected.loads &&
+			after.encodes - before.encodes == step.expected.encodes && after.keys - before.keys == step.expected.keys &&
+			after.pyramids - before.pyramids == step.expected.pyramids && after.mipmaps - before.mipmaps == step.expected.mipmaps &&
+			after.blends - before.blends == step.expected.blends;
+		if (!same || !counts) {
+			std::cout << "  glow cache step '" << step.name << "': " << (same ? "" : "output differs ")
+				<< (counts ? "" : "unexpected recomputation") << std::endl;
+			ok = false;
+		}
+	}
+	std::cout << "Glow cache check: " << cache.stats().renders << " renders, " << cache.stats().keys << " key passes, "
+		<< cache.stats().pyramids << " pyramids, " << cache.stats().mipmaps << " mipmaps, " << cache.stats().blends << " blends: " << (ok ? "PASSED" : "FAILED")
+		<< std::endl;
+	return ok;
+}
+
+//--------------------------------------------------------------------------
+// benchmark_glow_cache
+//--------------------------------------------------------------------------
+void benchmark_glow_cache(GlowStages stages, int width, int height) {
+	using clock = std::chrono::high_resolution_clock;
+	const int iterations = 5;
+	const cv::Size size(std::max(64, width), std::max(64, height));
+	const cv::Mat frame = make_source(size);
+	const cv::Mat mask = make_mask(size, 96, 48, 0);
+	stages.load = [&](const std::string&) { return frame; };
+
+	auto ms = [](clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+	const GlowParams base{ 96, 600, 10 };
+
+	double full = 0.0;
+	for (int i = 0; i < iterations; ++i) {
+		GlowImageCache cold(stages);
+		auto t0 = clock::now();
+		cold.render("bench", mask, base);
+		full += ms(clock::now() - t0);
+	}
+
+	// One slider update from a warm cache.
+	auto time_updates = [&](GlowParams a, GlowParams b) {
+		double total = 0.0;
+		for (int i = 0; i < iterations; ++i) {
+			GlowImageCache warm(stages);
+			warm.render("bench", mask, a);
+			auto t0 = clock::now();
+			warm.render("bench", mask, b);
+			total += ms(clock::now() - t0);
+		}
+		return total / iterations;
+	};
+	const double key_scale = time_updates(base, GlowParams{ 96, 300, 10 });
+	const double scale = time_updates(base, GlowParams{ 96, 600, 6 });
+	const double scale_up = time_updates(base, GlowParams{ 96, 600, 48 });
+	const double key_level = time_updates(base, GlowParams{ 48, 600, 10 });
+
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Glow cache benchmark (" << size.width << "x" << size.height << ")" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Full render:        " << full / iterations << " ms" << std::endl;
+	std::cout << "Key scale update:   " << key_scale << " ms (blend only)" << std::endl;
+	std::cout << "Blur scale update:  " << scale << " ms (resample + blend)" << std::endl;
+	std::cout << "Scale past pyramid: " << scale_up << " ms (pyramid + resample + blend)" << std::endl;
+	std::cout << "Key level update:   " << key_level << " ms (key + pyramid + resample + blend)" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+}
@@ -0,0 +1,204 @@
+#ifndef GLOW_CACHE_HPP
+#define GLOW_CACHE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <opencv2/core.hpp>
+
+#include "RleMask.hpp"
+
+class MipmapPyramid;
+
+/**
+ * @brief The slider-controlled glow parameters of one render.
+ */
+struct GlowParams {
+	int key_level = 96;    ///< Mask value that glows (key level slider).
+	int key_scale = 600;   ///< Blend strength (key scale slider).
+	int scale = 10;        ///< Mipmap blur scale (default scale slider).
+
+	bool operator==(const GlowParams& o) const {
+		return key_level == o.key_level && key_scale == o.key_scale && scale == o.scale;
+	}
+	bool operator!=(const GlowParams& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Image load, loaded as the BGRA layout mix_images outputs (CV_8UC4); empty on failure.
+ */
+using GlowLoadFn = std::function<cv::Mat(const std::string& path)>;
+
+/**
+ * @brief Key pass: overlay (CV_8UC4, mask size), key bounding box, matching pixel count (see glow_blow).
+ */
+using GlowKeyFn = std::function<int(const RleMask& mask, int key_level, cv::Mat& dst_rgba, cv::Rect& region)>;
+
+/**
+ * @brief Mipmap pyramid of a keyed ROI image (RleMask::key_image) placed at roi in a frame of size
+ *        frame; sampling it at a blur scale gives the mipmap (see MipmapPyramid). Null or empty
+ *        if it cannot be built.
+ */
+using GlowPyramidFn = std::function<std::shared_ptr<MipmapPyramid>(const cv::Mat& key_image, int key_level,
+	const cv::Rect& roi, const cv::Size& frame)>;
+
+/**
+ * @brief Blend of source and overlay ROIs through the mipmap (see mix_images).
+ */
+using GlowBlendFn = std::function<void(const cv::Mat& src_rgba, const cv::Mat& dst_rgba, const cv::Mat& mipmap,
+	cv::Mat& output, int key_scale)>;
+
+/**
+ * @brief Polled between render stages; true means the result is no longer wanted.
+ */
+using GlowCancelFn = std::function<bool()>;
+
+/**
+ * @brief The expensive stages of a glow render; glow_effect.cpp supplies the real ones
+ *        (default_glow_stages), checks and benchmarks substitute their own.
+ */
+struct GlowStages {
+	GlowLoadFn load;
+	GlowKeyFn key;
+	GlowPyramidFn pyramid;
+	GlowBlendFn blend;
+};
+
+/**
+ * @brief How often each node of GlowImageCache was (re)computed.
+ */
+struct GlowCacheStats {
+	uint64_t renders = 0;    ///< render() calls.
+	uint64_t loads = 0;      ///< Source images loaded.
+	uint64_t encodes = 0;    ///< Masks run-length encoded and scaled to the source.
+	uint64_t keys = 0;       ///< Key passes (glow_blow).
+	uint64_t pyramids = 0;   ///< Mipmap pyramids built from a keyed ROI.
+	uint64_t mipmaps = 0;    ///< Pyramid samples at a blur scale.
+	uint64_t blends = 0;     ///< ROI blends into the output.
+};
+
+/**
+ * @brief Dependency cache of a single-image glow render for interactive parameter changes.
+ *
+ * Nodes and what they depend on:
+ * - source: image path (and file modification time), loaded once as BGRA;
+ * - mask: the cv::Mat passed in (by data pointer; masks are treated as immutable), encoded once;
+ * - key: mask and key level (a few levels are kept, so toggling between them is free);
+ * - pyramid: key, the mipmap pyramid of the glow ROI of a blur scale with headroom;
+ * - glow: pyramid and blur scale, the pyramid sampled over that scale's glow ROI (a few scales
+ *   are kept per key);
+ * - output: glow and key scale.
+ *
+ * A render recomputes only the nodes whose inputs changed. A blur-scale change resamples the
+ * kept pyramid; it is rebuilt only when the new scale's ROI outgrows it, at twice that scale,
+ * so a scale scrub builds a handful of pyramids at most. A key-scale change is a blend of
+ * the glow ROI into the output, which is updated in place: outside the ROI it already holds
+ * the source. Not thread-safe; the GUI callbacks serialize on state_mutex.
+ */
+class GlowImageCache {
+public:
+	explicit GlowImageCache(GlowStages stages);
+
+	/**
+	 * @brief Renders image_path with the glow of mask under params.
+	 *
+	 * @param cancelled Optional; polled before the mipmap and the blend. Once it returns true
+	 *                  the render stops; the nodes finished so far stay cached for the next one.
+	 * @return The glowed image (CV_8UC4), or an empty cv::Mat if the image cannot be loaded or
+	 *         the render was cancelled. Valid until the next render() or clear(); copy it to keep it.
+	 */
+	const cv::Mat& render(const std::string& image_path, const cv::Mat& mask, const GlowParams& params,
+		const GlowCancelFn& cancelled = nullptr);
+
+	/** @brief Drops every cached node. */
+	void clear();
+
+	const GlowCacheStats& stats() const { return counters; }
+
+private:
+	struct KeyNode {
+		cv::Mat dst_rgba;
+		cv::Rect region;
+		int pixels = 0;
+	};
+
+	struct PyramidNode {
+		cv::Rect roi;        // glow ROI the pyramid was built on
+		int scale = 0;       // largest blur scale whose glow ROI fits in roi
+		std::shared_ptr<MipmapPyramid> pyramid;
+	};
+
+	struct GlowNode {
+		cv::Rect roi;
+		cv::Mat mipmap;
+	};
+
+	// Tiny most-recently-used list; a handful of entries, so lookups are linear.
+	template<typename K, typename V>
+	class RecentCache {
+	public:
+		explicit RecentCache(size_t capacity) : capacity(capacity) {}
+		V* find(const K& key) {
+			for (auto it = entries.begin(); it != entries.end(); ++it) {
+				if (it->first == key) {
+					entries.splice(entries.begin(), entries, it);
+					return &entries.front().second;
+				}
+			}
+			return nullptr;
+		}
+		V& insert(const K& key, V value) {
+			entries.emplace_front(key, std::move(value));
+			if (entries.size() > capacity)
+				entries.pop_back();
+			return entries.front().second;
+		}
+		void clear() { entries.clear(); }
+	private:
+		size_t capacity;
+		std::list<std::pair<K, V>> entries;
+	};
+
+	void restore_output(const cv::Rect& roi);
+
+	GlowStages stages;
+	GlowCacheStats counters;
+
+	// source
+	std::string source_path;
+	int64_t source_time = 0;
+	cv::Mat source;
+	// mask
+	cv::Mat mask_ref;   // keeps the identity of the encoded mask alive
+	RleMask mask_rle;
+	// key / glow
+	RecentCache<int, KeyNode> keys{ 4 };
+	RecentCache<int, PyramidNode> pyramids{ 4 };
+	RecentCache<std::pair<int, int>, GlowNode> glows{ 8 };
+	// output
+	cv::Mat output;
+	cv::Rect output_roi;        // region of output that differs from source
+	bool output_valid = false;
+	GlowParams output_params;
+};
+
+/**
+ * @brief Headless check of GlowImageCache: per slider change, only the dependent nodes are
+ *        recomputed and the output equals an uncached render.
+ *
+ * @return true if the check passed.
+ */
+bool verify_glow_cache();
+
+/**
+ * @brief Times full renders against the per-slider incremental updates of GlowImageCache.
+ *
+ * @param stages Stages to time (typically default_glow_stages()); the load stage is replaced
+ *               by a synthetic width x height frame.
+ */
+void benchmark_glow_cache(GlowStages stages, int width, int height);
+
+#endif // GLOW_CACHE_HPP
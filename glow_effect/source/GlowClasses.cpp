@@ -0,0 +1,391 @@
+/**
+ * @file GlowClasses.cpp
+ * @brief Multi-class glow: per-class table, one key pass, one blur per distinct scale.
+ */
+
+#include "GlowClasses.hpp"
+#include "ImageCompare.hpp"
+#include "MipmapCPU.hpp"
+#include "Profiler.hpp"
+#include "movie_effect/include/tools_task.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+namespace {
+	cv::Rect unite(const cv::Rect& a, const cv::Rect& b) {
+		if (a.area() <= 0)
+			return b;
+		if (b.area() <= 0)
+			return a;
+		const int x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+		const int x1 = std::max(a.x + a.width, b.x + b.width), y1 = std::max(a.y + a.height, b.y + b.height);
+		return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+	}
+
+	bool parse_int(const std::string& text, int& value) {
+		if (text.empty())
+			return false;
+		char* end = nullptr;
+		const long v = std::strtol(text.c_str(), &end, 10);
+		if (*end != '\0' || v < 0 || v > 65535)
+			return false;
+		value = static_cast<int>(v);
+		return true;
+	}
+
+	std::vector<std::string> split(const std::string& text, char separator) {
+		std::vector<std::string> parts;
+		std::stringstream stream(text);
+		std::string part;
+		while (std::getline(stream, part, separator))
+			parts.push_back(part);
+		return parts;
+	}
+
+	// Class map with one rectangle per level, placed relative to the frame size.
+	cv::Mat make_class_mask(const cv::Size& size) {
+		struct Blob {
+			float x, y, w, h;
+			int level;
+		};
+		const Blob blobs[] = {
+			{ 0.12f, 0.16f, 0.19f, 0.21f, 48 },
+			{ 0.40f, 0.25f, 0.12f, 0.33f, 60 },
+			{ 0.69f, 0.62f, 0.16f, 0.17f, 12 },
+			{ 0.06f, 0.71f, 0.12f, 0.12f, 24 },
+		};
+		cv::Mat mask(size, CV_8UC1, cv::Scalar(0));
+		for (const Blob& b : blobs) {
+			const cv::Rect rect(static_cast<int>(b.x * size.width), static_cast<int>(b.y * size.height),
+				static_cast<int>(b.w * size.width), static_cast<int>(b.h * size.height));
+			for (int y = rect.y; y < rect.y + rect.height; ++y)
+				for (int x = rect.x; x < rect.x + rect.width; ++x)
+					if ((x * 3 + y) % 13)   // ragged interior, so the runs are not one per row
+						mask.ptr<uchar>(y)[x] = static_cast<uchar>(b.level);
+		}
+		return mask;
+	}
+
+	cv::Mat make_frame(const cv::Size& size) {
+		cv::Mat frame(size, CV_8UC3);
+		for (int y = 0; y < size.height; ++y)
+			for (int x = 0; x < size.width; ++x)
+				frame.ptr<cv::Vec3b>(y)[x] = cv::Vec3b(static_cast<uchar>(x * 255 / size.width),
+					static_cast<uchar>(y * 255 / size.height), static_cast<uchar>((x + y) % 256));
+		return frame;
+	}
+
+	std::vector<cv::Mat> cpu_mipmaps(const GlowClassKey& key) {
+		std::vector<cv::Mat> mipmaps(key.layers.size());
+		for (size_t i = 0; i < key.layers.size(); ++i)
+			filter_mipmap_cpu(key.layers[i].key_image, mipmaps[i], static_cast<float>(key.layers[i].scale), key.layers[i].roi,
+				key.dst_rgba.size());
+		return mipmaps;
+	}
+
+	// blend_glow_roi with the per-pixel arithmetic of mix_images, for the check.
+	cv::Mat reference_blend(const cv::Mat& src, const cv::Mat& dst_rgba, const cv::Mat& mipmap, const cv::Rect& roi, int key_scale) {
+		cv::Mat out(src.size(), CV_8UC4);
+		for (int y = 0; y < src.rows; ++y) {
+			for (int x = 0; x < src.cols; ++x) {
+				const cv::Vec3b& s = src.ptr<cv::Vec3b>(y)[x];
+				cv::Vec4b p(s[0], s[1], s[2], 255);
+				if (roi.contains(cv::Point(x, y))) {
+					const uchar alpha = static_cast<uchar>((mipmap.ptr<uchar>(y - roi.y)[x - roi.x] * key_scale) >> 8);
+					const cv::Vec4b& d = dst_rgba.ptr<cv::Vec4b>(y)[x];
+					for (int k = 0; k < 4; ++k)
+						p[k] = static_cast<uchar>(std::min(255, (p[k] * (255 - alpha) + d[k] * alpha) >> 8));
+				}
+				out.ptr<cv::Vec4b>(y)[x] = p;
+			}
+		}
+		return out;
+	}
+}
+
+//--------------------------------------------------------------------------
+// key_glow_classes
+//--------------------------------------------------------------------------
+GlowClassKey key_glow_classes(const RleMask& mask, const GlowClassTable& table, int delta) {
+	PROFILE_ZONE("glow_blow");
+	GlowClassKey key;
+	key.matches.resize(table.size());
+	if (mask.empty())
+		return key;
+	key.dst_rgba = cv::Mat(mask.size(), CV_8UC4, cv::Scalar(0, 0, 0, 0));
+
+	// Mask value -> nearest enabled class within delta.
+	int class_of[256];
+	for (int v = 0; v < 256; ++v) {
+		class_of[v] = -1;
+		int best = delta;
+		for (size_t c = 0; c < table.size(); ++c) {
+			const int distance = std::abs(v - table[c].level);
+			if (table[c].enabled && distance < best) {
+				best = distance;
+				class_of[v] = static_cast<int>(c);
+			}
+		}
+	}
+	std::vector<cv::Vec4b> colors;
+	for (const GlowClass& c : table)
+		colors.push_back(c.color);
+	key.matches = mask.paint_classes(key.dst_rgba, class_of, colors);
+
+	// Classes with key pixels, one layer per blur scale.
+	std::map<int, std::vector<int>> by_scale;
+	for (size_t c = 0; c < table.size(); ++c) {
+		key.pixels += key.matches[c].pixels;
+		if (key.matches[c].pixels > 0)
+			by_scale[table[c].scale].push_back(static_cast<int>(c));
+	}
+	for (const auto& group : by_scale) {
+		GlowLayer layer;
+		layer.scale = group.first;
+		cv::Rect region;
+		for (int c : group.second) {
+			region = unite(region, key.matches[c].box);
+			layer.gain = std::max(layer.gain, table[c].intensity);
+		}
+		if (layer.gain <= 0)
+			continue;
+		uint8_t lut[256] = {};
+		for (int c : group.second) {
+			const int level = table[c].level;
+			if (level > 0 && level < 256)
+				lut[level] = static_cast<uint8_t>((level * table[c].intensity + layer.gain / 2) / layer.gain);
+		}
+		layer.roi = glow_roi(region, mask.size(), static_cast<float>(layer.scale));
+		layer.key_image = mask.key_image(lut, layer.roi);
+		if (!layer.key_image.empty())
+			key.layers.push_back(std::move(layer));
+	}
+	return key;
+}
+
+//--------------------------------------------------------------------------
+// blend_glow_layers
+//--------------------------------------------------------------------------
+void blend_glow_layers(const cv::Mat& src_img, const GlowClassKey& key, const std::vector<cv::Mat>& mipmaps, cv::Mat& output_image) {
+	PROFILE_ZONE("mix");
+	const int cn = src_img.channels();
+	if (src_img.empty() || src_img.depth() != CV_8U || (cn != 3 && cn != 4)) {
+		std::cerr << "Error: blend_glow_layers expects a BGR or BGRA frame." << std::endl;
+		return;
+	}
+	const cv::Rect frame(0, 0, src_img.cols, src_img.rows);
+	const bool has_overlay = key.dst_rgba.size() == src_img.size() && key.dst_rgba.type() == CV_8UC4;
+
+	// Layers that can be blended, and the area they cover.
+	std::vector<size_t> usable;
+	cv::Rect area;
+	for (size_t i = 0; i < key.layers.size() && i < mipmaps.size() && has_overlay; ++i) {
+		const cv::Rect& roi = key.layers[i].roi;
+		if (mipmaps[i].empty() || mipmaps[i].depth() != CV_8U || mipmaps[i].size() != roi.size() || (roi & frame) != roi)
+			continue;
+		usable.push_back(i);
+		area = unite(area, roi);
+	}
+
+	output_image.create(src_img.rows, src_img.cols, CV_8UC4);
+	task::parallel_rows(src_img.rows, [&](int row_begin, int row_end) {
+		std::vector<int> alpha(area.width);
+		for (int y = row_begin; y < row_end; ++y) {
+			const uchar* src_row = src_img.ptr<uchar>(y);
+			cv::Vec4b* out_row = output_image.ptr<cv::Vec4b>(y);
+			for (int x = 0; x < src_img.cols; ++x) {
+				const uchar* s = src_row + x * cn;
+				out_row[x] = cv::Vec4b(s[0], s[1], s[2], cn == 4 ? s[3] : 255);
+			}
+			if (y < area.y || y >= area.y + area.height)
+				continue;
+
+			std::fill(alpha.begin(), alpha.end(), 0);
+			for (size_t i : usable) {
+				const GlowLayer& layer = key.layers[i];
+				if (y < layer.roi.y || y >= layer.roi.y + layer.roi.height)
+					continue;
+				// The GPU mipmap is gray RGBA (v, v, v, a); its first channel is the gray value.
+				const cv::Mat& mipmap = mipmaps[i];
+				const int mcn = mipmap.channels();
+				const uchar* m = mipmap.ptr<uchar>(y - layer.roi.y);
+				int* a = alpha.data() + (layer.roi.x - area.x);
+				for (int x = 0; x < layer.roi.width; ++x)
+					a[x] += (m[x * mcn] * layer.gain) >> 8;
+			}
+
+			const cv::Vec4b* dst_row = key.dst_rgba.ptr<cv::Vec4b>(y);
+			for (int x = area.x; x < area.x + area.width; ++x) {
+				const int a = std::min(255, alpha[x - area.x]);
+				cv::Vec4b& p = out_row[x];
+				for (int k = 0; k < 4; ++k)
+					p[k] = static_cast<uchar>(std::min(255, (p[k] * (255 - a) + dst_row[x][k] * a) >> 8));
+			}
+		}
+	});
+}
+
+//--------------------------------------------------------------------------
+// parse_glow_classes
+//--------------------------------------------------------------------------
+bool parse_glow_classes(const std::string& spec, GlowClassTable& table) {
+	if (spec == "slider" || spec == "none") {
+		table.clear();
+		return true;
+	}
+	GlowClassTable parsed;
+	for (const std::string& entry : split(spec, ';')) {
+		const std::vector<std::string> fields = split(entry, ':');
+		GlowClass glow;
+		int index = 0;
+		if (fields.empty() || fields.size() > 4 || !parse_int(fields[0], index) || index * kClassLevelStep > 255)
+			return false;
+		glow.level = index * kClassLevelStep;
+		if (fields.size() > 1) {
+			const std::vector<std::string> bgr = split(fields[1], ',');
+			int channel[3];
+			if (bgr.size() != 3)
+				return false;
+			for (int k = 0; k < 3; ++k)
+				if (!parse_int(bgr[k], channel[k]) || channel[k] > 255)
+					return false;
+			glow.color = cv::Vec4b(static_cast<uchar>(channel[0]), static_cast<uchar>(channel[1]),
+				static_cast<uchar>(channel[2]), 255);
+		}
+		if (fields.size() > 2 && !parse_int(fields[2], glow.scale))
+			return false;
+		if (fields.size() > 3 && !parse_int(fields[3], glow.intensity))
+			return false;
+		parsed.push_back(glow);
+	}
+	if (parsed.empty())
+		return false;
+	table = parsed;
+	return true;
+}
+
+//--------------------------------------------------------------------------
+// verify_glow_classes
+//--------------------------------------------------------------------------
+bool verify_glow_classes() {
+	const cv::Size size(320, 240);
+	const cv::Mat frame = make_frame(size);
+	const RleMask mask = RleMask::encode(make_class_mask(size));
+	const cv::Vec4b purple(128, 0, 128, 255), cyan(255, 255, 0, 255), orange(0, 128, 255, 255);
+
+	// A one-class table is the single-class glow: glow_blow, ROI mipmap, mix_images.
+	GlowClassTable single{ GlowClass{ 48, true, purple, 10, 600 } };
+	GlowClassKey key = key_glow_classes(mask, single, 10);
+	cv::Mat result;
+	blend_glow_layers(frame, key, cpu_mipmaps(key), result);
+
+	cv::Mat overlay(size, CV_8UC4, cv::Scalar(0, 0, 0, 0));
+	const KeyMatch match = mask.match_key(48, 10);
+	mask.paint_key(overlay, 48, 10, purple);
+	const cv::Rect roi = glow_roi(match.box, size, 10.0f);
+	cv::Mat mipmap;
+	filter_mipmap_cpu(mask.key_image(48, roi), mipmap, 10.0f, roi, size);
+	bool single_ok = key.layers.size() == 1 && key.pixels == match.pixels &&
+		same_pixels(result, reference_blend(frame, overlay, mipmap, roi, 600));
+
+	// Three classes in two scales plus a disabled one.
+	GlowClassTable table{
+		GlowClass{ 48, true, purple, 10, 600 },
+		GlowClass{ 60, true, cyan, 10, 300 },
+		GlowClass{ 12, true, orange, 4, 500 },
+		GlowClass{ 24, false, purple, 10, 600 },
+	};
+	key = key_glow_classes(mask, table, 5);
+	bool multi_ok = key.layers.size() == 2 && key.layers[0].scale == 4 && key.layers[1].scale == 10 &&
+		key.layers[1].gain == 600 && key.matches[3].pixels == 0;
+	overlay = cv::Mat(size, CV_8UC4, cv::Scalar(0, 0, 0, 0));
+	for (size_t c = 0; c < 3; ++c) {
+		const KeyMatch expected = mask.match_key(table[c].level, 5);
+		multi_ok = multi_ok && key.matches[c].pixels == expected.pixels && key.matches[c].box == expected.box;
+		mask.paint_key(overlay, table[c].level, 5, table[c].color);
+	}
+	multi_ok = multi_ok && same_pixels(key.dst_rgba, overlay);
+
+	// The merged blur of the scale-10 layer against one blur per class.
+	int max_alpha_difference = 0;
+	if (multi_ok) {
+		const GlowLayer& layer = key.layers[1];
+		cv::Mat merged, first, second;
+		filter_mipmap_cpu(layer.key_image, merged, 10.0f, layer.roi, size);
+		filter_mipmap_cpu(mask.key_image(48, layer.roi), first, 10.0f, layer.roi, size);
+		filter_mipmap_cpu(mask.key_image(60, layer.roi), second, 10.0f, layer.roi, size);
+		for (int y = 0; y < merged.rows; ++y) {
+			for (int x = 0; x < merged.cols; ++x) {
+				const int a = std::min(255, (merged.ptr<uchar>(y)[x] * layer.gain) >> 8);
+				const int b = std::min(255, ((first.ptr<uchar>(y)[x] * 600) >> 8) + ((second.ptr<uchar>(y)[x] * 300) >> 8));
+				max_alpha_difference = std::max(max_alpha_difference, std::abs(a - b));
+			}
+		}
+		cv::Mat blended;
+		blend_glow_layers(frame, key, cpu_mipmaps(key), blended);
+		multi_ok = multi_ok && blended.size() == size && max_alpha_difference <= 3;
+	}
+
+	GlowClassTable parsed;
+	const bool parse_ok = parse_glow_classes("4:128,0,128:10:600;5:255,255,0:4", parsed) && parsed.size() == 2 &&
+		parsed[1].level == 5 * kClassLevelStep && parsed[1].scale == 4 && parsed[1].intensity == 600 &&
+		!parse_glow_classes("4:1,2:10", parsed) && !parse_glow_classes("30", parsed) && parsed.size() == 2;
+
+	const bool ok = single_ok && multi_ok && parse_ok;
+	std::cout << "Glow classes check: one-class table " << (single_ok ? "matches" : "DIFFERS from")
+		<< " the single-class glow, 3 classes in " << key.layers.size() << " blurs, max merged/per-class alpha difference "
+		<< max_alpha_difference << ": " << (ok ? "PASSED" : "FAILED") << std::endl;
+	return ok;
+}
+
+//--------------------------------------------------------------------------
+// benchmark_glow_classes
+//--------------------------------------------------------------------------
+void benchmark_glow_classes(int width, int height) {
+	using clock = std::chrono::high_resolution_clock;
+	const int iterations = 5;
+	const cv::Size size(std::max(64, width), std::max(64, height));
+	const cv::Mat frame = make_frame(size);
+	const RleMask mask = RleMask::encode(make_class_mask(size));
+	const GlowClassTable table{
+		GlowClass{ 48, true, cv::Vec4b(128, 0, 128, 255), 10, 600 },
+		GlowClass{ 60, true, cv::Vec4b(255, 255, 0, 255), 10, 300 },
+		GlowClass{ 12, true, cv::Vec4b(0, 128, 255, 255), 4, 500 },
+	};
+
+	auto render = [&](const cv::Mat& src, const GlowClassTable& classes) {
+		GlowClassKey key = key_glow_classes(mask, classes, 10);
+		cv::Mat out;
+		blend_glow_layers(src, key, cpu_mipmaps(key), out);
+		return out;
+	};
+	auto per_frame = [&](clock::duration d) { return std::chrono::duration<double, std::milli>(d).count() / iterations; };
+
+	auto t0 = clock::now();
+	for (int i = 0; i < iterations; ++i)
+		render(frame, GlowClassTable{ table[0] });
+	auto t1 = clock::now();
+	for (int i = 0; i < iterations; ++i)
+		render(frame, table);
+	auto t2 = clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		cv::Mat out = frame;
+		for (const GlowClass& c : table)
+			out = render(out, GlowClassTable{ c });
+	}
+	auto t3 = clock::now();
+
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Glow classes benchmark (" << size.width << "x" << size.height << ", CPU mipmap)" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "One class:             " << per_frame(t1 - t0) << " ms/frame" << std::endl;
+	std::cout << "Three classes, 1 pass: " << per_frame(t2 - t1) << " ms/frame (2 blurs)" << std::endl;
+	std::cout << "Three single passes:   " << per_frame(t3 - t2) << " ms/frame" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+}
@@ -0,0 +1,106 @@
+#ifndef GLOW_CLASSES_HPP
+#define GLOW_CLASSES_HPP
+
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "RleMask.hpp"
+
+/** @brief Mask value step between segmentation classes (class index * 255 / 21, see argmax_class_masks). */
+const int kClassLevelStep = 255 / 21;
+
+/**
+ * @brief How one segmentation class glows.
+ */
+struct GlowClass {
+	int level = 96;                                  ///< Mask value of the class (class index * kClassLevelStep).
+	bool enabled = true;                             ///< Disabled classes get neither overlay nor glow.
+	cv::Vec4b color = cv::Vec4b(128, 0, 128, 255);   ///< Overlay color (BGRA), glow_blow's by default.
+	int scale = 10;                                  ///< Mipmap blur scale.
+	int intensity = 600;                             ///< Blend strength, like the key scale slider.
+};
+
+/**
+ * @brief Per-class glow lookup table. Empty means the single class of the key level slider.
+ */
+using GlowClassTable = std::vector<GlowClass>;
+
+/**
+ * @brief One blur of a multi-class glow: the enabled classes that share a blur scale.
+ *
+ * The classes are keyed into one image, each at level * intensity / gain, so one mipmap
+ * times gain gives every class its own strength. With equal intensities this is the keyed
+ * image and key scale of a single-class glow.
+ */
+struct GlowLayer {
+	int scale = 0;       ///< Blur scale of the layer's classes.
+	int gain = 0;        ///< Blend strength of the layer's mipmap (largest intensity of its classes).
+	cv::Rect roi;        ///< glow_roi of the union of the classes' key boxes.
+	cv::Mat key_image;   ///< Mipmap input over roi (CV_8UC1).
+};
+
+/**
+ * @brief Result of the key pass of a multi-class glow.
+ */
+struct GlowClassKey {
+	cv::Mat dst_rgba;                ///< Overlay of every matching class (CV_8UC4, mask size).
+	std::vector<KeyMatch> matches;   ///< Key statistics, one per table entry.
+	std::vector<GlowLayer> layers;   ///< One per distinct blur scale with key pixels, by ascending scale.
+	int pixels = 0;                  ///< Matching pixels of all classes.
+};
+
+/**
+ * @brief Keys every enabled class of table in one pass over the runs of mask.
+ *
+ * A mask value belongs to the enabled class with the nearest level within delta (the first
+ * one on a tie); its pixels get that class's overlay color. Classes of equal blur scale are
+ * merged into one layer, so the glow costs one mipmap per distinct scale, not per class.
+ *
+ * @param mask  Class map at frame size.
+ * @param table Classes to glow.
+ * @param delta Overlay tolerance around each level, as in glow_blow.
+ */
+GlowClassKey key_glow_classes(const RleMask& mask, const GlowClassTable& table, int delta);
+
+/**
+ * @brief Blends the glow layers of a key pass into the source.
+ *
+ * The alpha of a pixel is the saturating sum of mipmap * gain / 256 over the layers; the blend
+ * is the arithmetic of mix_images. Only the union of the layer ROIs is blended, the rest of the
+ * frame is the source converted to BGRA. A single layer gives exactly the single-class glow.
+ *
+ * @param src_img      Source frame (BGR or BGRA).
+ * @param key          Key pass of the frame.
+ * @param mipmaps      Mipmap of each layer's key_image (CV_8UC1, or the gray RGBA of the GPU path).
+ * @param output_image Destination (CV_8UC4).
+ */
+void blend_glow_layers(const cv::Mat& src_img, const GlowClassKey& key, const std::vector<cv::Mat>& mipmaps, cv::Mat& output_image);
+
+/**
+ * @brief Parses a class table from "class:B,G,R:scale:intensity;..." (trailing fields optional).
+ *
+ * class is the segmentation class index; "slider" or "none" gives an empty table.
+ *
+ * @return false (table unchanged) if the text is malformed.
+ */
+bool parse_glow_classes(const std::string& spec, GlowClassTable& table);
+
+/**
+ * @brief Headless check of the multi-class glow: a one-class table reproduces the single-class
+ *        glow exactly, a multi-class table keys and paints like one pass per class and merges
+ *        equal scales into one blur.
+ *
+ * @return true if the check passed.
+ */
+bool verify_glow_classes();
+
+/**
+ * @brief Times one, three classes in one pass and three single-class passes (CPU mipmap).
+ *
+ * @param width  Frame width (e.g. 3840).
+ * @param height Frame height (e.g. 2160).
+ */
+void benchmark_glow_classes(int width, int height);
+
+#endif // GLOW_CLASSES_HPP
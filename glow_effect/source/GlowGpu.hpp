@@ -0,0 +1,65 @@
+#ifndef GLOW_GPU_HPP
+#define GLOW_GPU_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "AdaptiveBatcher.hpp"   // BatchBounds
+#include "MipmapCPU.hpp"         // MipmapPyramid
+
+/**
+ * @brief GPU backends of the glow paths in GlowRender.cpp: CUDA mipmaps and TensorRT segmentation.
+ *
+ * Implemented in glow_effect.cpp; GlowGpuStub.cpp stands in for builds without CUDA and
+ * TensorRT, where the CPU mipmap and the CPU segmenter are the only backends.
+ */
+
+/**
+ * @brief Segmentation of one batch: one mask per frame, the batch split into num_contexts
+ *        concurrent sub-batches where the backend supports it.
+ */
+typedef std::function<std::vector<cv::Mat>(const std::vector<cv::Mat>& frames, int num_contexts)> SegmentFramesFn;
+
+/**
+ * @brief true if this build has the GPU backends; otherwise the glow paths use the CPU ones.
+ */
+bool gpu_backends_available();
+
+/**
+ * @brief Triple buffered CUDA mipmaps of keyed images, image i at scales[i]; result i has the
+ *        size of key_images[i].
+ */
+std::vector<cv::Mat> gpu_glow_mipmaps(const std::vector<cv::Mat>& key_images, const std::vector<float>& scales, int key_level);
+
+/**
+ * @brief MipmapPyramidCuda of a keyed grayscale image; nullptr without the GPU backends.
+ */
+std::shared_ptr<MipmapPyramid> make_gpu_mipmap_pyramid(const cv::Mat& key_image, int param_KeyLevel);
+
+/**
+ * @brief TensorRT entry point of the video paths.
+ */
+enum class TrtSegmentation {
+	Concurrent,   ///< measure_segmentation_trt_performance_mul_concurrent
+	Graph         ///< measure_segmentation_trt_performance_mul_concurrent_graph (CUDA Graph)
+};
+
+/**
+ * @brief Loads a plan into the engine registry (TRTInference::acquire_engine).
+ *
+ * @return false if the plan cannot be deserialized or the build has no TensorRT.
+ */
+bool load_trt_plan(const std::string& planFilePath);
+
+/**
+ * @brief TensorRT segmentation of a plan through the given entry point.
+ *
+ * @param bounds Receives the batch limits of the plan's engine.
+ * @return Empty if the build has no TensorRT.
+ */
+SegmentFramesFn make_trt_segmenter(const std::string& planFilePath, TrtSegmentation path, BatchBounds& bounds);
+
+#endif // GLOW_GPU_HPP
@@ -0,0 +1,29 @@
+/**
+ * @file GlowGpuStub.cpp
+ * @brief GlowGpu.hpp for builds without CUDA and TensorRT (the pipeline_bench target).
+ */
+
+#include "GlowGpu.hpp"
+
+#include <iostream>
+
+bool gpu_backends_available() {
+	return false;
+}
+
+std::vector<cv::Mat> gpu_glow_mipmaps(const std::vector<cv::Mat>& key_images, const std::vector<float>&, int) {
+	return std::vector<cv::Mat>(key_images.size());
+}
+
+std::shared_ptr<MipmapPyramid> make_gpu_mipmap_pyramid(const cv::Mat&, int) {
+	return nullptr;
+}
+
+bool load_trt_plan(const std::string& planFilePath) {
+	std::cerr << "Error: This build has no TensorRT; cannot load " << planFilePath << " (use the plan \"cpu\")." << std::endl;
+	return false;
+}
+
+SegmentFramesFn make_trt_segmenter(const std::string&, TrtSegmentation, BatchBounds&) {
+	return nullptr;
+}
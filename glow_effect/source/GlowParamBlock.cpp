@@ -0,0 +1,145 @@
+/**
+ * @file GlowParamBlock.cpp
+ * @brief Wait-free parameter block shared by the GUI and the render paths.
+ */
+
+#include "GlowParamBlock.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+	const int kKeyLevelShift = 0;
+	const int kKeyScaleShift = 8;
+	const int kScaleShift = 24;
+	const int kButtonShift = 40;
+
+	uint64_t field(int value, int bits, int shift) {
+		const int max_value = (1 << bits) - 1;
+		return static_cast<uint64_t>(std::min(std::max(value, 0), max_value)) << shift;
+	}
+
+	int unfield(uint64_t word, int bits, int shift) {
+		return static_cast<int>((word >> shift) & ((uint64_t(1) << bits) - 1));
+	}
+
+	uint64_t pack_params(const GlowParams& params) {
+		return field(params.key_level, 8, kKeyLevelShift) | field(params.key_scale, 16, kKeyScaleShift) |
+			field(params.scale, 16, kScaleShift);
+	}
+
+	const uint64_t kParamsMask = (uint64_t(1) << kButtonShift) - 1;
+}
+
+//--------------------------------------------------------------------------
+// GlowParamBlock
+//--------------------------------------------------------------------------
+GlowParamBlock::GlowParamBlock(const GlowParams& initial) : word(pack_params(initial)) {}
+
+GlowParamSnapshot GlowParamBlock::snapshot() const {
+	GlowParamSnapshot snap;
+	snap.version = changes.load(std::memory_order_acquire);
+	const uint64_t w = word.load(std::memory_order_acquire);
+	snap.glow.key_level = unfield(w, 8, kKeyLevelShift);
+	snap.glow.key_scale = unfield(w, 16, kKeyScaleShift);
+	snap.glow.scale = unfield(w, 16, kScaleShift);
+	for (int i = 0; i < 5; ++i)
+		snap.button_state[i] = (w >> (kButtonShift + i)) & 1;
+	return snap;
+}
+
+template<typename Update>
+void GlowParamBlock::modify(Update&& update) {
+	uint64_t current = word.load(std::memory_order_relaxed);
+	while (!word.compare_exchange_weak(current, update(current), std::memory_order_release, std::memory_order_relaxed)) {
+	}
+	changes.fetch_add(1, std::memory_order_release);
+}
+
+void GlowParamBlock::set(const GlowParams& params) {
+	modify([&](uint64_t w) { return (w & ~kParamsMask) | pack_params(params); });
+}
+
+void GlowParamBlock::set_key_level(int value) {
+	modify([&](uint64_t w) { return (w & ~field(0xff, 8, kKeyLevelShift)) | field(value, 8, kKeyLevelShift); });
+}
+
+void GlowParamBlock::set_key_scale(int value) {
+	modify([&](uint64_t w) { return (w & ~field(0xffff, 16, kKeyScaleShift)) | field(value, 16, kKeyScaleShift); });
+}
+
+void GlowParamBlock::set_scale(int value) {
+	modify([&](uint64_t w) { return (w & ~field(0xffff, 16, kScaleShift)) | field(value, 16, kScaleShift); });
+}
+
+void GlowParamBlock::set_button(int index, bool on) {
+	if (index < 0 || index >= 5)
+		return;
+	const uint64_t bit = uint64_t(1) << (kButtonShift + index);
+	modify([&](uint64_t w) { return on ? (w | bit) : (w & ~bit); });
+}
+
+//--------------------------------------------------------------------------
+// verify_param_block
+//--------------------------------------------------------------------------
+bool verify_param_block() {
+	// Every written set satisfies key_scale == 3 * key_level and scale == key_level % 100 + 1,
+	// so a snapshot mixing two writes would break the relation.
+	auto make_set = [](int i) { return GlowParams{ i % 256, 3 * (i % 256), (i % 256) % 100 + 1 }; };
+	auto consistent = [](const GlowParams& p) {
+		return p.key_scale == 3 * p.key_level && p.scale == p.key_level % 100 + 1;
+	};
+
+	GlowParamBlock block(make_set(0));
+	const int writes = 200000;
+	std::atomic<bool> ok{ true };
+	std::atomic<bool> done{ false };
+	std::atomic<uint64_t> reads{ 0 };
+
+	std::vector<std::thread> readers;
+	for (int r = 0; r < 2; ++r) {
+		readers.emplace_back([&] {
+			uint64_t last_version = 0;
+			uint64_t count = 0;
+			while (!done.load()) {
+				GlowParamSnapshot snap = block.snapshot();
+				if (!consistent(snap.glow) || snap.version < last_version)
+					ok = false;
+				last_version = snap.version;
+				count++;
+			}
+			reads += count;
+		});
+	}
+	std::thread buttons([&] {
+		for (int i = 0; i < writes / 10; ++i)
+			block.set_button(i % 5, (i / 5) % 2 == 0);
+	});
+	for (int i = 1; i <= writes; ++i)
+		block.set(make_set(i));
+	buttons.join();
+	done = true;
+	for (std::thread& reader : readers)
+		reader.join();
+
+	// Last button pass (i = writes/10 - 5 .. writes/10 - 1) switched every button to the same state.
+	const bool last_on = ((writes / 10 - 1) / 5) % 2 == 0;
+	GlowParamSnapshot final_snap = block.snapshot();
+	bool buttons_ok = true;
+	for (int i = 0; i < 5; ++i)
+		buttons_ok = buttons_ok && final_snap.button_state[i] == last_on;
+	const bool passed = ok && buttons_ok && final_snap.glow == make_set(writes) &&
+		final_snap.version == static_cast<uint64_t>(writes + writes / 10);
+
+	// Clamping to the packed ranges.
+	GlowParamBlock clamped(GlowParams{ 300, -5, 70000 });
+	GlowParamSnapshot c = clamped.snapshot();
+	const bool clamp_ok = c.glow.key_level == 255 && c.glow.key_scale == 0 && c.glow.scale == 65535;
+
+	std::cout << "Parameter block check: " << writes + writes / 10 << " writes, " << reads.load()
+		<< " concurrent snapshots, no torn or out-of-order reads: " << (passed && clamp_ok ? "PASSED" : "FAILED")
+		<< std::endl;
+	return passed && clamp_ok;
+}
@@ -0,0 +1,67 @@
+#ifndef GLOW_PARAM_BLOCK_HPP
+#define GLOW_PARAM_BLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "GlowCache.hpp"
+
+/**
+ * @brief One consistent set of the GUI-controlled glow parameters.
+ */
+struct GlowParamSnapshot {
+	GlowParams glow;                  ///< Key level, key scale and blur scale.
+	bool button_state[5] = {};        ///< Mipmap texture filter toggles (see get_mipmap in mipmap.cu).
+	uint64_t version = 0;             ///< Version the snapshot is at least as new as.
+};
+
+/**
+ * @brief Parameter block written by the GUI and read by the render and video paths.
+ *
+ * All parameters live in one 64-bit atomic word (key level 8 bits, key scale 16, blur scale
+ * 16, five button bits), so a snapshot is a single atomic load: wait-free, and never a mix of
+ * two updates. Writers are serialized by a compare-and-swap loop. Values are clamped to the
+ * slider ranges that fit the word (key level 0-255, scales 0-65535).
+ *
+ * version() increases after every change. A snapshot's version is read before its values,
+ * so its values are never older than its version: a cache keyed on the version may render
+ * once more than needed but never misses a change.
+ */
+class GlowParamBlock {
+public:
+	explicit GlowParamBlock(const GlowParams& initial = GlowParams());
+
+	/** @brief Wait-free copy of every parameter. */
+	GlowParamSnapshot snapshot() const;
+
+	/** @brief Number of changes so far. */
+	uint64_t version() const { return changes.load(std::memory_order_acquire); }
+
+	void set(const GlowParams& params);
+	void set_key_level(int value);
+	void set_key_scale(int value);
+	void set_scale(int value);
+	void set_button(int index, bool on);
+
+private:
+	template<typename Update>
+	void modify(Update&& update);
+
+	std::atomic<uint64_t> word;
+	std::atomic<uint64_t> changes{ 0 };
+};
+
+/**
+ * @brief The application's glow parameters (sliders and filter buttons).
+ */
+extern GlowParamBlock glow_params;
+
+/**
+ * @brief Headless check of GlowParamBlock: concurrent writers and readers, every snapshot
+ *        must be one written set and versions must never go backwards.
+ *
+ * @return true if the check passed.
+ */
+bool verify_param_block();
+
+#endif // GLOW_PARAM_BLOCK_HPP
@@ -0,0 +1,931 @@
+/**
+ * @file GlowRender.cpp
+ * @brief The glow on the CPU side: keying, compositing and the video paths, with the GPU
+ *        backends reached through GlowGpu.hpp.
+ */
+
+#include "GlowRender.hpp"
+#include "GlowGpu.hpp"
+#include "AdaptiveBatcher.hpp"
+#include "CpuSegmenter.hpp"
+#include "MaskPropagation.hpp"
+#include "MaskStore.hpp"
+#include "Profiler.hpp"
+#include "SceneDetector.hpp"
+#include "VideoEncoder.hpp"
+#include "VideoPipeline.hpp"
+#include "movie_effect/include/tools_task.h"  // Shared work-stealing scheduler
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+namespace fs = std::filesystem;
+
+// Mipmap backend of the glow paths (GPU unless switched to the CPU fallback).
+MipmapBackend mipmap_backend = MipmapBackend::Cuda;
+
+// Glowing classes of the video paths; empty until main sets a table.
+GlowClassTable glow_classes;
+
+// Outputs of the video paths; the AVI alone until main selects a raw stream.
+VideoOutputOptions video_output;
+
+// Latency reports of the video paths; the final table only until main sets options.
+LatencyOptions latency_options;
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Function: compute_glow_mipmaps
+////////////////////////////////////////////////////////////////////////////////
+// Mipmaps of the keyed ROI images (RleMask::key_image, glow layers) with the selected backend,
+// image i at scales[i]; result i has the size of key_images[i]. Image i is the part rois[i] of a
+// frame of size frame_sizes[i]; the CPU backend builds on that frame's level grid, so its result
+// equals the full-frame mipmap there. The images are already keyed, so the CPU backend filters
+// them as they are. A build without the GPU backends (GlowGpu.hpp) always takes the CPU one.
+static std::vector<cv::Mat> compute_glow_mipmaps(const std::vector<cv::Mat>& key_images, const std::vector<float>& scales,
+	int key_level, const std::vector<cv::Rect>& rois, const std::vector<cv::Size>& frame_sizes) {
+	PROFILE_ZONE("mipmap");
+	if (mipmap_backend == MipmapBackend::Cpu || !gpu_backends_available()) {
+		std::vector<cv::Mat> results(key_images.size());
+		for (size_t i = 0; i < key_images.size(); ++i)
+			filter_mipmap_cpu(key_images[i], results[i], scales[i], rois[i], frame_sizes[i]);
+		return results;
+	}
+	return gpu_glow_mipmaps(key_images, scales, key_level);
+}
+
+std::vector<cv::Mat> compute_glow_mipmaps(const std::vector<cv::Mat>& key_images, const GlowParams& params,
+	const std::vector<cv::Rect>& rois, const std::vector<cv::Size>& frame_sizes) {
+	return compute_glow_mipmaps(key_images, std::vector<float>(key_images.size(), static_cast<float>(params.scale)),
+		params.key_level, rois, frame_sizes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Function: frame_mask_rle
+////////////////////////////////////////////////////////////////////////////////
+// Run-length encodes a segmentation mask and scales it to the frame on the runs;
+// a missing or unusable mask gives a blank one.
+RleMask frame_mask_rle(const cv::Mat& mask, const cv::Size& targetSize, int frame_index) {
+	RleMask rle = mask.empty() ? RleMask() : RleMask::encode(mask).resized(targetSize);
+	if (rle.empty()) {
+		std::cerr << "Warning: No usable segmentation mask for frame " << frame_index << ". Using blank mask." << std::endl;
+		rle = RleMask::filled(targetSize, 0);
+	}
+	return rle;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Function: report_target_region
+////////////////////////////////////////////////////////////////////////////////
+static void report_target_region(int target_pixel_count, double frame_pixels, const cv::Rect& box) {
+	double coverage_percent = (static_cast<double>(target_pixel_count) / frame_pixels) * 100.0;
+	std::cout << "Target region found!" << std::endl;
+	std::cout << "  - Pixels matching target: " << target_pixel_count << " (" << coverage_percent << "% of frame)" << std::endl;
+	std::cout << "  - Region bounding box: (" << box.x << "," << box.y << ") to (" << box.x + box.width - 1 << ","
+		<< box.y + box.height - 1 << ")" << std::endl;
+	std::cout << "  - Box dimensions: " << box.width << "x" << box.height << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: glow_blow
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+// Function: glow_blow
+////////////////////////////////////////////////////////////////////////////////
+int glow_blow(const cv::Mat& mask, cv::Mat& dst_rgba, int param_KeyLevel, int Delta, cv::Rect* region) {
+	PROFILE_ZONE("glow_blow");
+	if (region)
+		*region = cv::Rect();
+	if (mask.empty()) {
+		std::cerr << "Error: Segmentation mask is empty." << std::endl;
+		return 0;
+	}
+	if (mask.type() != CV_8UC1) {
+		std::cerr << "Error: Mask is not of type CV_8UC1." << std::endl;
+		return 0;
+	}
+
+	// Create a destination image with zeros
+	dst_rgba = cv::Mat::zeros(mask.size(), CV_8UC4);
+
+	// Use a more vibrant color for better visibility
+	cv::Vec4b overlay_color = { 128, 0, 128, 255 };
+
+	// Variables to track target region information
+	bool has_target_region = false;
+	int target_pixel_count = 0;
+	int min_x = mask.cols, max_x = 0;
+	int min_y = mask.rows, max_y = 0;
+	std::mutex region_mutex;
+
+	// Process the mask in row bands; each band tracks its own region and merges it at the end
+	task::parallel_rows(mask.rows, [&](int row_begin, int row_end) {
+		int band_count = 0;
+		int band_min_x = mask.cols, band_max_x = 0;
+		int band_min_y = mask.rows, band_max_y = 0;
+
+		for (int i = row_begin; i < row_end; ++i) {
+			const uchar* mask_row = mask.ptr<uchar>(i);
+			cv::Vec4b* dst_row = dst_rgba.ptr<cv::Vec4b>(i);
+			for (int j = 0; j < mask.cols; ++j) {
+				int mask_pixel = mask_row[j];
+
+				if (std::abs(mask_pixel - param_KeyLevel) < Delta) {
+					band_count++;
+
+					// Track bounding box of target region
+					band_min_x = std::min(band_min_x, j);
+					band_max_x = std::max(band_max_x, j);
+					band_min_y = std::min(band_min_y, i);
+					band_max_y = std::max(band_max_y, i);
+
+					// Apply overlay ONLY to pixels that match the target value
+					dst_row[j] = overlay_color;
+				}
+			}
+		}
+
+		if (band_count > 0) {
+			std::lock_guard<std::mutex> lock(region_mutex);
+			has_target_region = true;
+			target_pixel_count += band_count;
+			min_x = std::min(min_x, band_min_x);
+			max_x = std::max(max_x, band_max_x);
+			min_y = std::min(min_y, band_min_y);
+			max_y = std::max(max_y, band_max_y);
+		}
+	});
+
+	// Print the target region information that was specifically requested
+	if (has_target_region) {
+		cv::Rect box(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1);
+		report_target_region(target_pixel_count, static_cast<double>(mask.rows) * mask.cols, box);
+		if (region)
+			*region = box;
+	}
+	return target_pixel_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: glow_blow (run-length encoded mask)
+////////////////////////////////////////////////////////////////////////////////
+int glow_blow(const RleMask& mask, cv::Mat& dst_rgba, int param_KeyLevel, int Delta, cv::Rect* region) {
+	PROFILE_ZONE("glow_blow");
+	if (region)
+		*region = cv::Rect();
+	if (mask.empty()) {
+		std::cerr << "Error: Segmentation mask is empty." << std::endl;
+		return 0;
+	}
+
+	dst_rgba = cv::Mat::zeros(mask.size(), CV_8UC4);
+	KeyMatch match = mask.match_key(param_KeyLevel, Delta);
+	if (match.pixels == 0)
+		return 0;
+
+	mask.paint_key(dst_rgba, param_KeyLevel, Delta, cv::Vec4b(128, 0, 128, 255));
+	report_target_region(match.pixels, static_cast<double>(mask.rows()) * mask.cols(), match.box);
+	if (region)
+		*region = match.box;
+	return match.pixels;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: make_mipmap_pyramid
+////////////////////////////////////////////////////////////////////////////////
+std::shared_ptr<MipmapPyramid> make_mipmap_pyramid(const cv::Mat& key_image, int param_KeyLevel, const cv::Rect& roi,
+	const cv::Size& frame) {
+	PROFILE_ZONE("mipmap");
+	if (mipmap_backend == MipmapBackend::Cpu || !gpu_backends_available())
+		return std::make_shared<MipmapPyramidCPU>(key_image, roi, frame);   // key_image is already keyed
+	return make_gpu_mipmap_pyramid(key_image, param_KeyLevel);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: mix_images
+////////////////////////////////////////////////////////////////////////////////
+void mix_images(const cv::Mat& src_img, const cv::Mat& dst_rgba, const cv::Mat& mipmap_result, cv::Mat& output_image, float param_KeyScale) {
+	PROFILE_ZONE("mix");
+	if (src_img.empty() || dst_rgba.empty() || mipmap_result.empty()) {
+		std::cerr << "Error: One or more input images are empty." << std::endl;
+		return;
+	}
+	if (src_img.size() != dst_rgba.size() || src_img.size() != mipmap_result.size()) {
+		std::cerr << "Error: Images must have the same dimensions." << std::endl;
+		return;
+	}
+
+	cv::Mat src_rgba;
+	if (src_img.channels() != 4)
+		cv::cvtColor(src_img, src_rgba, cv::COLOR_BGR2BGRA);
+	else
+		src_rgba = src_img.clone();
+
+	cv::Mat high_lighted_rgba;
+	if (dst_rgba.channels() != 4)
+		cv::cvtColor(dst_rgba, high_lighted_rgba, cv::COLOR_BGR2BGRA);
+	else
+		high_lighted_rgba = dst_rgba.clone();
+
+	cv::Mat mipmap_gray;
+	if (mipmap_result.channels() != 1)
+		cv::cvtColor(mipmap_result, mipmap_gray, cv::COLOR_BGR2GRAY);
+	else
+		mipmap_gray = mipmap_result.clone();
+
+	output_image.create(src_rgba.size(), CV_8UC4);
+
+	task::parallel_rows(src_rgba.rows, [&](int row_begin, int row_end) {
+		for (int i = row_begin; i < row_end; ++i) {
+			const uchar* alpha_row = mipmap_gray.ptr<uchar>(i);
+			const cv::Vec4b* src_row = src_rgba.ptr<cv::Vec4b>(i);
+			const cv::Vec4b* dst_row = high_lighted_rgba.ptr<cv::Vec4b>(i);
+			cv::Vec4b* out_row = output_image.ptr<cv::Vec4b>(i);
+			for (int j = 0; j < src_rgba.cols; ++j) {
+				uchar original_alpha = alpha_row[j];
+				uchar alpha = (original_alpha * static_cast<int>(param_KeyScale)) >> 8;
+				const cv::Vec4b& src_pixel = src_row[j];
+				const cv::Vec4b& dst_pixel = dst_row[j];
+				cv::Vec4b& output_pixel = out_row[j];
+				for (int k = 0; k < 4; ++k) {
+					int temp_pixel = (src_pixel[k] * (255 - alpha) + dst_pixel[k] * alpha) >> 8;
+					output_pixel[k] = static_cast<uchar>(std::min(255, std::max(0, temp_pixel)));
+				}
+			}
+		}
+	});
+
+	std::cout << "mix_images: Image blending completed successfully." << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: pass_through_frame
+////////////////////////////////////////////////////////////////////////////////
+void pass_through_frame(const cv::Mat& src_img, cv::Mat& output_image) {
+	if (src_img.channels() == 4)
+		output_image = src_img.clone();
+	else if (src_img.channels() == 1)
+		cv::cvtColor(src_img, output_image, cv::COLOR_GRAY2BGRA);
+	else
+		cv::cvtColor(src_img, output_image, cv::COLOR_BGR2BGRA);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Function: blend_glow_roi
+////////////////////////////////////////////////////////////////////////////////
+// mix_images restricted to roi (mipmap_roi has the size of roi); outside it the source is
+// passed through, where the full-frame mipmap would be zero anyway.
+void blend_glow_roi(const cv::Mat& src_img, const cv::Mat& dst_rgba, const cv::Mat& mipmap_roi, const cv::Rect& roi,
+	int key_scale, cv::Mat& output_image) {
+	if (roi == cv::Rect(0, 0, src_img.cols, src_img.rows)) {
+		mix_images(src_img, dst_rgba, mipmap_roi, output_image, static_cast<float>(key_scale));
+		return;
+	}
+	if (src_img.size() != dst_rgba.size() || (roi & cv::Rect(0, 0, src_img.cols, src_img.rows)) != roi) {
+		std::cerr << "Error: Glow ROI does not fit the frame." << std::endl;
+		return;
+	}
+	pass_through_frame(src_img, output_image);
+	cv::Mat blended;
+	mix_images(src_img(roi), dst_rgba(roi), mipmap_roi, blended, static_cast<float>(key_scale));
+	if (!blended.empty())
+		blended.copyTo(output_image(roi));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: default_glow_stages
+////////////////////////////////////////////////////////////////////////////////
+GlowStages default_glow_stages() {
+	GlowStages stages;
+	stages.load = [](const std::string& path) {
+		cv::Mat src_img = cv::imread(path);
+		cv::Mat src_rgba;
+		if (!src_img.empty())
+			pass_through_frame(src_img, src_rgba);
+		return src_rgba;
+	};
+	stages.key = [](const RleMask& mask, int key_level, cv::Mat& dst_rgba, cv::Rect& region) {
+		int pixels = glow_blow(mask, dst_rgba, key_level, 10, &region);
+		if (pixels == 0)
+			std::cout << "No pixels match key level " << key_level << "; showing the source image." << std::endl;
+		return pixels;
+	};
+	stages.pyramid = make_mipmap_pyramid;
+	stages.blend = [](const cv::Mat& src_rgba, const cv::Mat& dst_rgba, const cv::Mat& mipmap, cv::Mat& output, int key_scale) {
+		mix_images(src_rgba, dst_rgba, mipmap, output, static_cast<float>(key_scale));
+	};
+	return stages;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Function: composite_glow_classes_batch
+////////////////////////////////////////////////////////////////////////////////
+// composite_glow_batch with a class table: one key pass per mask keys every class, and the
+// layers of all frames (one per distinct blur scale) are filtered as one mipmap batch.
+static std::vector<cv::Mat> composite_glow_classes_batch(const std::vector<cv::Mat>& frames, const std::vector<cv::Mat>& masks,
+	const cv::Size& defaultSize, const GlowClassTable& classes, GlowBatchStats* stats) {
+	const int count = static_cast<int>(frames.size());
+	std::vector<cv::Size> mask_sizes(count);
+	std::vector<int> key_index(count, -1);   // frame -> entry of keys, -1 without glow
+	std::vector<GlowClassKey> keys;          // key pass of each unique mask
+	std::vector<size_t> first_layer;         // key -> its first entry in key_images
+	std::vector<cv::Mat> key_images;
+	std::vector<float> scales;
+	std::vector<cv::Rect> layer_rois;
+	std::vector<cv::Size> layer_frames;
+
+	for (int i = 0; i < count; ++i) {
+		cv::Size targetSize = (frames[i].empty() || frames[i].cols <= 0 || frames[i].rows <= 0)
+			? defaultSize : frames[i].size();
+
+		// Same mask object as the previous frame: same key pass, same mipmaps.
+		if (i > 0 && i < static_cast<int>(masks.size()) && !masks[i].empty() && masks[i].data == masks[i - 1].data &&
+			mask_sizes[i - 1] == targetSize) {
+			mask_sizes[i] = targetSize;
+			key_index[i] = key_index[i - 1];
+			if (stats)
+				stats->glow_reused++;
+			continue;
+		}
+
+		RleMask frame_mask = frame_mask_rle(i < static_cast<int>(masks.size()) ? masks[i] : cv::Mat(), targetSize, i);
+		mask_sizes[i] = targetSize;
+		GlowClassKey key = key_glow_classes(frame_mask, classes, 10);
+		if (key.layers.empty())
+			continue;
+		key_index[i] = static_cast<int>(keys.size());
+		first_layer.push_back(key_images.size());
+		for (const GlowLayer& layer : key.layers) {
+			key_images.push_back(layer.key_image);
+			scales.push_back(static_cast<float>(layer.scale));
+			layer_rois.push_back(layer.roi);
+			layer_frames.push_back(targetSize);
+		}
+		keys.push_back(std::move(key));
+	}
+
+	// The layers are already keyed at their own levels.
+	std::vector<cv::Mat> mipmap_results = compute_glow_mipmaps(key_images, scales, -1, layer_rois, layer_frames);
+
+	std::vector<cv::Mat> outputs(count);
+	for (int i = 0; i < count; ++i) {
+		cv::Mat final_result;
+		if (key_index[i] < 0) {
+			if (!frames[i].empty())
+				pass_through_frame(frames[i], final_result);
+			if (stats)
+				stats->glow_skipped++;
+		}
+		else {
+			const GlowClassKey& key = keys[key_index[i]];
+			const auto first = mipmap_results.begin() + first_layer[key_index[i]];
+			blend_glow_layers(frames[i], key, std::vector<cv::Mat>(first, first + key.layers.size()), final_result);
+		}
+		if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
+			std::cerr << "Warning: Final blended image is empty for frame " << i
+				<< ". Creating blank output." << std::endl;
+			final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
+		}
+		outputs[i] = final_result;
+	}
+	if (stats)
+		stats->frames += count;
+	return outputs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Function: composite_glow_batch
+////////////////////////////////////////////////////////////////////////////////
+std::vector<cv::Mat> composite_glow_batch(const std::vector<cv::Mat>& frames, const std::vector<cv::Mat>& masks, const cv::Size& defaultSize,
+	GlowBatchStats* stats, const GlowClassTable& classes) {
+	if (!classes.empty())
+		return composite_glow_classes_batch(frames, masks, defaultSize, classes, stats);
+
+	// One parameter set for every stage of every frame in the batch, whatever the GUI does meanwhile.
+	const GlowParams params = glow_params.snapshot().glow;
+	const int count = static_cast<int>(frames.size());
+	std::vector<cv::Size> mask_sizes(count);
+	std::vector<cv::Mat> glow_blow_results(count);
+	std::vector<int> mipmap_index(count, -1);   // frame -> entry of key_images, -1 without key pixels
+	std::vector<cv::Mat> key_images;             // keyed glow ROI of each unique mask
+	std::vector<cv::Rect> unique_rois;           // glow ROI of each unique mask
+	std::vector<cv::Size> unique_frames;         // frame size of each unique mask
+
+	for (int i = 0; i < count; ++i) {
+		cv::Size targetSize = (frames[i].empty() || frames[i].cols <= 0 || frames[i].rows <= 0)
+			? defaultSize : frames[i].size();
+
+		// Same mask object as the previous frame: same key, same glow, same mipmap.
+		if (i > 0 && i < static_cast<int>(masks.size()) && !masks[i].empty() && masks[i].data == masks[i - 1].data &&
+			mask_sizes[i - 1] == targetSize) {
+			mask_sizes[i] = targetSize;
+			glow_blow_results[i] = glow_blow_results[i - 1];
+			mipmap_index[i] = mipmap_index[i - 1];
+			if (stats)
+				stats->glow_reused++;
+			continue;
+		}
+
+		RleMask frame_mask = frame_mask_rle(i < static_cast<int>(masks.size()) ? masks[i] : cv::Mat(), targetSize, i);
+		mask_sizes[i] = targetSize;
+
+		// No key pixels: the mipmap would be empty, so the frame is not queued for it.
+		cv::Mat dst_rgba;
+		cv::Rect region;
+		if (glow_blow(frame_mask, dst_rgba, params.key_level, 10, &region) == 0)
+			continue;
+		cv::Rect roi = glow_roi(region, targetSize, static_cast<float>(params.scale));
+		glow_blow_results[i] = dst_rgba;
+		mipmap_index[i] = static_cast<int>(key_images.size());
+		key_images.push_back(frame_mask.key_image(params.key_level, roi));
+		unique_rois.push_back(roi);
+		unique_frames.push_back(targetSize);
+	}
+
+	std::vector<cv::Mat> mipmap_results = compute_glow_mipmaps(key_images, params, unique_rois, unique_frames);
+
+	std::vector<cv::Mat> outputs(count);
+	for (int i = 0; i < count; ++i) {
+		cv::Mat final_result;
+		if (mipmap_index[i] < 0) {
+			if (!frames[i].empty())
+				pass_through_frame(frames[i], final_result);
+			if (stats)
+				stats->glow_skipped++;
+		}
+		else {
+			blend_glow_roi(frames[i], glow_blow_results[i], mipmap_results[mipmap_index[i]], unique_rois[mipmap_index[i]],
+				params.key_scale, final_result);
+		}
+		if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
+			std::cerr << "Warning: Final blended image is empty for frame " << i
+				<< ". Creating blank output." << std::endl;
+			final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
+		}
+		outputs[i] = final_result;
+	}
+	if (stats)
+		stats->frames += count;
+	return outputs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Function: make_segment_backend
+////////////////////////////////////////////////////////////////////////////////
+// Segmentation of run_glow_video: the TensorRT plan through the given entry point, or the CPU
+// color-rule segmenter when the plan is "cpu" (no engine needed, e.g. for segment workers on CPU
+// nodes). bounds receives the batch limits the AdaptiveBatcher may choose from. Empty if the
+// plan cannot be used.
+static SegmentFramesFn make_segment_backend(const std::string& planFilePath, TrtSegmentation path, BatchBounds& bounds) {
+	if (planFilePath == "cpu") {
+		bounds = BatchBounds{ 1, 8, 8, true, 1 };
+		return [](const std::vector<cv::Mat>& frames, int) { return segment_frames_cpu(frames); };
+	}
+	return make_trt_segmenter(planFilePath, path, bounds);
+}
+
+// Timing totals of one run_glow_video call.
+struct GlowVideoTiming {
+	bool completed = false;
+	uint64_t frames = 0;
+	uint64_t frames_segmented = 0;
+	uint64_t frames_from_store = 0;
+	uint64_t glow_reused = 0;
+	uint64_t glow_skipped = 0;
+	double total_time = 0.0;
+	double segmentation_time = 0.0;
+	double post_processing_time = 0.0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Function: open_video_output
+////////////////////////////////////////////////////////////////////////////////
+// Starts the encoder thread on the outputs selected in output: the MJPG writer at
+// avi_path, the raw Y4M / rawvideo sink, or both. Both are owned by the encoder thread
+// and closed by encoder.close().
+bool open_video_output(AsyncFrameEncoder& encoder, const std::string& avi_path, double fps, const cv::Size& size,
+	const VideoOutputOptions& output) {
+	if (output.raw_path.empty()) {
+		if (encoder.open(avi_path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, size))
+			return true;
+		std::cerr << "Error: Could not open the output video for writing: " << avi_path << std::endl;
+		return false;
+	}
+
+	auto raw = std::make_shared<RawVideoSink>();
+	if (!raw->open(output.raw_path, output.raw_format, size, fps)) {
+		std::cerr << "Error: Could not open the raw video output: " << output.raw_path << std::endl;
+		return false;
+	}
+	std::shared_ptr<cv::VideoWriter> avi;
+	if (output.avi) {
+		avi = std::make_shared<cv::VideoWriter>(avi_path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, size);
+		if (!avi->isOpened()) {
+			std::cerr << "Error: Could not open the output video for writing: " << avi_path << std::endl;
+			return false;
+		}
+	}
+	std::cout << "Raw video output: " << (output.raw_path == "-" ? "stdout" : output.raw_path) << std::endl;
+	encoder.start([raw, avi](const cv::Mat& bgr) {
+		if (avi)
+			avi->write(bgr);
+		return raw->write(bgr);
+	});
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helper Function: run_glow_video
+////////////////////////////////////////////////////////////////////////////////
+// Shared body of glow_effect_video and glow_effect_video_graph. Each batch owns its
+// frames and is segmented and composited as one task; results reach the display/writer
+// in frame order through the pipeline's reorder buffer. Batch size and context count
+// are chosen per batch by an AdaptiveBatcher (throughput mode) from measured timings.
+// With keyframe propagation every frame is scored by a SceneChangeDetector on the reader
+// thread; batches end at scene cuts, only the keyframes of a batch go through TensorRT,
+// the other masks are propagated on the CPU before glow_blow, and static frames reuse
+// the glow of their predecessor.
+// The masks do not depend on the glow parameters, so they are kept in a sidecar store at
+// mask_store_path. A store written for the same clip, plan and keyframe interval replaces
+// segmentation on re-renders (batches it does not cover are still segmented); otherwise
+// this run writes one.
+// Encoding runs on an AsyncFrameEncoder thread; the batch tasks convert their outputs to
+// BGR, so the sink only displays and queues frames.
+// Frame latency is kept in histograms: end-to-end from the read of a frame until the sink
+// takes it, decode per frame, segmentation and glow per batch and the encoder queue wait.
+// output, classes and report_options are passed in so that batch jobs can run side by side;
+// range limits the run to part of the clip (segment workers); a null window_name renders headless.
+static GlowVideoTiming run_glow_video(const char* video_nm, const std::string& planFilePath, TrtSegmentation segmentation,
+	const MaskPropagationConfig& propagation, const std::string& output_video_path, const std::string& mask_store_path,
+	const VideoOutputOptions& output, const GlowClassTable& classes, const LatencyOptions& report_options,
+	const char* window_name, const FrameRange& range = FrameRange()) {
+	GlowVideoTiming timing;
+	auto total_start = std::chrono::high_resolution_clock::now();
+
+	cv::VideoCapture video;
+	if (!video.open(video_nm, cv::VideoCaptureAPIs::CAP_ANY)) {
+		std::cerr << "Error: Could not open video file: " << video_nm << std::endl;
+		return timing;
+	}
+
+	int frame_width = static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH));
+	int frame_height = static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
+	double fps = video.get(cv::CAP_PROP_FPS);   // 29.97 stays 30000/1001 in the Y4M header
+
+	cv::Size defaultSize((frame_width > 0) ? frame_width : 640, (frame_height > 0) ? frame_height : 360);
+	if (range.first > 0 && !video.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(range.first))) {
+		std::cerr << "Error: Could not seek to frame " << range.first << " of " << video_nm << std::endl;
+		return timing;
+	}
+	BatchBounds bounds;
+	SegmentFramesFn segment_frames = make_segment_backend(planFilePath, segmentation, bounds);
+	if (!segment_frames) {
+		std::cerr << "Error: This build cannot segment with " << planFilePath << " (no TensorRT; use the plan \"cpu\")" << std::endl;
+		return timing;
+	}
+
+	if (!fs::exists("./VideoOutput/")) {
+		if (fs::create_directory("./VideoOutput/"))
+			std::cout << "Video Output Directory successfully created." << std::endl;
+		else {
+			std::cerr << "Failed to create video output folder." << std::endl;
+			return timing;
+		}
+	}
+	else {
+		std::cout << "Video Output Directory already exists." << std::endl;
+	}
+
+	AsyncFrameEncoder encoder;
+	if (!open_video_output(encoder, output_video_path, fps, defaultSize, output))
+		return timing;
+
+	std::string store_tag = std::string(video_nm) + "|" + planFilePath + "|k=" +
+		std::to_string(propagation.keyframe_interval);
+	if (range.first > 0 || range.count >= 0)
+		store_tag += "|frames=" + std::to_string(range.first) + "+" + std::to_string(range.count);
+	MaskStoreReader stored_masks;
+	MaskStoreWriter mask_writer;
+	const bool masks_stored = stored_masks.open(mask_store_path, store_tag);
+	if (masks_stored)
+		std::cout << "Reading masks from " << mask_store_path << " (" << stored_masks.frame_count()
+			<< " frames); segmentation is skipped." << std::endl;
+	else if (mask_writer.open(mask_store_path, store_tag))
+		std::cout << "Writing masks to " << mask_store_path << " for re-renders." << std::endl;
+
+	std::mutex timing_mutex;
+	AdaptiveBatcher batcher(bounds, AdaptiveBatcher::Mode::Throughput);
+
+	LatencyReport latency(fs::path(output_video_path).filename().string(), report_options);
+	LatencyHistogram& end_to_end_latency = latency.stage(LatencyReport::kEndToEnd);
+	LatencyHistogram& decode_latency = latency.stage("decode");
+	LatencyHistogram& segment_latency = latency.stage("segment (batch)");
+	LatencyHistogram& glow_latency = latency.stage("glow (batch)");
+	LatencyHistogram& encode_wait_latency = latency.stage("encoder queue");
+	std::mutex read_times_mutex;
+	std::map<uint64_t, std::chrono::steady_clock::time_point> read_times;   // by pipeline seq, until delivered
+	uint64_t next_read_seq = 0;
+
+	int64_t frames_left = range.count;
+	PipelineReadFn read_frame = [&](cv::Mat& frame) {
+		PROFILE_ZONE("decode");
+		const auto read_start = std::chrono::steady_clock::now();
+		if (frames_left == 0 || !video.read(frame) || frame.empty())
+			return false;
+		if (frames_left > 0)
+			--frames_left;
+		decode_latency.record_ms(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - read_start).count());
+		{
+			std::lock_guard<std::mutex> lock(read_times_mutex);
+			read_times[next_read_seq++] = read_start;
+		}
+		if (frame.cols <= 0 || frame.rows <= 0) {
+			std::cerr << "Warning: Read frame is invalid. Using default blank image." << std::endl;
+			frame = cv::Mat(defaultSize, CV_8UC3, cv::Scalar(0, 0, 0));
+		}
+		return true;
+	};
+
+	PipelineProcessFn process_batch = [&](const InFlightBatch& batch) {
+		auto seg_start = std::chrono::high_resolution_clock::now();
+		std::vector<cv::Mat> masks;
+		if (masks_stored)
+			masks = stored_masks.read_batch(batch.first_seq, batch.frames.size());
+		const bool from_store = !masks.empty();
+		size_t segmented = 0;
+		if (!from_store) {
+			MaskPropagator propagator(propagation);
+			std::vector<int> keyframes = batch.scores.size() == batch.frames.size()
+				? propagator.select_keyframes(batch.analysis, batch.scores)
+				: propagator.select_keyframes(batch.frames);
+			std::vector<cv::Mat> key_frames;
+			for (int k : keyframes)
+				key_frames.push_back(batch.frames[k]);
+			masks = segment_frames(key_frames, batch.plan.contexts);
+			if (keyframes.size() < batch.frames.size())
+				masks = propagator.propagate(masks);
+			if (mask_writer.is_open())
+				mask_writer.write_batch(batch.first_seq, masks);
+			segmented = keyframes.size();
+		}
+		auto pp_start = std::chrono::high_resolution_clock::now();
+		GlowBatchStats glow_stats;
+		std::vector<cv::Mat> outputs = composite_glow_batch(batch.frames, masks, defaultSize, &glow_stats, classes);
+		for (cv::Mat& output : outputs)
+			to_encoder_frame(output, output);
+		auto pp_end = std::chrono::high_resolution_clock::now();
+		segment_latency.record_ms(std::chrono::duration<double, std::milli>(pp_start - seg_start).count());
+		glow_latency.record_ms(std::chrono::duration<double, std::milli>(pp_end - pp_start).count());
+
+		// A short tail batch would skew the estimate of its plan; stored masks say nothing about it.
+		if (!from_store && static_cast<int>(batch.frames.size()) == batch.plan.batch_size)
+			batcher.record(batch.plan, std::chrono::duration<double, std::milli>(pp_start - seg_start).count(),
+				std::chrono::duration<double, std::milli>(pp_end - pp_start).count());
+
+		std::lock_guard<std::mutex> lock(timing_mutex);
+		timing.frames_segmented += segmented;
+		timing.frames_from_store += from_store ? batch.frames.size() : 0;
+		timing.glow_reused += glow_stats.glow_reused;
+		timing.glow_skipped += glow_stats.glow_skipped;
+		timing.segmentation_time += std::chrono::duration<double>(pp_start - seg_start).count();
+		timing.post_processing_time += std::chrono::duration<double>(pp_end - pp_start).count();
+		return outputs;
+	};
+
+	PipelineSinkFn show_and_write = [&](uint64_t seq, const cv::Mat& frame) {
+		{
+			std::lock_guard<std::mutex> lock(read_times_mutex);
+			auto read = read_times.find(seq);
+			if (read != read_times.end()) {
+				end_to_end_latency.record_ms(
+					std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - read->second).count());
+				read_times.erase(read_times.begin(), std::next(read));
+			}
+		}
+		latency.frame_done();
+		cv::Mat final_result = frame;
+		if (final_result.empty())
+			final_result = cv::Mat(defaultSize, CV_8UC3, cv::Scalar(0, 0, 0));
+		if (window_name) {
+			cv::imshow(window_name, final_result);
+			int key = cv::waitKey(30);
+			if (key == 'q')
+				return false;
+		}
+		const auto push_start = std::chrono::steady_clock::now();
+		const bool pushed = encoder.push(final_result);
+		encode_wait_latency.record_ms(
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - push_start).count());
+		return pushed;   // a failed output stops the run like 'q'
+	};
+
+	VideoPipelineConfig config;
+	config.max_in_flight = 2;
+	config.plan_fn = [&]() { return batcher.next(); };
+	SceneChangeDetector detector(propagation.detector);
+	if (propagation.keyframe_interval > 1 && !masks_stored) {
+		config.analyze_fn = [&](const cv::Mat& frame, cv::Mat& analysis) {
+			analysis = make_analysis_gray(frame, propagation.analysis_size);
+			return detector.analyze(analysis);
+		};
+	}
+	VideoPipelineStats stats = run_video_pipeline(read_frame, process_batch, show_and_write, config);
+	mask_writer.finish();
+
+	video.release();
+	const FrameEncoderStats encoded = encoder.close();
+	if (window_name)
+		cv::destroyAllWindows();
+	batcher.report();
+	encoder.report();
+	latency.finish();
+	if (masks_stored)
+		std::cout << "Mask store: " << timing.frames_from_store << " of " << stats.frames_read
+			<< " frames read from the store, " << timing.frames_segmented << " segmented" << std::endl;
+	else if (propagation.keyframe_interval > 1)
+		std::cout << "Keyframe segmentation: " << timing.frames_segmented << " of " << stats.frames_read
+			<< " frames segmented, the rest propagated; " << timing.glow_reused << " glows reused, "
+			<< stats.scene_cuts << " scene cuts" << std::endl;
+	std::cout << "Frames without key pixels (passed through): " << timing.glow_skipped << " of "
+		<< stats.frames_delivered << std::endl;
+
+	if (encoded.failed) {
+		std::cerr << "Error: Writing the video output failed after " << encoded.frames << " frames; the run was stopped."
+			<< std::endl;
+		return timing;
+	}
+	timing.completed = true;
+	timing.frames = stats.frames_delivered;
+	timing.total_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - total_start).count();
+	return timing;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: glow_effect_video
+////////////////////////////////////////////////////////////////////////////////
+void glow_effect_video(const char* video_nm, std::string planFilePath, int keyframe_interval) {
+	cv::String info = cv::getBuildInformation();
+	std::cout << info << std::endl;
+
+	MaskPropagationConfig propagation;
+	propagation.keyframe_interval = keyframe_interval;
+
+	std::string output_video_path = "./VideoOutput/processed_video.avi";
+	std::string mask_store_path = "./VideoOutput/" + fs::path(video_nm).stem().string() + ".masks";
+	GlowVideoTiming timing = run_glow_video(video_nm, planFilePath,
+		TrtSegmentation::Concurrent,
+		propagation, output_video_path, mask_store_path, video_output, glow_classes, latency_options, "Processed Frame");
+	if (timing.completed)
+		std::cout << "Video processing completed. Saved to: " << output_video_path << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: glow_effect_video_graph
+// Description: CUDA Graph accelerated version of glow_effect_video
+////////////////////////////////////////////////////////////////////////////////
+void glow_effect_video_graph(const char* video_nm, std::string planFilePath, int keyframe_interval) {
+	cv::String info = cv::getBuildInformation();
+	std::cout << info << std::endl;
+
+	MaskPropagationConfig propagation;
+	propagation.keyframe_interval = keyframe_interval;
+
+	std::string output_video_path = "./VideoOutput/processed_video_graph.avi";
+	std::string mask_store_path = "./VideoOutput/" + fs::path(video_nm).stem().string() + ".masks";
+	GlowVideoTiming timing = run_glow_video(video_nm, planFilePath,
+		TrtSegmentation::Graph, // Use the graph version
+		propagation, output_video_path, mask_store_path, video_output, glow_classes, latency_options,
+		"Processed Frame (CUDA Graph)");
+	if (!timing.completed)
+		return;
+
+	// Output performance metrics. Segmentation and post-processing run concurrently
+	// across batches, so their sums can exceed the wall-clock total.
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "CUDA Graph Video Processing Performance" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Total frames processed: " << timing.frames << std::endl;
+	std::cout << "Total processing time: " << timing.total_time << " seconds" << std::endl;
+	if (timing.frames > 0) {
+		std::cout << "Average time per frame: " << (timing.total_time * 1000.0) / timing.frames << " ms" << std::endl;
+		std::cout << "Effective frame rate: " << timing.frames / timing.total_time << " fps" << std::endl;
+	}
+	std::cout << "Segmentation time: " << timing.segmentation_time << " seconds ("
+		<< (timing.segmentation_time / timing.total_time) * 100.0 << "%)" << std::endl;
+	std::cout << "Post-processing time: " << timing.post_processing_time << " seconds ("
+		<< (timing.post_processing_time / timing.total_time) * 100.0 << "%)" << std::endl;
+	std::cout << "Video processing completed with CUDA Graph acceleration." << std::endl;
+	std::cout << "Saved to: " << output_video_path << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: glow_effect_video_segment
+// Description: One worker of a segment-parallel render (see SegmentRender.hpp)
+////////////////////////////////////////////////////////////////////////////////
+bool glow_effect_video_segment(const SegmentWorkerArgs& args) {
+	VideoOutputOptions output;
+	if (args.format != "avi") {
+		if (!parse_raw_video_format(args.format, output.raw_format)) {
+			std::cerr << "Error: Unknown segment format: " << args.format << std::endl;
+			return false;
+		}
+		output.raw_path = args.part;
+		output.avi = false;
+	}
+	mipmap_backend = args.cpu_mipmap ? MipmapBackend::Cpu : MipmapBackend::Cuda;
+
+	MaskPropagationConfig propagation;
+	propagation.keyframe_interval = args.keyframe_interval;
+	LatencyOptions latency = latency_options;
+	if (!latency.output_prefix.empty())
+		latency.output_prefix += "." + fs::path(args.part).filename().string();
+	std::cout << "Segment worker: frames " << args.range.first << " + "
+		<< (args.range.count < 0 ? std::string("rest") : std::to_string(args.range.count)) << " of " << args.video
+		<< " -> " << args.part << std::endl;
+	GlowVideoTiming timing = run_glow_video(args.video.c_str(), args.plan,
+		TrtSegmentation::Graph,
+		propagation, args.part, args.part + ".masks", output, glow_classes, latency, nullptr, args.range);
+	if (timing.completed)
+		std::cout << "Segment worker: " << timing.frames << " frames in " << timing.total_time << " s" << std::endl;
+	return timing.completed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: glow_effect_video_job
+// Description: One clip of the batch mode (see BatchJobs.hpp)
+////////////////////////////////////////////////////////////////////////////////
+BatchJobResult glow_effect_video_job(const BatchJob& job) {
+	BatchJobResult result;
+	VideoOutputOptions output;
+	if (job.format != "avi") {
+		if (!parse_raw_video_format(job.format, output.raw_format)) {
+			result.error = "unknown format " + job.format;
+			return result;
+		}
+		output.raw_path = job.output;
+		output.avi = false;
+	}
+	GlowClassTable classes;
+	if (!job.classes.empty() && !parse_glow_classes(job.classes, classes)) {
+		result.error = "malformed class table " + job.classes;
+		return result;
+	}
+	// The inference paths exit the process on a missing engine; a bad plan fails this job only.
+	if (job.plan != "cpu" && !load_trt_plan(job.plan)) {
+		result.error = "could not load the TensorRT plan " + job.plan;
+		return result;
+	}
+	std::error_code ec;
+	const fs::path parent = fs::path(job.output).parent_path();
+	if (!parent.empty())
+		fs::create_directories(parent, ec);
+
+	MaskPropagationConfig propagation;
+	propagation.keyframe_interval = job.keyframe_interval;
+	LatencyOptions latency = latency_options;
+	if (!latency.output_prefix.empty())
+		latency.output_prefix += "." + fs::path(job.output).filename().string();
+	GlowVideoTiming timing = run_glow_video(job.input.c_str(), job.plan,
+		TrtSegmentation::Graph,
+		propagation, job.output, job.output + ".masks", output, classes, latency, nullptr);
+	result.ok = timing.completed;
+	if (!timing.completed)
+		result.error = "could not open the input or the output";
+	result.frames = timing.frames;
+	result.segmentation_seconds = timing.segmentation_time;
+	result.post_seconds = timing.post_processing_time;
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: verify_video_job_errors
+////////////////////////////////////////////////////////////////////////////////
+bool verify_video_job_errors() {
+	BatchJob job;
+	job.input = "missing_clip.mp4";
+	job.output = "missing_plan_check.y4m";
+	job.format = "y4m";
+
+	job.plan = "missing_plan_check.plan";
+	const BatchJobResult bad_plan = glow_effect_video_job(job);
+	job.plan = "cpu";
+	job.format = "mkv";
+	const BatchJobResult bad_format = glow_effect_video_job(job);
+	job.format = "y4m";
+	job.classes = "8:0,0";
+	const BatchJobResult bad_classes = glow_effect_video_job(job);
+
+	const bool ok = !bad_plan.ok && bad_plan.error.find("plan") != std::string::npos && bad_plan.frames == 0 &&
+		!bad_format.ok && !bad_format.error.empty() && !bad_classes.ok && !bad_classes.error.empty() &&
+		!fs::exists(job.output);
+	std::cout << "Video job check: missing plan \"" << bad_plan.error << "\", unknown format \"" << bad_format.error
+		<< "\", bad class table \"" << bad_classes.error << "\": " << (ok ? "PASSED" : "FAILED") << std::endl;
+	return ok;
+}
@@ -0,0 +1,247 @@
+#ifndef GLOW_RENDER_HPP
+#define GLOW_RENDER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "RleMask.hpp"
+#include "GlowCache.hpp"
+#include "GlowParamBlock.hpp"
+#include "GlowClasses.hpp"
+#include "RawVideoSink.hpp"
+#include "SegmentRender.hpp"
+#include "BatchJobs.hpp"
+#include "LatencyHistogram.hpp"
+#include "MipmapCPU.hpp"
+
+class AsyncFrameEncoder;
+
+// The glow without CUDA types: keying, compositing and the video paths. The GPU backends
+// (CUDA mipmaps, TensorRT segmentation) are reached through GlowGpu.hpp, so this part also
+// builds without CUDA (see the pipeline_bench target of CMakeLists.txt).
+
+/**
+ * @brief Backend of the mipmap (blur) stage of the glow.
+ */
+enum class MipmapBackend {
+	Cuda,   ///< filter_mipmap / filter_mipmap_async on the GPU (triple buffered in video paths).
+	Cpu     ///< filter_mipmap_cpu on the shared task scheduler.
+};
+
+/** @brief Mipmap backend used by the image and video glow paths. */
+extern MipmapBackend mipmap_backend;
+
+/**
+ * @brief Classes glowing in the video paths (composite_glow_batch); empty means the one class
+ *        of the key level slider. Set before a video starts.
+ */
+extern GlowClassTable glow_classes;
+
+/**
+ * @brief Outputs of the video paths.
+ */
+struct VideoOutputOptions {
+	bool avi = true;            ///< MJPG .avi under ./VideoOutput/ (cv::VideoWriter).
+	std::string raw_path;       ///< Y4M / rawvideo file, named pipe or "-" for stdout; empty for none.
+	RawVideoFormat raw_format = RawVideoFormat::Y4m420;
+};
+
+/**
+ * @brief Outputs the video paths write (the AVI only unless main selects a raw stream).
+ */
+extern VideoOutputOptions video_output;
+
+/**
+ * @brief Latency reports of the video paths: interval lines, the p99 target and the CSV / JSON
+ *        prefix (nothing but the final table unless main sets them).
+ */
+extern LatencyOptions latency_options;
+
+/**
+ * @brief Applies a "blow" (highlight) effect based on a grayscale mask.
+ *
+ * Every pixel of the input mask within the specified tolerance (Delta) of the key
+ * level (param_KeyLevel) gets the overlay color in the output; all others stay transparent.
+ *
+ * @param mask          A single-channel (CV_8UC1) mask.
+ * @param dst_rgba      Destination RGBA image (CV_8UC4); will be created/overwritten.
+ * @param param_KeyLevel Key level parameter controlling the highlight trigger.
+ * @param Delta         Tolerance range around param_KeyLevel.
+ * @param region        Optional; receives the bounding box of the matching pixels (empty if none),
+ *                      from which glow_roi derives the region the glow work is restricted to.
+ * @return Number of matching pixels; 0 means the frame has no glow and the mipmap
+ *         and blend can be skipped (see pass_through_frame).
+ */
+int glow_blow(const cv::Mat& mask, cv::Mat& dst_rgba, int param_KeyLevel, int Delta, cv::Rect* region = nullptr);
+
+/**
+ * @brief glow_blow on a run-length encoded mask: matching, region statistics and overlay cost per run.
+ *
+ * Same output as the cv::Mat overload on the decoded mask.
+ */
+int glow_blow(const RleMask& mask, cv::Mat& dst_rgba, int param_KeyLevel, int Delta, cv::Rect* region = nullptr);
+
+/**
+ * @brief Pyramid of a keyed grayscale image on the selected mipmap backend.
+ *
+ * @param key_image      Source grayscale image (CV_8UC1), e.g. RleMask::key_image.
+ * @param param_KeyLevel Key level the image was keyed with.
+ * @param roi            Placement of key_image in the frame (glow_roi of its key region).
+ * @param frame          Frame size. The CPU pyramid follows the frame's level grid; the CUDA
+ *                       pyramid is built on key_image alone (see glow_roi). A build without
+ *                       the GPU backends (GlowGpu.hpp) always returns the CPU pyramid.
+ */
+std::shared_ptr<MipmapPyramid> make_mipmap_pyramid(const cv::Mat& key_image, int param_KeyLevel, const cv::Rect& roi,
+	const cv::Size& frame);
+
+/**
+ * @brief Blends two images using a mask and per-pixel alpha blending.
+ *
+ * The function blends a source image with a highlighted image using a grayscale mask
+ * (interpreted as alpha values scaled by param_KeyScale), producing a final blended RGBA output.
+ *
+ * @param src_img        First source image.
+ * @param dst_rgba       Second source image (highlighted).
+ * @param mipmap_result  Grayscale mask image used for alpha blending.
+ * @param output_image   Destination blended image.
+ * @param param_KeyScale Blending factor scaling.
+ */
+void mix_images(const cv::Mat& src_img, const cv::Mat& dst_rgba, const cv::Mat& mipmap_result, cv::Mat& output_image, float param_KeyScale);
+
+/**
+ * @brief Output of a frame without key pixels: the source converted to the RGBA layout of mix_images.
+ *
+ * @param src_img      Source image (BGR or BGRA).
+ * @param output_image Destination image (CV_8UC4).
+ */
+void pass_through_frame(const cv::Mat& src_img, cv::Mat& output_image);
+
+/**
+ * @brief The glow_effect_image stages for GlowImageCache: cv::imread, glow_blow, the mipmap
+ *        pyramid of the selected backend (make_mipmap_pyramid) and mix_images.
+ */
+GlowStages default_glow_stages();
+
+/**
+ * @brief Per-frame counters of composite_glow_batch.
+ */
+struct GlowBatchStats {
+	size_t frames = 0;         ///< Frames composited.
+	size_t glow_reused = 0;    ///< Frames that reused the glow and mipmap of the previous frame.
+	size_t glow_skipped = 0;   ///< Frames without key pixels, passed through with no mipmap or blend.
+};
+
+/**
+ * @brief Composites the glow effect onto a batch of frames using their segmentation masks.
+ *
+ * masks[i] belongs to frames[i]; each mask is run-length encoded, resized to its frame on
+ * the runs (nearest neighbour, class values are never blended), keyed by glow_blow,
+ * mipmap filtered and blended with mix_images. Mipmap and blend only cover the glow ROI
+ * (key bounding box padded by the blur reach, see glow_roi); the rest of the frame is
+ * copied through. A missing mask yields a blank mask.
+ * With a class table (classes) every enabled class is keyed in the same pass, with its own
+ * overlay color, and the classes of one blur scale share one mipmap (key_glow_classes,
+ * blend_glow_layers).
+ * When masks[i] shares its data with masks[i - 1] (a static frame in mask propagation),
+ * the glow and mipmap of frame i - 1 are reused and only the blend runs. Frames whose
+ * mask has no key pixels are passed through; no mipmap or blend work is scheduled for them.
+ *
+ * @param frames      Original frames of the batch (BGR).
+ * @param masks       Segmentation masks (CV_8UC1), one per frame, any resolution.
+ * @param defaultSize Fallback size for invalid frames and blank outputs.
+ * @param stats       Optional; the counters of this batch are added to it.
+ * @param classes     Glowing classes; empty for the one class of the key level slider.
+ * @return One blended RGBA frame per input frame.
+ */
+std::vector<cv::Mat> composite_glow_batch(const std::vector<cv::Mat>& frames, const std::vector<cv::Mat>& masks, const cv::Size& defaultSize,
+	GlowBatchStats* stats = nullptr, const GlowClassTable& classes = glow_classes);
+
+/**
+ * @brief Run-length encoded mask of a frame: mask scaled to targetSize on the runs, blank if
+ *        the mask is missing or unusable.
+ */
+RleMask frame_mask_rle(const cv::Mat& mask, const cv::Size& targetSize, int frame_index);
+
+/**
+ * @brief Mipmaps of keyed ROI images at params.scale on the selected backend.
+ *
+ * Image i is the part rois[i] of a frame of size frame_sizes[i]; result i has its size.
+ */
+std::vector<cv::Mat> compute_glow_mipmaps(const std::vector<cv::Mat>& key_images, const GlowParams& params,
+	const std::vector<cv::Rect>& rois, const std::vector<cv::Size>& frame_sizes);
+
+/**
+ * @brief mix_images restricted to roi; outside it the source is passed through.
+ *
+ * @param mipmap_roi Mipmap of the ROI, the size of roi.
+ */
+void blend_glow_roi(const cv::Mat& src_img, const cv::Mat& dst_rgba, const cv::Mat& mipmap_roi, const cv::Rect& roi,
+	int key_scale, cv::Mat& output_image);
+
+/**
+ * @brief Starts the encoder thread on the selected outputs: the MJPG writer at avi_path, the
+ *        raw Y4M / rawvideo sink, or both.
+ *
+ * @return false if no output could be opened.
+ */
+bool open_video_output(AsyncFrameEncoder& encoder, const std::string& avi_path, double fps, const cv::Size& size,
+	const VideoOutputOptions& output = video_output);
+
+/**
+ * @brief Applies a glow effect to a video file.
+ *
+ * @param video_nm          Path to the input video file.
+ * @param planFilePath      Path to the TRT plan file.
+ * @param keyframe_interval Segment every Nth frame (or on a scene change) and propagate masks in between; 1 segments every frame.
+ */
+void glow_effect_video(const char* video_nm, std::string planFilePath, int keyframe_interval = 1);
+
+/**
+ * @brief Applies a glow effect to a video file using CUDA Graph acceleration.
+ *
+ * This function maintains the same parallel processing approach as glow_effect_video,
+ * but enhances the segmentation phase with CUDA Graph technology to reduce kernel
+ * launch overhead and improve overall performance. Batch size and the number of concurrent
+ * sub-batches are chosen adaptively from measured timings.
+ *
+ * @param video_nm          Path to the input video file.
+ * @param planFilePath      Path to the TRT plan file.
+ * @param keyframe_interval Segment every Nth frame (or on a scene change) and propagate masks in between; 1 segments every frame.
+ */
+void glow_effect_video_graph(const char* video_nm, std::string planFilePath, int keyframe_interval = 1);
+
+/**
+ * @brief Renders one segment of a segment-parallel render, headless (run by a --segment-worker process).
+ *
+ * Frames args.range of args.video go through the glow_effect_video_graph pipeline (or the CPU
+ * segmenter when args.plan is "cpu") into args.part in args.format; masks are stored next to it.
+ * Sets mipmap_backend.
+ *
+ * @return true if the segment was rendered completely.
+ */
+bool glow_effect_video_segment(const SegmentWorkerArgs& args);
+
+/**
+ * @brief Renders one clip of a batch manifest, headless; several jobs may run at once.
+ *
+ * Same pipeline as glow_effect_video_segment over the whole clip, with the job's output and
+ * class table (the globals video_output and glow_classes are not used). TensorRT engines come
+ * from the engine registry, so only the first job on a plan deserializes it. Masks are stored
+ * at job.output + ".masks". A plan that cannot be loaded fails the job before anything is
+ * rendered, so the other jobs of the batch go on.
+ *
+ * @return Outcome and timing of the job.
+ */
+BatchJobResult glow_effect_video_job(const BatchJob& job);
+
+/**
+ * @brief Headless check that a batch job with a missing TensorRT plan, an unknown format or a
+ *        malformed class table fails with an error instead of ending the process.
+ *
+ * @return true if the check passed.
+ */
+bool verify_video_job_errors();
+
+#endif // GLOW_RENDER_HPP
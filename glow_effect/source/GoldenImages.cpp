@@ -0,0 +1,584 @@
+/**
+ * @file GoldenImages.cpp
+ * @brief Reference implementations of the hot kernels and the golden-image regression check.
+ */
+
+#include "GoldenImages.hpp"
+#include "glow_effect.hpp"
+#include "GlowClasses.hpp"
+#include "ImageProcessingUtil.hpp"
+#include "MipmapCPU.hpp"
+#include "PipelineBench.hpp"
+#include "RleMask.hpp"
+#include "SyntheticClip.hpp"
+#include "TRTInference.hpp"
+#include "segmentation_kernels.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "movie_effect/include/tools_bench.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	const int kClasses = 21;
+	const float kGlowScale = 10.0f;
+	const int kKeys[][2] = { { 56, 20 }, { 96, 1 } };        // key level, delta
+	const float kKeyScales[] = { 0.0f, 255.0f, 600.0f, 1000.0f };   // 1000 wraps the uchar alpha
+	const GoldenTolerance kExact;
+	const GoldenTolerance kMipmap = { 1, 45.0, 0.99 };
+
+	// One frame of the corpus with its class mask (CV_8UC3 and CV_8UC1, same size).
+	struct GoldenCase {
+		std::string name;
+		cv::Mat frame;
+		cv::Mat mask;
+	};
+
+	// Running result of one kernel over the corpus.
+	struct KernelTally {
+		std::string kernel;
+		GoldenTolerance tolerance;
+		int cases = 0;
+		int differing = 0;
+		int failed = 0;
+		int max_abs_error = 0;
+	};
+
+	std::string file_stem(const std::string& text) {
+		std::string stem;
+		for (char c : text)
+			stem += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+		return stem;
+	}
+
+	// Values a mask pixel is drawn from: every class level plus the values right at and next to
+	// the key boundaries |value - key| < delta.
+	std::vector<int> mask_palette() {
+		std::vector<int> values;
+		for (int c = 0; c < kClasses; ++c)
+			values.push_back(c * kClassLevelStep);
+		for (const auto& key : kKeys) {
+			for (int d : { -key[1] - 1, -key[1], -key[1] + 1, 0, key[1] - 1, key[1], key[1] + 1 })
+				values.push_back(std::min(255, std::max(0, key[0] + d)));
+		}
+		values.push_back(255);
+		return values;
+	}
+
+	cv::Mat noise_image(const cv::Size& size, int type, std::mt19937& rng) {
+		cv::Mat image(size, type);
+		std::uniform_int_distribution<int> value(0, 255);
+		const size_t row_bytes = static_cast<size_t>(image.cols) * image.elemSize();
+		for (int y = 0; y < image.rows; ++y) {
+			uchar* row = image.ptr<uchar>(y);
+			for (size_t i = 0; i < row_bytes; ++i)
+				row[i] = static_cast<uchar>(value(rng));
+		}
+		return image;
+	}
+
+	// Mask of class blobs: 4x4 blocks of palette values, so keys form small regions with edges.
+	cv::Mat noise_mask(const cv::Size& size, std::mt19937& rng) {
+		static const std::vector<int> palette = mask_palette();
+		std::uniform_int_distribution<size_t> pick(0, palette.size() - 1);
+		const int bw = (size.width + 3) / 4, bh = (size.height + 3) / 4;
+		std::vector<int> blocks(static_cast<size_t>(bw) * bh);
+		for (int& b : blocks)
+			b = palette[pick(rng)];
+		cv::Mat mask(size, CV_8UC1);
+		for (int y = 0; y < size.height; ++y) {
+			uchar* row = mask.ptr<uchar>(y);
+			for (int x = 0; x < size.width; ++x)
+				row[x] = static_cast<uchar>(blocks[(y / 4) * bw + x / 4]);
+		}
+		return mask;
+	}
+
+	// Synthetic frames of several sizes, odd ones included, then the stored images of corpus_dir
+	// (their masks are the gray image quantized to class levels).
+	std::vector<GoldenCase> golden_corpus(const std::string& corpus_dir) {
+		const cv::Size sizes[] = { { 1, 1 }, { 3, 2 }, { 17, 9 }, { 64, 33 }, { 384, 384 }, { 641, 359 }, { 1280, 720 } };
+		std::mt19937 rng(2025);
+		std::vector<GoldenCase> corpus;
+		for (const cv::Size& size : sizes) {
+			const std::string dims = std::to_string(size.width) + "x" + std::to_string(size.height);
+			corpus.push_back({ "noise " + dims, noise_image(size, CV_8UC3, rng), noise_mask(size, rng) });
+			if (size.width < 64 || size.height < 32)
+				continue;
+
+			SyntheticClipSpec spec;
+			spec.width = size.width;
+			spec.height = size.height;
+			spec.scene_lengths = { 1 };
+			spec.object_size = std::min(size.width, size.height) / 3;
+			spec.object_class = kKeys[0][0];
+			SyntheticClip clip = make_synthetic_clip(spec);
+			corpus.push_back({ "synthetic " + dims, clip.frames[0], clip.masks[0] });
+
+			GoldenCase pattern{ "pattern " + dims, cv::Mat(), cv::Mat() };
+			PatternClip(size.width, size.height).render(7, pattern.frame, pattern.mask);
+			corpus.push_back(pattern);
+		}
+
+		if (corpus_dir.empty())
+			return corpus;
+		std::vector<std::string> paths;
+		try {
+			paths = ImageProcessingUtil::getImagePaths(corpus_dir);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Golden check: cannot read the corpus directory " << corpus_dir << ": " << e.what() << std::endl;
+			return corpus;
+		}
+		std::sort(paths.begin(), paths.end());
+		for (const std::string& path : paths) {
+			GoldenCase stored{ fs::path(path).filename().string(), cv::imread(path, cv::IMREAD_COLOR), cv::Mat() };
+			if (stored.frame.empty()) {
+				std::cerr << "Golden check: skipping unreadable image " << path << std::endl;
+				continue;
+			}
+			cv::cvtColor(stored.frame, stored.mask, cv::COLOR_BGR2GRAY);
+			for (int y = 0; y < stored.mask.rows; ++y) {
+				uchar* row = stored.mask.ptr<uchar>(y);
+				for (int x = 0; x < stored.mask.cols; ++x)
+					row[x] = static_cast<uchar>(std::min(kClasses - 1, row[x] / kClassLevelStep) * kClassLevelStep);
+			}
+			corpus.push_back(stored);
+		}
+		return corpus;
+	}
+
+	// Compares one case, prints it if it is outside the tolerance (or extra is not empty, a
+	// mismatch beyond the pixels) and writes its images to diff_dir.
+	void record(KernelTally& tally, const std::string& name, const cv::Mat& fast, const cv::Mat& reference,
+		const GoldenOptions& options, const std::string& extra = std::string()) {
+		const GoldenDiff diff = compare_golden(fast, reference);
+		const bool ok = diff.within(tally.tolerance) && extra.empty();
+		tally.cases++;
+		tally.differing += diff.differing > 0 ? 1 : 0;
+		tally.max_abs_error = std::max(tally.max_abs_error, diff.max_abs_error);
+		if (ok)
+			return;
+
+		tally.failed++;
+		std::cout << "  " << tally.kernel << " / " << name << ": ";
+		if (!diff.comparable) {
+			std::cout << "fast output " << fast.cols << "x" << fast.rows << " type " << fast.type() << ", reference "
+				<< reference.cols << "x" << reference.rows << " type " << reference.type();
+		}
+		else if (diff.differing > 0) {
+			std::cout << diff.differing << " of " << diff.pixels << " pixels differ, first at (" << diff.first.x << ", "
+				<< diff.first.y << "), box " << diff.box.width << "x" << diff.box.height << " at (" << diff.box.x << ", "
+				<< diff.box.y << "), max error " << diff.max_abs_error << ", PSNR " << diff.psnr << " dB, SSIM " << diff.ssim;
+		}
+		else {
+			std::cout << "pixels identical";
+		}
+		if (!extra.empty())
+			std::cout << "; " << extra;
+		std::cout << std::endl;
+
+		if (options.diff_dir.empty() || !diff.comparable)
+			return;
+		std::error_code ec;
+		fs::create_directories(options.diff_dir, ec);
+		const std::string stem = (fs::path(options.diff_dir) / file_stem(tally.kernel + " " + name)).string();
+		cv::Mat difference;
+		cv::absdiff(fast, reference, difference);
+		cv::imwrite(stem + "_fast.png", fast);
+		cv::imwrite(stem + "_reference.png", reference);
+		cv::imwrite(stem + "_diff.png", difference);
+	}
+
+	bool report(const KernelTally& tally) {
+		const bool ok = tally.failed == 0;
+		std::cout << "Golden check: " << tally.kernel << ": " << tally.cases << " cases, " << tally.differing
+			<< " differing (max error " << tally.max_abs_error << "), " << tally.failed << " outside tolerance: "
+			<< (ok ? "PASSED" : "FAILED") << std::endl;
+		return ok;
+	}
+
+	std::string region_mismatch(int fast_pixels, const cv::Rect& fast_box, int ref_pixels, const cv::Rect& ref_box) {
+		if (fast_pixels == ref_pixels && fast_box == ref_box)
+			return std::string();
+		return "key pixels " + std::to_string(fast_pixels) + " vs " + std::to_string(ref_pixels) + ", box " +
+			std::to_string(fast_box.width) + "x" + std::to_string(fast_box.height) + " at (" + std::to_string(fast_box.x) +
+			", " + std::to_string(fast_box.y) + ") vs " + std::to_string(ref_box.width) + "x" +
+			std::to_string(ref_box.height) + " at (" + std::to_string(ref_box.x) + ", " + std::to_string(ref_box.y) + ")";
+	}
+
+	// Keyed mipmap input: key where the mask equals key (any nonzero value for a negative key), 0 elsewhere.
+	cv::Mat key_image_reference(const cv::Mat& mask, int key) {
+		cv::Mat key_image(mask.size(), CV_8UC1);
+		for (int y = 0; y < mask.rows; ++y) {
+			const uchar* in = mask.ptr<uchar>(y);
+			uchar* out = key_image.ptr<uchar>(y);
+			for (int x = 0; x < mask.cols; ++x)
+				out[x] = (key < 0 ? in[x] != 0 : in[x] == key) ? in[x] : 0;
+		}
+		return key_image;
+	}
+
+	// The uchar4 layout of convert_mask_to_rgba_buffer: gray, gray, gray, 255 on kept pixels.
+	cv::Mat gray_to_rgba_reference(const cv::Mat& key_image) {
+		cv::Mat rgba = cv::Mat::zeros(key_image.size(), CV_8UC4);
+		for (int y = 0; y < key_image.rows; ++y) {
+			const uchar* in = key_image.ptr<uchar>(y);
+			cv::Vec4b* out = rgba.ptr<cv::Vec4b>(y);
+			for (int x = 0; x < key_image.cols; ++x) {
+				if (in[x])
+					out[x] = cv::Vec4b(in[x], in[x], in[x], 255);
+			}
+		}
+		return rgba;
+	}
+
+	// [2, 21, h, w] logits: the class of the mask wins by a margin in image 0, a shifted class in
+	// image 1. Some pixels tie the winner with a later class, others carry NaN, -inf, +inf or
+	// -FLT_MAX, class 0 included.
+	std::vector<float> golden_logits(const cv::Mat& mask, std::mt19937& rng) {
+		const size_t plane = mask.total();
+		std::vector<float> logits(2 * kClasses * plane);
+		std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+		const float inf = std::numeric_limits<float>::infinity();
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		for (int b = 0; b < 2; ++b) {
+			float* image = logits.data() + b * kClasses * plane;
+			for (size_t p = 0; p < plane; ++p) {
+				const int cls = (std::min(kClasses - 1, mask.data[p] / kClassLevelStep) + 5 * b) % kClasses;
+				for (int c = 0; c < kClasses; ++c)
+					image[c * plane + p] = noise(rng) + (c == cls ? 4.0f : 0.0f);
+				switch (p % 11) {
+				case 1:   // tie with a later class: the first one wins
+					image[((cls + 3) % kClasses) * plane + p] = image[cls * plane + p];
+					break;
+				case 3:
+					image[p] = nan;
+					break;
+				case 5:
+					for (int c = 0; c < kClasses; ++c)
+						image[c * plane + p] = -inf;
+					break;
+				case 7:
+					for (int c = 0; c < kClasses; ++c)
+						image[c * plane + p] = c == 0 ? -FLT_MAX : -inf;
+					break;
+				case 8:
+					image[((cls + 7) % kClasses) * plane + p] = inf;
+					break;
+				case 9:
+					image[cls * plane + p] = nan;
+					break;
+				}
+			}
+		}
+		return logits;
+	}
+
+	// argmaxKernel on the default CUDA device; false with a reason if it could not run.
+	bool gpu_argmax(const std::vector<float>& logits, int batch, int height, int width, std::vector<uchar>& out,
+		std::string& reason) {
+		int devices = 0;
+		if (cudaGetDeviceCount(&devices) != cudaSuccess || devices == 0) {
+			reason = "no CUDA device";
+			return false;
+		}
+		out.assign(static_cast<size_t>(batch) * height * width, 0);
+		float* d_logits = nullptr;
+		unsigned char* d_masks = nullptr;
+		bool ok = cudaMalloc(&d_logits, logits.size() * sizeof(float)) == cudaSuccess &&
+			cudaMalloc(&d_masks, out.size()) == cudaSuccess &&
+			cudaMemcpy(d_logits, logits.data(), logits.size() * sizeof(float), cudaMemcpyHostToDevice) == cudaSuccess;
+		if (ok) {
+			launchArgmaxKernel(d_logits, d_masks, batch, kClasses, height, width, 0);
+			ok = cudaDeviceSynchronize() == cudaSuccess && cudaGetLastError() == cudaSuccess &&
+				cudaMemcpy(out.data(), d_masks, out.size(), cudaMemcpyDeviceToHost) == cudaSuccess;
+		}
+		cudaFree(d_logits);
+		cudaFree(d_masks);
+		if (!ok)
+			reason = "CUDA error";
+		return ok;
+	}
+}
+
+//--------------------------------------------------------------------------
+// compare_golden
+//--------------------------------------------------------------------------
+bool GoldenDiff::within(const GoldenTolerance& tolerance) const {
+	if (!comparable)
+		return false;
+	if (differing == 0)
+		return true;
+	const bool ssim_ok = size.width < 11 || size.height < 11 || ssim >= tolerance.min_ssim;
+	return max_abs_error <= tolerance.max_abs_error && psnr >= tolerance.min_psnr && ssim_ok;
+}
+
+GoldenDiff compare_golden(const cv::Mat& fast, const cv::Mat& reference) {
+	GoldenDiff diff;
+	if (fast.empty() || fast.size() != reference.size() || fast.type() != reference.type() || fast.depth() != CV_8U)
+		return diff;
+	diff.comparable = true;
+	diff.size = fast.size();
+	diff.pixels = fast.total();
+
+	const int cn = fast.channels();
+	int min_x = fast.cols, min_y = fast.rows, max_x = -1, max_y = -1;
+	for (int y = 0; y < fast.rows; ++y) {
+		const uchar* a = fast.ptr<uchar>(y);
+		const uchar* b = reference.ptr<uchar>(y);
+		for (int x = 0; x < fast.cols; ++x) {
+			int error = 0;
+			for (int c = 0; c < cn; ++c)
+				error = std::max(error, std::abs(a[x * cn + c] - b[x * cn + c]));
+			if (error == 0)
+				continue;
+			if (diff.differing++ == 0)
+				diff.first = cv::Point(x, y);
+			diff.max_abs_error = std::max(diff.max_abs_error, error);
+			min_x = std::min(min_x, x);
+			max_x = std::max(max_x, x);
+			min_y = std::min(min_y, y);
+			max_y = std::max(max_y, y);
+		}
+	}
+	if (diff.differing > 0) {
+		diff.box = cv::Rect(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1);
+		const ImageProcessingUtil::ImageComparison quality = ImageProcessingUtil::compareImages(fast, reference, false);
+		diff.psnr = quality.psnr;
+		diff.ssim = quality.ssim;
+	}
+	return diff;
+}
+
+//--------------------------------------------------------------------------
+// Reference implementations
+//--------------------------------------------------------------------------
+cv::Mat mix_images_reference(const cv::Mat& src_img, const cv::Mat& dst_rgba, const cv::Mat& alpha, float key_scale) {
+	cv::Mat out(src_img.size(), CV_8UC4);
+	const int cn = src_img.channels();
+	const int scale = static_cast<int>(key_scale);
+	for (int y = 0; y < src_img.rows; ++y) {
+		for (int x = 0; x < src_img.cols; ++x) {
+			const uchar* src = src_img.ptr<uchar>(y) + x * cn;
+			const uchar* dst = dst_rgba.ptr<uchar>(y) + x * 4;
+			const uchar a = static_cast<uchar>((alpha.ptr<uchar>(y)[x] * scale) >> 8);
+			uchar* o = out.ptr<uchar>(y) + x * 4;
+			for (int k = 0; k < 4; ++k) {
+				const int s = k < cn ? src[k] : 255;   // BGR sources are opaque
+				o[k] = static_cast<uchar>(std::min(255, std::max(0, (s * (255 - a) + dst[k] * a) >> 8)));
+			}
+		}
+	}
+	return out;
+}
+
+cv::Mat glow_blow_reference(const cv::Mat& mask, int key, int delta, int* pixels, cv::Rect* box) {
+	cv::Mat out = cv::Mat::zeros(mask.size(), CV_8UC4);
+	int count = 0;
+	int min_x = mask.cols, min_y = mask.rows, max_x = -1, max_y = -1;
+	for (int y = 0; y < mask.rows; ++y) {
+		for (int x = 0; x < mask.cols; ++x) {
+			if (std::abs(mask.ptr<uchar>(y)[x] - key) >= delta)
+				continue;
+			out.ptr<cv::Vec4b>(y)[x] = cv::Vec4b(128, 0, 128, 255);
+			++count;
+			min_x = std::min(min_x, x);
+			max_x = std::max(max_x, x);
+			min_y = std::min(min_y, y);
+			max_y = std::max(max_y, y);
+		}
+	}
+	if (pixels)
+		*pixels = count;
+	if (box)
+		*box = count ? cv::Rect(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1) : cv::Rect();
+	return out;
+}
+
+cv::Mat gen_mipmap_reference(const cv::Mat& level) {
+	const int in_w = level.cols, in_h = level.rows, cn = level.channels();
+	const int out_w = std::max(1, in_w / 2), out_h = std::max(1, in_h / 2);
+	cv::Mat out(out_h, out_w, level.type());
+	const float px = 1.0f / static_cast<float>(out_w);
+	const float py = 1.0f / static_cast<float>(out_h);
+
+	// Texel index and 1/256-step weight of a normalized coordinate along one axis.
+	auto texel = [](float u, int size, int& i0, float& weight) {
+		const float t = u * size - 0.5f;
+		i0 = static_cast<int>(std::floor(t));
+		int frac = static_cast<int>(std::lround((t - i0) * 256.0f));
+		if (frac == 256) {
+			++i0;
+			frac = 0;
+		}
+		weight = frac / 256.0f;
+	};
+	auto at = [&](int x, int y, int c) {
+		x = std::min(std::max(x, 0), in_w - 1);
+		y = std::min(std::max(y, 0), in_h - 1);
+		return level.ptr<uchar>(y)[x * cn + c] / 255.0f;
+	};
+	auto tex2D = [&](float u, float v, int c) {
+		int x0, y0;
+		float a, b;
+		texel(u, in_w, x0, a);
+		texel(v, in_h, y0, b);
+		return (1.0f - a) * (1.0f - b) * at(x0, y0, c) + a * (1.0f - b) * at(x0 + 1, y0, c) +
+			(1.0f - a) * b * at(x0, y0 + 1, c) + a * b * at(x0 + 1, y0 + 1, c);
+	};
+
+	for (int y = 0; y < out_h; ++y) {
+		for (int x = 0; x < out_w; ++x) {
+			for (int c = 0; c < cn; ++c) {
+				float color = tex2D((x + 0.0f) * px, (y + 0.0f) * py, c) +
+					tex2D((x + 1.0f) * px, (y + 0.0f) * py, c) +
+					tex2D((x + 1.0f) * px, (y + 1.0f) * py, c) +
+					tex2D((x + 0.0f) * px, (y + 1.0f) * py, c);
+				color /= 4.0f;
+				color *= 255.0f;
+				out.ptr<uchar>(y)[x * cn + c] = static_cast<uchar>(std::min(color, 255.0f));
+			}
+		}
+	}
+	return out;
+}
+
+cv::Mat argmax_reference(const float* logits, int batch_index, int num_classes, int height, int width) {
+	cv::Mat mask(height, width, CV_8UC1);
+	const size_t plane = static_cast<size_t>(height) * width;
+	const float* image = logits + static_cast<size_t>(batch_index) * num_classes * plane;
+	for (size_t p = 0; p < plane; ++p) {
+		float best = -FLT_MAX;
+		int best_class = 0;
+		for (int c = 0; c < num_classes; ++c) {
+			if (image[c * plane + p] > best) {
+				best = image[c * plane + p];
+				best_class = c;
+			}
+		}
+		mask.data[p] = static_cast<uchar>(best_class * kClassLevelStep);
+	}
+	return mask;
+}
+
+//--------------------------------------------------------------------------
+// verify_golden_images
+//--------------------------------------------------------------------------
+bool verify_golden_images(const GoldenOptions& options) {
+	const std::vector<GoldenCase> corpus = golden_corpus(options.corpus_dir);
+	KernelTally mix{ "mix_images", kExact };
+	KernelTally blow{ "glow_blow", kExact };
+	KernelTally blow_rle{ "glow_blow (RleMask)", kExact };
+	KernelTally rgba{ "convert_mask_to_rgba_buffer", kExact };
+	KernelTally key_image{ "RleMask::key_image", kExact };
+	KernelTally mipmap{ "half_mipmap_level", kMipmap };
+	KernelTally argmax{ "argmax_class_masks", kExact };
+	KernelTally argmax_gpu{ "argmaxKernel (GPU)", kExact };
+	std::string gpu_skipped = options.gpu ? std::string() : "not requested";
+	std::mt19937 rng(7);
+
+	for (const GoldenCase& sample : corpus) {
+		const cv::Rect full(0, 0, sample.mask.cols, sample.mask.rows);
+		const RleMask rle = RleMask::encode(sample.mask);
+
+		for (const auto& key : kKeys) {
+			const std::string name = sample.name + " key " + std::to_string(key[0]) + "/" + std::to_string(key[1]);
+			int ref_pixels = 0;
+			cv::Rect ref_box;
+			const cv::Mat overlay = glow_blow_reference(sample.mask, key[0], key[1], &ref_pixels, &ref_box);
+
+			cv::Mat fast;
+			cv::Rect box;
+			int pixels;
+			{
+				bench::mute_cout quiet;   // glow_blow and mix_images report every call
+				pixels = glow_blow(sample.mask, fast, key[0], key[1], &box);
+			}
+			record(blow, name, fast, overlay, options, region_mismatch(pixels, box, ref_pixels, ref_box));
+			{
+				bench::mute_cout quiet;
+				pixels = glow_blow(rle, fast, key[0], key[1], &box);
+			}
+			record(blow_rle, name, fast, overlay, options, region_mismatch(pixels, box, ref_pixels, ref_box));
+
+			const cv::Mat keyed = key_image_reference(sample.mask, key[0]);
+			cv::Mat buffer(sample.mask.size(), CV_8UC4);
+			convert_mask_to_rgba_buffer(sample.mask, reinterpret_cast<uchar4*>(buffer.data), buffer.cols, buffer.rows, key[0]);
+			record(rgba, name, buffer, gray_to_rgba_reference(keyed), options);
+			record(key_image, name, rle.key_image(key[0], full), keyed, options);
+
+			cv::Mat alpha;
+			apply_mipmap_cpu(sample.mask, alpha, kGlowScale, key[0]);
+			const cv::Mat alphas[] = { alpha, noise_image(sample.mask.size(), CV_8UC1, rng) };
+			for (int a = 0; a < 2; ++a) {
+				for (float key_scale : kKeyScales) {
+					{
+						bench::mute_cout quiet;
+						mix_images(sample.frame, overlay, alphas[a], fast, key_scale);
+					}
+					record(mix, name + (a ? " noise alpha" : " glow alpha") + " scale " + std::to_string(int(key_scale)),
+						fast, mix_images_reference(sample.frame, overlay, alphas[a], key_scale), options);
+				}
+			}
+		}
+
+		// Glow layers hand convert_mask_to_rgba_buffer an already keyed image (negative key).
+		const cv::Mat keyed = rle.key_image(kKeys[0][0], full);
+		cv::Mat buffer(sample.mask.size(), CV_8UC4);
+		convert_mask_to_rgba_buffer(keyed, reinterpret_cast<uchar4*>(buffer.data), buffer.cols, buffer.rows, -1);
+		record(rgba, sample.name + " keyed", buffer, gray_to_rgba_reference(key_image_reference(keyed, -1)), options);
+
+		// Every pass of the chain down to 1x1, each from the reference level above it.
+		const cv::Mat inputs[] = { key_image_reference(sample.mask, kKeys[0][0]), sample.frame };
+		for (int i = 0; i < 2; ++i) {
+			cv::Mat level = inputs[i];
+			for (int l = 1; level.cols > 1 || level.rows > 1; ++l) {
+				const cv::Mat reference = gen_mipmap_reference(level);
+				record(mipmap, sample.name + (i ? " frame" : " key") + " level " + std::to_string(l),
+					half_mipmap_level(level), reference, options);
+				level = reference;
+			}
+		}
+
+		const int height = sample.mask.rows, width = sample.mask.cols;
+		const std::vector<float> logits = golden_logits(sample.mask, rng);
+		std::vector<cv::Mat> masks = argmax_class_masks(logits.data(), kClasses, height, width, 2);
+		std::vector<uchar> gpu_masks;
+		const bool gpu_ran = gpu_skipped.empty() && gpu_argmax(logits, 2, height, width, gpu_masks, gpu_skipped);
+		for (int b = 0; b < 2; ++b) {
+			const cv::Mat reference = argmax_reference(logits.data(), b, kClasses, height, width);
+			const std::string name = sample.name + " image " + std::to_string(b);
+			record(argmax, name, masks[b], reference, options);
+			if (gpu_ran) {
+				cv::Mat gpu(height, width, CV_8UC1, gpu_masks.data() + static_cast<size_t>(b) * height * width);
+				record(argmax_gpu, name, gpu, reference, options);
+			}
+		}
+	}
+
+	bool ok = report(mix);
+	ok = report(blow) && ok;
+	ok = report(blow_rle) && ok;
+	ok = report(rgba) && ok;
+	ok = report(key_image) && ok;
+	ok = report(mipmap) && ok;
+	ok = report(argmax) && ok;
+	if (gpu_skipped.empty())
+		ok = report(argmax_gpu) && ok;
+	else
+		std::cout << "Golden check: argmaxKernel (GPU): skipped, " << gpu_skipped << std::endl;
+	std::cout << "Golden check: " << corpus.size() << " frames: " << (ok ? "PASSED" : "FAILED") << std::endl;
+	return ok;
+}
@@ -0,0 +1,95 @@
+#ifndef GOLDEN_IMAGES_HPP
+#define GOLDEN_IMAGES_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief How far an optimized kernel may stray from its reference implementation.
+ */
+struct GoldenTolerance {
+	int max_abs_error = 0;     ///< Largest per-channel difference; 0 demands bit-exact output.
+	double min_psnr = 0.0;     ///< dB, checked when the outputs differ.
+	double min_ssim = 0.0;     ///< Checked when the outputs differ on at least 11x11 pixels (the SSIM window).
+};
+
+/**
+ * @brief Where and how much a fast output differs from the reference output (8-bit images).
+ */
+struct GoldenDiff {
+	bool comparable = false;      ///< Same size, type and 8-bit depth.
+	cv::Size size;                ///< Size of the compared images.
+	uint64_t pixels = 0;          ///< Pixels compared.
+	uint64_t differing = 0;       ///< Pixels with at least one differing channel.
+	int max_abs_error = 0;        ///< Largest per-channel difference.
+	cv::Point first;              ///< First differing pixel in row order.
+	cv::Rect box;                 ///< Bounding box of the differing pixels.
+	double psnr = 0.0;            ///< dB (ImageProcessingUtil::compareImages); 0 when identical.
+	double ssim = 1.0;            ///< ImageProcessingUtil::computeSSIM; 1 when identical.
+
+	bool within(const GoldenTolerance& tolerance) const;
+};
+
+/**
+ * @brief Compares fast against reference pixel by pixel, plus PSNR / SSIM when they differ.
+ */
+GoldenDiff compare_golden(const cv::Mat& fast, const cv::Mat& reference);
+
+/**
+ * @brief Reference of mix_images: the scalar integer blend, one pixel at a time.
+ *
+ * src_img is BGR or BGRA, dst_rgba BGRA, alpha CV_8UC1 (the CPU mipmap output). Per channel
+ * out = (src * (255 - a) + dst * a) >> 8 with a = uchar((alpha * int(key_scale)) >> 8); the
+ * uchar truncation of a is part of today's behavior.
+ */
+cv::Mat mix_images_reference(const cv::Mat& src_img, const cv::Mat& dst_rgba, const cv::Mat& alpha, float key_scale);
+
+/**
+ * @brief Reference of the glow_blow key test: overlay color (128, 0, 128, 255) where
+ *        |mask - key| < delta, zero elsewhere; counts the pixels and boxes them.
+ */
+cv::Mat glow_blow_reference(const cv::Mat& mask, int key, int delta, int* pixels = nullptr, cv::Rect* box = nullptr);
+
+/**
+ * @brief Reference of one d_gen_mipmap pass on the CPU, fetch by fetch.
+ *
+ * Output size is half the input (at least 1x1). Each output texel (x, y) averages the four
+ * linear-filtered fetches at the normalized coordinates ((x + i) / w, (y + j) / h), i, j in
+ * {0, 1}, as the texture unit computes them: texels read as normalized floats, clamp addressing,
+ * blend weights in 1/256 steps. The float average is scaled to 0..255, clamped and truncated as
+ * in to_uchar4.
+ */
+cv::Mat gen_mipmap_reference(const cv::Mat& level);
+
+/**
+ * @brief Reference of argmaxKernel for one image of [batch, classes, height, width] logits:
+ *        running maximum from -FLT_MAX, strictly greater wins, class index * kClassLevelStep.
+ */
+cv::Mat argmax_reference(const float* logits, int batch_index, int num_classes, int height, int width);
+
+/**
+ * @brief Settings of the golden-image check.
+ */
+struct GoldenOptions {
+	std::string corpus_dir;   ///< Stored images (jpg, png, bmp) added to the synthetic corpus; empty for none.
+	std::string diff_dir;     ///< Diverging cases write fast, reference and difference PNGs here; empty for none.
+	bool gpu = false;         ///< Also compares argmaxKernel on the GPU with the reference.
+};
+
+/**
+ * @brief Golden-image regression check: runs the reference implementations and the fast paths
+ *        (mix_images; glow_blow on cv::Mat and RleMask, convert_mask_to_rgba_buffer and
+ *        RleMask::key_image; half_mipmap_level; argmax_class_masks, and argmaxKernel with
+ *        options.gpu) on synthetic frames and masks of several sizes, odd ones included, and
+ *        the stored images, and reports every case outside its tolerance with its location.
+ *
+ * All are bit-exact except half_mipmap_level, which sums in integers and rounds where
+ * d_gen_mipmap sums floats and truncates (max error 1, PSNR >= 45 dB, SSIM >= 0.99).
+ *
+ * @return true if every case is within its tolerance.
+ */
+bool verify_golden_images(const GoldenOptions& options = GoldenOptions());
+
+#endif // GOLDEN_IMAGES_HPP
@@ -0,0 +1,16 @@
+#ifndef IMAGE_COMPARE_HPP
+#define IMAGE_COMPARE_HPP
+
+#include <opencv2/core.hpp>
+
+/**
+ * @brief True if a and b have the same size, type and pixels (exact comparison), as the
+ *        headless checks require of a fast path and its reference.
+ */
+inline bool same_pixels(const cv::Mat& a, const cv::Mat& b) {
+	if (a.size() != b.size() || a.type() != b.type())
+		return false;
+	return a.empty() || cv::norm(a, b, cv::NORM_INF) == 0;
+}
+
+#endif // IMAGE_COMPARE_HPP
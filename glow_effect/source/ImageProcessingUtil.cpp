@@ -3,7 +3,7 @@
  * @brief Implements image-related utility functions for loading and processing images.
  *
  * This file includes functions for retrieving image paths, extracting image shapes,
- * comparing images (using PSNR), and converting images or batches of images
+ * comparing images (using PSNR and SSIM), and converting images or batches of images
  * to Torch tensors for inference.
  */
 
@@ -18,6 +18,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <opencv2/cudacodec.hpp>
+#include "movie_effect/include/tools_task.h"
 #include <opencv2/cudaimgproc.hpp>
 
  /**
@@ -58,30 +59,95 @@ cv::Vec4f ImageProcessingUtil::get_input_shape_from_image(const std::string& img
 }
 
 /**
- * @brief Compares a generated image with a reference grayscale image, computing PSNR.
+ * @brief Compares a generated image with a reference image, computing PSNR and SSIM.
  *
- * @param generated_img The generated image (float or double Mat, range typically 0..1).
- * @param gray_original The reference grayscale image.
- * @note Logs the PSNR result to std::cout.
+ * @param generated_img The generated image (float images in 0..1, 8-bit images in 0..255).
+ * @param gray_original The reference image, same size and type.
+ * @param verbose Logs the sizes and results to std::cout.
+ * @return PSNR and SSIM, both 0 if the images differ in size or type.
  */
-void ImageProcessingUtil::compareImages(const cv::Mat& generated_img, const cv::Mat& gray_original) {
-	cv::Mat generated_img_clamped;
-
-	// Clamp values to the range [0, 1]
-	cv::min(generated_img, 1.0, generated_img_clamped);
-	cv::max(generated_img_clamped, 0.0, generated_img_clamped);
+ImageProcessingUtil::ImageComparison ImageProcessingUtil::compareImages(const cv::Mat& generated_img, const cv::Mat& gray_original,
+	bool verbose) {
+	ImageComparison result;
+	if (verbose) {
+		std::cout << "generated_img size: " << generated_img.rows << "x" << generated_img.cols
+			<< " type: " << generated_img.type() << std::endl;
+		std::cout << "gray_original size: " << gray_original.rows << "x" << gray_original.cols
+			<< " type: " << gray_original.type() << std::endl;
+	}
+	if (generated_img.empty() || generated_img.size() != gray_original.size() || generated_img.type() != gray_original.type()) {
+		std::cerr << "Error: compareImages needs two images of the same size and type." << std::endl;
+		return result;
+	}
 
-	std::cout << "generated_img size: " << generated_img.rows << "x" << generated_img.cols
-		<< " type: " << generated_img.type() << std::endl;
-	std::cout << "gray_original size: " << gray_original.rows << "x" << gray_original.cols
-		<< " type: " << gray_original.type() << std::endl;
+	// Clamp float values to the range [0, 1] in a copy; the caller's image stays as it is.
+	const bool is_float = generated_img.depth() == CV_32F || generated_img.depth() == CV_64F;
+	cv::Mat generated_img_clamped;
+	if (is_float) {
+		cv::min(generated_img, 1.0, generated_img_clamped);
+		cv::max(generated_img_clamped, 0.0, generated_img_clamped);
+	}
+	else {
+		generated_img_clamped = generated_img;
+	}
 
-	double psnr = cv::PSNR(generated_img, gray_original);
-	std::cout << "PSNR: " << psnr << std::endl;
+	result.psnr = cv::PSNR(generated_img_clamped, gray_original, is_float ? 1.0 : 255.0);
+	result.ssim = computeSSIM(generated_img_clamped, gray_original);
+	if (verbose) {
+		std::cout << "PSNR: " << result.psnr << std::endl;
+		std::cout << "SSIM: " << result.ssim << std::endl;
+	}
+	return result;
+}
 
-	// The following SSIM computation was removed because cv::quality::QualitySSIM
-	// is not available in your OpenCV build.
-	std::cout << "SSIM: not computed (cv::quality::QualitySSIM not available)" << std::endl;
+/**
+ * @brief Mean SSIM of two images of the same size and type.
+ *
+ * @param img1 First image.
+ * @param img2 Second image.
+ * @return The SSIM map averaged over the image and the channels; 0 if the images cannot be compared.
+ */
+double ImageProcessingUtil::computeSSIM(const cv::Mat& img1, const cv::Mat& img2) {
+	if (img1.empty() || img1.size() != img2.size() || img1.type() != img2.type())
+		return 0.0;
+
+	const int depth = img1.depth();
+	const double range = (depth == CV_32F || depth == CV_64F) ? 1.0 : (depth == CV_16U ? 65535.0 : 255.0);
+	const double C1 = (0.01 * range) * (0.01 * range);
+	const double C2 = (0.03 * range) * (0.03 * range);
+	const cv::Size window(11, 11);
+	const double sigma = 1.5;
+
+	// Double precision keeps sigma = E[x^2] - E[x]^2 from cancelling on flat regions.
+	cv::Mat I1, I2;
+	img1.convertTo(I1, CV_64F);
+	img2.convertTo(I2, CV_64F);
+
+	cv::Mat mu1, mu2;
+	cv::GaussianBlur(I1, mu1, window, sigma);
+	cv::GaussianBlur(I2, mu2, window, sigma);
+	cv::Mat mu1_2 = mu1.mul(mu1);
+	cv::Mat mu2_2 = mu2.mul(mu2);
+	cv::Mat mu1_mu2 = mu1.mul(mu2);
+
+	cv::Mat sigma1_2, sigma2_2, sigma12;
+	cv::GaussianBlur(I1.mul(I1), sigma1_2, window, sigma);
+	sigma1_2 -= mu1_2;
+	cv::GaussianBlur(I2.mul(I2), sigma2_2, window, sigma);
+	sigma2_2 -= mu2_2;
+	cv::GaussianBlur(I1.mul(I2), sigma12, window, sigma);
+	sigma12 -= mu1_mu2;
+
+	cv::Mat numerator = (2 * mu1_mu2 + C1).mul(2 * sigma12 + C2);
+	cv::Mat denominator = (mu1_2 + mu2_2 + C1).mul(sigma1_2 + sigma2_2 + C2);
+	cv::Mat ssim_map;
+	cv::divide(numerator, denominator, ssim_map);
+
+	const cv::Scalar channel_ssim = cv::mean(ssim_map);
+	double ssim = 0.0;
+	for (int c = 0; c < img1.channels(); ++c)
+		ssim += channel_ssim[c];
+	return ssim / img1.channels();
 }
 
 /**
@@ -201,43 +267,48 @@ torch::Tensor ImageProcessingUtil::process_img(const cv::cuda::GpuMat& process_i
  * @throws std::invalid_argument if any image fails to load.
  */
 torch::Tensor ImageProcessingUtil::process_img_batch(const std::vector<std::string>& img_paths, bool grayscale) {
-	std::vector<torch::Tensor> img_tensors;
-	img_tensors.reserve(img_paths.size());
-
-	for (const auto& img_path : img_paths) {
-		cv::Mat img;
-		if (grayscale) {
-			img = cv::imread(img_path, cv::IMREAD_GRAYSCALE);
-			if (img.empty()) {
-				throw std::invalid_argument("Failed to load image at " + img_path);
+	// Each image is decoded and normalized as its own task; the first load failure is re-thrown by wait().
+	std::vector<torch::Tensor> img_tensors(img_paths.size());
+	task::group loaders;
+
+	for (size_t idx = 0; idx < img_paths.size(); ++idx) {
+		loaders.run([&, idx]() {
+			const std::string& img_path = img_paths[idx];
+			cv::Mat img;
+			if (grayscale) {
+				img = cv::imread(img_path, cv::IMREAD_GRAYSCALE);
+				if (img.empty()) {
+					throw std::invalid_argument("Failed to load image at " + img_path);
+				}
+				img.convertTo(img, CV_32FC1, 1.0f / 255.0f);
+
+				auto img_tensor = torch::from_blob(img.data, { img.rows, img.cols, 1 }, torch::kFloat32).clone();
+				img_tensor = img_tensor.unsqueeze(0); // Add batch dimension
+				img_tensors[idx] = img_tensor;
 			}
-			img.convertTo(img, CV_32FC1, 1.0f / 255.0f);
-
-			auto img_tensor = torch::from_blob(img.data, { img.rows, img.cols, 1 }, torch::kFloat32).clone();
-			img_tensor = img_tensor.unsqueeze(0); // Add batch dimension
-			img_tensors.push_back(img_tensor);
-		}
-		else {
-			img = cv::imread(img_path, cv::IMREAD_COLOR);
-			if (img.empty()) {
-				throw std::invalid_argument("Failed to load image at " + img_path);
+			else {
+				img = cv::imread(img_path, cv::IMREAD_COLOR);
+				if (img.empty()) {
+					throw std::invalid_argument("Failed to load image at " + img_path);
+				}
+				img.convertTo(img, CV_32FC3, 1.0f / 255.0f);
+
+				auto img_tensor = torch::from_blob(img.data, { img.rows, img.cols, 3 }, torch::kFloat32).clone();
+				img_tensor = img_tensor.permute({ 2, 0, 1 });
+				// Convert BGR to RGB:
+				auto rgb_tensor = img_tensor.index_select(0, torch::tensor({ 2, 1, 0 }));
+				auto din = rgb_tensor.unsqueeze(0);
+
+				// Normalize the tensor
+				auto mean = torch::tensor({ 0.485f, 0.456f, 0.406f }).view({ 1, 3, 1, 1 }).to(din.options());
+				auto std = torch::tensor({ 0.229f, 0.224f, 0.225f }).view({ 1, 3, 1, 1 }).to(din.options());
+				auto din_normalized = (din - mean) / std;
+
+				img_tensors[idx] = din_normalized;
 			}
-			img.convertTo(img, CV_32FC3, 1.0f / 255.0f);
-
-			auto img_tensor = torch::from_blob(img.data, { img.rows, img.cols, 3 }, torch::kFloat32).clone();
-			img_tensor = img_tensor.permute({ 2, 0, 1 });
-			// Convert BGR to RGB:
-			auto rgb_tensor = img_tensor.index_select(0, torch::tensor({ 2, 1, 0 }));
-			auto din = rgb_tensor.unsqueeze(0);
-
-			// Normalize the tensor
-			auto mean = torch::tensor({ 0.485f, 0.456f, 0.406f }).view({ 1, 3, 1, 1 }).to(din.options());
-			auto std = torch::tensor({ 0.229f, 0.224f, 0.225f }).view({ 1, 3, 1, 1 }).to(din.options());
-			auto din_normalized = (din - mean) / std;
-
-			img_tensors.push_back(din_normalized);
-		}
+		});
 	}
+	loaders.wait();
 
 	// Concatenate along the batch dimension (dim=0)
 	auto batched_tensor = torch::cat(img_tensors, 0);
@@ -35,14 +35,37 @@ public:
 	 */
 	static cv::Vec4f get_input_shape_from_image(const std::string& img_path);
 
+	/**
+	 * @brief PSNR and SSIM of two images (see compareImages).
+	 */
+	struct ImageComparison {
+		double psnr = 0.0;   ///< dB; about 361 for identical images.
+		double ssim = 0.0;   ///< Mean SSIM, 1 for identical images.
+	};
+
 	/**
 	 * @brief Compares two images using PSNR and SSIM metrics.
 	 *
-	 * @param generated_img The generated image (expected as a float/double Mat, range typically [0,1]).
-	 * @param gray_original The reference grayscale image.
-	 * @note The results are logged to std::cout.
+	 * Float images are taken as [0,1] (generated_img is clamped to it), 8-bit images as [0,255].
+	 *
+	 * @param generated_img The generated image.
+	 * @param gray_original The reference image, same size and type.
+	 * @param verbose Logs the sizes and results to std::cout.
+	 * @return PSNR and SSIM; both 0 if the images cannot be compared.
+	 */
+	static ImageComparison compareImages(const cv::Mat& generated_img, const cv::Mat& gray_original, bool verbose = true);
+
+	/**
+	 * @brief Mean structural similarity (Wang et al. 2004) of two images of the same size and type.
+	 *
+	 * Local statistics over an 11x11 Gaussian window (sigma 1.5), K1 = 0.01, K2 = 0.03 of the
+	 * dynamic range (1 for float, 255 for 8-bit, 65535 for 16-bit images); the SSIM map is averaged
+	 * over the image and then over the channels. Replaces cv::quality::QualitySSIM, which the
+	 * OpenCV build lacks.
+	 *
+	 * @return SSIM in [-1, 1]; 0 if the images cannot be compared.
 	 */
-	static void compareImages(const cv::Mat& generated_img, const cv::Mat& gray_original);
+	static double computeSSIM(const cv::Mat& img1, const cv::Mat& img2);
 
 	/**
 	 * @brief Processes an image from a file and returns it as a Torch tensor.
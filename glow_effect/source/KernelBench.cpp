@@ -0,0 +1,136 @@
+/**
+ * @file KernelBench.cpp
+ * @brief Microbenchmarks of the CPU hot kernels at the standard frame sizes.
+ */
+
+#include "KernelBench.hpp"
+#include "glow_effect.hpp"
+#include "GlowClasses.hpp"
+#include "MipmapCPU.hpp"
+#include "SyntheticClip.hpp"
+#include "ImageProcessingUtil.hpp"
+#include "TRTInference.hpp"
+#include "gaussian_blur.hpp"
+#include "movie_effect/include/tools_bench.h"
+
+#include <filesystem>
+#include <memory>
+#include <opencv2/imgcodecs.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+	const int kKeyLevel = 56;
+	const int kDelta = 20;
+	const float kScale = 10.0f;
+	const int kKeyScale = 600;
+	const int kClasses = 21;
+
+	// Frame and class mask of a one-frame synthetic clip: a textured background with the key
+	// object (kKeyLevel in the mask) covering about a sixteenth of the frame.
+	SyntheticClip bench_frame(const bench::frame_size& size) {
+		SyntheticClipSpec spec;
+		spec.width = size.width;
+		spec.height = size.height;
+		spec.scene_lengths = { 1 };
+		spec.object_size = size.height / 4;
+		spec.object_class = kKeyLevel;
+		return make_synthetic_clip(spec);
+	}
+
+	// Logits whose argmax is the class of the mask, with a second-best class close behind.
+	std::shared_ptr<std::vector<float>> bench_logits(const cv::Mat& mask) {
+		const size_t plane = mask.total();
+		auto logits = std::make_shared<std::vector<float>>(kClasses * plane, 0.0f);
+		uint32_t noise = 12345;
+		for (size_t p = 0; p < plane; ++p) {
+			const int cls = mask.data[p] / kClassLevelStep;
+			for (int c = 0; c < kClasses; ++c) {
+				noise = noise * 1664525u + 1013904223u;
+				(*logits)[c * plane + p] = (c == cls ? 4.0f : 0.0f) + (noise >> 8) * (1.0f / (1 << 24));
+			}
+		}
+		return logits;
+	}
+}
+
+//--------------------------------------------------------------------------
+// benchmark_cpu_kernels
+//--------------------------------------------------------------------------
+void benchmark_cpu_kernels() {
+	bench::report_header("CPU kernel microbenchmarks (synthetic frames, shared task scheduler)");
+	bench::mute_cout quiet;   // the kernels report every call on std::cout
+
+	bench::run_sizes("glow_blow", [](const bench::frame_size& size) {
+		cv::Mat mask = bench_frame(size).masks[0];
+		auto overlay = std::make_shared<cv::Mat>();
+		return [mask, overlay]() { glow_blow(mask, *overlay, kKeyLevel, kDelta); };
+	});
+
+	bench::run_sizes("convert_mask_to_rgba_buffer", [](const bench::frame_size& size) {
+		cv::Mat mask = bench_frame(size).masks[0];
+		auto rgba = std::make_shared<std::vector<uchar4>>(mask.total());
+		return [mask, rgba]() {
+			convert_mask_to_rgba_buffer(mask, rgba->data(), mask.cols, mask.rows, kKeyLevel);
+			bench::keep(rgba->data());
+		};
+	});
+
+	bench::run_sizes("mix_images", [](const bench::frame_size& size) {
+		SyntheticClip clip = bench_frame(size);
+		cv::Mat overlay, glow;
+		glow_blow(clip.masks[0], overlay, kKeyLevel, kDelta);
+		apply_mipmap_cpu(clip.masks[0], glow, kScale, kKeyLevel);
+		cv::Mat frame = clip.frames[0];
+		auto output = std::make_shared<cv::Mat>();
+		return [frame, overlay, glow, output]() { mix_images(frame, overlay, glow, *output, static_cast<float>(kKeyScale)); };
+	});
+
+	bench::run_sizes("apply_mipmap_cpu", [](const bench::frame_size& size) {
+		cv::Mat mask = bench_frame(size).masks[0];
+		auto glow = std::make_shared<cv::Mat>();
+		return [mask, glow]() { apply_mipmap_cpu(mask, *glow, kScale, kKeyLevel); };
+	});
+
+	bench::run_sizes("gaussian_blur_op<uchar> (k 15)", [](const bench::frame_size& size) {
+		cv::Mat mask = bench_frame(size).masks[0];
+		auto blurred = std::make_shared<cv::Mat>(mask.size(), CV_8UC1);
+		return [mask, blurred]() {
+			gaussian_blur_op<uchar> blur;
+			blur(mask.cols, mask.rows, 15, 5.0f, mask.data, blurred->data);
+		};
+	});
+
+	bench::report_skipped("dilate_erode_op",
+		"hor_op / ver_op load a fixed segmentation image instead of filtering their input");
+
+	// process_img takes a path; a BMP keeps the decode cost small next to the tensor conversion.
+	const std::filesystem::path temp = std::filesystem::temp_directory_path();
+	bench::run_sizes("process_img (BMP load + normalize)", [&temp](const bench::frame_size& size) {
+		const std::string path = (temp / ("glow_bench_" + std::string(size.name) + ".bmp")).string();
+		cv::imwrite(path, bench_frame(size).frames[0]);
+		return [path]() {
+			torch::Tensor tensor = ImageProcessingUtil::process_img(path, false);
+			bench::keep(tensor.data_ptr());
+		};
+	});
+	for (const bench::frame_size& size : bench::sizes()) {
+		std::error_code ec;
+		std::filesystem::remove(temp / ("glow_bench_" + std::string(size.name) + ".bmp"), ec);
+	}
+
+	// 21-class float logits of a 4K frame would take 700 MB; the engines output 384x384.
+	for (const bench::frame_size& size : bench::sizes()) {
+		if (size.width * static_cast<size_t>(size.height) > 1920 * 1080) {
+			bench::report_skipped("argmax_class_masks (21 classes)", "4K logits would take 700 MB");
+			continue;
+		}
+		cv::Mat mask = bench_frame(size).masks[0];
+		std::shared_ptr<std::vector<float>> logits = bench_logits(mask);
+		bench::report(bench::run("argmax_class_masks (21 classes)", size, [&]() {
+			std::vector<cv::Mat> masks = argmax_class_masks(logits->data(), kClasses, size.height, size.width, 1);
+			bench::keep(masks[0].data);
+		}));
+	}
+	std::printf("---------------------------------------------------\n");
+}
@@ -0,0 +1,15 @@
+#ifndef KERNEL_BENCH_HPP
+#define KERNEL_BENCH_HPP
+
+/**
+ * @brief Microbenchmarks of the CPU hot kernels of the glow on synthetic inputs.
+ *
+ * Every kernel runs at 720p, 1080p and 4K (bench::sizes in tools_bench.h) and is reported as
+ * best / median ms per call and Mpix/s, in a fixed-width table that can be diffed between builds:
+ * glow_blow, convert_mask_to_rgba_buffer, mix_images, apply_mipmap_cpu (the CPU mipmap backend),
+ * gaussian_blur_op, ImageProcessingUtil::process_img and argmax_class_masks. The movie_effect
+ * kernels (color_polarizer, dynamic_defocus) are measured by movie_effect.exe bench.
+ */
+void benchmark_cpu_kernels();
+
+#endif // KERNEL_BENCH_HPP
@@ -0,0 +1,415 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @brief Log-linear latency histograms, per-run stage reports and their CSV / JSON export.
+ */
+
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <thread>
+
+const char* const LatencyReport::kEndToEnd = "end-to-end";
+
+namespace {
+	int highest_bit(uint64_t v) {
+		int bit = 0;
+		for (int shift = 32; shift > 0; shift >>= 1) {
+			if (v >> shift) {
+				v >>= shift;
+				bit += shift;
+			}
+		}
+		return bit;
+	}
+
+	double ns_to_ms(double ns) {
+		return ns * 1e-6;
+	}
+
+	void atomic_min(std::atomic<uint64_t>& target, uint64_t value) {
+		uint64_t seen = target.load(std::memory_order_relaxed);
+		while (value < seen && !target.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+	}
+
+	void atomic_max(std::atomic<uint64_t>& target, uint64_t value) {
+		uint64_t seen = target.load(std::memory_order_relaxed);
+		while (value > seen && !target.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+	}
+
+	// Percentile q of the values counted by count_at(bucket), total of them, clamped to lo..hi (ns).
+	template <typename CountAt>
+	double percentile_of(CountAt count_at, uint64_t total, double q, uint64_t lo, uint64_t hi) {
+		if (total == 0)
+			return 0.0;
+		const double wanted = std::ceil(std::min(std::max(q, 0.0), 100.0) / 100.0 * static_cast<double>(total));
+		const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(wanted));
+		uint64_t seen = 0;
+		for (size_t b = 0; b < LatencyHistogram::kBuckets; ++b) {
+			seen += count_at(b);
+			if (seen < rank)
+				continue;
+			const uint64_t lower = LatencyHistogram::bucket_lower_ns(b);
+			const uint64_t upper = LatencyHistogram::bucket_lower_ns(b + 1) - 1;
+			const double value = 0.5 * (static_cast<double>(lower) + static_cast<double>(upper));
+			return ns_to_ms(std::min(std::max(value, static_cast<double>(lo)), static_cast<double>(hi)));
+		}
+		return ns_to_ms(static_cast<double>(hi));
+	}
+
+	void json_string(std::ostream& out, const std::string& s) {
+		out << '"';
+		for (char c : s) {
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20)
+				out << ' ';
+			else
+				out << c;
+		}
+		out << '"';
+	}
+
+	const double kPercentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+}
+
+//--------------------------------------------------------------------------
+// LatencyHistogram
+//--------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram() : counts(new std::atomic<uint64_t>[kBuckets]) {
+	for (size_t b = 0; b < kBuckets; ++b)
+		counts[b].store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::bucket_of(uint64_t ns) {
+	if (ns < kLinear)
+		return static_cast<size_t>(ns);
+	ns = std::min(ns, (uint64_t(1) << kMaxBits) - 1);
+	const int shift = highest_bit(ns) - kSubBits;
+	return (static_cast<size_t>(shift) << kSubBits) + static_cast<size_t>(ns >> shift);
+}
+
+uint64_t LatencyHistogram::bucket_lower_ns(size_t bucket) {
+	if (bucket < kLinear)
+		return bucket;
+	const int shift = static_cast<int>(bucket >> kSubBits) - 1;
+	return static_cast<uint64_t>(bucket - (static_cast<size_t>(shift) << kSubBits)) << shift;
+}
+
+void LatencyHistogram::record_ns(uint64_t ns) {
+	counts[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+	sum_ns.fetch_add(ns, std::memory_order_relaxed);
+	atomic_min(min_value, ns);
+	atomic_max(max_value, ns);
+	total.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+	for (size_t b = 0; b < kBuckets; ++b) {
+		const uint64_t n = other.bucket_count(b);
+		if (n)
+			counts[b].fetch_add(n, std::memory_order_relaxed);
+	}
+	if (other.count() == 0)
+		return;
+	sum_ns.fetch_add(other.sum_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	atomic_min(min_value, other.min_value.load(std::memory_order_relaxed));
+	atomic_max(max_value, other.max_value.load(std::memory_order_relaxed));
+	total.fetch_add(other.count(), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+	for (size_t b = 0; b < kBuckets; ++b)
+		counts[b].store(0, std::memory_order_relaxed);
+	total.store(0, std::memory_order_relaxed);
+	sum_ns.store(0, std::memory_order_relaxed);
+	min_value.store(UINT64_MAX, std::memory_order_relaxed);
+	max_value.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::min_ms() const {
+	return count() ? ns_to_ms(static_cast<double>(min_value.load(std::memory_order_relaxed))) : 0.0;
+}
+
+double LatencyHistogram::max_ms() const {
+	return ns_to_ms(static_cast<double>(max_value.load(std::memory_order_relaxed)));
+}
+
+double LatencyHistogram::mean_ms() const {
+	const uint64_t n = count();
+	return n ? ns_to_ms(static_cast<double>(sum_ns.load(std::memory_order_relaxed)) / n) : 0.0;
+}
+
+double LatencyHistogram::percentile_ms(double q) const {
+	uint64_t n = 0;
+	for (size_t b = 0; b < kBuckets; ++b)
+		n += bucket_count(b);
+	return percentile_of([this](size_t b) { return bucket_count(b); }, n, q,
+		min_value.load(std::memory_order_relaxed), max_value.load(std::memory_order_relaxed));
+}
+
+//--------------------------------------------------------------------------
+// LatencyReport
+//--------------------------------------------------------------------------
+LatencyReport::LatencyReport(const std::string& report_title, const LatencyOptions& report_options)
+	: title(report_title), options(report_options) {}
+
+LatencyHistogram& LatencyReport::stage(const std::string& name) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (Stage& s : stages) {
+		if (s.name == name)
+			return *s.histogram;
+	}
+	stages.emplace_back();
+	Stage& s = stages.back();
+	s.name = name;
+	s.histogram.reset(new LatencyHistogram());
+	if (options.report_every > 0)
+		s.reported.assign(LatencyHistogram::kBuckets, 0);
+	return *s.histogram;
+}
+
+void LatencyReport::frame_done() {
+	++frames;
+	if (options.report_every <= 0 || frames % options.report_every != 0)
+		return;
+
+	// Percentiles of the values recorded since the last interval report.
+	std::string line = "Latency, frames " + std::to_string(frames - options.report_every + 1) + "-" +
+		std::to_string(frames) + " (ms):";
+	std::lock_guard<std::mutex> lock(mutex);
+	for (Stage& s : stages) {
+		const LatencyHistogram& h = *s.histogram;
+		std::vector<uint64_t> now(LatencyHistogram::kBuckets);
+		uint64_t n = 0, highest = 0;
+		for (size_t b = 0; b < now.size(); ++b) {
+			now[b] = h.bucket_count(b);
+			const uint64_t added = now[b] - s.reported[b];
+			n += added;
+			if (added)
+				highest = LatencyHistogram::bucket_lower_ns(b + 1) - 1;
+		}
+		if (n > 0) {
+			const uint64_t lo = static_cast<uint64_t>(h.min_ms() * 1e6);
+			const uint64_t hi = std::min(highest, static_cast<uint64_t>(h.max_ms() * 1e6 + 0.5));
+			auto added_at = [&](size_t b) { return now[b] - s.reported[b]; };
+			char text[160];
+			std::snprintf(text, sizeof(text), " %s p50 %.2f p90 %.2f p99 %.2f max %.2f;", s.name.c_str(),
+				percentile_of(added_at, n, 50.0, lo, hi), percentile_of(added_at, n, 90.0, lo, hi),
+				percentile_of(added_at, n, 99.0, lo, hi), ns_to_ms(static_cast<double>(hi)));
+			line += text;
+		}
+		s.reported.swap(now);
+	}
+	std::cout << line << std::endl;
+}
+
+void LatencyReport::print() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::printf("Latency: %s (%llu frames, ms)\n", title.c_str(), static_cast<unsigned long long>(frames));
+	std::printf("%-20s %8s %9s %9s %9s %9s %9s %9s %9s\n", "stage", "count", "min", "mean", "p50", "p90", "p99",
+		"p99.9", "max");
+	for (const Stage& s : stages) {
+		const LatencyHistogram& h = *s.histogram;
+		std::printf("%-20s %8llu %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", s.name.c_str(),
+			static_cast<unsigned long long>(h.count()), h.min_ms(), h.mean_ms(), h.percentile_ms(kPercentiles[0]),
+			h.percentile_ms(kPercentiles[1]), h.percentile_ms(kPercentiles[2]), h.percentile_ms(kPercentiles[3]),
+			h.max_ms());
+	}
+	if (options.p99_target_ms <= 0.0)
+		return;
+	for (const Stage& s : stages) {
+		if (s.name != kEndToEnd)
+			continue;
+		const double p99 = s.histogram->percentile_ms(99.0);
+		std::printf("p99 target %.2f ms: %s p99 %.3f ms, %s\n", options.p99_target_ms, kEndToEnd, p99,
+			p99 <= options.p99_target_ms ? "MET" : "MISSED");
+	}
+}
+
+bool LatencyReport::sla_met() const {
+	if (options.p99_target_ms <= 0.0)
+		return true;
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const Stage& s : stages) {
+		if (s.name == kEndToEnd)
+			return s.histogram->percentile_ms(99.0) <= options.p99_target_ms;
+	}
+	return true;
+}
+
+bool LatencyReport::write_csv(const std::string& path) const {
+	std::ofstream out(path, std::ios::binary);
+	if (!out.is_open())
+		return false;
+	out << "stage,count,min_ms,mean_ms,p50_ms,p90_ms,p99_ms,p99.9_ms,max_ms\n";
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const Stage& s : stages) {
+		const LatencyHistogram& h = *s.histogram;
+		out << s.name << ',' << h.count() << ',' << h.min_ms() << ',' << h.mean_ms();
+		for (double q : kPercentiles)
+			out << ',' << h.percentile_ms(q);
+		out << ',' << h.max_ms() << '\n';
+	}
+	return static_cast<bool>(out);
+}
+
+bool LatencyReport::write_json(const std::string& path) const {
+	std::ofstream out(path, std::ios::binary);
+	if (!out.is_open())
+		return false;
+	std::lock_guard<std::mutex> lock(mutex);
+	out << "{\"title\":";
+	json_string(out, title);
+	out << ",\"frames\":" << frames << ",\"p99_target_ms\":" << options.p99_target_ms << ",\"stages\":[";
+	for (size_t i = 0; i < stages.size(); ++i) {
+		const LatencyHistogram& h = *stages[i].histogram;
+		out << (i ? ",\n" : "\n") << "{\"name\":";
+		json_string(out, stages[i].name);
+		out << ",\"count\":" << h.count() << ",\"min_ms\":" << h.min_ms() << ",\"mean_ms\":" << h.mean_ms()
+			<< ",\"p50_ms\":" << h.percentile_ms(50.0) << ",\"p90_ms\":" << h.percentile_ms(90.0)
+			<< ",\"p99_ms\":" << h.percentile_ms(99.0) << ",\"p999_ms\":" << h.percentile_ms(99.9)
+			<< ",\"max_ms\":" << h.max_ms() << ",\"buckets\":[";
+		// Non-empty buckets as [lowest value in ms, count]; enough to merge or re-plot runs.
+		bool first = true;
+		for (size_t b = 0; b < LatencyHistogram::kBuckets; ++b) {
+			const uint64_t n = h.bucket_count(b);
+			if (!n)
+				continue;
+			out << (first ? "" : ",") << '[' << ns_to_ms(static_cast<double>(LatencyHistogram::bucket_lower_ns(b)))
+				<< ',' << n << ']';
+			first = false;
+		}
+		out << "]}";
+	}
+	out << "\n]}\n";
+	return static_cast<bool>(out);
+}
+
+void LatencyReport::finish() const {
+	print();
+	if (options.output_prefix.empty())
+		return;
+	const std::string csv = options.output_prefix + ".csv";
+	const std::string json = options.output_prefix + ".json";
+	if (write_csv(csv) && write_json(json))
+		std::cout << "Latency histograms written to " << csv << " and " << json << std::endl;
+	else
+		std::cerr << "Error: Could not write the latency histograms to " << options.output_prefix << ".*" << std::endl;
+}
+
+//--------------------------------------------------------------------------
+// verify_latency_histogram
+//--------------------------------------------------------------------------
+bool verify_latency_histogram() {
+	// Values below 256 ns are exact.
+	LatencyHistogram linear;
+	for (uint64_t ns = 0; ns < LatencyHistogram::kLinear; ++ns)
+		linear.record_ns(ns);
+	bool linear_ok = linear.count() == LatencyHistogram::kLinear && linear.percentile_ms(50.0) == ns_to_ms(127.0) &&
+		linear.percentile_ms(100.0) == ns_to_ms(255.0) && linear.min_ms() == 0.0;
+	for (size_t b = 1; b < LatencyHistogram::kBuckets; ++b)
+		linear_ok = linear_ok && LatencyHistogram::bucket_lower_ns(b) > LatencyHistogram::bucket_lower_ns(b - 1) &&
+		LatencyHistogram::bucket_of(LatencyHistogram::bucket_lower_ns(b)) == b &&
+		LatencyHistogram::bucket_of(LatencyHistogram::bucket_lower_ns(b) - 1) == b - 1;
+
+	// Frame-time-like values (log-normal around 5 ms): percentiles against the sorted values.
+	std::mt19937_64 rng(47);
+	std::lognormal_distribution<double> frame_ms(std::log(5.0), 0.8);
+	const size_t samples = 100000;
+	std::vector<uint64_t> values(samples);
+	LatencyHistogram all, first_half, second_half;
+	double sum = 0.0;
+	for (size_t i = 0; i < samples; ++i) {
+		values[i] = static_cast<uint64_t>(frame_ms(rng) * 1e6);
+		all.record_ns(values[i]);
+		(i < samples / 2 ? first_half : second_half).record_ns(values[i]);
+		sum += static_cast<double>(values[i]);
+	}
+	std::vector<uint64_t> sorted = values;
+	std::sort(sorted.begin(), sorted.end());
+	double worst_error = 0.0;
+	for (double q : kPercentiles) {
+		const size_t rank = static_cast<size_t>(std::ceil(q / 100.0 * samples));
+		const double exact = ns_to_ms(static_cast<double>(sorted[rank - 1]));
+		worst_error = std::max(worst_error, std::abs(all.percentile_ms(q) - exact) / exact);
+	}
+	const bool accuracy_ok = worst_error <= 1.0 / 256 + 1e-9 && all.min_ms() == ns_to_ms(static_cast<double>(sorted.front())) &&
+		all.max_ms() == ns_to_ms(static_cast<double>(sorted.back())) &&
+		std::abs(all.mean_ms() - ns_to_ms(sum / samples)) <= 1e-9 * all.mean_ms();
+
+	// Merging the halves gives the whole.
+	first_half.merge(second_half);
+	bool merge_ok = first_half.count() == all.count() && first_half.min_ms() == all.min_ms() && first_half.max_ms() == all.max_ms();
+	for (double q : kPercentiles)
+		merge_ok = merge_ok && first_half.percentile_ms(q) == all.percentile_ms(q);
+
+	// Concurrent recording loses nothing; also the cost of one record.
+	LatencyHistogram shared;
+	const int threads = 4, per_thread = 250000;
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&shared, &values, t] {
+			for (int i = 0; i < per_thread; ++i)
+				shared.record_ns(values[(i * 7 + t) % values.size()]);
+		});
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+	const double record_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+		per_thread;
+	uint64_t bucketed = 0;
+	for (size_t b = 0; b < LatencyHistogram::kBuckets; ++b)
+		bucketed += shared.bucket_count(b);
+	const bool concurrent_ok = shared.count() == uint64_t(threads) * per_thread && bucketed == shared.count();
+
+	// Report: interval lines, p99 verdict, CSV and JSON.
+	const std::string prefix = (std::filesystem::temp_directory_path() / "glow_latency_check").string();
+	LatencyOptions options;
+	options.output_prefix = prefix;
+	options.report_every = 50;
+	options.p99_target_ms = 150.0;
+	LatencyReport report("check", options);
+	for (int frame = 1; frame <= 100; ++frame) {
+		report.record("segment", 0.5 * frame);
+		report.record(LatencyReport::kEndToEnd, frame);
+		report.frame_done();
+	}
+	options.p99_target_ms = 50.0;
+	LatencyReport missed("check", options);
+	missed.stage(LatencyReport::kEndToEnd).merge(report.stage(LatencyReport::kEndToEnd));
+	bool report_ok = report.sla_met() && !missed.sla_met() && report.stage("segment").count() == 100;
+	report.finish();
+	{
+		std::ifstream csv(prefix + ".csv", std::ios::binary);
+		std::string header, row, end_to_end;
+		std::getline(csv, header);
+		std::getline(csv, row);
+		std::getline(csv, end_to_end);
+		std::ifstream json_in(prefix + ".json", std::ios::binary);
+		const std::string json((std::istreambuf_iterator<char>(json_in)), std::istreambuf_iterator<char>());
+		report_ok = report_ok && header.compare(0, 12, "stage,count,") == 0 && row.compare(0, 12, "segment,100,") == 0 &&
+			end_to_end.compare(0, 15, "end-to-end,100,") == 0 && json.compare(0, 17, "{\"title\":\"check\",") == 0 &&
+			json.find("\"name\":\"end-to-end\",\"count\":100,") != std::string::npos &&
+			json.find("\"buckets\":[[") != std::string::npos && json.find("\n]}") != std::string::npos;
+	}
+	std::error_code ec;
+	std::filesystem::remove(prefix + ".csv", ec);
+	std::filesystem::remove(prefix + ".json", ec);
+
+	const bool passed = linear_ok && accuracy_ok && merge_ok && concurrent_ok && report_ok;
+	std::cout << "Latency histogram check: buckets " << (linear_ok ? "ok" : "WRONG") << ", percentiles "
+		<< (accuracy_ok ? "ok" : "WRONG") << " (worst error " << worst_error * 100.0 << "%), merge "
+		<< (merge_ok ? "ok" : "WRONG") << ", concurrent " << (concurrent_ok ? "ok" : "WRONG") << " ("
+		<< record_ns << " ns per record), report " << (report_ok ? "ok" : "WRONG") << ": "
+		<< (passed ? "PASSED" : "FAILED") << std::endl;
+	return passed;
+}
@@ -0,0 +1,135 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief HDR-style latency histogram: log-linear buckets over nanoseconds, percentiles within
+ *        1/256 (0.4%) relative error from 1 us to hours, in a fixed 38 KiB of counters.
+ *
+ * Values below 256 ns get one bucket each; above, every power of two is split into 128
+ * buckets of equal width, at most 1/128 of their values wide. Percentiles report the bucket
+ * midpoint, so they are off by at most half that. record() is lock-free and may be called from any thread; min, max,
+ * count and sum are exact.
+ */
+class LatencyHistogram {
+public:
+	static constexpr int kSubBits = 7;                                 ///< 128 buckets per power of two.
+	static constexpr uint64_t kLinear = uint64_t(2) << kSubBits;       ///< Values with a bucket each (ns).
+	static constexpr int kMaxBits = 44;                                ///< Values from 2^44 ns (4.9 h) share the last bucket.
+	static constexpr size_t kBuckets = size_t(kMaxBits - kSubBits + 1) << kSubBits;
+
+	LatencyHistogram();
+	LatencyHistogram(const LatencyHistogram&) = delete;
+	LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+	void record_ns(uint64_t ns);
+	void record_ms(double ms) { record_ns(ms > 0.0 ? static_cast<uint64_t>(ms * 1e6 + 0.5) : 0); }
+
+	/** @brief Adds the values of other (e.g. the histograms of several runs). */
+	void merge(const LatencyHistogram& other);
+
+	/** @brief Forgets every value. Values recorded concurrently may survive or be lost. */
+	void reset();
+
+	uint64_t count() const { return total.load(std::memory_order_relaxed); }
+	double min_ms() const;
+	double max_ms() const;
+	double mean_ms() const;
+
+	/**
+	 * @brief The value below which q percent of the values fall (q in 0..100), in ms.
+	 *
+	 * Exact below 256 ns, otherwise the middle of the bucket holding it, within min..max.
+	 */
+	double percentile_ms(double q) const;
+
+	/** @brief Bucket of a value (ns). */
+	static size_t bucket_of(uint64_t ns);
+	/** @brief Lowest value (ns) of a bucket; the bucket ends where the next one starts. */
+	static uint64_t bucket_lower_ns(size_t bucket);
+
+	/** @brief Values recorded in a bucket. */
+	uint64_t bucket_count(size_t bucket) const { return counts[bucket].load(std::memory_order_relaxed); }
+
+private:
+	std::unique_ptr<std::atomic<uint64_t>[]> counts;
+	std::atomic<uint64_t> total{ 0 };
+	std::atomic<uint64_t> sum_ns{ 0 };
+	std::atomic<uint64_t> min_value{ UINT64_MAX };
+	std::atomic<uint64_t> max_value{ 0 };
+};
+
+/**
+ * @brief What a LatencyReport prints and writes (the video paths take latency_options).
+ */
+struct LatencyOptions {
+	std::string output_prefix;     ///< Writes <prefix>.csv (summary) and <prefix>.json (summary and buckets); empty for none.
+	int report_every = 0;          ///< Prints the percentiles of the last N frames every N frames; 0 for none.
+	double p99_target_ms = 0.0;    ///< p99 SLA of the end-to-end stage, judged at the end; 0 for none.
+};
+
+/**
+ * @brief Named latency histograms of one run (stages and end-to-end) with interval and final
+ *        percentile reports.
+ *
+ * Stages appear in the order they are first recorded. Stages may be recorded from any thread;
+ * frame_done() and the reports belong to one thread (the sink of the run).
+ */
+class LatencyReport {
+public:
+	static const char* const kEndToEnd;   ///< "end-to-end", the stage the p99 target applies to.
+
+	LatencyReport(const std::string& title, const LatencyOptions& options);
+	LatencyReport(const LatencyReport&) = delete;
+	LatencyReport& operator=(const LatencyReport&) = delete;
+
+	/** @brief Histogram of a stage, created on first use; the reference stays valid. */
+	LatencyHistogram& stage(const std::string& name);
+
+	void record(const std::string& name, double ms) { stage(name).record_ms(ms); }
+
+	/** @brief Counts one delivered frame; prints the interval report every report_every frames. */
+	void frame_done();
+
+	/** @brief Prints count, min, mean, p50, p90, p99, p99.9 and max of every stage, and the p99 verdict. */
+	void print() const;
+
+	bool write_csv(const std::string& path) const;
+	bool write_json(const std::string& path) const;
+
+	/** @brief print(), then the CSV and JSON files when an output prefix is set. */
+	void finish() const;
+
+	/** @brief False when a p99 target is set and the end-to-end p99 exceeds it. */
+	bool sla_met() const;
+
+private:
+	struct Stage {
+		std::string name;
+		std::unique_ptr<LatencyHistogram> histogram;
+		std::vector<uint64_t> reported;   // bucket counts at the last interval report
+	};
+
+	std::string title;
+	LatencyOptions options;
+	mutable std::mutex mutex;   // guards stages (not the histograms)
+	std::deque<Stage> stages;
+	uint64_t frames = 0;
+};
+
+/**
+ * @brief Headless check: percentile accuracy against the exact sorted values, merge, concurrent
+ *        recording, interval reports and the CSV / JSON files.
+ *
+ * @return true if the check passed.
+ */
+bool verify_latency_histogram();
+
+#endif // LATENCY_HISTOGRAM_HPP
@@ -0,0 +1,231 @@
+/**
+ * @file MaskPropagation.cpp
+ * @brief Keyframe segmentation: scene-change keyframe selection and block-motion mask propagation.
+ */
+
+#include "MaskPropagation.hpp"
+#include "SyntheticClip.hpp"
+#include "movie_effect/include/tools_task.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace {
+	// Nearest-neighbour resize that keeps class values intact.
+	cv::Mat resize_mask_nearest(const cv::Mat& mask, int size) {
+		if (mask.rows == size && mask.cols == size)
+			return mask;
+		cv::Mat out(size, size, CV_8UC1, cv::Scalar(0));
+		if (mask.empty())
+			return out;
+		for (int y = 0; y < size; ++y) {
+			const uchar* src = mask.ptr<uchar>(y * mask.rows / size);
+			uchar* dst = out.ptr<uchar>(y);
+			for (int x = 0; x < size; ++x)
+				dst[x] = src[(x * mask.cols / size) * mask.channels()];
+		}
+		return out;
+	}
+
+	uint64_t block_sad(const cv::Mat& a, int ax, int ay, const cv::Mat& b, int bx, int by, int w, int h) {
+		uint64_t sad = 0;
+		for (int y = 0; y < h; ++y)
+			sad += sum_abs_diff_u8(a.ptr<uchar>(ay + y) + ax, b.ptr<uchar>(by + y) + bx, w);
+		return sad;
+	}
+}
+
+//--------------------------------------------------------------------------
+// MaskPropagator
+//--------------------------------------------------------------------------
+MaskPropagator::MaskPropagator(const MaskPropagationConfig& config) : config(config) {
+	this->config.keyframe_interval = std::max(1, config.keyframe_interval);
+	this->config.block_size = std::max(4, config.block_size);
+	this->config.search_range = std::max(1, config.search_range);
+	this->config.analysis_size = std::max(config.block_size, config.analysis_size);
+}
+
+std::vector<int> MaskPropagator::select_keyframes(const std::vector<cv::Mat>& frames) {
+	if (config.keyframe_interval <= 1)
+		return select_keyframes(std::vector<cv::Mat>(frames.size()), std::vector<FrameChangeScore>(frames.size()));
+
+	std::vector<cv::Mat> analysis(frames.size());
+	std::vector<FrameChangeScore> scores(frames.size());
+	SceneChangeDetector detector(config.detector);
+	for (size_t i = 0; i < frames.size(); ++i) {
+		analysis[i] = make_analysis_gray(frames[i], config.analysis_size);
+		scores[i] = detector.analyze(analysis[i]);
+	}
+	return select_keyframes(analysis, scores);
+}
+
+std::vector<int> MaskPropagator::select_keyframes(const std::vector<cv::Mat>& analysis_grays, const std::vector<FrameChangeScore>& scores) {
+	const int count = static_cast<int>(analysis_grays.size());
+	grays = analysis_grays;
+	is_keyframe.assign(count, true);
+	is_static.assign(count, false);
+
+	std::vector<int> keyframes;
+	if (config.keyframe_interval <= 1) {
+		for (int i = 0; i < count; ++i)
+			keyframes.push_back(i);
+		return keyframes;
+	}
+
+	int last_key = 0;
+	double changed_since_key = 0.0;
+	for (int i = 0; i < count; ++i) {
+		const FrameChangeScore& score = scores[i];
+		changed_since_key += i > 0 ? score.changed_blocks : 0.0;
+		bool key = i == 0 || i - last_key >= config.keyframe_interval || score.scene_cut ||
+			changed_since_key > config.detector.resegment_blocks || grays[i].empty();
+		is_keyframe[i] = key;
+		is_static[i] = !key && score.static_frame;
+		if (key) {
+			keyframes.push_back(i);
+			last_key = i;
+			changed_since_key = 0.0;
+		}
+	}
+	return keyframes;
+}
+
+std::vector<cv::Mat> MaskPropagator::propagate(const std::vector<cv::Mat>& key_masks) const {
+	const int count = static_cast<int>(is_keyframe.size());
+	const int size = config.analysis_size;
+	std::vector<cv::Mat> masks(count);
+
+	size_t next_key = 0;
+	for (int i = 0; i < count; ++i) {
+		if (is_keyframe[i]) {
+			cv::Mat key = next_key < key_masks.size() ? key_masks[next_key] : cv::Mat();
+			next_key++;
+			masks[i] = key.empty() ? cv::Mat(size, size, CV_8UC1, cv::Scalar(0)) : resize_mask_nearest(key, size);
+		}
+		else if (is_static[i] || !config.warp) {
+			masks[i] = masks[i - 1];   // shared on purpose: identical mask, identical glow
+		}
+		else {
+			masks[i] = warp_mask(grays[i - 1], grays[i], masks[i - 1], config.block_size, config.search_range);
+		}
+	}
+	return masks;
+}
+
+cv::Mat MaskPropagator::warp_mask(const cv::Mat& prev_gray, const cv::Mat& cur_gray, const cv::Mat& prev_mask,
+	int block_size, int search_range) {
+	const int width = cur_gray.cols;
+	const int height = cur_gray.rows;
+	cv::Mat out(height, width, CV_8UC1, cv::Scalar(0));
+	const int blocks_y = (height + block_size - 1) / block_size;
+
+	task::parallel_rows(blocks_y, [&](int b0, int b1) {
+		for (int by = b0; by < b1; ++by) {
+			const int y = by * block_size;
+			const int h = std::min(block_size, height - y);
+			for (int x = 0; x < width; x += block_size) {
+				const int w = std::min(block_size, width - x);
+
+				// Three-step search around the zero vector, candidates clamped to the image.
+				int best_dx = 0, best_dy = 0;
+				uint64_t best_sad = block_sad(cur_gray, x, y, prev_gray, x, y, w, h);
+				int step = 1;
+				while (step * 2 <= search_range)
+					step *= 2;
+				for (; step >= 1; step /= 2) {
+					int center_dx = best_dx, center_dy = best_dy;
+					for (int sy = -1; sy <= 1; ++sy) {
+						for (int sx = -1; sx <= 1; ++sx) {
+							if (sx == 0 && sy == 0)
+								continue;
+							int dx = center_dx + sx * step;
+							int dy = center_dy + sy * step;
+							if (std::abs(dx) > search_range || std::abs(dy) > search_range ||
+								x + dx < 0 || y + dy < 0 || x + dx + w > width || y + dy + h > height)
+								continue;
+							uint64_t sad = block_sad(cur_gray, x, y, prev_gray, x + dx, y + dy, w, h);
+							if (sad < best_sad) {
+								best_sad = sad;
+								best_dx = dx;
+								best_dy = dy;
+							}
+						}
+					}
+				}
+
+				for (int r = 0; r < h; ++r)
+					std::memcpy(out.ptr<uchar>(y + r) + x, prev_mask.ptr<uchar>(y + best_dy + r) + x + best_dx, w);
+			}
+		}
+	}, 1);
+	return out;
+}
+
+//--------------------------------------------------------------------------
+// verify_mask_propagation
+//--------------------------------------------------------------------------
+namespace {
+	const uchar kObjectClass = 56;
+
+	double mask_iou(const cv::Mat& a, const cv::Mat& b) {
+		unsigned long long inter = 0, uni = 0;
+		for (int y = 0; y < a.rows; ++y) {
+			const uchar* pa = a.ptr<uchar>(y);
+			const uchar* pb = b.ptr<uchar>(y);
+			for (int x = 0; x < a.cols; ++x) {
+				bool ia = pa[x] == kObjectClass, ib = pb[x] == kObjectClass;
+				inter += ia && ib;
+				uni += ia || ib;
+			}
+		}
+		return uni ? static_cast<double>(inter) / uni : 1.0;
+	}
+}
+
+bool verify_mask_propagation() {
+	// 12 frames: object moves 3 px right and 2 px down per frame, hard cut at frame 7.
+	SyntheticClipSpec spec;
+	spec.scene_lengths = { 7, 5 };
+	spec.object_class = kObjectClass;
+	SyntheticClip clip = make_synthetic_clip(spec);
+	const std::vector<cv::Mat>& frames = clip.frames;
+	const std::vector<cv::Mat>& truths = clip.masks;
+
+	MaskPropagationConfig config;
+	config.keyframe_interval = 8;
+	MaskPropagator propagator(config);
+	std::vector<int> keys = propagator.select_keyframes(frames);
+	std::vector<cv::Mat> key_masks;
+	for (int k : keys)
+		key_masks.push_back(truths[k]);
+	std::vector<cv::Mat> masks = propagator.propagate(key_masks);
+
+	config.warp = false;
+	MaskPropagator holder(config);
+	holder.select_keyframes(frames);
+	std::vector<cv::Mat> held = holder.propagate(key_masks);
+
+	bool ok = keys.size() <= frames.size() / 2 && keys[0] == 0 && std::count(keys.begin(), keys.end(), 7) == 1;
+	if (!ok) {
+		std::cerr << "Mask propagation check: expected few keyframes including 0 and 7, got";
+		for (int k : keys)
+			std::cerr << " " << k;
+		std::cerr << std::endl;
+	}
+
+	double worst_warp = 1.0, worst_hold = 1.0;
+	for (size_t i = 0; i < frames.size(); ++i) {
+		worst_warp = std::min(worst_warp, mask_iou(masks[i], truths[i]));
+		worst_hold = std::min(worst_hold, mask_iou(held[i], truths[i]));
+	}
+	ok = ok && worst_warp >= 0.8 && worst_warp > worst_hold;
+
+	std::cout << "Mask propagation check: " << keys.size() << " of " << frames.size()
+		<< " frames segmented, worst IoU warp " << worst_warp << " / hold " << worst_hold
+		<< ": " << (ok ? "PASSED" : "FAILED") << std::endl;
+	return ok;
+}
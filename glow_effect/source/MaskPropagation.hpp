@@ -0,0 +1,85 @@
+#ifndef MASK_PROPAGATION_HPP
+#define MASK_PROPAGATION_HPP
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "SceneDetector.hpp"
+
+/**
+ * @brief Settings of keyframe segmentation with mask propagation.
+ */
+struct MaskPropagationConfig {
+	int keyframe_interval = 1;              ///< Segment every Nth frame; 1 segments every frame (propagation off).
+	SceneDetectorConfig detector;           ///< Scene-cut / motion thresholds that force a new keyframe.
+	bool warp = true;                       ///< Warp masks with block motion; false simply holds the last mask.
+	int block_size = 16;                    ///< Motion block size in analysis pixels.
+	int search_range = 8;                   ///< Max motion vector component in analysis pixels.
+	int analysis_size = 384;                ///< Side of the square analysis grid (matches the segmenter input).
+};
+
+/**
+ * @brief Selects keyframes inside a batch of consecutive frames and fills in the masks of the others.
+ *
+ * Usage per batch: select_keyframes() on the frames, segment only the returned frames, then
+ * propagate() with their masks. Frame 0 of a batch is always a keyframe, so batches stay
+ * independent and can still be processed concurrently. A frame is also a keyframe when the
+ * SceneChangeDetector reports a cut or the changed blocks accumulated since the last keyframe
+ * exceed resegment_blocks. Between keyframes each mask is derived from the previous frame's
+ * mask, either held or motion-compensated with block motion vectors estimated on a grayscale
+ * analysis grid on the CPU. Static frames share the previous mask object, so later stages can
+ * reuse its glow by comparing cv::Mat::data.
+ */
+class MaskPropagator {
+public:
+	explicit MaskPropagator(const MaskPropagationConfig& config);
+
+	/**
+	 * @brief Builds the analysis images of the frames and decides which ones to segment.
+	 *
+	 * @param frames Consecutive frames of one batch (BGR, BGRA or gray).
+	 * @return Ascending frame indices to segment; always starts with 0 for a non-empty batch.
+	 */
+	std::vector<int> select_keyframes(const std::vector<cv::Mat>& frames);
+
+	/**
+	 * @brief Same as above with analysis grids and scores already computed in display order
+	 *        (e.g. by the pipeline reader); scores[0] is ignored since frame 0 is always a keyframe.
+	 */
+	std::vector<int> select_keyframes(const std::vector<cv::Mat>& analysis_grays, const std::vector<FrameChangeScore>& scores);
+
+	/**
+	 * @brief Returns one mask per frame of the last select_keyframes() call.
+	 *
+	 * @param key_masks Segmentation masks of the keyframes, in the order returned by select_keyframes().
+	 * @return Masks of all frames on the analysis grid (CV_8UC1, analysis_size x analysis_size).
+	 */
+	std::vector<cv::Mat> propagate(const std::vector<cv::Mat>& key_masks) const;
+
+	/**
+	 * @brief Moves a mask from prev to cur using block motion estimated between the two gray images.
+	 *
+	 * Every block of cur is matched against prev with a three-step search (SAD); the mask block at
+	 * the matched position is copied, so class values are never blended.
+	 */
+	static cv::Mat warp_mask(const cv::Mat& prev_gray, const cv::Mat& cur_gray, const cv::Mat& prev_mask,
+		int block_size, int search_range);
+
+private:
+	MaskPropagationConfig config;
+	std::vector<cv::Mat> grays;        // analysis grid per frame
+	std::vector<bool> is_keyframe;
+	std::vector<bool> is_static;
+};
+
+/**
+ * @brief Headless check of keyframe selection and mask propagation on synthetic footage.
+ *
+ * A textured clip with a moving object and a hard cut is generated; the check verifies that the
+ * cut forces a keyframe and that warped masks stay close to the true object position.
+ *
+ * @return true if the check passed.
+ */
+bool verify_mask_propagation();
+
+#endif // MASK_PROPAGATION_HPP
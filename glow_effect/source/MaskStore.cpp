@@ -0,0 +1,334 @@
+/**
+ * @file MaskStore.cpp
+ * @brief Memory-mapped sidecar store of per-frame segmentation masks.
+ */
+
+#include "MaskStore.hpp"
+#include "ImageCompare.hpp"
+#include "SyntheticClip.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	const uint32_t kStoreMagic = 0x534d4c47;   // "GLMS"
+	const uint32_t kStoreVersion = 1;
+	const size_t kFooterSize = 16;             // u64 index offset, u32 frame count, u32 magic
+	const size_t kIndexEntrySize = 12;         // u64 offset, u32 size
+
+	void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+		for (int i = 0; i < 4; ++i)
+			out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+	}
+
+	void put_u64(std::vector<uint8_t>& out, uint64_t v) {
+		for (int i = 0; i < 8; ++i)
+			out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+	}
+
+	uint32_t get_u32(const uint8_t* p) {
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	uint64_t get_u64(const uint8_t* p) {
+		return get_u32(p) | (static_cast<uint64_t>(get_u32(p + 4)) << 32);
+	}
+}
+
+//--------------------------------------------------------------------------
+// MappedFile
+//--------------------------------------------------------------------------
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const std::string& path) {
+	close();
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(handle);
+		return false;
+	}
+	HANDLE mapping = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		CloseHandle(handle);
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) {
+		CloseHandle(mapping);
+		CloseHandle(handle);
+		return false;
+	}
+	file_handle = handle;
+	mapping_handle = mapping;
+	bytes = static_cast<const uint8_t*>(view);
+	length = static_cast<size_t>(file_size.QuadPart);
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);   // the mapping keeps the file referenced
+	if (view == MAP_FAILED)
+		return false;
+	bytes = static_cast<const uint8_t*>(view);
+	length = static_cast<size_t>(st.st_size);
+#endif
+	return true;
+}
+
+void MappedFile::close() {
+	if (!bytes)
+		return;
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
+	UnmapViewOfFile(bytes);
+	CloseHandle(static_cast<HANDLE>(mapping_handle));
+	CloseHandle(static_cast<HANDLE>(file_handle));
+	file_handle = mapping_handle = nullptr;
+#else
+	munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+	bytes = nullptr;
+	length = 0;
+}
+
+//--------------------------------------------------------------------------
+// MaskStoreWriter
+//--------------------------------------------------------------------------
+bool MaskStoreWriter::open(const std::string& path, const std::string& tag) {
+	std::lock_guard<std::mutex> lock(mutex);
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		std::cerr << "Error: Could not create mask store: " << path << std::endl;
+		return false;
+	}
+	index.clear();
+	frames = 0;
+
+	std::vector<uint8_t> header;
+	put_u32(header, kStoreMagic);
+	put_u32(header, kStoreVersion);
+	put_u32(header, static_cast<uint32_t>(tag.size()));
+	header.insert(header.end(), tag.begin(), tag.end());
+	file.write(reinterpret_cast<const char*>(header.data()), header.size());
+	return static_cast<bool>(file);
+}
+
+bool MaskStoreWriter::write_batch(uint64_t first_frame, const std::vector<cv::Mat>& masks) {
+	// Encode outside the lock; batches of different threads only serialize on the file write.
+	std::vector<uint8_t> blob;
+	std::vector<size_t> starts(masks.size()), sizes(masks.size());
+	for (size_t i = 0; i < masks.size(); ++i) {
+		if (i > 0 && !masks[i].empty() && masks[i].data == masks[i - 1].data) {
+			starts[i] = starts[i - 1];
+			sizes[i] = sizes[i - 1];
+			continue;
+		}
+		RleMask rle = RleMask::encode(masks[i]);
+		starts[i] = blob.size();
+		if (!rle.empty())
+			rle.serialize(blob);
+		sizes[i] = blob.size() - starts[i];
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!file.is_open())
+		return false;
+	const uint64_t base = static_cast<uint64_t>(file.tellp());
+	file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+	if (index.size() < first_frame + masks.size())
+		index.resize(first_frame + masks.size());
+	for (size_t i = 0; i < masks.size(); ++i) {
+		if (sizes[i] == 0)
+			continue;   // unusable mask: stays missing, the reader falls back to segmentation
+		index[first_frame + i] = { base + starts[i], static_cast<uint32_t>(sizes[i]) };
+		frames++;
+	}
+	return static_cast<bool>(file);
+}
+
+bool MaskStoreWriter::finish() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!file.is_open())
+		return false;
+	std::vector<uint8_t> tail;
+	const uint64_t index_offset = static_cast<uint64_t>(file.tellp());
+	for (const Entry& e : index) {
+		put_u64(tail, e.offset);
+		put_u32(tail, e.size);
+	}
+	put_u64(tail, index_offset);
+	put_u32(tail, static_cast<uint32_t>(index.size()));
+	put_u32(tail, kStoreMagic);
+	file.write(reinterpret_cast<const char*>(tail.data()), tail.size());
+	bool ok = static_cast<bool>(file);
+	file.close();
+	return ok;
+}
+
+//--------------------------------------------------------------------------
+// MaskStoreReader
+//--------------------------------------------------------------------------
+bool MaskStoreReader::open(const std::string& path, const std::string& tag) {
+	index = nullptr;
+	count = 0;
+	if (!file.open(path))
+		return false;
+
+	const uint8_t* data = file.data();
+	const size_t size = file.size();
+	if (size < 12 + kFooterSize || get_u32(data) != kStoreMagic || get_u32(data + 4) != kStoreVersion) {
+		file.close();
+		return false;
+	}
+	const size_t tag_size = get_u32(data + 8);
+	const uint8_t* footer = data + size - kFooterSize;
+	const uint64_t index_offset = get_u64(footer);
+	const uint64_t frames = get_u32(footer + 8);
+	if (get_u32(footer + 12) != kStoreMagic || 12 + tag_size > size ||
+		std::string(reinterpret_cast<const char*>(data + 12), tag_size) != tag ||
+		index_offset < 12 + tag_size || index_offset + frames * kIndexEntrySize != size - kFooterSize) {
+		file.close();
+		return false;
+	}
+	index = data + index_offset;
+	count = frames;
+	return true;
+}
+
+bool MaskStoreReader::entry(uint64_t frame, uint64_t& offset, uint32_t& size) const {
+	if (!index || frame >= count)
+		return false;
+	const uint8_t* e = index + frame * kIndexEntrySize;
+	offset = get_u64(e);
+	size = get_u32(e + 8);
+	return size > 0 && offset + size <= static_cast<uint64_t>(index - file.data());
+}
+
+bool MaskStoreReader::contains(uint64_t frame) const {
+	uint64_t offset;
+	uint32_t size;
+	return entry(frame, offset, size);
+}
+
+bool MaskStoreReader::read(uint64_t frame, RleMask& mask) const {
+	uint64_t offset;
+	uint32_t size;
+	if (!entry(frame, offset, size))
+		return false;
+	return RleMask::deserialize(file.data() + offset, size, mask) == size;
+}
+
+std::vector<cv::Mat> MaskStoreReader::read_batch(uint64_t first_frame, size_t batch_count) const {
+	std::vector<cv::Mat> masks(batch_count);
+	uint64_t prev_offset = 0;
+	for (size_t i = 0; i < batch_count; ++i) {
+		uint64_t offset;
+		uint32_t size;
+		if (!entry(first_frame + i, offset, size))
+			return std::vector<cv::Mat>();
+		if (i > 0 && offset == prev_offset) {
+			masks[i] = masks[i - 1];
+			continue;
+		}
+		RleMask rle;
+		if (RleMask::deserialize(file.data() + offset, size, rle) != size)
+			return std::vector<cv::Mat>();
+		masks[i] = rle.decode();
+		prev_offset = offset;
+	}
+	return masks;
+}
+
+//--------------------------------------------------------------------------
+// verify_mask_store
+//--------------------------------------------------------------------------
+bool verify_mask_store() {
+	SyntheticClipSpec spec;
+	spec.scene_lengths = { 9, 7 };
+	spec.static_frames = 3;
+	SyntheticClip clip = make_synthetic_clip(spec);
+
+	// Static tails share one cv::Mat like propagated masks do.
+	std::vector<cv::Mat> masks = clip.masks;
+	for (size_t i = 1; i < masks.size(); ++i)
+		if (same_pixels(masks[i], masks[i - 1]))
+			masks[i] = masks[i - 1];
+
+	const std::string path = (std::filesystem::temp_directory_path() / "glow_mask_store_check.masks").string();
+	const std::string tag = "check|plan=none|k=4";
+	bool ok = true;
+	{
+		// Batches of 4 frames, written out of order.
+		MaskStoreWriter writer;
+		ok = writer.open(path, tag);
+		for (size_t first : { size_t(4), size_t(0), size_t(12), size_t(8) }) {
+			std::vector<cv::Mat> batch(masks.begin() + first, masks.begin() + std::min(first + 4, masks.size()));
+			ok = ok && writer.write_batch(first, batch);
+		}
+		ok = ok && writer.finish() && writer.frames_written() == masks.size();
+	}
+
+	MaskStoreReader reader;
+	ok = ok && reader.open(path, tag) && reader.frame_count() == masks.size();
+	size_t shared = 0, expected_shared = 0;
+	for (size_t first = 0; ok && first < masks.size(); first += 5) {
+		size_t n = std::min<size_t>(5, masks.size() - first);
+		std::vector<cv::Mat> loaded = reader.read_batch(first, n);
+		ok = loaded.size() == n;
+		for (size_t i = 0; ok && i < n; ++i) {
+			ok = same_pixels(loaded[i], masks[first + i]);
+			// Sharing is kept within a written batch (frames 4k .. 4k + 3) that is also one read batch.
+			if (i > 0 && masks[first + i].data == masks[first + i - 1].data && (first + i) % 4 != 0) {
+				expected_shared++;
+				shared += loaded[i].data == loaded[i - 1].data;
+			}
+		}
+	}
+	RleMask single;
+	ok = ok && reader.read(13, single) && same_pixels(single.decode(), masks[13]) && !reader.contains(masks.size()) &&
+		reader.read_batch(masks.size() - 2, 3).empty();
+	const size_t store_bytes = reader.bytes();
+
+	MaskStoreReader other;
+	ok = ok && !other.open(path, "check|plan=other|k=4");
+
+	// A truncated store (e.g. the writer was killed) is rejected as a whole.
+	{
+		std::ifstream in(path, std::ios::binary);
+		std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		in.close();
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write(bytes.data(), bytes.size() - 7);
+	}
+	MaskStoreReader truncated;
+	ok = ok && !truncated.open(path, tag);
+	std::filesystem::remove(path);
+
+	ok = ok && shared == expected_shared;
+	std::cout << "Mask store check: " << masks.size() << " frames in " << store_bytes << " bytes ("
+		<< masks[0].total() * masks.size() << " raw), " << shared << "/" << expected_shared
+		<< " static masks shared on read: " << (ok ? "PASSED" : "FAILED") << std::endl;
+	return ok;
+}
@@ -0,0 +1,125 @@
+#ifndef MASK_STORE_HPP
+#define MASK_STORE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "RleMask.hpp"
+
+/**
+ * @brief Read-only memory mapping of a whole file (mmap / CreateFileMapping).
+ */
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/** @brief Maps path; returns false (and stays closed) if it cannot be opened or is empty. */
+	bool open(const std::string& path);
+	void close();
+
+	const uint8_t* data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	const uint8_t* bytes = nullptr;
+	size_t length = 0;
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
+
+/**
+ * @brief Writes the segmentation masks of a clip to a sidecar file.
+ *
+ * Layout: a header with a tag string, one serialized RleMask per distinct mask, then a
+ * frame-indexed table of (offset, size) and a footer pointing at it. Batches may arrive in any
+ * order and from any thread. Consecutive frames of a batch that share their cv::Mat data (static
+ * frames in mask propagation) are stored once and share an index entry, so the reader hands
+ * them back as one cv::Mat and the glow reuse survives re-rendering.
+ */
+class MaskStoreWriter {
+public:
+	MaskStoreWriter() = default;
+	~MaskStoreWriter() { finish(); }
+
+	/**
+	 * @brief Creates (truncates) the store.
+	 *
+	 * @param tag Identifies what the masks depend on (clip, model plan, keyframe settings);
+	 *            MaskStoreReader::open rejects a store whose tag differs.
+	 */
+	bool open(const std::string& path, const std::string& tag);
+
+	/** @brief Appends the masks of frames first_frame .. first_frame + masks.size() - 1. Thread-safe. */
+	bool write_batch(uint64_t first_frame, const std::vector<cv::Mat>& masks);
+
+	/** @brief Writes the index and closes the file; called by the destructor if needed. */
+	bool finish();
+
+	bool is_open() const { return file.is_open(); }
+	uint64_t frames_written() const { return frames; }
+
+private:
+	struct Entry {
+		uint64_t offset = 0;
+		uint32_t size = 0;
+	};
+
+	std::mutex mutex;
+	std::ofstream file;
+	std::vector<Entry> index;   // by frame; size 0 = missing
+	uint64_t frames = 0;
+};
+
+/**
+ * @brief Random access to a mask store written by MaskStoreWriter through a memory mapping.
+ */
+class MaskStoreReader {
+public:
+	/** @brief Maps and validates the store; false if missing, corrupt or written with another tag. */
+	bool open(const std::string& path, const std::string& tag);
+
+	/** @brief Number of index entries (highest stored frame + 1). */
+	uint64_t frame_count() const { return count; }
+
+	/** @brief true if the mask of frame is stored. */
+	bool contains(uint64_t frame) const;
+
+	/** @brief Parses the mask of frame; false if it is not stored. */
+	bool read(uint64_t frame, RleMask& mask) const;
+
+	/**
+	 * @brief Decoded masks of count consecutive frames, or an empty vector if any is missing.
+	 *
+	 * Frames that share an index entry with their predecessor share the decoded cv::Mat.
+	 */
+	std::vector<cv::Mat> read_batch(uint64_t first_frame, size_t count) const;
+
+	/** @brief Size of the store in bytes. */
+	size_t bytes() const { return file.size(); }
+
+private:
+	bool entry(uint64_t frame, uint64_t& offset, uint32_t& size) const;
+
+	MappedFile file;
+	const uint8_t* index = nullptr;
+	uint64_t count = 0;
+};
+
+/**
+ * @brief Headless check of the mask store: out-of-order batches, shared static masks,
+ *        random access, tag mismatch and truncation, on masks of a generated clip.
+ *
+ * @return true if the check passed.
+ */
+bool verify_mask_store();
+
+#endif // MASK_STORE_HPP
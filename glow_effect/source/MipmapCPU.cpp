@@ -0,0 +1,504 @@
+/**
+ * @file MipmapCPU.cpp
+ * @brief CPU mipmap backend and the glow region of interest.
+ */
+
+#include "MipmapCPU.hpp"
+#include "movie_effect/include/tools_task.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+	// Level of detail of a blur scale, as computed by the GPU kernel (log2(scale)).
+	float mipmap_lod(float scale) {
+		return scale > 1.0f ? std::log2(scale) : 0.0f;
+	}
+
+	// Texels and weights of one output coordinate of a d_gen_mipmap pass along one axis. The
+	// kernel averages two linear fetches at the edges i / out_size and (i + 1) / out_size of the
+	// output texel; each fetch blends two texels (clamped) with a weight in 1/256 steps, as the
+	// texture unit does. Weights sum to 512; for even sizes they are 128 each on 2i - 1 .. 2i + 2.
+	struct HalfTaps {
+		int i[4];
+		int w[4];
+	};
+
+	std::vector<HalfTaps> make_half_taps(int out_size, int in_size) {
+		std::vector<HalfTaps> taps(out_size);
+		const int den = 2 * out_size;
+		for (int i = 0; i < out_size; ++i) {
+			for (int k = 0; k < 2; ++k) {
+				const int num = 2 * (i + k) * in_size - out_size;   // (fetch coordinate - 0.5) * den
+				int t0 = num >= 0 ? num / den : -((den - 1 - num) / den);
+				int frac = ((num - t0 * den) * 256 + out_size) / den;
+				if (frac == 256) {
+					++t0;
+					frac = 0;
+				}
+				taps[i].i[2 * k] = std::min(std::max(t0, 0), in_size - 1);
+				taps[i].i[2 * k + 1] = std::min(std::max(t0 + 1, 0), in_size - 1);
+				taps[i].w[2 * k] = 256 - frac;
+				taps[i].w[2 * k + 1] = frac;
+			}
+		}
+		return taps;
+	}
+
+	// Outputs [begin, end) of a pass along one axis that read a texel of [in_begin, in_end) with a
+	// nonzero weight; begin >= end if none does.
+	void reached_span(const std::vector<HalfTaps>& taps, int in_begin, int in_end, int& begin, int& end) {
+		begin = static_cast<int>(taps.size());
+		end = 0;
+		for (int i = 0; i < static_cast<int>(taps.size()); ++i) {
+			for (int k = 0; k < 4; ++k) {
+				if (taps[i].w[k] > 0 && taps[i].i[k] >= in_begin && taps[i].i[k] < in_end) {
+					begin = std::min(begin, i);
+					end = i + 1;
+					break;
+				}
+			}
+		}
+	}
+
+	// Taps of the outputs [begin, begin + count) relative to the stored part [in_begin, in_begin +
+	// in_count) of the input; texels outside it are zero, so their weight is dropped.
+	std::vector<HalfTaps> window_half_taps(const std::vector<HalfTaps>& taps, int begin, int count, int in_begin, int in_count) {
+		std::vector<HalfTaps> local(taps.begin() + begin, taps.begin() + begin + count);
+		for (HalfTaps& h : local) {
+			for (int k = 0; k < 4; ++k) {
+				h.i[k] -= in_begin;
+				if (h.i[k] < 0 || h.i[k] >= in_count) {
+					h.i[k] = 0;
+					h.w[k] = 0;
+				}
+			}
+		}
+		return local;
+	}
+
+	// Next pyramid level as d_gen_mipmap computes it (a 4x4 footprint around each 2x2 block,
+	// see make_half_taps), rounded where the kernel truncates. prev holds the part prev_window
+	// of a level of size prev_size (zero elsewhere); the result is the part window of the next
+	// level, of size next_size.
+	cv::Mat half_level(const cv::Mat& prev, const cv::Rect& prev_window, const cv::Size& prev_size,
+		const cv::Size& next_size, const cv::Rect& window) {
+		const int cn = prev.channels();
+		cv::Mat next(window.size(), prev.type());
+		const std::vector<HalfTaps> tx = window_half_taps(make_half_taps(next_size.width, prev_size.width),
+			window.x, window.width, prev_window.x, prev_window.width);
+		const std::vector<HalfTaps> ty = window_half_taps(make_half_taps(next_size.height, prev_size.height),
+			window.y, window.height, prev_window.y, prev_window.height);
+		task::parallel_rows(next.rows, [&](int row_begin, int row_end) {
+			for (int y = row_begin; y < row_end; ++y) {
+				const uchar* rows[4];
+				for (int j = 0; j < 4; ++j)
+					rows[j] = prev.ptr<uchar>(ty[y].i[j]);
+				uchar* out = next.ptr<uchar>(y);
+				for (int x = 0; x < next.cols; ++x) {
+					const HalfTaps& h = tx[x];
+					for (int c = 0; c < cn; ++c) {
+						int sum = 0;
+						for (int j = 0; j < 4; ++j) {
+							const uchar* r = rows[j] + c;
+							sum += ty[y].w[j] * (h.w[0] * r[h.i[0] * cn] + h.w[1] * r[h.i[1] * cn] +
+								h.w[2] * r[h.i[2] * cn] + h.w[3] * r[h.i[3] * cn]);
+						}
+						out[x * cn + c] = static_cast<uchar>((sum + (1 << 17)) >> 18);
+					}
+				}
+			}
+		});
+		return next;
+	}
+
+	cv::Mat half_level(const cv::Mat& prev) {
+		const cv::Size next_size(std::max(1, prev.cols / 2), std::max(1, prev.rows / 2));
+		return half_level(prev, cv::Rect(0, 0, prev.cols, prev.rows), prev.size(), next_size,
+			cv::Rect(0, 0, next_size.width, next_size.height));
+	}
+
+	// Bilinear taps of every output coordinate into a level (texel centers, clamp addressing).
+	struct Taps {
+		std::vector<int> i0, i1;
+		std::vector<float> w;
+	};
+
+	Taps make_taps(int out_size, int level_size) {
+		Taps t;
+		t.i0.resize(out_size);
+		t.i1.resize(out_size);
+		t.w.resize(out_size);
+		const float ratio = static_cast<float>(level_size) / out_size;
+		for (int i = 0; i < out_size; ++i) {
+			float c = (i + 0.5f) * ratio - 0.5f;
+			int c0 = static_cast<int>(std::floor(c));
+			t.w[i] = c - c0;
+			t.i0[i] = std::min(std::max(c0, 0), level_size - 1);
+			t.i1[i] = std::min(std::max(c0 + 1, 0), level_size - 1);
+		}
+		return t;
+	}
+
+	// make_taps of the outputs [begin, begin + count) of a frame row or column, relative to the
+	// stored part of the level that starts at origin.
+	Taps window_taps(int out_size, int level_size, int begin, int count, int origin) {
+		const Taps frame = make_taps(out_size, level_size);
+		Taps t;
+		t.i0.assign(frame.i0.begin() + begin, frame.i0.begin() + begin + count);
+		t.i1.assign(frame.i1.begin() + begin, frame.i1.begin() + begin + count);
+		t.w.assign(frame.w.begin() + begin, frame.w.begin() + begin + count);
+		for (int i = 0; i < count; ++i) {
+			t.i0[i] -= origin;
+			t.i1[i] -= origin;
+		}
+		return t;
+	}
+
+	// Part of a level a pyramid stores: the texels that may be nonzero (support) and those the
+	// lookups of the ROI pixels read.
+	cv::Rect level_window(const cv::Rect& support, const cv::Size& level_size, const cv::Rect& roi, const cv::Size& frame) {
+		const Taps tx = make_taps(frame.width, level_size.width), ty = make_taps(frame.height, level_size.height);
+		int x0 = tx.i0[roi.x], x1 = tx.i1[roi.x + roi.width - 1] + 1;
+		int y0 = ty.i0[roi.y], y1 = ty.i1[roi.y + roi.height - 1] + 1;
+		if (support.area() > 0) {
+			x0 = std::min(x0, support.x);
+			x1 = std::max(x1, support.x + support.width);
+			y0 = std::min(y0, support.y);
+			y1 = std::max(y1, support.y + support.height);
+		}
+		return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+	}
+
+	// Bilinear sample of one level at the pixels x0 .. x0 + count - 1 of an output row.
+	void sample_row(const cv::Mat& level, const Taps& tx, const Taps& ty, int y, int x0, int count, float* out) {
+		const int cn = level.channels();
+		const uchar* r0 = level.ptr<uchar>(ty.i0[y]);
+		const uchar* r1 = level.ptr<uchar>(ty.i1[y]);
+		const float wy = ty.w[y];
+		for (int i = 0; i < count; ++i) {
+			const int a = tx.i0[x0 + i] * cn, b = tx.i1[x0 + i] * cn;
+			const float wx = tx.w[x0 + i];
+			for (int c = 0; c < cn; ++c) {
+				float top = r0[a + c] + (r0[b + c] - r0[a + c]) * wx;
+				float bottom = r1[a + c] + (r1[b + c] - r1[a + c]) * wx;
+				out[i * cn + c] = top + (bottom - top) * wy;
+			}
+		}
+	}
+
+	// Key image of a mask: key_level where the mask equals it, 0 elsewhere.
+	cv::Mat key_mask(const cv::Mat& input_gray, int key_level) {
+		cv::Mat key(input_gray.size(), CV_8UC1);
+		const uchar level = static_cast<uchar>(key_level);
+		task::parallel_rows(input_gray.rows, [&](int row_begin, int row_end) {
+			for (int i = row_begin; i < row_end; ++i) {
+				const uchar* in = input_gray.ptr<uchar>(i);
+				uchar* out = key.ptr<uchar>(i);
+				for (int j = 0; j < input_gray.cols; ++j)
+					out[j] = in[j] == key_level ? level : 0;
+			}
+		});
+		return key;
+	}
+
+	// Key mask in the layout of the self-check: rectangles of key pixels plus a non-key class.
+	cv::Mat make_key_mask(const cv::Size& size, const cv::Rect& key, int key_level) {
+		cv::Mat mask(size, CV_8UC1, cv::Scalar(0));
+		for (int y = 0; y < size.height; ++y) {
+			uchar* row = mask.ptr<uchar>(y);
+			for (int x = 0; x < size.width; ++x) {
+				if (key.contains(cv::Point(x, y)))
+					row[x] = static_cast<uchar>((x + y) % 5 ? key_level : 0);   // ragged key edge
+				else if ((x / 32 + y / 32) % 7 == 0)
+					row[x] = static_cast<uchar>(key_level / 2);                  // other class, never glows
+			}
+		}
+		return mask;
+	}
+}
+
+//--------------------------------------------------------------------------
+// MipmapPyramidCPU
+//--------------------------------------------------------------------------
+MipmapPyramidCPU::MipmapPyramidCPU(const cv::Mat& src)
+	: MipmapPyramidCPU(src, cv::Rect(0, 0, src.cols, src.rows), src.size()) {
+}
+
+MipmapPyramidCPU::MipmapPyramidCPU(const cv::Mat& src, const cv::Rect& roi, const cv::Size& frame)
+	: roi(roi), frame(frame) {
+	if (src.empty() || src.depth() != CV_8U || src.channels() > 4) {
+		std::cerr << "Error: filter_mipmap_cpu expects a non-empty 8-bit image with 1 to 4 channels." << std::endl;
+		return;
+	}
+	if (roi.size() != src.size() || (roi & cv::Rect(0, 0, frame.width, frame.height)) != roi) {
+		std::cerr << "Error: MipmapPyramidCPU expects src to be the ROI of the frame." << std::endl;
+		return;
+	}
+	for (int level = std::max(frame.width, frame.height); level; level >>= 1)
+		n_level++;
+	levels.reserve(n_level);   // references into levels stay valid while levels are added
+
+	// Level 0 also stores the texels past the ROI that the lookup reads (with weight 0).
+	Level base;
+	base.size = frame;
+	base.support = roi;
+	base.window = level_window(roi, frame, roi, frame);
+	if (base.window == roi) {
+		base.data = src;
+	}
+	else {
+		base.data = cv::Mat::zeros(base.window.size(), src.type());
+		src.copyTo(base.data(cv::Rect(roi.x - base.window.x, roi.y - base.window.y, roi.width, roi.height)));
+	}
+	levels.push_back(base);
+}
+
+void MipmapPyramidCPU::add_level() {
+	const Level& prev = levels.back();
+	Level next;
+	next.size = cv::Size(std::max(1, prev.size.width / 2), std::max(1, prev.size.height / 2));
+	int x0, x1, y0, y1;
+	reached_span(make_half_taps(next.size.width, prev.size.width), prev.support.x, prev.support.x + prev.support.width, x0, x1);
+	reached_span(make_half_taps(next.size.height, prev.size.height), prev.support.y, prev.support.y + prev.support.height, y0, y1);
+	next.support = (x0 < x1 && y0 < y1) ? cv::Rect(x0, y0, x1 - x0, y1 - y0) : cv::Rect();
+	next.window = level_window(next.support, next.size, roi, frame);
+	next.data = half_level(prev.data, prev.window, prev.size, next.size, next.window);
+	levels.push_back(next);
+}
+
+cv::Mat MipmapPyramidCPU::sample(float scale, const cv::Rect& region) {
+	if (levels.empty())
+		return cv::Mat();
+	const cv::Rect full(0, 0, roi.width, roi.height);
+	const cv::Rect out_rect = region.area() > 0 ? (region & full) : full;
+	if (out_rect.area() <= 0)
+		return cv::Mat();
+
+	const float lod = std::min(mipmap_lod(scale), static_cast<float>(n_level - 1));
+	const int l0 = static_cast<int>(std::floor(lod));
+	const float blend = lod - l0;
+	const int l1 = blend > 0.0f ? l0 + 1 : l0;
+	const Level& base = levels[0];
+	if (l1 == 0) {
+		return base.data(cv::Rect(roi.x - base.window.x + out_rect.x, roi.y - base.window.y + out_rect.y,
+			out_rect.width, out_rect.height)).clone();
+	}
+
+	// Levels up to the sampled LOD; coarser ones wait for a larger scale.
+	while (static_cast<int>(levels.size()) <= l1)
+		add_level();
+
+	const Level& fine_level = levels[l0];
+	const Level& coarse_level = levels[l1];
+	const cv::Mat& fine = fine_level.data;
+	const cv::Mat& coarse = coarse_level.data;
+	const Taps fine_x = window_taps(frame.width, fine_level.size.width, roi.x, roi.width, fine_level.window.x);
+	const Taps fine_y = window_taps(frame.height, fine_level.size.height, roi.y, roi.height, fine_level.window.y);
+	const Taps coarse_x = window_taps(frame.width, coarse_level.size.width, roi.x, roi.width, coarse_level.window.x);
+	const Taps coarse_y = window_taps(frame.height, coarse_level.size.height, roi.y, roi.height, coarse_level.window.y);
+	const int cn = base.data.channels();
+
+	cv::Mat out(out_rect.size(), base.data.type());
+	task::parallel_rows(out.rows, [&](int row_begin, int row_end) {
+		std::vector<float> a(static_cast<size_t>(out.cols) * cn), b(a.size());
+		for (int y = row_begin; y < row_end; ++y) {
+			sample_row(fine, fine_x, fine_y, out_rect.y + y, out_rect.x, out.cols, a.data());
+			if (l1 != l0)
+				sample_row(coarse, coarse_x, coarse_y, out_rect.y + y, out_rect.x, out.cols, b.data());
+			uchar* row = out.ptr<uchar>(y);
+			for (size_t i = 0; i < a.size(); ++i) {
+				float v = l1 != l0 ? a[i] + (b[i] - a[i]) * blend : a[i];
+				row[i] = static_cast<uchar>(std::min(255.0f, std::max(0.0f, v + 0.5f)));
+			}
+		}
+	});
+	return out;
+}
+
+//--------------------------------------------------------------------------
+// half_mipmap_level
+//--------------------------------------------------------------------------
+cv::Mat half_mipmap_level(const cv::Mat& prev) {
+	return half_level(prev);
+}
+
+//--------------------------------------------------------------------------
+// filter_mipmap_cpu
+//--------------------------------------------------------------------------
+void filter_mipmap_cpu(const cv::Mat& src, cv::Mat& dst, float scale, const cv::Rect& roi, const cv::Size& frame) {
+	const bool placed = roi.area() > 0;
+	MipmapPyramidCPU pyramid(src, placed ? roi : cv::Rect(0, 0, src.cols, src.rows), placed ? frame : src.size());
+	cv::Mat out = pyramid.sample(scale);
+	if (!out.empty())
+		dst = out;
+}
+
+//--------------------------------------------------------------------------
+// apply_mipmap_cpu
+//--------------------------------------------------------------------------
+void apply_mipmap_cpu(const cv::Mat& input_gray, cv::Mat& output_gray, float scale, int param_KeyLevel,
+	const cv::Rect& roi, const cv::Size& frame) {
+	if (input_gray.empty() || input_gray.type() != CV_8UC1) {
+		std::cerr << "Error: Input image must be a single-channel grayscale image." << std::endl;
+		return;
+	}
+
+	filter_mipmap_cpu(key_mask(input_gray, param_KeyLevel), output_gray, scale, roi, frame);
+}
+
+//--------------------------------------------------------------------------
+// mipmap_texel_size / glow_roi
+//--------------------------------------------------------------------------
+int mipmap_texel_size(float scale) {
+	float lod = mipmap_lod(scale);
+	return 1 << static_cast<int>(std::ceil(lod - 1e-4f));
+}
+
+cv::Rect glow_roi(const cv::Rect& region, const cv::Size& frame, float scale) {
+	cv::Rect clipped = region & cv::Rect(0, 0, frame.width, frame.height);
+	if (clipped.width <= 0 || clipped.height <= 0)
+		return cv::Rect();
+
+	const int texel = mipmap_texel_size(scale);
+	const int pad = 2 * texel;
+	int x0 = std::max(0, clipped.x - pad) / texel * texel;
+	int y0 = std::max(0, clipped.y - pad) / texel * texel;
+	int x1 = std::min(frame.width, (clipped.x + clipped.width + pad + texel - 1) / texel * texel);
+	int y1 = std::min(frame.height, (clipped.y + clipped.height + pad + texel - 1) / texel * texel);
+	return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+//--------------------------------------------------------------------------
+// verify_glow_roi
+//--------------------------------------------------------------------------
+bool verify_glow_roi() {
+	const int key_level = 56;
+	// Frame sizes that are and are not multiples of the texel sizes sampled.
+	const cv::Size frames[] = { cv::Size(1024, 576), cv::Size(1920, 1080), cv::Size(1280, 720), cv::Size(1000, 563),
+		cv::Size(641, 359) };
+	const float scales[] = { 10.0f, 8.0f, 1.0f };
+	// A key inside the frame and keys on the bottom-left and bottom-right corners, where the
+	// level grid of a crop and of the full frame differ.
+	auto frame_keys = [](const cv::Size& frame) {
+		return std::vector<cv::Rect>{ cv::Rect(frame.width * 5 / 17, frame.height * 6 / 17, 90, 70),
+			cv::Rect(0, frame.height - 46, 41, 46), cv::Rect(frame.width - 37, frame.height - 29, 37, 29) };
+	};
+	auto max_difference = [](const cv::Mat& a, const cv::Mat& b) {
+		int d = 0;
+		for (int y = 0; y < a.rows; ++y)
+			for (int x = 0; x < a.cols; ++x)
+				d = std::max(d, std::abs(a.ptr<uchar>(y)[x] - b.ptr<uchar>(y)[x]));
+		return d;
+	};
+
+	bool ok = glow_roi(cv::Rect(), frames[0], 10.0f).area() == 0;
+	int max_inside = 0, max_crop = 0, max_outside = 0;
+	double area = 0.0;
+	for (const cv::Size& frame : frames) {
+		for (const cv::Rect& key : frame_keys(frame)) {
+			cv::Mat mask = make_key_mask(frame, key, key_level);
+			for (float scale : scales) {
+				cv::Rect roi = glow_roi(key, frame, scale);
+				cv::Mat full, part, crop;
+				apply_mipmap_cpu(mask, full, scale, key_level);
+				apply_mipmap_cpu(mask(roi), part, scale, key_level, roi, frame);
+				apply_mipmap_cpu(mask(roi), crop, scale, key_level);
+				if (full.empty() || part.size() != roi.size() || crop.size() != roi.size()) {
+					ok = false;
+					continue;
+				}
+				max_inside = std::max(max_inside, max_difference(full(roi), part));
+				max_crop = std::max(max_crop, max_difference(full(roi), crop));
+				for (int y = 0; y < frame.height; ++y) {
+					const uchar* f = full.ptr<uchar>(y);
+					for (int x = 0; x < frame.width; ++x) {
+						if (!roi.contains(cv::Point(x, y)))
+							max_outside = std::max(max_outside, static_cast<int>(f[x]));
+					}
+				}
+				area = std::max(area, static_cast<double>(roi.area()) / frame.area());
+			}
+		}
+	}
+	ok = ok && max_inside == 0 && max_crop <= 8 && max_outside == 0;
+	std::cout << "Glow ROI check (" << sizeof(frames) / sizeof(frames[0]) << " frame sizes): max ROI/full-frame mipmap "
+		<< "difference " << max_inside << " (crop's own grid: " << max_crop << "), max glow outside ROI " << max_outside
+		<< ", largest ROI " << area * 100.0 << "% of frame: " << (ok ? "PASSED" : "FAILED") << std::endl;
+
+	// One pyramid per key, built on the ROI of the largest scale, resampled at the others.
+	const float pyramid_scale = 128.0f;
+	const float resample_scales[] = { 100.0f, 32.0f, 10.0f, 8.0f, 3.0f, 1.0f };
+	int max_resample = 0;
+	bool resample_ok = true;
+	for (const cv::Size& frame : frames) {
+		for (const cv::Rect& key : frame_keys(frame)) {
+			cv::Mat mask = make_key_mask(frame, key, key_level);
+			const cv::Rect outer = glow_roi(key, frame, pyramid_scale);
+			MipmapPyramidCPU pyramid(key_mask(mask(outer), key_level), outer, frame);
+			for (float scale : resample_scales) {
+				cv::Rect roi = glow_roi(key, frame, scale);
+				cv::Mat fresh, resampled = pyramid.sample(scale, roi - outer.tl());
+				apply_mipmap_cpu(mask(roi), fresh, scale, key_level, roi, frame);
+				if (resampled.size() != fresh.size()) {
+					resample_ok = false;
+					continue;
+				}
+				max_resample = std::max(max_resample, max_difference(fresh, resampled));
+			}
+		}
+	}
+	resample_ok = resample_ok && max_resample == 0;
+	std::cout << "Mipmap pyramid check: max resample/fresh filter difference " << max_resample << " over "
+		<< sizeof(resample_scales) / sizeof(resample_scales[0]) << " scales: " << (resample_ok ? "PASSED" : "FAILED")
+		<< std::endl;
+	return ok && resample_ok;
+}
+
+//--------------------------------------------------------------------------
+// benchmark_glow_roi
+//--------------------------------------------------------------------------
+void benchmark_glow_roi(int width, int height) {
+	using clock = std::chrono::high_resolution_clock;
+	const int key_level = 56;
+	const int iterations = 5;
+	const float scale = 10.0f;
+	const cv::Size frame(std::max(64, width), std::max(64, height));
+	const cv::Rect key(frame.width / 2, frame.height / 3, frame.width / 24, frame.height / 12);
+	cv::Mat mask = make_key_mask(frame, key, key_level);
+	cv::Rect roi = glow_roi(key, frame, scale);
+
+	cv::Mat full, part;
+	auto t0 = clock::now();
+	for (int i = 0; i < iterations; ++i)
+		apply_mipmap_cpu(mask, full, scale, key_level);
+	auto t1 = clock::now();
+	for (int i = 0; i < iterations; ++i)
+		apply_mipmap_cpu(mask(roi), part, scale, key_level, roi, frame);
+	auto t2 = clock::now();
+	const cv::Rect outer = glow_roi(key, frame, 128.0f);
+	MipmapPyramidCPU pyramid(key_mask(mask(outer), key_level), outer, frame);
+	pyramid.sample(128.0f);
+	auto t3 = clock::now();
+	for (int i = 0; i < iterations; ++i)
+		part = pyramid.sample(scale + i, roi - outer.tl());
+	auto t4 = clock::now();
+
+	auto per_frame = [&](clock::duration d) {
+		return std::chrono::duration<double, std::milli>(d).count() / iterations;
+	};
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Glow ROI benchmark (" << frame.width << "x" << frame.height << ", CPU mipmap, scale "
+		<< scale << ")" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Full-frame mipmap: " << per_frame(t1 - t0) << " ms/frame" << std::endl;
+	std::cout << "ROI mipmap:        " << per_frame(t2 - t1) << " ms/frame (ROI " << roi.width << "x" << roi.height
+		<< ", " << 100.0 * roi.area() / frame.area() << "% of frame)" << std::endl;
+	std::cout << "Pyramid resample:  " << per_frame(t4 - t3) << " ms/scale change (pyramid kept from a "
+		<< outer.width << "x" << outer.height << " build)" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+}
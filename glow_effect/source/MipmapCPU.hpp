@@ -0,0 +1,169 @@
+#ifndef MIPMAP_CPU_HPP
+#define MIPMAP_CPU_HPP
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief A built mipmap pyramid that can be sampled at any blur scale.
+ *
+ * Building the pyramid is the expensive part of the glow blur; the level of detail only
+ * enters at sampling. Keeping the pyramid of a key image makes a blur scale change, or
+ * several looks at different scales, a resample each.
+ */
+class MipmapPyramid {
+public:
+	virtual ~MipmapPyramid() = default;
+
+	/**
+	 * @brief Samples the pyramid at the uniform LOD log2(scale).
+	 *
+	 * @param scale  Blur scale.
+	 * @param region Part of the level-0 image to produce; empty means all of it. Each output
+	 *               pixel equals the same pixel of a full-size sample.
+	 * @return The blurred region (the pyramid's type), empty if the pyramid is empty.
+	 */
+	virtual cv::Mat sample(float scale, const cv::Rect& region = cv::Rect()) = 0;
+
+	/** @brief Size of level 0. */
+	virtual cv::Size size() const = 0;
+};
+
+/**
+ * @brief CPU mipmap pyramid; levels are built on the first sample that needs them and kept.
+ */
+class MipmapPyramidCPU : public MipmapPyramid {
+public:
+	/** @brief Starts a pyramid on src (CV_8UCn, n = 1..4); an ROI view is fine, it is not copied. */
+	explicit MipmapPyramidCPU(const cv::Mat& src);
+
+	/**
+	 * @brief Starts a pyramid on the part roi of a frame image that is zero outside it.
+	 *
+	 * Levels keep the full frame's sizes and texel grid (floor(W / 2^L)), and only the part of
+	 * each level that is nonzero or read by a lookup inside roi is built, so sampling gives
+	 * exactly the full-frame result on roi. glow_roi of the key region satisfies the zero
+	 * precondition.
+	 *
+	 * @param src   The roi of the frame image (CV_8UCn, n = 1..4); copied only if padding is needed.
+	 * @param roi   Placement of src in the frame.
+	 * @param frame Frame size.
+	 */
+	MipmapPyramidCPU(const cv::Mat& src, const cv::Rect& roi, const cv::Size& frame);
+
+	cv::Mat sample(float scale, const cv::Rect& region = cv::Rect()) override;
+	cv::Size size() const override { return levels.empty() ? cv::Size() : roi.size(); }
+
+	/** @brief Levels built so far (level 0 included). */
+	int built_levels() const { return static_cast<int>(levels.size()); }
+
+private:
+	/** @brief Stored part of a pyramid level. */
+	struct Level {
+		cv::Size size;     ///< Full level size
+		cv::Rect support;  ///< Texels that may be nonzero
+		cv::Rect window;   ///< Texels held in data: the support and what lookups inside roi read
+		cv::Mat data;
+	};
+
+	void add_level();
+
+	cv::Rect roi;
+	cv::Size frame;
+	std::vector<Level> levels;
+	int n_level = 0;
+};
+
+/**
+ * @brief CPU counterpart of filter_mipmap: builds levels like d_gen_mipmap and samples them
+ *        trilinearly at the uniform level of detail log2(scale).
+ *
+ * Only the levels needed for that LOD are built. Works on any 8-bit image with 1 to 4
+ * channels; a single-channel key image gives the same alpha as the RGBA GPU path at a
+ * quarter of the work.
+ *
+ * @param src   Source image (CV_8UCn, n = 1..4).
+ * @param dst   Destination image, same size and type as src.
+ * @param scale Blur scale; values <= 1 copy the source.
+ * @param roi   Placement of src in a frame image that is zero outside it (see MipmapPyramidCPU);
+ *              empty means src is the whole frame.
+ * @param frame Frame size; used with roi.
+ */
+void filter_mipmap_cpu(const cv::Mat& src, cv::Mat& dst, float scale,
+	const cv::Rect& roi = cv::Rect(), const cv::Size& frame = cv::Size());
+
+/**
+ * @brief Next level of a CPU pyramid, half the size (at least 1x1): one d_gen_mipmap pass.
+ *
+ * d_gen_mipmap averages four bilinear fetches at the corners of each output texel, which reads
+ * a 4x4 texel footprint (clamped at the edges) rather than the 2x2 block; this function uses the
+ * same footprint and weights but rounds where the kernel truncates, so the two may differ by 1.
+ */
+cv::Mat half_mipmap_level(const cv::Mat& prev);
+
+/**
+ * @brief CPU counterpart of apply_mipmap: keys the mask and filters it with filter_mipmap_cpu.
+ *
+ * Pixels equal to param_KeyLevel keep their value, all others become 0; the result is the
+ * blurred key as a single-channel image, which mix_images accepts as its alpha source.
+ *
+ * @param input_gray     Source mask (CV_8UC1); an ROI view is fine.
+ * @param output_gray    Destination blurred key (CV_8UC1, same size as input_gray).
+ * @param scale          Scale factor used by the mipmap filter.
+ * @param param_KeyLevel Mask value that is glowing.
+ * @param roi            Placement of input_gray in the frame, as for filter_mipmap_cpu.
+ * @param frame          Frame size; used with roi.
+ */
+void apply_mipmap_cpu(const cv::Mat& input_gray, cv::Mat& output_gray, float scale, int param_KeyLevel,
+	const cv::Rect& roi = cv::Rect(), const cv::Size& frame = cv::Size());
+
+/**
+ * @brief Texel size in pixels of the coarsest mipmap level sampled at log2(scale).
+ */
+int mipmap_texel_size(float scale);
+
+/**
+ * @brief Region of a frame that the glow of a key region can reach.
+ *
+ * The key bounding box is padded by two texels of the coarsest sampled level, which covers
+ * the 4x4 footprint of the pyramid and the bilinear footprint of the lookup, and aligned to
+ * that texel size. Outside the returned rectangle the mipmap is zero, so pyramid build, LOD
+ * sampling and blend can be restricted to it and the rest of the frame copied through.
+ *
+ * Level sizes are floor(W / 2^L), so unless the frame size is a multiple of the texel size a
+ * pyramid built on the crop alone has a slightly different texel grid. The CPU path places
+ * its pyramid on the frame's grid (MipmapPyramidCPU(src, roi, frame)) and matches the full
+ * frame exactly; the GPU path builds on the crop and may differ by a few levels of 255 near
+ * the glow edge (see verify_glow_roi).
+ *
+ * @param region Bounding box of the key pixels (empty if there are none).
+ * @param frame  Frame size.
+ * @param scale  Blur scale (default_scale).
+ * @return Rectangle inside the frame; empty if region is empty.
+ */
+cv::Rect glow_roi(const cv::Rect& region, const cv::Size& frame, float scale);
+
+/**
+ * @brief Headless check of the CPU mipmap, the glow ROI and pyramid resampling.
+ *
+ * For several frame sizes, including ones that are not multiples of the texel size, filters
+ * generated key masks over the full frame and over their ROI only. The placed ROI result must
+ * equal the full frame inside the ROI and the full frame must be zero outside it; the difference
+ * of a pyramid built on the crop's own grid (as the GPU path does) is reported and bounded. One
+ * pyramid built on the ROI of the largest scale must then give, at every smaller scale and on
+ * that scale's ROI, exactly what a fresh filter gives.
+ *
+ * @return true if the check passed.
+ */
+bool verify_glow_roi();
+
+/**
+ * @brief Times the CPU mipmap over a full frame and over the ROI of a small key region, and a
+ *        scale change answered by resampling a kept pyramid.
+ *
+ * @param width  Frame width (e.g. 3840).
+ * @param height Frame height (e.g. 2160).
+ */
+void benchmark_glow_roi(int width, int height);
+
+#endif // MIPMAP_CPU_HPP
@@ -0,0 +1,309 @@
+/**
+ * @file PipelineBench.cpp
+ * @brief End-to-end benchmark of the video pipeline on a synthetic clip with the CPU backends.
+ */
+
+#include "PipelineBench.hpp"
+#include "GlowRender.hpp"
+#include "BatchJobs.hpp"
+#include "CpuSegmenter.hpp"
+#include "GlowClasses.hpp"
+#include "Profiler.hpp"
+#include "RawVideoSink.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+#include "movie_effect/include/def_movies.h"
+#include "movie_effect/include/tools_image.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	const int kTile = 128;         // checker tile of the background (a compile-time size for synimg)
+
+	// Position at frame index of a point moving by velocity and bouncing off 0 and range.
+	int bounce(int origin, int velocity, int index, int range) {
+		if (range <= 0)
+			return 0;
+		const int period = 2 * range;
+		int p = (origin + velocity * index) % period;
+		if (p < 0)
+			p += period;
+		return p < range ? p : period - p;
+	}
+
+	std::string output_extension(const std::string& format) {
+		if (format == "avi")
+			return ".avi";
+		return format.compare(0, 3, "y4m") == 0 ? ".y4m" : ".yuv";
+	}
+
+	double mib(uint64_t bytes) {
+		return bytes / (1024.0 * 1024.0);
+	}
+}
+
+//--------------------------------------------------------------------------
+// parse_pipeline_bench_args
+//--------------------------------------------------------------------------
+bool parse_pipeline_bench_args(int argc, char** argv, PipelineBenchSpec& spec) {
+	if (argc < 2 || argc > 6 || std::string(argv[1]) != "--pipeline-bench")
+		return false;
+	try {
+		if (argc > 2) {
+			const std::string size = argv[2];
+			const size_t x = size.find('x');
+			if (x == std::string::npos)
+				return false;
+			spec.width = std::stoi(size.substr(0, x));
+			spec.height = std::stoi(size.substr(x + 1));
+		}
+		if (argc > 3)
+			spec.frames = std::stoi(argv[3]);
+		if (argc > 4)
+			spec.keyframe_interval = std::max(1, std::stoi(argv[4]));
+		if (argc > 5)
+			spec.format = argv[5];
+	}
+	catch (const std::exception&) {
+		return false;
+	}
+	RawVideoFormat raw;
+	return spec.width >= 64 && spec.height >= 64 && spec.frames > 0 &&
+		(spec.format == "avi" || parse_raw_video_format(spec.format, raw));
+}
+
+//--------------------------------------------------------------------------
+// PatternClip
+//--------------------------------------------------------------------------
+PatternClip::PatternClip(int width, int height) : width(width), height(height), tile(kTile) {
+	struct Planes {
+		short r[kTile][kTile], g[kTile][kTile], b[kTile][kTile];
+	};
+	auto planes = std::make_unique<Planes>();
+	// Two soft-edged cells per tile side, so the tiles join without a seam.
+	synimg::image_checker<kTile, kTile, 8>(kTile, kTile, 2, 2, true, 0.3f, planes->r, planes->g, planes->b);
+	cv::Mat checker(kTile, kTile, CV_8UC3);
+	for (int y = 0; y < kTile; ++y) {
+		uchar* row = checker.ptr<uchar>(y);
+		for (int x = 0; x < kTile; ++x) {
+			row[x * 3] = cv::saturate_cast<uchar>(planes->b[y][x]);
+			row[x * 3 + 1] = cv::saturate_cast<uchar>(planes->g[y][x]);
+			row[x * 3 + 2] = cv::saturate_cast<uchar>(planes->r[y][x]);
+		}
+	}
+	cv::repeat(checker, (height + kTile - 1) / kTile, width / kTile + 2, background);
+
+	const int h = height;
+	shapes[0] = { cv::Scalar(0, 0, 230), 8 * kClassLevelStep, true, cv::Size(h / 4, h / 4), cv::Point(0, h / 3), cv::Point(9, 5) };
+	shapes[1] = { cv::Scalar(0, 200, 0), 5 * kClassLevelStep, false, cv::Size(h / 5, h / 7), cv::Point(width / 2, 0), cv::Point(-6, 4) };
+	shapes[2] = { cv::Scalar(220, 40, 0), 2 * kClassLevelStep, true, cv::Size(h / 5, h / 5), cv::Point(width / 3, h / 2), cv::Point(4, -7) };
+}
+
+void PatternClip::render(int index, cv::Mat& frame, cv::Mat& mask) const {
+	background(cv::Rect((index * 2) % tile, 0, width, height)).copyTo(frame);
+	mask.create(height, width, CV_8UC1);
+	mask.setTo(cv::Scalar(0));
+
+	// Later shapes cover earlier ones in the frame and in the mask alike.
+	for (const Shape& shape : shapes) {
+		const cv::Rect box(bounce(shape.origin.x, shape.velocity.x, index, width - shape.size.width),
+			bounce(shape.origin.y, shape.velocity.y, index, height - shape.size.height),
+			shape.size.width, shape.size.height);
+		if (shape.disc) {
+			const cv::Point center(box.x + box.width / 2, box.y + box.height / 2);
+			cv::circle(frame, center, box.width / 2, shape.bgr, cv::FILLED);
+			cv::circle(mask, center, box.width / 2, cv::Scalar(shape.level), cv::FILLED);
+		}
+		else {
+			cv::rectangle(frame, box, shape.bgr, cv::FILLED);
+			cv::rectangle(mask, box, cv::Scalar(shape.level), cv::FILLED);
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+// peak_memory_bytes / reset_peak_memory
+//--------------------------------------------------------------------------
+uint64_t peak_memory_bytes() {
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize;
+	return 0;
+#else
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		if (line.compare(0, 6, "VmHWM:") == 0)
+			return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+	}
+	return 0;
+#endif
+}
+
+bool reset_peak_memory() {
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
+	return false;
+#else
+	std::ofstream clear_refs("/proc/self/clear_refs");
+	clear_refs << "5";   // resets VmHWM to the current resident size (Linux 4.0+)
+	clear_refs.flush();
+	return clear_refs.good();
+#endif
+}
+
+//--------------------------------------------------------------------------
+// benchmark_pipeline
+//--------------------------------------------------------------------------
+bool benchmark_pipeline(const PipelineBenchSpec& spec) {
+	std::error_code ec;
+	const fs::path dir = spec.work_dir.empty() ? fs::temp_directory_path() / "glow_pipeline_bench" : fs::path(spec.work_dir);
+	fs::create_directories(dir, ec);
+	const std::string input = (dir / "pattern_clip.avi").string();
+	const std::string output = (dir / ("pattern_clip_glow" + output_extension(spec.format))).string();
+	const cv::Size size(spec.width, spec.height);
+	const int check_stride = std::max(1, spec.frames / 16);
+
+	// The clip is written frame by frame; only the masks of the frames checked below are kept.
+	auto gen_start = std::chrono::steady_clock::now();
+	std::vector<cv::Mat> truth;
+	{
+		cv::VideoWriter writer(input, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30.0, size);
+		if (!writer.isOpened()) {
+			std::cerr << "Error: Could not write the benchmark clip: " << input << std::endl;
+			return false;
+		}
+		writer.set(cv::VIDEOWRITER_PROP_QUALITY, 95);
+		PatternClip clip(spec.width, spec.height);
+		cv::Mat frame, mask;
+		for (int i = 0; i < spec.frames; ++i) {
+			clip.render(i, frame, mask);
+			writer.write(frame);
+			if (i % check_stride == 0) {
+				cv::Mat grid;
+				cv::resize(mask, grid, CpuSegmenterConfig().mask_size, 0, 0, cv::INTER_NEAREST);
+				truth.push_back(grid);
+			}
+		}
+	}
+	const double gen_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - gen_start).count();
+
+	// Mock segmentation of the decoded clip against the ground truth, per class.
+	const int levels[3] = { 8 * kClassLevelStep, 5 * kClassLevelStep, 2 * kClassLevelStep };
+	const char* const level_names[3] = { "red (class 8)", "green (class 5)", "blue (class 2)" };
+	uint64_t intersection[3] = {}, union_count[3] = {};
+	{
+		cv::VideoCapture capture(input);
+		cv::Mat frame;
+		for (int i = 0; capture.read(frame) && !frame.empty(); ++i) {
+			if (i % check_stride != 0 || static_cast<size_t>(i / check_stride) >= truth.size())
+				continue;
+			const cv::Mat segmented = segment_frame_cpu(frame);
+			const cv::Mat& expected = truth[i / check_stride];
+			for (int y = 0; y < segmented.rows; ++y) {
+				const uchar* s = segmented.ptr<uchar>(y);
+				const uchar* t = expected.ptr<uchar>(y);
+				for (int x = 0; x < segmented.cols; ++x) {
+					for (int l = 0; l < 3; ++l) {
+						intersection[l] += (s[x] == levels[l]) && (t[x] == levels[l]);
+						union_count[l] += (s[x] == levels[l]) || (t[x] == levels[l]);
+					}
+				}
+			}
+		}
+	}
+	truth.clear();
+
+	// Render through the batch-mode pipeline with the CPU backends; a mask store of an earlier
+	// run would replace the segmentation, so it goes first.
+	fs::remove(output + ".masks", ec);
+	const MipmapBackend saved_backend = mipmap_backend;
+	// A GLOW_PROFILE session keeps its zones: the stage table counts only those of the render.
+	const bool profiling = profiler_enabled();
+	mipmap_backend = MipmapBackend::Cpu;
+	if (!profiling)
+		profiler_reset();
+	profiler_enable(true);
+	const uint64_t render_start_ns = profiler_now_ns();
+	const uint64_t peak_before = peak_memory_bytes();
+	const bool peak_reset = reset_peak_memory();
+
+	BatchJob job;
+	job.input = input;
+	job.output = output;
+	job.plan = "cpu";
+	job.keyframe_interval = spec.keyframe_interval;
+	job.format = spec.format;
+	auto run_start = std::chrono::steady_clock::now();
+	const BatchJobResult result = glow_effect_video_job(job);
+	const double run_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+
+	const uint64_t peak_run = peak_memory_bytes();
+	profiler_enable(profiling);
+	const std::vector<ProfileStageStats> stages = profiler_stage_stats(render_start_ns);
+	mipmap_backend = saved_backend;
+	uintmax_t output_bytes = fs::file_size(output, ec);
+	if (ec)
+		output_bytes = 0;
+
+	bool segmentation_ok = true;
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "End-to-end pipeline benchmark (" << spec.width << "x" << spec.height << ", " << spec.frames
+		<< " synthetic frames, CPU segmenter, CPU mipmaps, k=" << spec.keyframe_interval << ", " << spec.format << ")" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Input clip: " << input << " (generated and encoded in " << gen_seconds << " s)" << std::endl;
+	std::cout << "Mock segmentation vs ground truth (IoU, every " << check_stride << " frames of the decoded clip):" << std::endl;
+	for (int l = 0; l < 3; ++l) {
+		const double iou = union_count[l] ? double(intersection[l]) / union_count[l] : 0.0;
+		segmentation_ok &= iou >= 0.8;
+		std::printf("   %-16s %.3f\n", level_names[l], iou);
+	}
+	if (!result.ok) {
+		std::cout << "Render failed: " << result.error << std::endl;
+	}
+	else {
+		std::cout << "Frames rendered: " << result.frames << " in " << run_seconds << " s: "
+			<< (run_seconds > 0.0 ? result.frames / run_seconds : 0.0) << " fps ("
+			<< (result.frames ? run_seconds * 1000.0 / result.frames : 0.0) << " ms per frame)" << std::endl;
+		std::cout << "Segmentation (summed over batches): " << result.segmentation_seconds << " s" << std::endl;
+		std::cout << "Glow and compositing (summed over batches): " << result.post_seconds << " s" << std::endl;
+		std::cout << "Output: " << output << " (" << mib(output_bytes) << " MiB)" << std::endl;
+		std::cout << "Stages (profiler zones, summed over threads):" << std::endl;
+		std::printf("   %-12s %8s %10s %9s %9s %9s\n", "zone", "count", "total ms", "mean ms", "p95 ms", "max ms");
+		for (const ProfileStageStats& stage : stages)
+			std::printf("   %-12s %8llu %10.1f %9.3f %9.3f %9.3f\n", stage.name.c_str(), static_cast<unsigned long long>(stage.count),
+				stage.total_ms, stage.mean_ms, stage.p95_ms, stage.max_ms);
+	}
+	if (peak_run == 0)
+		std::cout << "Peak memory: not available on this system" << std::endl;
+	else if (peak_reset)
+		std::cout << "Peak memory of the render: " << mib(peak_run) << " MiB (" << mib(peak_before) << " MiB before)" << std::endl;
+	else
+		std::cout << "Peak memory of the process: " << mib(peak_run) << " MiB (" << mib(peak_before) << " MiB before the render)" << std::endl;
+	if (!segmentation_ok)
+		std::cout << "Segmentation missed the synthetic shapes (IoU below 0.8); the timings do not cover the glow path." << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+
+	fs::remove(input, ec);
+	fs::remove(output, ec);
+	fs::remove(output + ".masks", ec);
+	return result.ok && segmentation_ok;
+}
@@ -0,0 +1,84 @@
+#ifndef PIPELINE_BENCH_HPP
+#define PIPELINE_BENCH_HPP
+
+#include <cstdint>
+#include <string>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Settings of the end-to-end pipeline benchmark.
+ */
+struct PipelineBenchSpec {
+	int width = 1920;              ///< Frame width of the synthetic clip.
+	int height = 1080;             ///< Frame height of the synthetic clip.
+	int frames = 240;              ///< Length of the clip.
+	int keyframe_interval = 1;     ///< Segment every Nth frame and propagate masks in between.
+	std::string format = "avi";    ///< "avi" or a raw format name (see parse_raw_video_format).
+	std::string work_dir;          ///< Input clip, output and mask store; empty for a temporary directory.
+};
+
+/**
+ * @brief Parses "--pipeline-bench [WxH] [frames] [keyframe interval] [format]".
+ *
+ * @return false if argv is not a --pipeline-bench command line or an argument is malformed.
+ */
+bool parse_pipeline_bench_args(int argc, char** argv, PipelineBenchSpec& spec);
+
+/**
+ * @brief Frames of the benchmark clip with ground-truth class masks.
+ *
+ * The background is a soft checker tile from synimg::image_checker (movie_effect/include/
+ * tools_image.h) scrolling sideways; a red disc, a green box and a blue disc bounce across it.
+ * Their colors are those the CPU segmenter maps to classes 8 (the default key level), 5 and 2,
+ * and the masks carry those classes at the argmax_class_masks levels (class * kClassLevelStep).
+ */
+class PatternClip {
+public:
+	PatternClip(int width, int height);
+
+	/** @brief Renders frame index (CV_8UC3) and its mask (CV_8UC1, frame size). */
+	void render(int index, cv::Mat& frame, cv::Mat& mask) const;
+
+private:
+	struct Shape {
+		cv::Scalar bgr;
+		int level;           // mask value
+		bool disc;
+		cv::Size size;       // bounding box
+		cv::Point origin;    // position at frame 0
+		cv::Point velocity;  // pixels per frame
+	};
+
+	int width;
+	int height;
+	int tile;
+	cv::Mat background;   // tiled checker, one tile wider than the frame
+	Shape shapes[3];
+};
+
+/**
+ * @brief Peak resident memory of the process in bytes (0 where unknown).
+ */
+uint64_t peak_memory_bytes();
+
+/**
+ * @brief Resets the peak of peak_memory_bytes() to the current resident memory where the OS
+ *        allows it (Linux); returns false otherwise.
+ */
+bool reset_peak_memory();
+
+/**
+ * @brief End-to-end benchmark without a video file, a TensorRT plan or a GPU.
+ *
+ * Writes a PatternClip to an MJPG AVI, checks that the CPU segmenter finds the shapes of the
+ * decoded clip where the ground-truth masks put them, and renders the clip through the video
+ * pipeline of the batch mode (decode, CPU segmentation, glow with CPU mipmaps, compositing and
+ * encoding to spec.format). Prints fps, the per-stage profiler table, the latency report and
+ * the peak memory of the render. Restores mipmap_backend and the profiler state afterwards;
+ * the zones of an active profiler session are kept.
+ *
+ * @return false if the clip could not be written or rendered, or the segmentation missed the shapes.
+ */
+bool benchmark_pipeline(const PipelineBenchSpec& spec);
+
+#endif // PIPELINE_BENCH_HPP
@@ -0,0 +1,346 @@
+/**
+ * @file Profiler.cpp
+ * @brief Thread ring registry, Chrome trace export and stage aggregates of the scoped-zone profiler.
+ */
+
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+std::atomic<bool> profiler_detail::enabled{ false };
+
+namespace {
+	struct ProfileRegistry {
+		std::mutex mutex;   // guards rings, next_tid and the names and exited flags of the rings
+		std::vector<std::shared_ptr<ProfileRing>> rings;
+		int next_tid = 0;
+	};
+
+	// Never destroyed: threads may still close zones while the process exits.
+	ProfileRegistry& registry() {
+		static ProfileRegistry* instance = new ProfileRegistry();
+		return *instance;
+	}
+
+	std::chrono::steady_clock::time_point clock_origin() {
+		static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+		return origin;
+	}
+
+	void json_string(std::ostream& out, const std::string& s) {
+		out << '"';
+		for (char c : s) {
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20)
+				out << ' ';
+			else
+				out << c;
+		}
+		out << '"';
+	}
+}
+
+uint64_t profiler_detail::now_ns() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - clock_origin()).count());
+}
+
+profiler_detail::ThreadRing::ThreadRing() {
+	auto owned = std::make_shared<ProfileRing>();
+	ProfileRegistry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	owned->tid = reg.next_tid++;
+	reg.rings.push_back(owned);
+	ring = owned.get();
+}
+
+profiler_detail::ThreadRing::~ThreadRing() {
+	std::lock_guard<std::mutex> lock(registry().mutex);
+	ring->exited = true;
+}
+
+void profiler_enable(bool on) {
+	clock_origin();
+	profiler_detail::enabled.store(on, std::memory_order_relaxed);
+}
+
+void profiler_set_thread_name(const std::string& name) {
+	if (!profiler_enabled())
+		return;
+	ProfileRing& ring = profiler_detail::this_thread_ring();
+	std::lock_guard<std::mutex> lock(registry().mutex);
+	ring.name = name;
+}
+
+void profiler_reset() {
+	ProfileRegistry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	reg.rings.erase(std::remove_if(reg.rings.begin(), reg.rings.end(),
+		[](const std::shared_ptr<ProfileRing>& ring) { return ring->exited; }), reg.rings.end());
+	for (auto& ring : reg.rings)
+		ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------
+// profiler_collect
+//--------------------------------------------------------------------------
+std::vector<ProfileThreadEvents> profiler_collect() {
+	const uint64_t capacity = ProfileRing::kCapacity;
+	std::vector<ProfileThreadEvents> threads;
+	ProfileRegistry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	for (auto& ring : reg.rings) {
+		ProfileThreadEvents t;
+		t.tid = ring->tid;
+		t.name = ring->name;
+		const uint64_t head = ring->head.load(std::memory_order_acquire);
+		const uint64_t first = std::max(ring->tail.load(std::memory_order_relaxed), head > capacity ? head - capacity : 0);
+		for (uint64_t i = first; i < head; ++i)
+			t.events.push_back(ring->load(i));
+		// Slots the owner reused while they were copied are dropped, including the one it may be
+		// writing now (event head_after shares its slot with event head_after - capacity). The
+		// fence pairs with the one in push(): a copied store of zone h means head_after >= h.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t head_after = ring->head.load(std::memory_order_relaxed);
+		const uint64_t valid_from = head_after >= capacity ? head_after - capacity + 1 : 0;
+		if (valid_from > first)
+			t.events.erase(t.events.begin(), t.events.begin() + std::min<uint64_t>(valid_from - first, t.events.size()));
+		if (!t.events.empty())
+			threads.push_back(std::move(t));
+	}
+	return threads;
+}
+
+//--------------------------------------------------------------------------
+// profiler_write_chrome_trace
+//--------------------------------------------------------------------------
+bool profiler_write_chrome_trace(const std::string& path) {
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		std::cerr << "Error: Could not write the profile trace: " << path << std::endl;
+		return false;
+	}
+	char number[64];
+	bool first = true;
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (const ProfileThreadEvents& t : profiler_collect()) {
+		out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t.tid
+			<< ",\"args\":{\"name\":";
+		json_string(out, t.name.empty() ? "thread " + std::to_string(t.tid) : t.name);
+		out << "}}";
+		first = false;
+		for (const ProfileEvent& e : t.events) {
+			out << ",\n{\"name\":";
+			json_string(out, e.name);
+			std::snprintf(number, sizeof(number), ",\"ts\":%.3f,\"dur\":%.3f", e.begin_ns / 1000.0,
+				(e.end_ns - e.begin_ns) / 1000.0);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << t.tid << number << "}";
+		}
+	}
+	out << "\n]}\n";
+	return static_cast<bool>(out);
+}
+
+//--------------------------------------------------------------------------
+// Stage aggregates
+//--------------------------------------------------------------------------
+std::vector<ProfileStageStats> profiler_stage_stats(uint64_t since_ns) {
+	std::map<std::string, std::vector<double>> durations;
+	for (const ProfileThreadEvents& t : profiler_collect())
+		for (const ProfileEvent& e : t.events)
+			if (e.begin_ns >= since_ns)
+				durations[e.name].push_back((e.end_ns - e.begin_ns) / 1e6);
+
+	std::vector<ProfileStageStats> stages;
+	for (auto& item : durations) {
+		std::vector<double>& d = item.second;
+		std::sort(d.begin(), d.end());
+		ProfileStageStats s;
+		s.name = item.first;
+		s.count = d.size();
+		for (double ms : d)
+			s.total_ms += ms;
+		s.mean_ms = s.total_ms / d.size();
+		s.p50_ms = d[(d.size() - 1) / 2];
+		s.p95_ms = d[(d.size() - 1) * 95 / 100];
+		s.max_ms = d.back();
+		stages.push_back(s);
+	}
+	std::sort(stages.begin(), stages.end(), [](const ProfileStageStats& a, const ProfileStageStats& b) {
+		return a.total_ms > b.total_ms;
+	});
+	return stages;
+}
+
+void profiler_report() {
+	std::vector<ProfileStageStats> stages = profiler_stage_stats();
+	std::printf("%-20s %9s %11s %9s %9s %9s %9s\n", "zone", "count", "total ms", "mean ms", "p50 ms", "p95 ms", "max ms");
+	for (const ProfileStageStats& s : stages)
+		std::printf("%-20s %9llu %11.2f %9.3f %9.3f %9.3f %9.3f\n", s.name.c_str(), static_cast<unsigned long long>(s.count),
+			s.total_ms, s.mean_ms, s.p50_ms, s.p95_ms, s.max_ms);
+	if (stages.empty())
+		std::printf("(no zones recorded)\n");
+}
+
+//--------------------------------------------------------------------------
+// ProfileSession
+//--------------------------------------------------------------------------
+ProfileSession::ProfileSession(const std::string& trace_path) : path(trace_path) {
+	if (path.empty())
+		return;
+	profiler_reset();
+	profiler_enable(true);
+	std::cout << "Profiling; the trace goes to " << path << std::endl;
+}
+
+ProfileSession::~ProfileSession() {
+	if (path.empty())
+		return;
+	profiler_enable(false);
+	profiler_report();
+	if (profiler_write_chrome_trace(path))
+		std::cout << "Profile trace saved to: " << path << " (open in chrome://tracing or ui.perfetto.dev)" << std::endl;
+}
+
+//--------------------------------------------------------------------------
+// verify_profiler
+//--------------------------------------------------------------------------
+bool verify_profiler() {
+	using clock = std::chrono::steady_clock;
+
+	// Disabled zones record nothing; their cost is one load and a branch.
+	profiler_enable(false);
+	profiler_reset();
+	const int disabled_zones = 1000000;
+	auto start = clock::now();
+	for (int i = 0; i < disabled_zones; ++i) {
+		PROFILE_ZONE("check_disabled");
+	}
+	const double disabled_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / disabled_zones;
+	bool disabled_ok = profiler_collect().empty();
+
+	// Nested zones on four threads.
+	profiler_enable(true);
+	const int threads = 4, iterations = 100;
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([t] {
+			profiler_set_thread_name("check " + std::to_string(t));
+			for (int i = 0; i < iterations; ++i) {
+				PROFILE_ZONE("check_outer");
+				{
+					PROFILE_ZONE("check_inner");
+					const auto until = clock::now() + std::chrono::microseconds(20);
+					while (clock::now() < until) {}
+				}
+			}
+		});
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+
+	bool nested_ok = true;
+	int named_threads = 0;
+	for (const ProfileThreadEvents& t : profiler_collect()) {
+		named_threads += t.name.compare(0, 6, "check ") == 0 ? 1 : 0;
+		nested_ok = nested_ok && t.events.size() == 2 * iterations;
+		for (size_t i = 0; nested_ok && i + 1 < t.events.size(); i += 2) {
+			const ProfileEvent& inner = t.events[i];
+			const ProfileEvent& outer = t.events[i + 1];
+			nested_ok = std::string(inner.name) == "check_inner" && std::string(outer.name) == "check_outer" &&
+				outer.begin_ns <= inner.begin_ns && inner.end_ns <= outer.end_ns && inner.end_ns - inner.begin_ns >= 20000;
+		}
+	}
+	nested_ok = nested_ok && named_threads == threads;
+
+	std::vector<ProfileStageStats> stages = profiler_stage_stats();
+	const bool stats_ok = stages.size() == 2 && stages[0].name == "check_outer" && stages[0].count == threads * iterations &&
+		stages[1].count == threads * iterations && stages[0].total_ms >= stages[1].total_ms &&
+		stages[1].p50_ms >= 0.02 && stages[1].max_ms >= stages[1].p95_ms && stages[1].p95_ms >= stages[1].p50_ms;
+
+	// Chrome trace: one complete event per zone and one name per thread.
+	const std::string trace_path = (std::filesystem::temp_directory_path() / "glow_profile_check.json").string();
+	bool trace_ok = profiler_write_chrome_trace(trace_path);
+	{
+		std::ifstream in(trace_path, std::ios::binary);
+		const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		size_t complete = 0, names = 0;
+		for (size_t pos = text.find("\"ph\":\"X\""); pos != std::string::npos; pos = text.find("\"ph\":\"X\"", pos + 1))
+			++complete;
+		for (size_t pos = text.find("\"thread_name\""); pos != std::string::npos; pos = text.find("\"thread_name\"", pos + 1))
+			++names;
+		trace_ok = trace_ok && text.compare(0, 15, "{\"displayTimeUn") == 0 && text.find("\n]}") != std::string::npos &&
+			complete == static_cast<size_t>(2 * threads * iterations) && names == static_cast<size_t>(threads);
+	}
+	std::error_code ec;
+	std::filesystem::remove(trace_path, ec);
+
+	// Ring wrap-around keeps the newest kCapacity - 1 zones of the thread (see profiler_collect).
+	profiler_reset();
+	const uint64_t wrap_zones = ProfileRing::kCapacity + 100;
+	for (uint64_t i = 0; i < wrap_zones; ++i) {
+		PROFILE_ZONE("check_wrap");
+	}
+	bool wrap_ok = false;
+	for (const ProfileThreadEvents& t : profiler_collect()) {
+		if (t.tid != profiler_detail::this_thread_ring().tid)
+			continue;
+		wrap_ok = t.events.size() == ProfileRing::kCapacity - 1;
+		for (size_t i = 1; wrap_ok && i < t.events.size(); ++i)
+			wrap_ok = t.events[i].begin_ns >= t.events[i - 1].end_ns;
+	}
+
+	// Collecting while threads push and wrap their rings: every copied zone is one the thread
+	// pushed, whole. The zones carry their index i as (check_race_a|b, i, i + 7).
+	profiler_reset();
+	static const char* const race_names[2] = { "check_race_a", "check_race_b" };
+	const uint64_t race_zones = 4 * ProfileRing::kCapacity;
+	std::atomic<int> racing{ threads };
+	std::vector<std::thread> pushers;
+	for (int t = 0; t < threads; ++t) {
+		pushers.emplace_back([&racing, race_zones] {
+			profiler_set_thread_name("check race");
+			ProfileRing& ring = profiler_detail::this_thread_ring();
+			for (uint64_t i = 0; i < race_zones; ++i)
+				ring.push(race_names[i & 1], i, i + 7);
+			--racing;
+		});
+	}
+	bool race_ok = true;
+	int collects = 0;
+	do {
+		++collects;
+		for (const ProfileThreadEvents& t : profiler_collect()) {
+			if (t.name != "check race")
+				continue;
+			for (size_t i = 0; race_ok && i < t.events.size(); ++i) {
+				const ProfileEvent& e = t.events[i];
+				race_ok = e.name == race_names[e.begin_ns & 1] && e.end_ns == e.begin_ns + 7 &&
+					(i == 0 || e.begin_ns == t.events[i - 1].begin_ns + 1);
+			}
+		}
+	} while (racing > 0);
+	for (std::thread& pusher : pushers)
+		pusher.join();
+
+	profiler_enable(false);
+	profiler_reset();
+	const bool passed = disabled_ok && nested_ok && stats_ok && trace_ok && wrap_ok && race_ok;
+	std::cout << "Profiler check: disabled zone " << disabled_ns << " ns, nested zones on " << threads << " threads "
+		<< (nested_ok ? "ok" : "WRONG") << ", stage table " << (stats_ok ? "ok" : "WRONG") << ", Chrome trace "
+		<< (trace_ok ? "ok" : "WRONG") << ", ring wrap-around " << (wrap_ok ? "ok" : "WRONG") << ", collect while recording ("
+		<< collects << " collects) " << (race_ok ? "ok" : "TORN") << ": "
+		<< (passed ? "PASSED" : "FAILED") << std::endl;
+	return passed;
+}
@@ -0,0 +1,204 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One completed zone: a static name and its begin/end on the profiler clock (ns).
+ */
+struct ProfileEvent {
+	const char* name = nullptr;   ///< String literal passed to PROFILE_ZONE.
+	uint64_t begin_ns = 0;
+	uint64_t end_ns = 0;
+};
+
+/**
+ * @brief Ring of the most recent zones of one thread.
+ *
+ * Only the owning thread pushes (no lock, no allocation); readers copy the ring and drop the
+ * slots the owner may have overwritten meanwhile. When the ring is full the oldest zones are lost.
+ * The slot fields are relaxed atomics (plain moves on x86), so a copy racing with a push is
+ * stale rather than undefined, and head works as the sequence counter of a seqlock.
+ */
+class ProfileRing {
+public:
+	static constexpr uint64_t kCapacity = uint64_t(1) << 16;
+
+	struct Slot {
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<uint64_t> begin_ns{ 0 };
+		std::atomic<uint64_t> end_ns{ 0 };
+	};
+
+	ProfileRing() : slots(new Slot[kCapacity]) {}
+
+	void push(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+		const uint64_t h = head.load(std::memory_order_relaxed);
+		// Orders the slot stores after the head store of the previous zone: a reader that copies
+		// one of them sees head >= h when it re-reads head (profiler_collect).
+		std::atomic_thread_fence(std::memory_order_release);
+		Slot& s = slots[h & (kCapacity - 1)];
+		s.name.store(name, std::memory_order_relaxed);
+		s.begin_ns.store(begin_ns, std::memory_order_relaxed);
+		s.end_ns.store(end_ns, std::memory_order_relaxed);
+		head.store(h + 1, std::memory_order_release);
+	}
+
+	/** @brief Copy of zone i; valid only if head is still below i + kCapacity after an acquire fence. */
+	ProfileEvent load(uint64_t i) const {
+		const Slot& s = slots[i & (kCapacity - 1)];
+		ProfileEvent e;
+		e.name = s.name.load(std::memory_order_relaxed);
+		e.begin_ns = s.begin_ns.load(std::memory_order_relaxed);
+		e.end_ns = s.end_ns.load(std::memory_order_relaxed);
+		return e;
+	}
+
+	std::unique_ptr<Slot[]> slots;
+	std::atomic<uint64_t> head{ 0 };   ///< Zones pushed since the thread started.
+	std::atomic<uint64_t> tail{ 0 };   ///< Zones before this index were dropped by profiler_reset().
+	int tid = 0;                       ///< Registration order, the tid of the trace.
+	std::string name;                  ///< Thread name of the trace (profiler_set_thread_name).
+	bool exited = false;               ///< The thread ended; the ring is freed by the next profiler_reset().
+};
+
+namespace profiler_detail {
+	extern std::atomic<bool> enabled;
+	uint64_t now_ns();
+
+	// Registers the ring of a thread on its first zone and retires it when the thread ends.
+	struct ThreadRing {
+		ThreadRing();
+		~ThreadRing();
+		ProfileRing* ring;
+	};
+
+	inline ProfileRing& this_thread_ring() {
+		thread_local ThreadRing owner;
+		return *owner.ring;
+	}
+}
+
+/** @brief True while zones are recorded. */
+inline bool profiler_enabled() {
+	return profiler_detail::enabled.load(std::memory_order_relaxed);
+}
+
+/** @brief Starts or stops recording; zones already open when it changes are dropped or kept as they began. */
+void profiler_enable(bool on);
+
+/** @brief Names the calling thread in the trace (e.g. "decoder"); ignored while the profiler is disabled. */
+void profiler_set_thread_name(const std::string& name);
+
+/** @brief Forgets every zone recorded so far and frees the rings of threads that ended. */
+void profiler_reset();
+
+/** @brief Current time on the clock of the recorded zones (ns). */
+inline uint64_t profiler_now_ns() {
+	return profiler_detail::now_ns();
+}
+
+/**
+ * @brief RAII zone: records the time between construction and destruction under name.
+ *
+ * While the profiler is disabled a zone costs one relaxed load and a branch. name must
+ * outlive the profile (a string literal).
+ */
+class ProfileZone {
+public:
+	explicit ProfileZone(const char* zone_name) : name(profiler_enabled() ? zone_name : nullptr) {
+		if (name)
+			begin_ns = profiler_detail::now_ns();
+	}
+	~ProfileZone() {
+		if (name)
+			profiler_detail::this_thread_ring().push(name, begin_ns, profiler_detail::now_ns());
+	}
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* name;
+	uint64_t begin_ns = 0;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#ifdef GLOW_PROFILE_OFF
+#define PROFILE_ZONE(name) ((void)0)
+#else
+/** @brief Profiles the rest of the enclosing scope as zone name. */
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#endif
+
+/**
+ * @brief Zones of one thread, oldest first.
+ */
+struct ProfileThreadEvents {
+	int tid = 0;
+	std::string name;
+	std::vector<ProfileEvent> events;
+};
+
+/**
+ * @brief Copies the recorded zones of every thread; safe while threads keep recording.
+ *
+ * A full ring gives its newest kCapacity - 1 zones: the oldest slot is the one its owner
+ * writes next, so it is never trusted.
+ */
+std::vector<ProfileThreadEvents> profiler_collect();
+
+/**
+ * @brief Writes the recorded zones as Chrome trace JSON (chrome://tracing, Perfetto).
+ *
+ * @return false if the file cannot be written.
+ */
+bool profiler_write_chrome_trace(const std::string& path);
+
+/**
+ * @brief Per-zone aggregates of the recorded zones.
+ */
+struct ProfileStageStats {
+	std::string name;
+	uint64_t count = 0;
+	double total_ms = 0.0;
+	double mean_ms = 0.0;
+	double p50_ms = 0.0;
+	double p95_ms = 0.0;
+	double max_ms = 0.0;
+};
+
+/** @brief Aggregates by zone name, largest total first; only zones that began at or after since_ns (profiler_now_ns()). */
+std::vector<ProfileStageStats> profiler_stage_stats(uint64_t since_ns = 0);
+
+/** @brief Prints profiler_stage_stats() as a table. */
+void profiler_report();
+
+/**
+ * @brief Profiles a scope: enables the profiler when path is not empty, and on destruction
+ *        stops it, prints the stage table and writes the Chrome trace to path.
+ */
+class ProfileSession {
+public:
+	explicit ProfileSession(const std::string& trace_path);
+	~ProfileSession();
+	ProfileSession(const ProfileSession&) = delete;
+	ProfileSession& operator=(const ProfileSession&) = delete;
+
+private:
+	std::string path;
+};
+
+/**
+ * @brief Headless check: nested zones on several threads, ring wrap-around, the Chrome trace
+ *        and the stage table; also prints the cost of a disabled zone.
+ *
+ * @return true if the check passed.
+ */
+bool verify_profiler();
+
+#endif // PROFILER_HPP
@@ -0,0 +1,533 @@
+/**
+ * @file RawVideoSink.cpp
+ * @brief Y4M / rawvideo output with a vectorized BGR to YUV conversion.
+ */
+
+#include "RawVideoSink.hpp"
+#include "movie_effect/include/tools_task.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RAW_VIDEO_SSE2 1
+#endif
+
+namespace {
+	// Limited-range BT.709 in 8.8 fixed point, per pixel in B, G, R order (alpha weighs 0).
+	// Each chroma row sums to 0, so gray maps to 128 exactly.
+	const int kY[3] = { 16, 157, 47 };
+	const int kU[3] = { 112, -86, -26 };
+	const int kV[3] = { -10, -102, 112 };
+
+	inline uint8_t clamp_u8(int v) {
+		return static_cast<uint8_t>(std::min(std::max(v, 0), 255));
+	}
+
+	inline int weigh(const int* k, int b, int g, int r) {
+		return k[0] * b + k[1] * g + k[2] * r;
+	}
+
+	//----------------------------------------------------------------------
+	// Scalar rows (reference, tails and builds without SSE2); BGRA input
+	//----------------------------------------------------------------------
+	void luma_row_scalar(const uint8_t* px, int x0, int width, uint8_t* y) {
+		for (int x = x0; x < width; ++x, px += 4)
+			y[x] = clamp_u8(((weigh(kY, px[0], px[1], px[2]) + 128) >> 8) + 16);
+	}
+
+	void chroma444_row_scalar(const uint8_t* px, int x0, int width, uint8_t* u, uint8_t* v) {
+		for (int x = x0; x < width; ++x, px += 4) {
+			u[x] = clamp_u8(((weigh(kU, px[0], px[1], px[2]) + 128) >> 8) + 128);
+			v[x] = clamp_u8(((weigh(kV, px[0], px[1], px[2]) + 128) >> 8) + 128);
+		}
+	}
+
+	// Rows r0 and r1 are averaged first (rounding up, like _mm_avg_epu8), then the two
+	// columns are summed; an odd last column counts its single pixel twice.
+	void chroma420_row_scalar(const uint8_t* r0, const uint8_t* r1, int c0, int width, uint8_t* u, uint8_t* v) {
+		const int chroma_width = (width + 1) / 2;
+		for (int c = c0; c < chroma_width; ++c) {
+			const int xa = 2 * c, xb = std::min(2 * c + 1, width - 1);
+			int s[3];
+			for (int k = 0; k < 3; ++k)
+				s[k] = ((r0[xa * 4 + k] + r1[xa * 4 + k] + 1) >> 1) + ((r0[xb * 4 + k] + r1[xb * 4 + k] + 1) >> 1);
+			u[c] = clamp_u8(((weigh(kU, s[0], s[1], s[2]) + 256) >> 9) + 128);
+			v[c] = clamp_u8(((weigh(kV, s[0], s[1], s[2]) + 256) >> 9) + 128);
+		}
+	}
+
+#ifdef RAW_VIDEO_SSE2
+	//----------------------------------------------------------------------
+	// SSE2 rows: 16 pixels per step
+	//----------------------------------------------------------------------
+	inline __m128i coefficients(const int* k) {
+		return _mm_setr_epi16(static_cast<short>(k[0]), static_cast<short>(k[1]), static_cast<short>(k[2]), 0,
+			static_cast<short>(k[0]), static_cast<short>(k[1]), static_cast<short>(k[2]), 0);
+	}
+
+	// Weighted sums of the two 16-bit BGRA pixels in px, in 32-bit lanes 0 and 1.
+	inline __m128i weigh2(__m128i px, __m128i coef) {
+		__m128i m = _mm_madd_epi16(px, coef);
+		m = _mm_add_epi32(m, _mm_srli_epi64(m, 32));
+		return _mm_shuffle_epi32(m, _MM_SHUFFLE(0, 0, 2, 0));
+	}
+
+	// Weighted sums of four 8-bit BGRA pixels, one per 32-bit lane.
+	inline __m128i weigh4(__m128i px, __m128i coef) {
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_unpacklo_epi64(weigh2(_mm_unpacklo_epi8(px, zero), coef), weigh2(_mm_unpackhi_epi8(px, zero), coef));
+	}
+
+	// One plane value per pixel: ((sum + 128) >> 8) + offset, for 16 pixels.
+	inline __m128i plane16(const uint8_t* px, __m128i coef, __m128i offset) {
+		const __m128i round = _mm_set1_epi32(128);
+		__m128i q[4];
+		for (int i = 0; i < 4; ++i) {
+			__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + 16 * i));
+			q[i] = _mm_srai_epi32(_mm_add_epi32(weigh4(p, coef), round), 8);
+		}
+		__m128i lo = _mm_add_epi16(_mm_packs_epi32(q[0], q[1]), offset);
+		__m128i hi = _mm_add_epi16(_mm_packs_epi32(q[2], q[3]), offset);
+		return _mm_packus_epi16(lo, hi);
+	}
+
+	int luma_row_sse2(const uint8_t* px, int width, uint8_t* y) {
+		const __m128i coef = coefficients(kY), offset = _mm_set1_epi16(16);
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(y + x), plane16(px + 4 * x, coef, offset));
+		return x;
+	}
+
+	int chroma444_row_sse2(const uint8_t* px, int width, uint8_t* u, uint8_t* v) {
+		const __m128i cu = coefficients(kU), cv = coefficients(kV), offset = _mm_set1_epi16(128);
+		int x = 0;
+		for (; x + 16 <= width; x += 16) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(u + x), plane16(px + 4 * x, cu, offset));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(v + x), plane16(px + 4 * x, cv, offset));
+		}
+		return x;
+	}
+
+	// 16 source pixels of two rows -> 8 chroma samples per plane.
+	int chroma420_row_sse2(const uint8_t* r0, const uint8_t* r1, int width, uint8_t* u, uint8_t* v) {
+		const __m128i cu = coefficients(kU), cv = coefficients(kV);
+		const __m128i zero = _mm_setzero_si128(), round = _mm_set1_epi32(256), offset = _mm_set1_epi16(128);
+		int x = 0;
+		for (; x + 16 <= width; x += 16) {
+			__m128i wu[4], wv[4];
+			for (int i = 0; i < 4; ++i) {
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 4 * x + 16 * i));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 4 * x + 16 * i));
+				const __m128i avg = _mm_avg_epu8(a, b);
+				const __m128i lo = _mm_unpacklo_epi8(avg, zero), hi = _mm_unpackhi_epi8(avg, zero);
+				// Column pairs (0,1) and (2,3) summed into the low and high 64 bits.
+				const __m128i pairs = _mm_unpacklo_epi64(_mm_add_epi16(lo, _mm_srli_si128(lo, 8)),
+					_mm_add_epi16(hi, _mm_srli_si128(hi, 8)));
+				wu[i] = weigh2(pairs, cu);
+				wv[i] = weigh2(pairs, cv);
+			}
+			auto pack8 = [&](const __m128i* w) {
+				__m128i a = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi64(w[0], w[1]), round), 9);
+				__m128i b = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi64(w[2], w[3]), round), 9);
+				__m128i s = _mm_add_epi16(_mm_packs_epi32(a, b), offset);
+				return _mm_packus_epi16(s, s);
+			};
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(u + x / 2), pack8(wu));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(v + x / 2), pack8(wv));
+		}
+		return x;
+	}
+#endif
+
+	// BGRA pointer to row y of src; BGR rows are expanded into scratch.
+	const uint8_t* bgra_row(const cv::Mat& src, int y, std::vector<uint8_t>& scratch) {
+		const uint8_t* row = src.ptr<uint8_t>(y);
+		if (src.channels() == 4)
+			return row;
+		scratch.resize(static_cast<size_t>(src.cols) * 4);
+		uint8_t* out = scratch.data();
+		for (int x = 0; x < src.cols; ++x, row += 3, out += 4) {
+			out[0] = row[0];
+			out[1] = row[1];
+			out[2] = row[2];
+			out[3] = 255;
+		}
+		return scratch.data();
+	}
+
+	void convert_planar(const cv::Mat& src, bool chroma420, std::vector<uint8_t>& dst, bool simd) {
+		const int width = src.cols, height = src.rows;
+		const int chroma_width = chroma420 ? (width + 1) / 2 : width;
+		const int chroma_height = chroma420 ? (height + 1) / 2 : height;
+		const size_t luma_size = static_cast<size_t>(width) * height;
+		const size_t chroma_size = static_cast<size_t>(chroma_width) * chroma_height;
+		dst.resize(luma_size + 2 * chroma_size);
+		uint8_t* y_plane = dst.data();
+		uint8_t* u_plane = y_plane + luma_size;
+		uint8_t* v_plane = u_plane + chroma_size;
+#ifndef RAW_VIDEO_SSE2
+		simd = false;
+#endif
+
+		auto luma = [&](const uint8_t* px, uint8_t* y) {
+			int x = 0;
+#ifdef RAW_VIDEO_SSE2
+			if (simd)
+				x = luma_row_sse2(px, width, y);
+#endif
+			luma_row_scalar(px + 4 * x, x, width, y);
+		};
+
+		// One band per chroma row: rows 2c and 2c + 1 for 4:2:0, row c for 4:4:4.
+		task::parallel_rows(chroma_height, [&](int c0, int c1) {
+			std::vector<uint8_t> scratch0, scratch1;
+			for (int c = c0; c < c1; ++c) {
+				uint8_t* u = u_plane + static_cast<size_t>(c) * chroma_width;
+				uint8_t* v = v_plane + static_cast<size_t>(c) * chroma_width;
+				if (!chroma420) {
+					const uint8_t* px = bgra_row(src, c, scratch0);
+					luma(px, y_plane + static_cast<size_t>(c) * width);
+					int x = 0;
+#ifdef RAW_VIDEO_SSE2
+					if (simd)
+						x = chroma444_row_sse2(px, width, u, v);
+#endif
+					chroma444_row_scalar(px + 4 * x, x, width, u, v);
+					continue;
+				}
+				const int y0 = 2 * c, y1 = std::min(2 * c + 1, height - 1);
+				const uint8_t* r0 = bgra_row(src, y0, scratch0);
+				const uint8_t* r1 = bgra_row(src, y1, scratch1);
+				luma(r0, y_plane + static_cast<size_t>(y0) * width);
+				if (y1 != y0)
+					luma(r1, y_plane + static_cast<size_t>(y1) * width);
+				int x = 0;
+#ifdef RAW_VIDEO_SSE2
+				if (simd)
+					x = chroma420_row_sse2(r0, r1, width, u, v);
+#endif
+				chroma420_row_scalar(r0, r1, x / 2, width, u, v);
+			}
+		}, 8);
+	}
+
+	bool is_420(RawVideoFormat format) {
+		return format == RawVideoFormat::Y4m420 || format == RawVideoFormat::Raw420;
+	}
+
+	bool is_y4m(RawVideoFormat format) {
+		return format == RawVideoFormat::Y4m420 || format == RawVideoFormat::Y4m444;
+	}
+
+	// Y4M frame rate as a ratio; 23.976, 29.97 and 59.94 become n*1000/1001.
+	std::string y4m_rate(double fps) {
+		if (fps <= 0.0)
+			fps = 30.0;
+		const double ntsc = fps * 1.001;
+		if (std::abs(fps - std::round(fps)) > 0.005 && std::abs(ntsc - std::round(ntsc)) < 0.005)
+			return std::to_string(static_cast<long long>(std::round(ntsc)) * 1000) + ":1001";
+		if (std::abs(fps - std::round(fps)) < 0.0005)
+			return std::to_string(static_cast<long long>(std::round(fps))) + ":1";
+		return std::to_string(static_cast<long long>(std::round(fps * 1000.0))) + ":1000";
+	}
+}
+
+//--------------------------------------------------------------------------
+// parse_raw_video_format / bgr_to_yuv_planar
+//--------------------------------------------------------------------------
+bool parse_raw_video_format(const std::string& name, RawVideoFormat& format) {
+	if (name == "y4m" || name == "y4m420")
+		format = RawVideoFormat::Y4m420;
+	else if (name == "y4m444")
+		format = RawVideoFormat::Y4m444;
+	else if (name == "raw" || name == "raw420")
+		format = RawVideoFormat::Raw420;
+	else if (name == "raw444")
+		format = RawVideoFormat::Raw444;
+	else
+		return false;
+	return true;
+}
+
+void bgr_to_yuv_planar(const cv::Mat& src, bool chroma420, std::vector<uint8_t>& dst) {
+	convert_planar(src, chroma420, dst, true);
+}
+
+namespace {
+	// The process's stdout as a stream of its own. On first use fd 1 is pointed at stderr for the
+	// rest of the process, so nothing printed with printf or std::cout, the reports after the
+	// sink is closed included, can end up in the video stream.
+	FILE* reserve_stdout() {
+		static FILE* video = [] {
+			std::fflush(stdout);
+#ifdef _WIN32
+			const int fd = _dup(_fileno(stdout));
+			FILE* stream = fd >= 0 ? _fdopen(fd, "wb") : nullptr;
+			if (stream) {
+				_setmode(fd, _O_BINARY);
+				_dup2(_fileno(stderr), _fileno(stdout));
+			}
+#else
+			const int fd = dup(fileno(stdout));
+			FILE* stream = fd >= 0 ? fdopen(fd, "wb") : nullptr;
+			if (stream)
+				dup2(fileno(stderr), fileno(stdout));
+#endif
+			return stream;
+		}();
+		return video;
+	}
+
+	const cv::Size kStdoutCheckSize(34, 20);
+	const char kStdoutCheckHeader[] = "YUV4MPEG2 W34 H20 F30000:1001 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+	const char kStdoutCheckPrompt[] = "Raw output path (file, named pipe or - for stdout): ";
+}
+
+bool reserve_stdout_for_raw_video() {
+	return reserve_stdout() != nullptr;
+}
+
+bool reserve_redirected_stdout() {
+#ifdef _WIN32
+	const bool terminal = _isatty(_fileno(stdout)) != 0;
+#else
+	const bool terminal = isatty(fileno(stdout)) != 0;
+#endif
+	return !terminal && reserve_stdout_for_raw_video();
+}
+
+//--------------------------------------------------------------------------
+// RawVideoSink
+//--------------------------------------------------------------------------
+RawVideoSink::~RawVideoSink() {
+	close();
+}
+
+bool RawVideoSink::open(const std::string& path, RawVideoFormat fmt, const cv::Size& frame_size, double fps) {
+	close();
+	if (frame_size.width <= 0 || frame_size.height <= 0)
+		return false;
+	to_stdout = path == "-";
+	file = to_stdout ? reserve_stdout() : std::fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+	format = fmt;
+	size = frame_size;
+	frames = 0;
+	bytes = 0;
+
+	if (is_y4m(format)) {
+		const std::string header = "YUV4MPEG2 W" + std::to_string(size.width) + " H" + std::to_string(size.height) +
+			" F" + y4m_rate(fps) + " Ip A1:1 " + (is_420(format) ? "C420jpeg" : "C444") + " XCOLORRANGE=LIMITED\n";
+		bytes += std::fwrite(header.data(), 1, header.size(), file);
+	}
+	return true;
+}
+
+bool RawVideoSink::write(const cv::Mat& frame) {
+	if (!file || frame.size() != size || (frame.channels() != 3 && frame.channels() != 4))
+		return false;
+	convert_planar(frame, is_420(format), planes, true);
+	if (is_y4m(format)) {
+		static const char kFrameTag[] = "FRAME\n";
+		bytes += std::fwrite(kFrameTag, 1, sizeof(kFrameTag) - 1, file);
+	}
+	const size_t written = std::fwrite(planes.data(), 1, planes.size(), file);
+	bytes += written;
+	if (written != planes.size())
+		return false;
+	frames++;
+	return true;
+}
+
+void RawVideoSink::close() {
+	if (!file)
+		return;
+	std::fflush(file);
+	if (!to_stdout)
+		std::fclose(file);
+	file = nullptr;
+}
+
+//--------------------------------------------------------------------------
+// verify_raw_video_sink
+//--------------------------------------------------------------------------
+bool verify_raw_video_sink() {
+	// SSE2 and scalar agree on odd sizes (vector body plus scalar tail, odd last row/column).
+	std::mt19937 rng(7);
+	bool simd_ok = true;
+	for (int channels : { 3, 4 }) {
+		cv::Mat frame(35, 67, channels == 3 ? CV_8UC3 : CV_8UC4);
+		for (int y = 0; y < frame.rows; ++y) {
+			uint8_t* row = frame.ptr<uint8_t>(y);
+			for (int x = 0; x < frame.cols * channels; ++x)
+				row[x] = static_cast<uint8_t>(rng());
+		}
+		for (bool chroma420 : { true, false }) {
+			std::vector<uint8_t> fast, reference;
+			convert_planar(frame, chroma420, fast, true);
+			convert_planar(frame, chroma420, reference, false);
+			simd_ok = simd_ok && fast == reference;
+		}
+	}
+
+	// Reference colors: white, black, gray and red in limited-range BT.709.
+	struct ColorCase { cv::Scalar bgr; int y, u, v; };
+	const ColorCase cases[] = { { cv::Scalar(255, 255, 255), 235, 128, 128 }, { cv::Scalar(0, 0, 0), 16, 128, 128 },
+		{ cv::Scalar(128, 128, 128), 126, 128, 128 }, { cv::Scalar(0, 0, 255), 63, 102, 240 } };
+	bool color_ok = true;
+	for (const ColorCase& c : cases) {
+		cv::Mat frame(4, 32, CV_8UC3, c.bgr);
+		std::vector<uint8_t> planes;
+		bgr_to_yuv_planar(frame, true, planes);
+		const size_t luma = 4 * 32, chroma = 2 * 16;
+		color_ok = color_ok && planes.size() == luma + 2 * chroma && planes[0] == c.y && planes[luma - 1] == c.y &&
+			planes[luma] == c.u && planes[luma + chroma] == c.v && planes.back() == c.v;
+	}
+
+	// Y4M layout: header line, then "FRAME\n" and three planes per frame.
+	const std::string path = (std::filesystem::temp_directory_path() / "glow_raw_sink_check.y4m").string();
+	const cv::Size size(34, 20);
+	bool file_ok = false;
+	{
+		RawVideoSink sink;
+		if (sink.open(path, RawVideoFormat::Y4m420, size, 29.97)) {
+			cv::Mat frame(size, CV_8UC4, cv::Scalar(10, 200, 30, 255));
+			file_ok = sink.write(frame) && sink.write(frame) && sink.write(frame) &&
+				!sink.write(cv::Mat(cv::Size(8, 8), CV_8UC3, cv::Scalar()));
+			sink.close();
+		}
+	}
+	const std::string expected_header = "YUV4MPEG2 W34 H20 F30000:1001 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+	const uintmax_t frame_bytes = 6 + 34 * 20 + 2 * 17 * 10;
+	if (file_ok) {
+		std::string header(expected_header.size(), '\0');
+		FILE* f = std::fopen(path.c_str(), "rb");
+		file_ok = f && std::fread(&header[0], 1, header.size(), f) == header.size() && header == expected_header;
+		if (f)
+			std::fclose(f);
+		file_ok = file_ok && std::filesystem::file_size(path) == expected_header.size() + 3 * frame_bytes;
+	}
+	std::filesystem::remove(path);
+
+	const bool passed = simd_ok && color_ok && file_ok;
+	std::cout << "Raw video sink check: SSE2/scalar conversion "
+#ifdef RAW_VIDEO_SSE2
+		<< (simd_ok ? "identical" : "DIFFERENT")
+#else
+		<< "(scalar build)"
+#endif
+		<< ", BT.709 reference colors " << (color_ok ? "match" : "DIFFER") << ", Y4M layout "
+		<< (file_ok ? "ok" : "WRONG") << ": " << (passed ? "PASSED" : "FAILED") << std::endl;
+	return passed;
+}
+
+//--------------------------------------------------------------------------
+// verify_raw_stdout
+//--------------------------------------------------------------------------
+bool write_raw_stdout_check() {
+	// The same order as the video mode: prompts and logs first, the stream only after them.
+	reserve_redirected_stdout();
+	printf("%s", kStdoutCheckPrompt);
+	std::cout << "Video Output Directory already exists." << std::endl;
+	RawVideoSink sink;
+	const cv::Mat frame(kStdoutCheckSize, CV_8UC3, cv::Scalar(10, 200, 30));
+	const bool ok = sink.open("-", RawVideoFormat::Y4m420, kStdoutCheckSize, 29.97) && sink.write(frame) && sink.write(frame);
+	sink.close();
+	std::cout << "Raw stdout check: " << sink.frames_written() << " frames written" << std::endl;
+	return ok;
+}
+
+bool verify_raw_stdout(const std::string& executable) {
+	const std::filesystem::path dir = std::filesystem::temp_directory_path();
+	const std::string video = (dir / "glow_raw_stdout_check.y4m").string();
+	const std::string log = (dir / "glow_raw_stdout_check.log").string();
+	std::string cmd = "\"" + executable + "\" --raw-stdout-check > \"" + video + "\" 2> \"" + log + "\"";
+#ifdef _WIN32
+	// cmd.exe strips the outer quotes of a command line that starts with a quote.
+	cmd = "\"" + cmd + "\"";
+#endif
+	const int exit_code = std::system(cmd.c_str());
+
+	auto read_file = [](const std::string& path) {
+		std::ifstream in(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	};
+	const std::string stream = read_file(video);
+	const std::string text = read_file(log);
+	std::error_code ec;
+	std::filesystem::remove(video, ec);
+	std::filesystem::remove(log, ec);
+
+	const std::string header = kStdoutCheckHeader;
+	const size_t frame_bytes = 6 + kStdoutCheckSize.area() + 2 * ((kStdoutCheckSize.width + 1) / 2) * ((kStdoutCheckSize.height + 1) / 2);
+	const bool stream_ok = stream.compare(0, header.size(), header) == 0 && stream.size() == header.size() + 2 * frame_bytes;
+	const bool text_ok = text.find(kStdoutCheckPrompt) != std::string::npos && text.find("2 frames written") != std::string::npos;
+	const bool passed = exit_code == 0 && stream_ok && text_ok;
+	std::cout << "Raw stdout check: stream " << (stream_ok ? "starts with the Y4M header, nothing else" : "CORRUPT")
+		<< ", prompts and logs " << (text_ok ? "on stderr" : "MISSING") << ": " << (passed ? "PASSED" : "FAILED") << std::endl;
+	return passed;
+}
+
+//--------------------------------------------------------------------------
+// benchmark_raw_video_sink
+//--------------------------------------------------------------------------
+void benchmark_raw_video_sink(int width, int height) {
+	cv::Mat frame(height, width, CV_8UC3);
+	std::mt19937 rng(3);
+	for (int y = 0; y < height; ++y) {
+		uint8_t* row = frame.ptr<uint8_t>(y);
+		for (int x = 0; x < width * 3; ++x)
+			row[x] = static_cast<uint8_t>(rng());
+	}
+	const int iterations = 20;
+	std::vector<uint8_t> planes;
+	auto time_ms = [&](auto&& body) {
+		body();   // warm-up
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iterations; ++i)
+			body();
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+	};
+
+	const double scalar_ms = time_ms([&] { convert_planar(frame, true, planes, false); });
+	const double simd_ms = time_ms([&] { convert_planar(frame, true, planes, true); });
+
+	const std::string path = (std::filesystem::temp_directory_path() / "glow_raw_sink_bench.y4m").string();
+	double sink_ms = 0.0;
+	{
+		RawVideoSink sink;
+		if (sink.open(path, RawVideoFormat::Y4m420, frame.size(), 30.0))
+			sink_ms = time_ms([&] { sink.write(frame); });
+	}
+	std::filesystem::remove(path);
+
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Raw video sink benchmark (" << width << "x" << height << ", BGR to Y4M 4:2:0)" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Scalar conversion: " << scalar_ms << " ms/frame" << std::endl;
+#ifdef RAW_VIDEO_SSE2
+	std::cout << "SSE2 conversion:   " << simd_ms << " ms/frame" << std::endl;
+#else
+	std::cout << "SSE2 conversion:   n/a (scalar build, " << simd_ms << " ms/frame)" << std::endl;
+#endif
+	std::cout << "Y4M sink to file:  " << sink_ms << " ms/frame (conversion + write)" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+}
@@ -0,0 +1,139 @@
+#ifndef RAW_VIDEO_SINK_HPP
+#define RAW_VIDEO_SINK_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Layout of a raw video stream.
+ */
+enum class RawVideoFormat {
+	Y4m420,   ///< YUV4MPEG2, 4:2:0 (C420jpeg: chroma centered between the 2x2 luma samples).
+	Y4m444,   ///< YUV4MPEG2, 4:4:4.
+	Raw420,   ///< Headerless planar yuv420p (ffmpeg -f rawvideo -pix_fmt yuv420p).
+	Raw444,   ///< Headerless planar yuv444p.
+};
+
+/**
+ * @brief Parses "y4m" / "y4m420", "y4m444", "raw" / "raw420" or "raw444".
+ *
+ * @return false (format unchanged) for any other name.
+ */
+bool parse_raw_video_format(const std::string& name, RawVideoFormat& format);
+
+/**
+ * @brief Converts a BGR or BGRA frame to planar limited-range BT.709 YUV (Y, then U, then V).
+ *
+ * With chroma420 the chroma planes are ((width + 1) / 2) x ((height + 1) / 2), each sample
+ * the average of its 2x2 block. Rows are split across the shared scheduler and converted
+ * with SSE2 where available, 16 pixels at a time; the result does not depend on either.
+ *
+ * @param src       CV_8UC3 (BGR) or CV_8UC4 (BGRA) frame.
+ * @param chroma420 Subsample chroma 2x2 (4:2:0) instead of keeping it per pixel (4:4:4).
+ * @param dst       Resized to the frame's planar size; reused across calls.
+ */
+void bgr_to_yuv_planar(const cv::Mat& src, bool chroma420, std::vector<uint8_t>& dst);
+
+/**
+ * @brief Streams frames as Y4M or rawvideo to a file or to stdout, for piping into an
+ *        external encoder instead of re-encoding the MJPG output.
+ *
+ * Frames of a size other than the one the sink was opened with are rejected. The first sink
+ * opened on stdout reserves it for the rest of the process: the sink writes to a duplicate of
+ * the original descriptor and stdout itself is pointed at stderr, so log lines and reports,
+ * also those printed after close(), cannot end up in the video stream.
+ */
+class RawVideoSink {
+public:
+	RawVideoSink() = default;
+	~RawVideoSink();
+	RawVideoSink(const RawVideoSink&) = delete;
+	RawVideoSink& operator=(const RawVideoSink&) = delete;
+
+	/**
+	 * @param path   Output file, or "-" for stdout.
+	 * @param format Stream layout.
+	 * @param size   Frame size of every frame written.
+	 * @param fps    Frame rate written to the Y4M header (NTSC rates become n*1000/1001).
+	 * @return false if the output could not be opened or the size is empty.
+	 */
+	bool open(const std::string& path, RawVideoFormat format, const cv::Size& size, double fps);
+
+	bool is_open() const { return file != nullptr; }
+
+	/** @brief Converts and writes one BGR or BGRA frame. @return false on a size mismatch or write error. */
+	bool write(const cv::Mat& frame);
+
+	/** @brief Flushes and closes the output (stdout is flushed, not closed). Idempotent. */
+	void close();
+
+	uint64_t frames_written() const { return frames; }
+	uint64_t bytes_written() const { return bytes; }
+
+private:
+	FILE* file = nullptr;
+	bool to_stdout = false;
+	RawVideoFormat format = RawVideoFormat::Y4m420;
+	cv::Size size;
+	std::vector<uint8_t> planes;
+	uint64_t frames = 0;
+	uint64_t bytes = 0;
+};
+
+/**
+ * @brief Reserves stdout for a raw stream now instead of when the first sink opens on it (see
+ *        RawVideoSink). Idempotent.
+ *
+ * @return false if stdout could not be duplicated.
+ */
+bool reserve_stdout_for_raw_video();
+
+/**
+ * @brief Reserves stdout when it is redirected (a pipe or a file, not a terminal).
+ *
+ * The interactive modes call it before their first prompt: a raw output path of "-" is only
+ * known after several prompts, and those must reach the user on stderr instead of preceding
+ * the stream's header in the pipe.
+ *
+ * @return true if stdout is reserved.
+ */
+bool reserve_redirected_stdout();
+
+/**
+ * @brief Child side of verify_raw_stdout (glow_effect --raw-stdout-check): reserves a
+ *        redirected stdout, prints a prompt and a log line, then streams two Y4M frames to "-".
+ *
+ * @return false if the frames could not be written.
+ */
+bool write_raw_stdout_check();
+
+/**
+ * @brief Runs executable --raw-stdout-check with stdout and stderr redirected to files and
+ *        checks that stdout holds exactly the Y4M stream, header first, and stderr the text.
+ *
+ * @return true if the check passed.
+ */
+bool verify_raw_stdout(const std::string& executable);
+
+/**
+ * @brief Headless check of the raw sink: SSE2 and scalar conversion agree on odd frame
+ *        sizes, reference colors map to their BT.709 codes and a Y4M file has the expected
+ *        header and frame layout.
+ *
+ * @return true if the check passed.
+ */
+bool verify_raw_video_sink();
+
+/**
+ * @brief Times the scalar and SSE2 BGR to YUV 4:2:0 conversion and the whole Y4M sink
+ *        (conversion + write to a temporary file).
+ *
+ * @param width  Frame width (e.g. 1920).
+ * @param height Frame height (e.g. 1080).
+ */
+void benchmark_raw_video_sink(int width, int height);
+
+#endif // RAW_VIDEO_SINK_HPP
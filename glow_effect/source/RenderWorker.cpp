@@ -0,0 +1,134 @@
+/**
+ * @file RenderWorker.cpp
+ * @brief Coalescing render thread for slider updates.
+ */
+
+#include "RenderWorker.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+//--------------------------------------------------------------------------
+// RenderWorker
+//--------------------------------------------------------------------------
+RenderWorker::RenderWorker(RenderFn render) : render(std::move(render)) {
+	thread = std::thread(&RenderWorker::run, this);
+}
+
+RenderWorker::~RenderWorker() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	thread.join();
+}
+
+uint64_t RenderWorker::submit(const GlowParams& params) {
+	uint64_t version;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending = params;
+		version = ++pending_version;
+		counters.submitted++;
+		latest.store(version);
+	}
+	wake.notify_one();
+	return version;
+}
+
+void RenderWorker::wait_idle() {
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [&] { return handled_version == pending_version || stopping; });
+}
+
+uint64_t RenderWorker::rendered_version() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return completed_version;
+}
+
+RenderWorkerStats RenderWorker::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void RenderWorker::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		wake.wait(lock, [&] { return pending_version != handled_version || stopping; });
+		if (stopping)
+			break;
+		const uint64_t version = pending_version;
+		const GlowParams params = pending;
+		counters.superseded += version - handled_version - 1;
+		lock.unlock();
+
+		bool completed = false;
+		try {
+			completed = render(params, [this, version] { return stopping || latest.load() != version; });
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Error rendering image: " << e.what() << std::endl;
+		}
+
+		lock.lock();
+		handled_version = version;
+		if (completed) {
+			completed_version = version;
+			counters.rendered++;
+		}
+		else {
+			counters.cancelled++;
+		}
+		idle.notify_all();
+	}
+	idle.notify_all();
+}
+
+//--------------------------------------------------------------------------
+// verify_render_worker
+//--------------------------------------------------------------------------
+bool verify_render_worker() {
+	std::mutex seen_mutex;
+	std::vector<int> seen;   // key scale of every completed render, in order
+	RenderWorker worker([&](const GlowParams& params, const GlowCancelFn& cancelled) {
+		// Three 5 ms stages with a cancellation point after each, like key / mipmap / blend.
+		for (int stage = 0; stage < 3; ++stage) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			if (cancelled())
+				return false;
+		}
+		std::lock_guard<std::mutex> lock(seen_mutex);
+		seen.push_back(params.key_scale);
+		return true;
+	});
+
+	// A slider drag: 200 updates, one every 0.25 ms, against a 15 ms render.
+	const int updates = 200;
+	auto start = std::chrono::high_resolution_clock::now();
+	uint64_t last = 0;
+	for (int i = 1; i <= updates; ++i) {
+		last = worker.submit(GlowParams{ 96, i, 10 });
+		std::this_thread::sleep_for(std::chrono::microseconds(250));
+	}
+	const double submit_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	worker.wait_idle();
+	const RenderWorkerStats stats = worker.stats();
+
+	bool ok = worker.rendered_version() == last && !seen.empty() && seen.back() == updates &&
+		stats.submitted == static_cast<uint64_t>(updates) &&
+		stats.rendered + stats.superseded + stats.cancelled == stats.submitted && stats.rendered < stats.submitted / 4;
+	for (size_t i = 1; i < seen.size(); ++i)
+		ok = ok && seen[i] > seen[i - 1];
+
+	// An idle worker renders a single update right away.
+	last = worker.submit(GlowParams{ 96, updates + 1, 10 });
+	worker.wait_idle();
+	ok = ok && worker.rendered_version() == last && seen.back() == updates + 1;
+
+	std::cout << "Render worker check: " << updates << " updates submitted in " << submit_ms << " ms, "
+		<< stats.rendered << " rendered, " << stats.superseded << " superseded, " << stats.cancelled << " cancelled: "
+		<< (ok ? "PASSED" : "FAILED") << std::endl;
+	return ok;
+}
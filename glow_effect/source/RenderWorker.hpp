@@ -0,0 +1,81 @@
+#ifndef RENDER_WORKER_HPP
+#define RENDER_WORKER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "GlowCache.hpp"
+
+/**
+ * @brief A render of one parameter snapshot; polls cancelled between stages and returns
+ *        false if it gave up, true once the result is handed to the thread that shows it.
+ */
+using RenderFn = std::function<bool(const GlowParams& params, const GlowCancelFn& cancelled)>;
+
+/**
+ * @brief Counters of a RenderWorker.
+ */
+struct RenderWorkerStats {
+	uint64_t submitted = 0;    ///< Parameter snapshots submitted.
+	uint64_t rendered = 0;     ///< Renders that completed.
+	uint64_t superseded = 0;   ///< Snapshots replaced by a newer one before their render started.
+	uint64_t cancelled = 0;    ///< Renders abandoned because a newer snapshot arrived.
+};
+
+/**
+ * @brief Latest-wins render thread for GUI parameter changes.
+ *
+ * submit() publishes a versioned parameter snapshot and returns at once, so slider handlers
+ * never wait for a render. The worker renders only the newest snapshot: versions submitted
+ * while it is busy replace each other, and the render in flight sees cancelled() turn true
+ * as soon as a newer version exists, so a slider drag costs at most one stale render stage.
+ */
+class RenderWorker {
+public:
+	explicit RenderWorker(RenderFn render);
+	~RenderWorker();
+	RenderWorker(const RenderWorker&) = delete;
+	RenderWorker& operator=(const RenderWorker&) = delete;
+
+	/** @brief Publishes a snapshot; thread-safe. @return Its version (1, 2, ...). */
+	uint64_t submit(const GlowParams& params);
+
+	/** @brief Blocks until the newest submitted version has been rendered or cancelled. */
+	void wait_idle();
+
+	/** @brief Version of the last completed render (0 if none). */
+	uint64_t rendered_version() const;
+
+	RenderWorkerStats stats() const;
+
+private:
+	void run();
+
+	RenderFn render;
+	mutable std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable idle;
+	GlowParams pending;
+	uint64_t pending_version = 0;    // newest submitted version
+	uint64_t handled_version = 0;    // newest version taken by the worker and finished
+	uint64_t completed_version = 0;  // newest version whose render completed
+	std::atomic<uint64_t> latest{ 0 };
+	std::atomic<bool> stopping{ false };
+	RenderWorkerStats counters;
+	std::thread thread;
+};
+
+/**
+ * @brief Headless check of RenderWorker coalescing: a burst of submissions against a slow
+ *        render ends with the newest snapshot rendered, versions in increasing order, stale
+ *        ones dropped or cancelled.
+ *
+ * @return true if the check passed.
+ */
+bool verify_render_worker();
+
+#endif // RENDER_WORKER_HPP
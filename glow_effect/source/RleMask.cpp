@@ -0,0 +1,432 @@
+/**
+ * @file RleMask.cpp
+ * @brief Run-length encoded class maps for key matching and glow_blow.
+ */
+
+#include "RleMask.hpp"
+#include "ImageCompare.hpp"
+#include "movie_effect/include/tools_task.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+namespace {
+	const uint32_t kRleMagic = 0x4d454c52;   // "RLEM"
+
+	void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+		for (int i = 0; i < 4; ++i)
+			out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+	}
+
+	void put_u16(std::vector<uint8_t>& out, uint16_t v) {
+		out.push_back(static_cast<uint8_t>(v));
+		out.push_back(static_cast<uint8_t>(v >> 8));
+	}
+
+	uint32_t get_u32(const uint8_t* p) {
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	uint16_t get_u16(const uint8_t* p) {
+		return static_cast<uint16_t>(p[0] | (p[1] << 8));
+	}
+
+	bool within(int value, int key, int delta) {
+		return std::abs(value - key) < delta;
+	}
+
+	// Segmentation-like class map: blobs of a few classes (multiples of 12, as the argmax emits) with ragged edges.
+	cv::Mat make_class_map(int width, int height) {
+		cv::Mat map(height, width, CV_8UC1, cv::Scalar(0));
+		for (int y = 0; y < height; ++y) {
+			uchar* row = map.ptr<uchar>(y);
+			for (int x = 0; x < width; ++x) {
+				int dx = x - width / 3, dy = y - height / 2;
+				if (dx * dx + dy * dy < (width / 5) * (width / 5) + ((x * 7 + y * 3) % 11) * 40)
+					row[x] = 48;
+				else if (x > width * 2 / 3 && y > height / 4 && y < height * 3 / 4)
+					row[x] = 60;
+				else if (y > height * 7 / 8)
+					row[x] = static_cast<uchar>(x % 37 < 5 ? 48 : 12);
+			}
+		}
+		return map;
+	}
+
+	cv::Mat resize_nearest_reference(const cv::Mat& src, const cv::Size& size) {
+		cv::Mat dst(size, CV_8UC1);
+		for (int y = 0; y < size.height; ++y) {
+			const uchar* in = src.ptr<uchar>(static_cast<int>(static_cast<int64_t>(y) * src.rows / size.height));
+			uchar* out = dst.ptr<uchar>(y);
+			for (int x = 0; x < size.width; ++x)
+				out[x] = in[static_cast<int64_t>(x) * src.cols / size.width];
+		}
+		return dst;
+	}
+}
+
+//--------------------------------------------------------------------------
+// Encoding
+//--------------------------------------------------------------------------
+RleMask RleMask::encode(const cv::Mat& mask) {
+	RleMask rle;
+	if (mask.empty() || mask.type() != CV_8UC1 || mask.cols > 0xffff)
+		return rle;
+
+	rle.width = mask.cols;
+	rle.height = mask.rows;
+	rle.row_spans.resize(mask.rows);
+	rle.runs.reserve(static_cast<size_t>(mask.rows) * 4);
+	for (int y = 0; y < mask.rows; ++y) {
+		const uchar* row = mask.ptr<uchar>(y);
+		const uint32_t begin = static_cast<uint32_t>(rle.runs.size());
+		int x = 0;
+		while (x < mask.cols) {
+			const uchar v = row[x];
+			int end = x + 1;
+			while (end < mask.cols && row[end] == v)
+				++end;
+			rle.runs.push_back({ static_cast<uint16_t>(x), static_cast<uint16_t>(end - x), v });
+			x = end;
+		}
+		rle.row_spans[y] = { begin, static_cast<uint32_t>(rle.runs.size()) - begin };
+	}
+	return rle;
+}
+
+RleMask RleMask::filled(const cv::Size& size, uint8_t value) {
+	RleMask rle;
+	if (size.width <= 0 || size.height <= 0 || size.width > 0xffff)
+		return rle;
+	rle.width = size.width;
+	rle.height = size.height;
+	rle.runs.push_back({ 0, static_cast<uint16_t>(size.width), value });
+	rle.row_spans.assign(size.height, { 0, 1 });
+	return rle;
+}
+
+cv::Mat RleMask::decode() const {
+	if (empty())
+		return cv::Mat();
+	cv::Mat mask(height, width, CV_8UC1);
+	task::parallel_rows(height, [&](int row_begin, int row_end) {
+		for (int y = row_begin; y < row_end; ++y) {
+			uchar* row = mask.ptr<uchar>(y);
+			const RowSpan& span = row_spans[y];
+			for (uint32_t r = span.begin; r < span.begin + span.count; ++r)
+				std::memset(row + runs[r].start, runs[r].value, runs[r].length);
+		}
+	});
+	return mask;
+}
+
+RleMask RleMask::resized(const cv::Size& size) const {
+	if (empty() || size.width <= 0 || size.height <= 0 || size.width > 0xffff)
+		return RleMask();
+	if (size == this->size())
+		return *this;
+
+	RleMask out;
+	out.width = size.width;
+	out.height = size.height;
+	out.row_spans.resize(size.height);
+
+	// Destination column x samples source column floor(x * width / size.width), so the source
+	// run [s, e) covers destination columns [ceil(s * W / width), ceil(e * W / width)).
+	auto scaled = [&](int x) {
+		return static_cast<int>((static_cast<int64_t>(x) * size.width + width - 1) / width);
+	};
+
+	std::vector<int> scaled_row(height, -1);   // source row -> its row in out, once scaled
+	for (int y = 0; y < size.height; ++y) {
+		const int sy = static_cast<int>(static_cast<int64_t>(y) * height / size.height);
+		if (scaled_row[sy] >= 0) {
+			out.row_spans[y] = out.row_spans[scaled_row[sy]];
+			continue;
+		}
+		const RowSpan& span = row_spans[sy];
+		const uint32_t begin = static_cast<uint32_t>(out.runs.size());
+		for (uint32_t r = span.begin; r < span.begin + span.count; ++r) {
+			const int x0 = scaled(runs[r].start), x1 = scaled(runs[r].start + runs[r].length);
+			if (x1 <= x0)
+				continue;   // run dropped by downscaling
+			if (out.runs.size() > begin && out.runs.back().value == runs[r].value)
+				out.runs.back().length = static_cast<uint16_t>(out.runs.back().length + (x1 - x0));
+			else
+				out.runs.push_back({ static_cast<uint16_t>(x0), static_cast<uint16_t>(x1 - x0), runs[r].value });
+		}
+		out.row_spans[y] = { begin, static_cast<uint32_t>(out.runs.size()) - begin };
+		scaled_row[sy] = y;
+	}
+	return out;
+}
+
+//--------------------------------------------------------------------------
+// Key operations
+//--------------------------------------------------------------------------
+KeyMatch RleMask::match_key(int key, int delta) const {
+	KeyMatch match;
+	int min_x = width, max_x = -1, min_y = height, max_y = -1;
+	for (int y = 0; y < height; ++y) {
+		const RowSpan& span = row_spans[y];
+		for (uint32_t r = span.begin; r < span.begin + span.count; ++r) {
+			const MaskRun& run = runs[r];
+			if (!within(run.value, key, delta))
+				continue;
+			match.pixels += run.length;
+			min_x = std::min(min_x, static_cast<int>(run.start));
+			max_x = std::max(max_x, run.start + run.length - 1);
+			min_y = std::min(min_y, y);
+			max_y = y;
+		}
+	}
+	if (match.pixels > 0)
+		match.box = cv::Rect(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1);
+	return match;
+}
+
+void RleMask::paint_key(cv::Mat& dst, int key, int delta, const cv::Vec4b& color) const {
+	if (dst.type() != CV_8UC4 || dst.size() != size())
+		return;
+	task::parallel_rows(height, [&](int row_begin, int row_end) {
+		for (int y = row_begin; y < row_end; ++y) {
+			cv::Vec4b* row = dst.ptr<cv::Vec4b>(y);
+			const RowSpan& span = row_spans[y];
+			for (uint32_t r = span.begin; r < span.begin + span.count; ++r) {
+				const MaskRun& run = runs[r];
+				if (within(run.value, key, delta))
+					std::fill(row + run.start, row + run.start + run.length, color);
+			}
+		}
+	});
+}
+
+std::vector<KeyMatch> RleMask::paint_classes(cv::Mat& dst, const int class_of[256], const std::vector<cv::Vec4b>& colors) const {
+	const int classes = static_cast<int>(colors.size());
+	std::vector<KeyMatch> matches(classes);
+	if (dst.type() != CV_8UC4 || dst.size() != size() || classes == 0)
+		return matches;
+
+	struct Extent {
+		int pixels = 0;
+		int min_x = INT_MAX, max_x = -1, min_y = INT_MAX, max_y = -1;
+	};
+	std::vector<Extent> extents(classes);
+	std::mutex extents_mutex;
+
+	// Each band keeps its own extents and merges them at the end.
+	task::parallel_rows(height, [&](int row_begin, int row_end) {
+		std::vector<Extent> band(classes);
+		for (int y = row_begin; y < row_end; ++y) {
+			cv::Vec4b* row = dst.ptr<cv::Vec4b>(y);
+			const RowSpan& span = row_spans[y];
+			for (uint32_t r = span.begin; r < span.begin + span.count; ++r) {
+				const MaskRun& run = runs[r];
+				const int k = class_of[run.value];
+				if (k < 0 || k >= classes)
+					continue;
+				std::fill(row + run.start, row + run.start + run.length, colors[k]);
+				Extent& e = band[k];
+				e.pixels += run.length;
+				e.min_x = std::min(e.min_x, static_cast<int>(run.start));
+				e.max_x = std::max(e.max_x, run.start + run.length - 1);
+				e.min_y = std::min(e.min_y, y);
+				e.max_y = y;
+			}
+		}
+		std::lock_guard<std::mutex> lock(extents_mutex);
+		for (int k = 0; k < classes; ++k) {
+			if (band[k].pixels == 0)
+				continue;
+			Extent& e = extents[k];
+			e.pixels += band[k].pixels;
+			e.min_x = std::min(e.min_x, band[k].min_x);
+			e.max_x = std::max(e.max_x, band[k].max_x);
+			e.min_y = std::min(e.min_y, band[k].min_y);
+			e.max_y = std::max(e.max_y, band[k].max_y);
+		}
+	});
+
+	for (int k = 0; k < classes; ++k) {
+		const Extent& e = extents[k];
+		matches[k].pixels = e.pixels;
+		if (e.pixels > 0)
+			matches[k].box = cv::Rect(e.min_x, e.min_y, e.max_x - e.min_x + 1, e.max_y - e.min_y + 1);
+	}
+	return matches;
+}
+
+cv::Mat RleMask::key_image(int key, const cv::Rect& roi) const {
+	uint8_t lut[256] = {};
+	if (key > 0 && key < 256)
+		lut[key] = static_cast<uint8_t>(key);
+	return key_image(lut, roi);
+}
+
+cv::Mat RleMask::key_image(const uint8_t lut[256], const cv::Rect& roi) const {
+	cv::Rect area = roi & cv::Rect(0, 0, width, height);
+	if (area.width <= 0 || area.height <= 0)
+		return cv::Mat();
+	cv::Mat image(area.height, area.width, CV_8UC1, cv::Scalar(0));
+	task::parallel_rows(area.height, [&](int row_begin, int row_end) {
+		for (int i = row_begin; i < row_end; ++i) {
+			uchar* row = image.ptr<uchar>(i);
+			const RowSpan& span = row_spans[area.y + i];
+			for (uint32_t r = span.begin; r < span.begin + span.count; ++r) {
+				const MaskRun& run = runs[r];
+				const uint8_t level = lut[run.value];
+				if (level == 0)
+					continue;
+				const int x0 = std::max(static_cast<int>(run.start), area.x);
+				const int x1 = std::min(run.start + run.length, area.x + area.width);
+				if (x1 > x0)
+					std::memset(row + (x0 - area.x), level, x1 - x0);
+			}
+		}
+	}, 32);
+	return image;
+}
+
+//--------------------------------------------------------------------------
+// Serialization
+//--------------------------------------------------------------------------
+void RleMask::serialize(std::vector<uint8_t>& out) const {
+	out.reserve(out.size() + 16 + row_spans.size() * 8 + runs.size() * 5);
+	put_u32(out, kRleMagic);
+	put_u32(out, static_cast<uint32_t>(width));
+	put_u32(out, static_cast<uint32_t>(height));
+	put_u32(out, static_cast<uint32_t>(runs.size()));
+	for (const RowSpan& span : row_spans) {
+		put_u32(out, span.begin);
+		put_u32(out, span.count);
+	}
+	for (const MaskRun& run : runs) {
+		put_u16(out, run.start);
+		put_u16(out, run.length);
+		out.push_back(run.value);
+	}
+}
+
+size_t RleMask::deserialize(const uint8_t* data, size_t size, RleMask& mask) {
+	mask = RleMask();
+	if (size < 16 || get_u32(data) != kRleMagic)
+		return 0;
+	const uint32_t w = get_u32(data + 4), h = get_u32(data + 8), n = get_u32(data + 12);
+	if (w > 0xffff || h > (1u << 20) || n > (1u << 28))
+		return 0;
+	const size_t total = 16 + static_cast<size_t>(h) * 8 + static_cast<size_t>(n) * 5;
+	if (size < total)
+		return 0;
+
+	RleMask rle;
+	rle.width = static_cast<int>(w);
+	rle.height = static_cast<int>(h);
+	rle.row_spans.resize(h);
+	rle.runs.resize(n);
+	const uint8_t* p = data + 16;
+	for (uint32_t y = 0; y < h; ++y, p += 8) {
+		rle.row_spans[y] = { get_u32(p), get_u32(p + 4) };
+		if (static_cast<uint64_t>(rle.row_spans[y].begin) + rle.row_spans[y].count > n)
+			return 0;
+	}
+	for (uint32_t r = 0; r < n; ++r, p += 5) {
+		rle.runs[r] = { get_u16(p), get_u16(p + 2), p[4] };
+		if (rle.runs[r].start + rle.runs[r].length > static_cast<int>(w))
+			return 0;
+	}
+	mask = std::move(rle);
+	return total;
+}
+
+size_t RleMask::bytes() const {
+	return row_spans.size() * sizeof(RowSpan) + runs.size() * sizeof(MaskRun);
+}
+
+//--------------------------------------------------------------------------
+// verify_rle_mask
+//--------------------------------------------------------------------------
+bool verify_rle_mask() {
+	const int key = 48;
+	const cv::Mat map = make_class_map(384, 384);
+	const RleMask rle = RleMask::encode(map);
+	bool ok = same_pixels(rle.decode(), map);
+
+	const cv::Size sizes[] = { cv::Size(1280, 720), cv::Size(3840, 2160), cv::Size(200, 150) };
+	size_t frame_bytes = 0, frame_rle_bytes = 0;
+	for (const cv::Size& size : sizes) {
+		RleMask scaled = rle.resized(size);
+		cv::Mat reference = resize_nearest_reference(map, size);
+		ok = ok && same_pixels(scaled.decode(), reference);
+
+		for (int delta : { 1, 20 }) {
+			// Per-pixel key statistics and overlay, as glow_blow computes them on a decoded mask.
+			int pixels = 0, min_x = size.width, max_x = -1, min_y = size.height, max_y = -1;
+			cv::Mat expected(size, CV_8UC4, cv::Scalar(0, 0, 0, 0));
+			const cv::Vec4b color(128, 0, 128, 255);
+			for (int y = 0; y < size.height; ++y) {
+				const uchar* row = reference.ptr<uchar>(y);
+				for (int x = 0; x < size.width; ++x) {
+					if (std::abs(row[x] - key) < delta) {
+						pixels++;
+						min_x = std::min(min_x, x);
+						max_x = std::max(max_x, x);
+						min_y = std::min(min_y, y);
+						max_y = std::max(max_y, y);
+						expected.ptr<cv::Vec4b>(y)[x] = color;
+					}
+				}
+			}
+			KeyMatch match = scaled.match_key(key, delta);
+			ok = ok && match.pixels == pixels &&
+				(pixels == 0 || match.box == cv::Rect(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1));
+
+			cv::Mat painted(size, CV_8UC4, cv::Scalar(0, 0, 0, 0));
+			scaled.paint_key(painted, key, delta, color);
+			ok = ok && same_pixels(painted, expected);
+
+			// Two keys in one pass: the same as one match_key / paint_key per key (ranges apart).
+			const int other = 60;
+			if (2 * delta > other - key)
+				continue;
+			const cv::Vec4b other_color(0, 200, 255, 255);
+			int class_of[256];
+			for (int v = 0; v < 256; ++v)
+				class_of[v] = within(v, key, delta) ? 0 : within(v, other, delta) ? 1 : -1;
+			scaled.paint_key(expected, other, delta, other_color);
+			cv::Mat both(size, CV_8UC4, cv::Scalar(0, 0, 0, 0));
+			std::vector<KeyMatch> matches = scaled.paint_classes(both, class_of, { color, other_color });
+			KeyMatch other_match = scaled.match_key(other, delta);
+			ok = ok && same_pixels(both, expected) && matches.size() == 2 && matches[0].pixels == match.pixels &&
+				matches[0].box == match.box && matches[1].pixels == other_match.pixels && matches[1].box == other_match.box;
+		}
+
+		cv::Rect roi(size.width / 5, size.height / 7, size.width / 2, size.height / 3);
+		cv::Mat keyed = scaled.key_image(key, roi);
+		cv::Mat keyed_reference(roi.size(), CV_8UC1, cv::Scalar(0));
+		for (int y = 0; y < roi.height; ++y)
+			for (int x = 0; x < roi.width; ++x)
+				if (reference.ptr<uchar>(y + roi.y)[x + roi.x] == key)
+					keyed_reference.ptr<uchar>(y)[x] = static_cast<uchar>(key);
+		ok = ok && same_pixels(keyed, keyed_reference);
+
+		if (size == cv::Size(3840, 2160)) {
+			frame_bytes = reference.total();
+			frame_rle_bytes = scaled.bytes();
+		}
+	}
+
+	std::vector<uint8_t> blob;
+	rle.serialize(blob);
+	RleMask loaded;
+	ok = ok && RleMask::deserialize(blob.data(), blob.size(), loaded) == blob.size() && same_pixels(loaded.decode(), map) &&
+		RleMask::deserialize(blob.data(), blob.size() - 1, loaded) == 0;
+
+	std::cout << "RLE mask check: " << rle.run_count() << " runs for 384x384 (" << blob.size() << " bytes serialized vs "
+		<< map.total() << "), 3840x2160 upscale " << frame_rle_bytes << " bytes vs " << frame_bytes << ": "
+		<< (ok ? "PASSED" : "FAILED") << std::endl;
+	return ok;
+}
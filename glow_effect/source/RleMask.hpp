@@ -0,0 +1,127 @@
+#ifndef RLE_MASK_HPP
+#define RLE_MASK_HPP
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief One horizontal run of equal class values.
+ */
+struct MaskRun {
+	uint16_t start;    ///< First column of the run.
+	uint16_t length;   ///< Number of columns (> 0).
+	uint8_t value;     ///< Class value of the run.
+};
+
+/**
+ * @brief Key statistics of a mask: matching pixel count and their bounding box.
+ */
+struct KeyMatch {
+	int pixels = 0;    ///< Pixels with |value - key| < delta.
+	cv::Rect box;      ///< Bounding box of those pixels (empty if none).
+};
+
+/**
+ * @brief Run-length encoded class map (CV_8UC1 equivalent).
+ *
+ * Rows reference spans of a shared run array, so rows repeated by a nearest-neighbour upscale
+ * share their runs: a 384x384 segmentation scaled to 4K keeps the run count of the 384x384
+ * map. Key matching, region statistics, the overlay of glow_blow and the keyed image fed to
+ * the mipmap all cost per run instead of per pixel. Widths are limited to 65535.
+ */
+class RleMask {
+public:
+	RleMask() = default;
+
+	/** @brief Encodes a CV_8UC1 mask (an ROI view is fine). An empty or non-8UC1 mask gives an empty RleMask. */
+	static RleMask encode(const cv::Mat& mask);
+
+	/** @brief Mask of the given size filled with one value. */
+	static RleMask filled(const cv::Size& size, uint8_t value);
+
+	/** @brief Decodes to CV_8UC1. */
+	cv::Mat decode() const;
+
+	/**
+	 * @brief Nearest-neighbour resize (the sampling of cv::INTER_NEAREST), done on the runs.
+	 *
+	 * Class values are never blended; source rows are scaled once and shared by all
+	 * destination rows that sample them.
+	 */
+	RleMask resized(const cv::Size& size) const;
+
+	/** @brief Pixel count and bounding box of the values within delta of key. */
+	KeyMatch match_key(int key, int delta) const;
+
+	/**
+	 * @brief Writes color into dst (CV_8UC4, mask size) on every pixel within delta of key;
+	 *        other pixels are left untouched.
+	 */
+	void paint_key(cv::Mat& dst, int key, int delta, const cv::Vec4b& color) const;
+
+	/**
+	 * @brief match_key and paint_key of several keys in one pass over the runs.
+	 *
+	 * class_of maps every mask value to a key index (-1 for none). Runs of key k are painted
+	 * with colors[k] into dst (CV_8UC4, mask size; other pixels are left untouched) and counted
+	 * in result[k]. With class_of[v] = 0 for the values within delta of one key, this is
+	 * match_key and paint_key of that key.
+	 *
+	 * @return One KeyMatch per entry of colors.
+	 */
+	std::vector<KeyMatch> paint_classes(cv::Mat& dst, const int class_of[256], const std::vector<cv::Vec4b>& colors) const;
+
+	/**
+	 * @brief Keyed mipmap input of an ROI: key where the value equals key, 0 elsewhere (CV_8UC1).
+	 *
+	 * Same content as convert_mask_to_rgba_buffer / apply_mipmap_cpu derive from the decoded mask,
+	 * so either mipmap backend produces the same glow from it.
+	 */
+	cv::Mat key_image(int key, const cv::Rect& roi) const;
+
+	/** @brief key_image through a value table: lut[value] on every pixel, CV_8UC1 over roi. */
+	cv::Mat key_image(const uint8_t lut[256], const cv::Rect& roi) const;
+
+	/** @brief Appends the serialized mask (little-endian header, row spans, runs) to out. */
+	void serialize(std::vector<uint8_t>& out) const;
+
+	/**
+	 * @brief Parses a mask written by serialize.
+	 *
+	 * @return Bytes consumed, or 0 if the data is truncated or inconsistent.
+	 */
+	static size_t deserialize(const uint8_t* data, size_t size, RleMask& mask);
+
+	int rows() const { return height; }
+	int cols() const { return width; }
+	cv::Size size() const { return cv::Size(width, height); }
+	bool empty() const { return width == 0 || height == 0; }
+	size_t run_count() const { return runs.size(); }
+
+	/** @brief Heap bytes held by the runs and row spans. */
+	size_t bytes() const;
+
+private:
+	struct RowSpan {
+		uint32_t begin;   // first run of the row
+		uint32_t count;   // runs in the row
+	};
+
+	int width = 0;
+	int height = 0;
+	std::vector<RowSpan> row_spans;
+	std::vector<MaskRun> runs;
+};
+
+/**
+ * @brief Headless check of RleMask against per-pixel reference implementations.
+ *
+ * Covers encode/decode, nearest resize, key statistics, overlay (single and multi-key), keyed image and serialization
+ * on a synthetic class map, and prints the memory of the RLE against the decoded mask.
+ *
+ * @return true if every result matches.
+ */
+bool verify_rle_mask();
+
+#endif // RLE_MASK_HPP
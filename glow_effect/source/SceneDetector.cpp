@@ -0,0 +1,288 @@
+/**
+ * @file SceneDetector.cpp
+ * @brief CPU scene-change / motion-energy detector on the 384x384 analysis grid.
+ */
+
+#include "SceneDetector.hpp"
+#include "SyntheticClip.hpp"
+#include "movie_effect/include/tools_task.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCENE_DETECTOR_SSE2 1
+#endif
+
+namespace {
+	const int kHistBins = 64;   // luma histogram bins (4 gray levels per bin)
+
+	uint64_t sum_abs_diff_scalar(const uchar* a, const uchar* b, int count) {
+		uint64_t sum = 0;
+		for (int i = 0; i < count; ++i)
+			sum += static_cast<unsigned>(std::abs(a[i] - b[i]));
+		return sum;
+	}
+
+	// Four partial histograms break the store-to-load dependency on repeated bins.
+	void luma_histogram(const cv::Mat& gray, std::vector<uint32_t>& hist) {
+		uint32_t partial[4][kHistBins] = {};
+		for (int y = 0; y < gray.rows; ++y) {
+			const uchar* row = gray.ptr<uchar>(y);
+			int x = 0;
+			for (; x + 4 <= gray.cols; x += 4) {
+				partial[0][row[x] >> 2]++;
+				partial[1][row[x + 1] >> 2]++;
+				partial[2][row[x + 2] >> 2]++;
+				partial[3][row[x + 3] >> 2]++;
+			}
+			for (; x < gray.cols; ++x)
+				partial[0][row[x] >> 2]++;
+		}
+		hist.assign(kHistBins, 0);
+		for (int b = 0; b < kHistBins; ++b)
+			hist[b] = partial[0][b] + partial[1][b] + partial[2][b] + partial[3][b];
+	}
+}
+
+//--------------------------------------------------------------------------
+// make_analysis_gray
+//--------------------------------------------------------------------------
+cv::Mat make_analysis_gray(const cv::Mat& frame, int size) {
+	cv::Mat gray(size, size, CV_8UC1, cv::Scalar(0));
+	if (frame.empty() || frame.cols <= 0 || frame.rows <= 0)
+		return gray;
+	const int channels = frame.channels();
+
+	// Source column span of every output column, computed once per frame.
+	std::vector<int> col_begin(size), col_end(size);
+	for (int x = 0; x < size; ++x) {
+		col_begin[x] = x * frame.cols / size;
+		col_end[x] = std::max(col_begin[x] + 1, (x + 1) * frame.cols / size);
+	}
+
+	task::parallel_rows(size, [&](int y0, int y1) {
+		// Luma of the source rows of one output row, summed column-wise first.
+		std::vector<unsigned> column_sum(frame.cols);
+		for (int y = y0; y < y1; ++y) {
+			int sy0 = y * frame.rows / size;
+			int sy1 = std::max(sy0 + 1, (y + 1) * frame.rows / size);
+			std::fill(column_sum.begin(), column_sum.end(), 0u);
+			for (int sy = sy0; sy < sy1; ++sy) {
+				const uchar* row = frame.ptr<uchar>(sy);
+				if (channels >= 3) {
+					for (int sx = 0; sx < frame.cols; ++sx, row += channels)
+						column_sum[sx] += (row[0] * 29u + row[1] * 150u + row[2] * 77u) >> 8;
+				}
+				else {
+					for (int sx = 0; sx < frame.cols; ++sx)
+						column_sum[sx] += row[sx];
+				}
+			}
+
+			uchar* out = gray.ptr<uchar>(y);
+			const unsigned rows = static_cast<unsigned>(sy1 - sy0);
+			for (int x = 0; x < size; ++x) {
+				unsigned sum = 0;
+				for (int sx = col_begin[x]; sx < col_end[x]; ++sx)
+					sum += column_sum[sx];
+				out[x] = static_cast<uchar>(sum / (rows * (col_end[x] - col_begin[x])));
+			}
+		}
+	});
+	return gray;
+}
+
+//--------------------------------------------------------------------------
+// sum_abs_diff_u8
+//--------------------------------------------------------------------------
+uint64_t sum_abs_diff_u8(const uchar* a, const uchar* b, int count) {
+#ifdef SCENE_DETECTOR_SSE2
+	__m128i acc = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+	}
+	uint64_t lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+	return lanes[0] + lanes[1] + sum_abs_diff_scalar(a + i, b + i, count - i);
+#else
+	return sum_abs_diff_scalar(a, b, count);
+#endif
+}
+
+//--------------------------------------------------------------------------
+// SceneChangeDetector
+//--------------------------------------------------------------------------
+SceneChangeDetector::SceneChangeDetector(const SceneDetectorConfig& config) : config(config) {
+	this->config.block_size = std::max(4, config.block_size);
+}
+
+void SceneChangeDetector::reset() {
+	prev_gray = cv::Mat();
+	prev_hist.clear();
+}
+
+FrameChangeScore SceneChangeDetector::analyze(const cv::Mat& gray) {
+	FrameChangeScore score;
+	std::vector<uint32_t> hist;
+	luma_histogram(gray, hist);
+
+	if (prev_gray.empty() || prev_gray.size() != gray.size()) {
+		prev_gray = gray.clone();
+		prev_hist = hist;
+		return score;   // first frame: everything is new
+	}
+
+	// Histogram difference.
+	uint64_t hist_l1 = 0;
+	for (int b = 0; b < kHistBins; ++b)
+		hist_l1 += hist[b] > prev_hist[b] ? hist[b] - prev_hist[b] : prev_hist[b] - hist[b];
+	score.histogram_diff = static_cast<double>(hist_l1) / (2.0 * gray.total());
+
+	// Block SAD, one row of blocks per task.
+	const int bs = config.block_size;
+	const int blocks_x = (gray.cols + bs - 1) / bs;
+	const int blocks_y = (gray.rows + bs - 1) / bs;
+	std::vector<uint64_t> block_sad(static_cast<size_t>(blocks_x) * blocks_y, 0);
+	task::parallel_rows(blocks_y, [&](int b0, int b1) {
+		for (int by = b0; by < b1; ++by) {
+			const int y0 = by * bs, y1 = std::min(gray.rows, y0 + bs);
+			for (int y = y0; y < y1; ++y) {
+				const uchar* cur = gray.ptr<uchar>(y);
+				const uchar* prev = prev_gray.ptr<uchar>(y);
+				for (int bx = 0; bx < blocks_x; ++bx) {
+					const int x0 = bx * bs;
+					block_sad[by * blocks_x + bx] += sum_abs_diff_u8(cur + x0, prev + x0, std::min(bs, gray.cols - x0));
+				}
+			}
+		}
+	}, 1);
+
+	uint64_t total_sad = 0;
+	int changed = 0;
+	for (int by = 0; by < blocks_y; ++by) {
+		for (int bx = 0; bx < blocks_x; ++bx) {
+			const int pixels = std::min(bs, gray.rows - by * bs) * std::min(bs, gray.cols - bx * bs);
+			const uint64_t sad = block_sad[by * blocks_x + bx];
+			total_sad += sad;
+			if (sad > config.block_change * 255.0 * pixels)
+				changed++;
+		}
+	}
+	score.motion_energy = static_cast<double>(total_sad) / (255.0 * gray.total());
+	score.changed_blocks = static_cast<double>(changed) / block_sad.size();
+
+	score.scene_cut = score.histogram_diff > config.cut_histogram ||
+		(score.motion_energy > config.cut_motion && score.changed_blocks > 0.5);
+	score.static_frame = !score.scene_cut && score.motion_energy < config.static_motion;
+
+	prev_gray = gray.clone();
+	prev_hist.swap(hist);
+	return score;
+}
+
+//--------------------------------------------------------------------------
+// verify_scene_detector
+//--------------------------------------------------------------------------
+bool verify_scene_detector() {
+	SyntheticClipSpec spec;
+	spec.scene_lengths = { 20, 13, 27, 9 };
+	spec.static_frames = 5;
+	SyntheticClip clip = make_synthetic_clip(spec);
+
+	SceneChangeDetector detector;
+	std::vector<int> cuts;
+	int static_expected = 0, static_found = 0, static_false = 0;
+	int first = 0;
+	size_t scene = 0;
+	for (int i = 0; i < static_cast<int>(clip.frames.size()); ++i) {
+		if (scene < spec.scene_lengths.size() && i >= first + spec.scene_lengths[scene]) {
+			first += spec.scene_lengths[scene];
+			scene++;
+		}
+		FrameChangeScore score = detector.analyze(make_analysis_gray(clip.frames[i]));
+		if (i > 0 && score.scene_cut)
+			cuts.push_back(i);
+
+		// Frames after the first static one of a scene are pixel-identical to their predecessor.
+		bool expect_static = i - first > 0 && i - first >= spec.scene_lengths[scene] - spec.static_frames;
+		static_expected += expect_static;
+		static_found += expect_static && score.static_frame;
+		static_false += !expect_static && score.static_frame;
+	}
+
+	bool ok = cuts == clip.cuts && static_found == static_expected && static_false == 0;
+	std::cout << "Scene detector check: " << cuts.size() << " cuts found (" << clip.cuts.size() << " expected), "
+		<< static_found << "/" << static_expected << " static frames flagged, " << static_false
+		<< " false static: " << (ok ? "PASSED" : "FAILED") << std::endl;
+	return ok;
+}
+
+//--------------------------------------------------------------------------
+// benchmark_scene_detector
+//--------------------------------------------------------------------------
+void benchmark_scene_detector(int num_frames) {
+	using clock = std::chrono::high_resolution_clock;
+	num_frames = std::max(2, num_frames);
+
+	SyntheticClipSpec spec;
+	spec.width = 1280;
+	spec.height = 720;
+	spec.object_size = 200;
+	spec.scene_lengths.clear();
+	for (int left = num_frames, len = 37; left > 0; left -= len, len = len % 50 + 13)
+		spec.scene_lengths.push_back(std::min(len, left));
+	SyntheticClip clip = make_synthetic_clip(spec);
+
+	std::vector<cv::Mat> grays(clip.frames.size());
+	auto t0 = clock::now();
+	for (size_t i = 0; i < clip.frames.size(); ++i)
+		grays[i] = make_analysis_gray(clip.frames[i]);
+	auto t1 = clock::now();
+
+	SceneChangeDetector detector;
+	std::vector<int> cuts;
+	for (size_t i = 0; i < grays.size(); ++i) {
+		if (detector.analyze(grays[i]).scene_cut && i > 0)
+			cuts.push_back(static_cast<int>(i));
+	}
+	auto t2 = clock::now();
+
+	// Raw SAD kernels over whole analysis frames.
+	uint64_t sink = 0;
+	auto t3 = clock::now();
+	for (size_t i = 1; i < grays.size(); ++i)
+		sink += sum_abs_diff_u8(grays[i].data, grays[i - 1].data, static_cast<int>(grays[i].total()));
+	auto t4 = clock::now();
+	for (size_t i = 1; i < grays.size(); ++i)
+		sink -= sum_abs_diff_scalar(grays[i].data, grays[i - 1].data, static_cast<int>(grays[i].total()));
+	auto t5 = clock::now();
+
+	int hits = 0;
+	for (int c : cuts)
+		hits += std::find(clip.cuts.begin(), clip.cuts.end(), c) != clip.cuts.end();
+
+	auto per_frame = [&](clock::duration d) {
+		return std::chrono::duration<double, std::milli>(d).count() / grays.size();
+	};
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Scene detector benchmark (" << grays.size() << " frames, 1280x720 -> 384x384)" << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+	std::cout << "Downscale to analysis grid: " << per_frame(t1 - t0) << " ms/frame" << std::endl;
+	std::cout << "Histogram + block SAD:      " << per_frame(t2 - t1) << " ms/frame" << std::endl;
+#ifdef SCENE_DETECTOR_SSE2
+	std::cout << "Frame SAD (SSE2):           " << per_frame(t4 - t3) << " ms/frame" << std::endl;
+#else
+	std::cout << "Frame SAD (no SIMD):        " << per_frame(t4 - t3) << " ms/frame" << std::endl;
+#endif
+	std::cout << "Frame SAD (scalar):         " << per_frame(t5 - t4) << " ms/frame" << std::endl;
+	std::cout << "Cuts: " << hits << " of " << clip.cuts.size() << " found, "
+		<< cuts.size() - hits << " false" << (sink == 0 ? "" : " (SAD mismatch!)") << std::endl;
+	std::cout << "---------------------------------------------------" << std::endl;
+}
@@ -0,0 +1,93 @@
+#ifndef SCENE_DETECTOR_HPP
+#define SCENE_DETECTOR_HPP
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Thresholds of the scene-change / motion-energy detector.
+ *
+ * All scores are normalized to 0..1 so the thresholds do not depend on the analysis size.
+ */
+struct SceneDetectorConfig {
+	int block_size = 16;              ///< Block size of the SAD motion measure.
+	double cut_histogram = 0.30;      ///< Histogram difference above which a frame is a scene cut.
+	double cut_motion = 0.20;         ///< Motion energy above which a frame is a scene cut (with most blocks changed).
+	double block_change = 0.06;       ///< Mean abs difference of a block above which the block counts as changed.
+	double resegment_blocks = 0.25;   ///< Changed-block fraction accumulated since the last keyframe that requires a fresh segmentation.
+	double static_motion = 0.004;     ///< Motion energy below which the frame is treated as static (mask and glow reusable).
+};
+
+/**
+ * @brief Per-frame output of SceneChangeDetector, relative to the previous frame.
+ */
+struct FrameChangeScore {
+	double histogram_diff = 1.0;   ///< Half L1 distance of the 64-bin luma histograms (0 same, 1 disjoint).
+	double motion_energy = 1.0;    ///< Mean absolute pixel difference / 255.
+	double changed_blocks = 1.0;   ///< Fraction of blocks whose mean absolute difference exceeds block_change.
+	bool scene_cut = true;         ///< Content changed completely; segment fresh and start a new batch.
+	bool static_frame = false;     ///< Practically no change; previous mask and glow can be reused.
+};
+
+/**
+ * @brief Box-filtered downscale of a BGR/BGRA/gray frame to a size x size gray analysis grid.
+ *
+ * This is the only full-resolution pass of the CPU analysis; the detector and the mask
+ * propagation work on its output.
+ */
+cv::Mat make_analysis_gray(const cv::Mat& frame, int size = 384);
+
+/**
+ * @brief Sum of absolute differences of two byte rows (SSE2 when available).
+ */
+uint64_t sum_abs_diff_u8(const uchar* a, const uchar* b, int count);
+
+/**
+ * @brief Fast CPU scene-change and motion-energy detector.
+ *
+ * Frames must be pushed in display order (the detector compares against the previous frame).
+ * Two measures are combined: a luma histogram difference, which catches cuts between scenes
+ * with different content, and block SAD, which measures how much of the picture moved.
+ */
+class SceneChangeDetector {
+public:
+	explicit SceneChangeDetector(const SceneDetectorConfig& config = SceneDetectorConfig());
+
+	/**
+	 * @brief Scores the next frame against the previous one.
+	 *
+	 * @param gray Analysis grid from make_analysis_gray (CV_8UC1). The first frame, or a frame
+	 *             whose size differs from the previous one, is reported as a scene cut.
+	 */
+	FrameChangeScore analyze(const cv::Mat& gray);
+
+	/** @brief Forgets the previous frame. */
+	void reset();
+
+	const SceneDetectorConfig& settings() const { return config; }
+
+private:
+	SceneDetectorConfig config;
+	cv::Mat prev_gray;
+	std::vector<uint32_t> prev_hist;
+};
+
+/**
+ * @brief Headless check of the detector on a generated clip with known cuts and static tails.
+ *
+ * @return true if every cut is detected without false cuts and the static frames are flagged.
+ */
+bool verify_scene_detector();
+
+/**
+ * @brief Times the analysis stages on a generated clip and prints ms per frame.
+ *
+ * Reports the downscale from a 1280x720 source, histogram + block SAD, the SSE2 and scalar SAD
+ * kernels, and the cut detection accuracy.
+ *
+ * @param num_frames Frames in the generated benchmark clip.
+ */
+void benchmark_scene_detector(int num_frames);
+
+#endif // SCENE_DETECTOR_HPP
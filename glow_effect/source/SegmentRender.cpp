@@ -0,0 +1,394 @@
+/**
+ * @file SegmentRender.cpp
+ * @brief Segment-parallel rendering: range planning, worker processes and part concatenation.
+ */
+
+#include "SegmentRender.hpp"
+#include "RawVideoSink.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+	std::string quoted(const std::string& s) {
+		return "\"" + s + "\"";
+	}
+
+	std::string part_extension(const std::string& format) {
+		if (format == "avi")
+			return ".avi";
+		RawVideoFormat raw;
+		if (parse_raw_video_format(format, raw))
+			return (raw == RawVideoFormat::Y4m420 || raw == RawVideoFormat::Y4m444) ? ".y4m" : ".yuv";
+		return ".bin";
+	}
+
+	bool copy_bytes(std::ifstream& in, std::ofstream& out) {
+		std::vector<char> buffer(1 << 20);
+		while (in) {
+			in.read(buffer.data(), buffer.size());
+			out.write(buffer.data(), in.gcount());
+		}
+		return static_cast<bool>(out);
+	}
+
+	bool concat_avi(const std::vector<std::string>& parts, const std::string& output) {
+		cv::VideoWriter writer;
+		cv::Mat frame;
+		for (const std::string& part : parts) {
+			cv::VideoCapture video;
+			if (!video.open(part, cv::CAP_ANY)) {
+				std::cerr << "Error: Could not open segment part: " << part << std::endl;
+				return false;
+			}
+			while (video.read(frame) && !frame.empty()) {
+				if (!writer.isOpened() && !writer.open(output, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+					video.get(cv::CAP_PROP_FPS), frame.size())) {
+					std::cerr << "Error: Could not open the output video for writing: " << output << std::endl;
+					return false;
+				}
+				writer.write(frame);
+			}
+		}
+		return writer.isOpened();
+	}
+
+	// Seconds since the part or the log of a worker last changed; negative if neither exists yet.
+	double seconds_since_activity(const std::string& part) {
+		std::error_code ec;
+		bool found = false;
+		fs::file_time_type latest = fs::file_time_type::min();
+		for (const std::string& path : { part, part + ".log" }) {
+			const fs::file_time_type written = fs::last_write_time(path, ec);
+			if (!ec) {
+				latest = std::max(latest, written);
+				found = true;
+			}
+		}
+		if (!found)
+			return -1.0;
+		return std::chrono::duration<double>(fs::file_time_type::clock::now() - latest).count();
+	}
+}
+
+//--------------------------------------------------------------------------
+// plan_segments
+//--------------------------------------------------------------------------
+std::vector<FrameRange> plan_segments(int64_t frame_count, int workers, int align) {
+	std::vector<FrameRange> ranges;
+	if (frame_count <= 0)
+		return ranges;
+	const int64_t step = std::max(1, align);
+	const int64_t units = (frame_count + step - 1) / step;
+	const int64_t n = std::max<int64_t>(1, std::min<int64_t>(workers, units));
+
+	int64_t first = 0;
+	for (int64_t i = 1; i <= n; ++i) {
+		// Boundary i of n, in whole alignment units; the last one is the end of the video.
+		const int64_t end = (i == n) ? frame_count : std::min(frame_count, (units * i + n / 2) / n * step);
+		if (end > first)
+			ranges.push_back(FrameRange{ first, end - first });
+		first = std::max(first, end);
+	}
+	return ranges;
+}
+
+//--------------------------------------------------------------------------
+// Worker command line
+//--------------------------------------------------------------------------
+std::string segment_worker_command(const std::string& executable, const SegmentWorkerArgs& args) {
+	std::string cmd = quoted(executable) + " --segment-worker " + quoted(args.video) + " " + quoted(args.plan) + " " +
+		std::to_string(args.range.first) + " " + std::to_string(args.range.count) + " " +
+		std::to_string(args.keyframe_interval) + " " + args.format + " " + (args.cpu_mipmap ? "cpu" : "gpu") + " " +
+		std::to_string(args.device) + " " + quoted(args.part) + " > " + quoted(args.part + ".log") + " 2>&1";
+#ifdef _WIN32
+	// cmd.exe strips the outer quotes of a command line that starts with a quote.
+	cmd = "\"" + cmd + "\"";
+#endif
+	return cmd;
+}
+
+bool parse_segment_worker_args(int argc, char** argv, SegmentWorkerArgs& args) {
+	if (argc != 11 || std::string(argv[1]) != "--segment-worker")
+		return false;
+	try {
+		args.video = argv[2];
+		args.plan = argv[3];
+		args.range.first = std::stoll(argv[4]);
+		args.range.count = std::stoll(argv[5]);
+		args.keyframe_interval = std::max(1, std::stoi(argv[6]));
+		args.format = argv[7];
+		args.cpu_mipmap = std::string(argv[8]) == "cpu";
+		args.device = std::stoi(argv[9]);
+		args.part = argv[10];
+	}
+	catch (const std::exception&) {
+		return false;
+	}
+	return args.range.first >= 0;
+}
+
+void mark_segment_done(const std::string& part) {
+	std::ofstream(part + ".done") << "done\n";
+}
+
+void mark_segment_failed(const std::string& part) {
+	std::ofstream(part + ".failed") << "failed\n";
+}
+
+//--------------------------------------------------------------------------
+// concat_segment_parts
+//--------------------------------------------------------------------------
+bool concat_segment_parts(const std::vector<std::string>& parts, const std::string& output, const std::string& format) {
+	if (parts.empty())
+		return false;
+	if (format == "avi")
+		return concat_avi(parts, output);
+
+	RawVideoFormat raw;
+	if (!parse_raw_video_format(format, raw))
+		return false;
+	const bool y4m = raw == RawVideoFormat::Y4m420 || raw == RawVideoFormat::Y4m444;
+	std::ofstream out(output, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		std::cerr << "Error: Could not create " << output << std::endl;
+		return false;
+	}
+	std::string first_header;
+	for (size_t i = 0; i < parts.size(); ++i) {
+		std::ifstream in(parts[i], std::ios::binary);
+		if (!in.is_open()) {
+			std::cerr << "Error: Missing segment part: " << parts[i] << std::endl;
+			return false;
+		}
+		if (y4m) {
+			// The stream header is written once; every part must describe the same stream.
+			std::string header;
+			std::getline(in, header);
+			if (header.compare(0, 9, "YUV4MPEG2") != 0 || (i > 0 && header != first_header)) {
+				std::cerr << "Error: Segment part " << parts[i] << " has a different Y4M header." << std::endl;
+				return false;
+			}
+			if (i == 0) {
+				first_header = header;
+				out << header << '\n';
+			}
+		}
+		if (!copy_bytes(in, out))
+			return false;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------
+// run_segment_render
+//--------------------------------------------------------------------------
+bool run_segment_render(const SegmentRenderConfig& config) {
+	auto start = std::chrono::high_resolution_clock::now();
+	int64_t frame_count = 0;
+	{
+		cv::VideoCapture video;
+		if (!video.open(config.job.video, cv::CAP_ANY)) {
+			std::cerr << "Error: Could not open video file: " << config.job.video << std::endl;
+			return false;
+		}
+		frame_count = static_cast<int64_t>(video.get(cv::CAP_PROP_FRAME_COUNT));
+	}
+	const int align = config.align > 0 ? config.align : config.job.keyframe_interval;
+	std::vector<FrameRange> ranges = plan_segments(frame_count, config.workers, align);
+	if (ranges.empty()) {
+		std::cerr << "Error: The video reports no frames: " << config.job.video << std::endl;
+		return false;
+	}
+	std::error_code ec;
+	fs::create_directories(config.work_dir, ec);
+
+	std::vector<SegmentWorkerArgs> jobs;
+	for (size_t i = 0; i < ranges.size(); ++i) {
+		SegmentWorkerArgs args = config.job;
+		args.range = ranges[i];
+		// The frame count of some containers is an estimate: the last worker reads to the end.
+		if (i + 1 == ranges.size())
+			args.range.count = -1;
+		args.device = config.gpus > 0 ? static_cast<int>(i % config.gpus) : -1;
+		char name[32];
+		std::snprintf(name, sizeof(name), "part_%03d", static_cast<int>(i));
+		args.part = (fs::path(config.work_dir) / (name + part_extension(args.format))).string();
+		fs::remove(args.part, ec);
+		fs::remove(args.part + ".done", ec);
+		fs::remove(args.part + ".failed", ec);
+		fs::remove(args.part + ".log", ec);   // an old log would look like a stalled worker
+		jobs.push_back(args);
+		std::cout << "Segment " << i << ": frames " << ranges[i].first << " - "
+			<< ranges[i].first + ranges[i].count - 1 << std::endl;
+	}
+
+	bool ok = true;
+	if (config.launch) {
+		std::vector<int> exit_codes(jobs.size(), 0);
+		std::vector<std::thread> workers;
+		for (size_t i = 0; i < jobs.size(); ++i) {
+			workers.emplace_back([&, i] {
+				exit_codes[i] = std::system(segment_worker_command(config.executable, jobs[i]).c_str());
+			});
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+		for (size_t i = 0; i < jobs.size(); ++i) {
+			if (exit_codes[i] != 0 || !fs::exists(jobs[i].part + ".done")) {
+				std::cerr << "Error: Segment worker " << i << " failed (exit code " << exit_codes[i] << "), see "
+					<< jobs[i].part << ".log" << std::endl;
+				ok = false;
+			}
+		}
+	}
+	else {
+		std::cout << "Run these worker commands (any node that shares " << config.work_dir << "):" << std::endl;
+		for (const SegmentWorkerArgs& args : jobs)
+			std::cout << "  " << segment_worker_command(config.executable, args) << std::endl;
+		// A worker elsewhere may die without a marker: it is also given up when its part and log
+		// stop changing, and the whole wait has a deadline.
+		const auto wait_start = std::chrono::steady_clock::now();
+		std::vector<bool> finished(jobs.size(), false);
+		size_t done = 0;
+		while (ok && done < jobs.size()) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			const size_t before = done;
+			for (size_t i = 0; ok && i < jobs.size(); ++i) {
+				if (finished[i])
+					continue;
+				if (fs::exists(jobs[i].part + ".done")) {
+					finished[i] = true;
+					done++;
+					continue;
+				}
+				const double idle_s = seconds_since_activity(jobs[i].part);
+				if (fs::exists(jobs[i].part + ".failed")) {
+					std::cerr << "Error: Segment worker " << i << " failed, see " << jobs[i].part << ".log" << std::endl;
+					ok = false;
+				}
+				else if (config.stall_timeout_s > 0 && idle_s > config.stall_timeout_s) {
+					std::cerr << "Error: Segment worker " << i << " wrote nothing for " << static_cast<int>(idle_s)
+						<< " s and is taken as dead, see " << jobs[i].part << ".log" << std::endl;
+					ok = false;
+				}
+			}
+			if (done != before)
+				std::cout << done << " of " << jobs.size() << " segments done" << std::endl;
+			const double waited_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start).count();
+			if (ok && done < jobs.size() && config.wait_timeout_s > 0 && waited_s > config.wait_timeout_s) {
+				std::cerr << "Error: Gave up waiting for the segment workers after " << config.wait_timeout_s << " s ("
+					<< done << " of " << jobs.size() << " segments done)" << std::endl;
+				ok = false;
+			}
+		}
+	}
+	if (!ok)
+		return false;
+
+	auto render_end = std::chrono::high_resolution_clock::now();
+	std::vector<std::string> parts;
+	for (const SegmentWorkerArgs& args : jobs)
+		parts.push_back(args.part);
+	if (!concat_segment_parts(parts, config.output, config.job.format))
+		return false;
+	auto end = std::chrono::high_resolution_clock::now();
+
+	std::cout << "Segment-parallel render: " << frame_count << " frames in " << jobs.size() << " segments, render "
+		<< std::chrono::duration<double>(render_end - start).count() << " s, concatenation "
+		<< std::chrono::duration<double>(end - render_end).count() << " s. Saved to: " << config.output << std::endl;
+	return true;
+}
+
+//--------------------------------------------------------------------------
+// verify_segment_render
+//--------------------------------------------------------------------------
+bool verify_segment_render() {
+	// Planner: ranges cover every frame once, in order, on aligned boundaries.
+	bool plan_ok = true;
+	struct PlanCase { int64_t frames; int workers; int align; };
+	const PlanCase cases[] = { { 1000, 4, 1 }, { 1000, 3, 8 }, { 7, 4, 8 }, { 10, 16, 1 }, { 99, 4, 25 } };
+	for (const PlanCase& c : cases) {
+		std::vector<FrameRange> ranges = plan_segments(c.frames, c.workers, c.align);
+		int64_t next = 0;
+		for (const FrameRange& r : ranges) {
+			plan_ok = plan_ok && r.first == next && r.count > 0 && r.first % c.align == 0;
+			next = r.first + r.count;
+		}
+		plan_ok = plan_ok && next == c.frames && !ranges.empty() && static_cast<int>(ranges.size()) <= c.workers;
+	}
+	// Balanced: 1000 frames over 4 workers are 250 each.
+	std::vector<FrameRange> even = plan_segments(1000, 4, 1);
+	plan_ok = plan_ok && even.size() == 4 && even[0].count == 250 && even[3].count == 250;
+
+	// Worker command line round trip (the arguments a shell would pass).
+	SegmentWorkerArgs args;
+	args.video = "in.mp4";
+	args.plan = "cpu";
+	args.range = FrameRange{ 250, -1 };
+	args.keyframe_interval = 4;
+	args.format = "y4m";
+	args.cpu_mipmap = true;
+	args.device = 1;
+	args.part = "part_001.y4m";
+	const char* argv[] = { "glow", "--segment-worker", "in.mp4", "cpu", "250", "-1", "4", "y4m", "cpu", "1", "part_001.y4m" };
+	SegmentWorkerArgs parsed;
+	const std::string cmd = segment_worker_command("glow", args);
+	const bool args_ok = parse_segment_worker_args(11, const_cast<char**>(argv), parsed) && parsed.video == args.video &&
+		parsed.plan == args.plan && parsed.range.first == 250 && parsed.range.count == -1 && parsed.keyframe_interval == 4 &&
+		parsed.format == "y4m" && parsed.cpu_mipmap && parsed.device == 1 && parsed.part == args.part &&
+		cmd.find("--segment-worker \"in.mp4\" \"cpu\" 250 -1 4 y4m cpu 1 \"part_001.y4m\"") != std::string::npos;
+
+	// Concatenation: three Y4M parts of 2, 1 and 3 frames equal one sink writing all 6.
+	const fs::path dir = fs::temp_directory_path() / "glow_segment_check";
+	std::error_code ec;
+	fs::create_directories(dir, ec);
+	const cv::Size size(18, 10);
+	auto frame = [&](int i) { return cv::Mat(size, CV_8UC3, cv::Scalar(20 * i, 255 - 30 * i, 7 * i)); };
+	bool concat_ok = true;
+	for (const std::string format : { "y4m", "raw" }) {
+		RawVideoFormat raw;
+		parse_raw_video_format(format, raw);
+		std::vector<std::string> parts;
+		const int lengths[] = { 2, 1, 3 };
+		int index = 0;
+		for (int p = 0; p < 3; ++p) {
+			parts.push_back((dir / ("part_" + std::to_string(p) + part_extension(format))).string());
+			RawVideoSink sink;
+			concat_ok = concat_ok && sink.open(parts.back(), raw, size, 25.0);
+			for (int i = 0; i < lengths[p]; ++i)
+				concat_ok = concat_ok && sink.write(frame(index++));
+		}
+		const std::string whole = (dir / ("whole" + part_extension(format))).string();
+		{
+			RawVideoSink sink;
+			concat_ok = concat_ok && sink.open(whole, raw, size, 25.0);
+			for (int i = 0; i < index; ++i)
+				concat_ok = concat_ok && sink.write(frame(i));
+		}
+		const std::string joined = (dir / ("joined" + part_extension(format))).string();
+		concat_ok = concat_ok && concat_segment_parts(parts, joined, format);
+		std::ifstream a(whole, std::ios::binary), b(joined, std::ios::binary);
+		const std::string whole_bytes((std::istreambuf_iterator<char>(a)), std::istreambuf_iterator<char>());
+		const std::string joined_bytes((std::istreambuf_iterator<char>(b)), std::istreambuf_iterator<char>());
+		concat_ok = concat_ok && !whole_bytes.empty() && whole_bytes == joined_bytes;
+	}
+	fs::remove_all(dir, ec);
+
+	const bool passed = plan_ok && args_ok && concat_ok;
+	std::cout << "Segment render check: planner " << (plan_ok ? "ok" : "WRONG") << ", worker arguments "
+		<< (args_ok ? "ok" : "WRONG") << ", Y4M/raw concatenation " << (concat_ok ? "bit-exact" : "DIFFERENT") << ": "
+		<< (passed ? "PASSED" : "FAILED") << std::endl;
+	return passed;
+}
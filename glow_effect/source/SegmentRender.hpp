@@ -0,0 +1,112 @@
+#ifndef SEGMENT_RENDER_HPP
+#define SEGMENT_RENDER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Consecutive frames of a video.
+ */
+struct FrameRange {
+	int64_t first = 0;    ///< Index of the first frame.
+	int64_t count = -1;   ///< Number of frames; negative means up to the end of the video.
+};
+
+/**
+ * @brief Command line of one segment worker (see segment_worker_command).
+ */
+struct SegmentWorkerArgs {
+	std::string video;           ///< Input video.
+	std::string plan;            ///< TensorRT plan, or "cpu" for the CPU segmenter backend.
+	FrameRange range;            ///< Frames the worker renders.
+	int keyframe_interval = 1;   ///< Segment every Nth frame and propagate masks in between.
+	std::string format = "avi";  ///< "avi" or a raw format name (see parse_raw_video_format).
+	bool cpu_mipmap = false;     ///< Glow mipmaps on the CPU instead of CUDA.
+	int device = -1;             ///< GPU the worker is pinned to (CUDA_VISIBLE_DEVICES); -1 leaves it alone.
+	std::string part;            ///< Output file of the worker.
+};
+
+/**
+ * @brief Settings of a segment-parallel render.
+ */
+struct SegmentRenderConfig {
+	std::string executable;                          ///< This program; workers run it with --segment-worker.
+	std::string work_dir = "./VideoOutput/segments"; ///< Part files and worker logs (a shared directory for several nodes).
+	std::string output;                              ///< Concatenated result.
+	SegmentWorkerArgs job;                           ///< Worker settings; range, device and part are set per segment.
+	int workers = 2;                                 ///< Segments, one worker process each.
+	int gpus = 0;                                    ///< GPUs to spread the workers over round-robin; 0 does not pin.
+	int align = 0;                                   ///< Segment boundaries are multiples of this (e.g. the codec GOP);
+	                                                 ///< 0 uses the keyframe interval.
+	bool launch = true;                              ///< Start the workers here; false prints their commands (to run on
+	                                                 ///< other nodes sharing work_dir) and waits for their parts.
+	int wait_timeout_s = 24 * 3600;                  ///< Longest wait for workers started elsewhere; 0 waits forever.
+	int stall_timeout_s = 600;                       ///< A worker started elsewhere whose part and log stay unchanged
+	                                                 ///< this long is taken as dead; 0 disables the check.
+};
+
+/**
+ * @brief Splits frame_count frames into at most workers ranges of nearly equal length whose
+ *        boundaries are multiples of align.
+ *
+ * Aligning to the keyframe interval keeps each worker's segmentation cadence that of a
+ * single-process run; aligning to the codec GOP lets every worker's seek start on a keyframe.
+ */
+std::vector<FrameRange> plan_segments(int64_t frame_count, int workers, int align);
+
+/**
+ * @brief Shell command that runs one worker; its output is logged to part + ".log".
+ */
+std::string segment_worker_command(const std::string& executable, const SegmentWorkerArgs& args);
+
+/**
+ * @brief Parses the arguments of a worker started by segment_worker_command.
+ *
+ * @return false if argv is not a --segment-worker command line.
+ */
+bool parse_segment_worker_args(int argc, char** argv, SegmentWorkerArgs& args);
+
+/**
+ * @brief Marks a part complete (part + ".done"); the coordinator waits for these markers.
+ */
+void mark_segment_done(const std::string& part);
+
+/**
+ * @brief Marks a part failed (part + ".failed"), so a coordinator on another node stops waiting.
+ */
+void mark_segment_failed(const std::string& part);
+
+/**
+ * @brief Concatenates the parts in order into output.
+ *
+ * Y4M parts must share their header, which is written once; rawvideo parts are appended as
+ * they are. AVI parts are decoded and re-encoded (MJPG), which is slow: prefer a raw format
+ * for segment-parallel renders.
+ *
+ * @return false if a part is missing or does not match the first one.
+ */
+bool concat_segment_parts(const std::vector<std::string>& parts, const std::string& output, const std::string& format);
+
+/**
+ * @brief Coordinator: plans the segments of the video, runs or waits for one worker per
+ *        segment and concatenates their parts into config.output.
+ *
+ * Workers started elsewhere are polled for their markers; one that marked its part failed,
+ * or stopped writing its part and log for config.stall_timeout_s, ends the wait, as does
+ * config.wait_timeout_s.
+ *
+ * @return false if the video cannot be opened, or a worker failed, stalled or timed out (its
+ *         log is kept).
+ */
+bool run_segment_render(const SegmentRenderConfig& config);
+
+/**
+ * @brief Headless check of the segment planner, the worker command line round trip and the
+ *        concatenation of Y4M and rawvideo parts.
+ *
+ * @return true if the check passed.
+ */
+bool verify_segment_render();
+
+#endif // SEGMENT_RENDER_HPP
@@ -0,0 +1,82 @@
+/**
+ * @file SyntheticClip.cpp
+ * @brief Deterministic test clip generator for self-checks and benchmarks.
+ */
+
+#include "SyntheticClip.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+	const int kTile = 8;   // texture tile size in pixels
+
+	void fill_texture(cv::Mat& frame, const std::vector<uchar>& tiles, int tiles_x) {
+		for (int y = 0; y < frame.rows; ++y) {
+			uchar* row = frame.ptr<uchar>(y);
+			const uchar* tile_row = tiles.data() + (y / kTile) * tiles_x;
+			for (int x = 0; x < frame.cols; ++x) {
+				uchar v = tile_row[x / kTile];
+				row[x * 3] = v;
+				row[x * 3 + 1] = static_cast<uchar>((v * 7) / 8);
+				row[x * 3 + 2] = static_cast<uchar>(255 - v / 2);
+			}
+		}
+	}
+}
+
+SyntheticClip make_synthetic_clip(const SyntheticClipSpec& spec) {
+	SyntheticClip clip;
+	const int tiles_x = (spec.width + kTile - 1) / kTile;
+	const int tiles_y = (spec.height + kTile - 1) / kTile;
+	const int size = std::min(spec.object_size, std::min(spec.width, spec.height));
+
+	int first = 0;
+	for (size_t scene = 0; scene < spec.scene_lengths.size(); ++scene) {
+		const int length = std::max(0, spec.scene_lengths[scene]);
+		if (scene > 0 && length > 0)
+			clip.cuts.push_back(first);
+
+		// Scene texture: its own tiles and brightness band, so cuts change the histogram too.
+		std::mt19937 rng(spec.seed * 7919u + static_cast<uint32_t>(scene));
+		int base = 20 + static_cast<int>(scene % 3) * 45;
+		std::uniform_int_distribution<int> level(base, base + 110);
+		std::vector<uchar> tiles(static_cast<size_t>(tiles_x) * tiles_y);
+		for (uchar& t : tiles)
+			t = static_cast<uchar>(level(rng));
+
+		int start_x = static_cast<int>(rng() % std::max(1, spec.width - size));
+		int start_y = static_cast<int>(rng() % std::max(1, spec.height - size));
+		const int moving = std::max(0, length - spec.static_frames);
+
+		for (int i = 0; i < length; ++i) {
+			int step = std::min(i, std::max(0, moving - 1));
+			// Bounce inside the frame so long scenes stay valid.
+			int range_x = std::max(1, spec.width - size), range_y = std::max(1, spec.height - size);
+			int px = (start_x + step * spec.object_dx) % (2 * range_x);
+			int py = (start_y + step * spec.object_dy) % (2 * range_y);
+			if (px < 0) px += 2 * range_x;
+			if (py < 0) py += 2 * range_y;
+			int ox = px < range_x ? px : 2 * range_x - px;
+			int oy = py < range_y ? py : 2 * range_y - py;
+
+			cv::Mat frame(spec.height, spec.width, CV_8UC3, cv::Scalar(0, 0, 0));
+			cv::Mat mask(spec.height, spec.width, CV_8UC1, cv::Scalar(0));
+			fill_texture(frame, tiles, tiles_x);
+			for (int y = oy; y < oy + size; ++y) {
+				uchar* row = frame.ptr<uchar>(y);
+				uchar* mrow = mask.ptr<uchar>(y);
+				for (int x = ox; x < ox + size; ++x) {
+					// The checker pattern moves with the object so motion search can lock onto it.
+					uchar v = static_cast<uchar>(((x - ox) / 6 + (y - oy) / 6) % 2 ? 255 : 230);
+					row[x * 3] = row[x * 3 + 1] = row[x * 3 + 2] = v;
+					mrow[x] = static_cast<uchar>(spec.object_class);
+				}
+			}
+			clip.frames.push_back(frame);
+			clip.masks.push_back(mask);
+		}
+		first += length;
+	}
+	return clip;
+}
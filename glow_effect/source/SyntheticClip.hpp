@@ -0,0 +1,41 @@
+#ifndef SYNTHETIC_CLIP_HPP
+#define SYNTHETIC_CLIP_HPP
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Description of a deterministic synthetic clip.
+ *
+ * Each scene has its own tile texture and brightness range; a textured square (the "key"
+ * object) moves by (object_dx, object_dy) per frame and stops for the last static_frames
+ * frames of every scene. The same spec and seed always produce the same pixels.
+ */
+struct SyntheticClipSpec {
+	int width = 384;                              ///< Frame width.
+	int height = 384;                             ///< Frame height.
+	std::vector<int> scene_lengths = { 24, 24, 24 };  ///< Frames per scene; a hard cut separates scenes.
+	int object_size = 96;                         ///< Side of the square object.
+	int object_dx = 3;                            ///< Horizontal object motion in pixels per frame.
+	int object_dy = 2;                            ///< Vertical object motion in pixels per frame.
+	int static_frames = 0;                        ///< Frames at the end of each scene in which nothing moves.
+	int object_class = 56;                        ///< Mask value of the object in the ground-truth masks.
+	uint32_t seed = 1;                            ///< Texture seed.
+};
+
+/**
+ * @brief Frames plus ground truth of a synthetic clip.
+ */
+struct SyntheticClip {
+	std::vector<cv::Mat> frames;   ///< CV_8UC3 frames.
+	std::vector<cv::Mat> masks;    ///< CV_8UC1 ground-truth masks (object_class on the object, 0 elsewhere).
+	std::vector<int> cuts;         ///< Indices of the first frame of every scene after the first.
+};
+
+/**
+ * @brief Generates the clip described by spec.
+ */
+SyntheticClip make_synthetic_clip(const SyntheticClipSpec& spec);
+
+#endif // SYNTHETIC_CLIP_HPP
@@ -8,18 +8,66 @@
 
 #include "TRTInference.hpp"
 #include "ImageProcessingUtil.hpp"
+#include "GlowClasses.hpp"
 #include "nvToolsExt.h"
 #include "helper_cuda.h"  // For checkCudaErrors
 #include <future>
 #include <thread>
 #include <mutex>
 #include <iterator>
+#include <map>
+#include <atomic>
+#include <cfloat>
 #include "segmentation_kernels.h"
+#include "Profiler.hpp"
+#include "LatencyHistogram.hpp"
+#include "movie_effect/include/tools_task.h"
 
- // Add these external variable declarations
-extern int param_KeyLevel;  // Defined in control_gui.cpp
-extern int param_KeyScale;  // Defined in control_gui.cpp 
-extern int default_scale;   // Defined in control_gui.cpp
+//--------------------------------------------------------------------------
+// CPU argmax over the class dimension
+//--------------------------------------------------------------------------
+// Turns [batch, num_classes, height, width] logits into one CV_8UC1 mask per image
+// (class index * kClassLevelStep, first maximum wins like argmaxKernel). The rows of all images
+// are split into bands on the shared task scheduler; within a row the classes are
+// walked in the outer loop so every read stays contiguous. As in argmaxKernel the running
+// maximum starts at -FLT_MAX with class 0, so NaN and -inf logits never win.
+std::vector<cv::Mat> argmax_class_masks(const float* logits, int num_classes, int height, int width, int valid_count) {
+	PROFILE_ZONE("argmax");
+	const int scale = kClassLevelStep;
+	const size_t plane = static_cast<size_t>(height) * width;
+
+	std::vector<cv::Mat> masks(valid_count);
+	for (int b = 0; b < valid_count; ++b)
+		masks[b].create(height, width, CV_8UC1);
+
+	task::parallel_rows(valid_count * height, [&](int row_begin, int row_end) {
+		std::vector<float> best_val(width);
+		std::vector<uchar> best_idx(width);
+		for (int r = row_begin; r < row_end; ++r) {
+			const int b = r / height;
+			const int y = r % height;
+			const float* row = logits + b * num_classes * plane + static_cast<size_t>(y) * width;
+
+			std::fill(best_val.begin(), best_val.end(), -FLT_MAX);
+			std::fill(best_idx.begin(), best_idx.end(), 0);
+			for (int c = 0; c < num_classes; ++c) {
+				const float* class_row = row + c * plane;
+				for (int x = 0; x < width; ++x) {
+					if (class_row[x] > best_val[x]) {
+						best_val[x] = class_row[x];
+						best_idx[x] = static_cast<uchar>(c);
+					}
+				}
+			}
+
+			uchar* dst = masks[b].ptr<uchar>(y);
+			for (int x = 0; x < width; ++x)
+				dst[x] = static_cast<uchar>(best_idx[x] * scale);
+		}
+	}, 8);
+
+	return masks;
+}
 
  //--------------------------------------------------------------------------
  // Measure Segmentation Inference (Single Image)
@@ -276,31 +324,38 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul(cons
 		bindings.push_back(d_output);
 	}
 
-	vector<float> latencies;
-	cudaEvent_t start, stop;
-	cudaEventCreate(&start);
-	cudaEventCreate(&stop);
+	// One event pair per trial, so the spread of the trials is measured and not only their mean.
+	std::vector<cudaEvent_t> trial_start(num_trials), trial_stop(num_trials);
+	for (int i = 0; i < num_trials; ++i) {
+		cudaEventCreate(&trial_start[i]);
+		cudaEventCreate(&trial_stop[i]);
+	}
 
 	for (int i = 0; i < 10; ++i) {
 		context->enqueueV2(bindings.data(), stream, nullptr);
 	}
 
-	cudaEventRecord(start, stream);
 	for (int i = 0; i < num_trials; ++i) {
 		char str_buf[100];
 		std::sprintf(str_buf, "frame%03d", i);
 		nvtxRangePushA(str_buf);
+		cudaEventRecord(trial_start[i], stream);
 		if (!context->enqueueV2(bindings.data(), stream, nullptr)) {
 			cerr << "TensorRT enqueueV2 failed!" << endl;
 			exit(EXIT_FAILURE);
 		}
+		cudaEventRecord(trial_stop[i], stream);
 		nvtxRangePop();
 	}
-	cudaEventRecord(stop, stream);
-	cudaEventSynchronize(stop);
-	float milliseconds = 0;
-	cudaEventElapsedTime(&milliseconds, start, stop);
-	latencies.push_back(milliseconds);
+	cudaStreamSynchronize(stream);
+	LatencyHistogram trial_latency;
+	for (int i = 0; i < num_trials; ++i) {
+		float milliseconds = 0;
+		cudaEventElapsedTime(&milliseconds, trial_start[i], trial_stop[i]);
+		trial_latency.record_ms(milliseconds);
+		cudaEventDestroy(trial_start[i]);
+		cudaEventDestroy(trial_stop[i]);
+	}
 
 	float* last_h_output = h_outputs.back();
 	int last_output_size = outputDims.d[0] * outputDims.d[1] * outputDims.d[2] * outputDims.d[3];
@@ -312,10 +367,9 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul(cons
 	float avg_val = std::accumulate(last_h_output, last_h_output + last_output_size, 0.0f) / last_output_size;
 	cout << "Last Output Tensor - Min: " << min_val << ", Max: " << max_val << ", Avg: " << avg_val << endl;
 
-	float average_latency = std::accumulate(latencies.begin(), latencies.end(), 0.0f) / num_trials;
-	cout << "TRT - Average Latency over " << num_trials << " trials: " << average_latency << " ms" << endl;
-	cudaEventDestroy(start);
-	cudaEventDestroy(stop);
+	cout << "TRT - Average Latency over " << num_trials << " trials: " << trial_latency.mean_ms() << " ms" << endl;
+	cout << "TRT - Latency p50 " << trial_latency.percentile_ms(50.0) << " ms, p90 " << trial_latency.percentile_ms(90.0)
+		<< " ms, p99 " << trial_latency.percentile_ms(99.0) << " ms, max " << trial_latency.max_ms() << " ms" << endl;
 
 	int batch = outputDims.d[0];
 	int num_classes = outputDims.d[1];
@@ -329,16 +383,7 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul(cons
 	}
 	cout << std::endl;
 
-	auto max_out = torch::max(last_output_tensor, 1);
-	auto class_labels = std::get<1>(max_out);
-	int scale = 255 / 21;
-	auto image_post = class_labels * scale;
-
-	for (int i = 0; i < batch; ++i) {
-		auto single_image_post = image_post[i].squeeze().to(torch::kU8);
-		cv::Mat cv_img(single_image_post.size(0), single_image_post.size(1), CV_8UC1, single_image_post.data_ptr<uchar>());
-		grayscale_images.push_back(cv_img.clone());
-	}
+	grayscale_images = argmax_class_masks(last_h_output, num_classes, height, width, batch);
 
 	cudaFreeHost(h_input);
 	for (float* h_output : h_outputs) {
@@ -360,18 +405,14 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul(cons
 // New Function: Measure Segmentation Inference (Batch) Concurrent Version
 //--------------------------------------------------------------------------
 std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_concurrent(
-	const std::string& trt_plan, torch::Tensor img_tensor_batch, int num_trials) {
+	const std::string& trt_plan, torch::Tensor img_tensor_batch, int num_trials, int num_contexts) {
 
 	std::cout << "STARTING measure_segmentation_trt_performance_mul_concurrent (multi-stream concurrent version)" << std::endl;
 
 	// -----------------------------
-	// Create TensorRT runtime and deserialize the engine from the plan file.
+	// Engine of the plan file, deserialized once per process (see acquire_engine).
 	// -----------------------------
-	TRTGeneration::CustomLogger myLogger;
-	IRuntime* runtime = createInferRuntime(myLogger);
-	ifstream planFile(trt_plan, ios::binary);
-	vector<char> plan((istreambuf_iterator<char>(planFile)), istreambuf_iterator<char>());
-	ICudaEngine* engine = runtime->deserializeCudaEngine(plan.data(), plan.size());
+	std::shared_ptr<ICudaEngine> engine = acquire_engine(trt_plan);
 	if (!engine) {
 		std::cerr << "Failed to deserialize engine in concurrent segmentation." << std::endl;
 		exit(EXIT_FAILURE);
@@ -381,21 +422,26 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 	// Determine batch and thread parameters.
 	// -----------------------------
 	int totalBatch = img_tensor_batch.size(0);  // Total number of images.
-	int numThreads = 2;                           // Fixed number of threads.
+	int numThreads = std::max(1, num_contexts);   // One sub-batch task per execution context.
+	BatchBounds bounds = get_engine_batch_bounds(engine.get());
+	int padBatch = bounds.dynamic ? bounds.min_batch : bounds.max_batch;  // Smallest batch the engine accepts.
+	// A short (tail) batch on a fixed-shape engine uses only as many contexts as it fills.
+	if (!bounds.dynamic)
+		numThreads = std::min(numThreads, (totalBatch + padBatch - 1) / padBatch);
 	int subBatch = (totalBatch + numThreads - 1) / numThreads;  // Images per thread.
 
 	// allResults will store the segmentation output for each image.
 	std::vector<cv::Mat> allResults(totalBatch);
 	std::mutex resultMutex;  // Mutex to protect shared results vector.
-	std::vector<std::thread> threads;
+	task::group workers;
 
 	// -----------------------------
-	// Launch threads to process sub-batches concurrently.
+	// Launch sub-batch tasks on the shared scheduler.
 	// -----------------------------
 	for (int t = 0; t < numThreads; ++t) {
-		threads.emplace_back([&, t]() {
-			// Create execution context for this thread.
-			IExecutionContext* context = engine->createExecutionContext();
+		workers.run([&, t]() {
+			// Execution context for this thread, back to the engine's pool when the task ends.
+			std::shared_ptr<IExecutionContext> context = acquire_context(trt_plan);
 			if (!context) {
 				std::cerr << "Failed to create execution context for thread " << t << std::endl;
 				return;
@@ -422,29 +468,33 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 			{
 				subTensor = subTensor.squeeze(1);
 			}
-			// Pad the sub-batch to have exactly 4 images if needed.
-			if (subTensor.size(0) < 4) {
-				int pad = 4 - subTensor.size(0);
-				torch::Tensor lastFrame = subTensor[subTensor.size(0) - 1].unsqueeze(0);
-				torch::Tensor padTensor = lastFrame.repeat({ pad, 1, 1, 1 });
-				subTensor = torch::cat({ subTensor, padTensor }, 0);
-			}
+			subTensor = subTensor.contiguous();
+			// Dynamic engines run the real sub-batch; a fixed-shape engine still needs padBatch
+			// images, so the missing slots are zero-filled on the device only.
+			int inferBatch = std::max(validCount, padBatch);
 
 			// -----------------------------
 			// Allocate host and device memory for input data.
 			// -----------------------------
-			int inputSize = subTensor.numel();
+			int validInputSize = subTensor.numel();
+			int inputSize = (validInputSize / validCount) * inferBatch;
 			float* h_input = nullptr;
-			checkCudaErrors(cudaMallocHost((void**)&h_input, inputSize * sizeof(float)));
-			std::memcpy(h_input, subTensor.data_ptr<float>(), inputSize * sizeof(float));
-
 			void* d_input = nullptr;
-			checkCudaErrors(cudaMalloc(&d_input, inputSize * sizeof(float)));
-			checkCudaErrors(cudaMemcpyAsync(d_input, h_input, inputSize * sizeof(float), cudaMemcpyHostToDevice, stream));
+			{
+				PROFILE_ZONE("preprocess");
+				checkCudaErrors(cudaMallocHost((void**)&h_input, validInputSize * sizeof(float)));
+				std::memcpy(h_input, subTensor.data_ptr<float>(), validInputSize * sizeof(float));
+
+				checkCudaErrors(cudaMalloc(&d_input, inputSize * sizeof(float)));
+				checkCudaErrors(cudaMemcpyAsync(d_input, h_input, validInputSize * sizeof(float), cudaMemcpyHostToDevice, stream));
+				if (inputSize > validInputSize)
+					checkCudaErrors(cudaMemsetAsync(static_cast<float*>(d_input) + validInputSize, 0,
+						(inputSize - validInputSize) * sizeof(float), stream));
+			}
 
 			// Set input dimensions for the context.
 			nvinfer1::Dims4 inputDims;
-			inputDims.d[0] = subTensor.size(0);
+			inputDims.d[0] = inferBatch;
 			inputDims.d[1] = subTensor.size(1);
 			inputDims.d[2] = subTensor.size(2);
 			inputDims.d[3] = subTensor.size(3);
@@ -478,47 +528,40 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 				bindings.push_back(d_output);
 			}
 
-			// -----------------------------
-			// Perform optional warm-up runs.
-			// -----------------------------
-			for (int i = 0; i < 3; ++i) {
-				context->enqueueV2(bindings.data(), stream, nullptr);
-			}
+			int outSize = validCount * outputDims.d[1] * outputDims.d[2] * outputDims.d[3];
+			float* lastOutput = h_outputs.back();
+			{
+				// Asynchronous copies complete within this zone, so it includes the transfers.
+				PROFILE_ZONE("inference");
+
+				// -----------------------------
+				// Perform optional warm-up runs.
+				// -----------------------------
+				for (int i = 0; i < 3; ++i) {
+					context->enqueueV2(bindings.data(), stream, nullptr);
+				}
 
-			// -----------------------------
-			// Enqueue inference and check for errors.
-			// -----------------------------
-			if (!context->enqueueV2(bindings.data(), stream, nullptr)) {
-				std::cerr << "TensorRT enqueueV2 failed in thread " << t << std::endl;
-				exit(EXIT_FAILURE);
-			}
+				// -----------------------------
+				// Enqueue inference and check for errors.
+				// -----------------------------
+				if (!context->enqueueV2(bindings.data(), stream, nullptr)) {
+					std::cerr << "TensorRT enqueueV2 failed in thread " << t << std::endl;
+					exit(EXIT_FAILURE);
+				}
 
-			// -----------------------------
-			// Copy inference results from device to host.
-			// -----------------------------
-			int outSize = outputDims.d[0] * outputDims.d[1] * outputDims.d[2] * outputDims.d[3];
-			float* lastOutput = h_outputs.back();
-			checkCudaErrors(cudaMemcpyAsync(lastOutput, d_outputs.back(), outSize * sizeof(float), cudaMemcpyDeviceToHost, stream));
-			cudaStreamSynchronize(stream);  // Ensure all operations complete.
+				// -----------------------------
+				// Copy inference results of the real images from device to host.
+				// -----------------------------
+				checkCudaErrors(cudaMemcpyAsync(lastOutput, d_outputs.back(), outSize * sizeof(float), cudaMemcpyDeviceToHost, stream));
+				cudaStreamSynchronize(stream);  // Ensure all operations complete.
+			}
 
 			// -----------------------------
 			// Post-process the output tensor.
 			// -----------------------------
-			auto outputTensor = torch::from_blob(lastOutput, { outputDims.d[0], outputDims.d[1], outputDims.d[2], outputDims.d[3] }, torch::kFloat32);
-			auto maxOut = torch::max(outputTensor, 1);  // Find maximum values along the channel dimension.
-			auto segMask = std::get<1>(maxOut);  // Expected shape: [4, H, W], where each element is the class index.
-			int scaleFactor = 255 / 21;  // Scale factor to map class indices to an 8-bit range.
-			auto imagePost = segMask * scaleFactor;
-
-			// -----------------------------
-			// Convert tensor outputs to cv::Mat and handle padded outputs.
-			// -----------------------------
-			std::vector<cv::Mat> localResults;
-			for (int i = 0; i < validCount; ++i) {
-				auto single = imagePost[i].to(torch::kU8);  // Convert to unsigned 8-bit.
-				cv::Mat result(single.size(0), single.size(1), CV_8UC1, single.data_ptr<uchar>());
-				localResults.push_back(result.clone());
-			}
+			// Argmax over the class dimension, only for the valid (non-padded) images.
+			std::vector<cv::Mat> localResults = argmax_class_masks(
+				lastOutput, outputDims.d[1], outputDims.d[2], outputDims.d[3], validCount);
 
 			// -----------------------------
 			// Safely update the global results vector.
@@ -531,7 +574,7 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 			}
 
 			// -----------------------------
-			// Free allocated host and device memory, destroy CUDA stream and context.
+			// Free allocated host and device memory and destroy the CUDA stream.
 			// -----------------------------
 			cudaFreeHost(h_input);
 			cudaFree(d_input);
@@ -542,17 +585,11 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 				cudaFree(dptr);
 			}
 			cudaStreamDestroy(stream);
-			context->destroy();
 			});
 	}
 
-	// Wait for all threads to complete execution.
-	for (auto& t : threads)
-		t.join();
-
-	// Destroy the engine and runtime to free resources.
-	engine->destroy();
-	runtime->destroy();
+	// Wait for all sub-batch tasks to complete execution.
+	workers.wait();
 
 	return allResults;
 }
@@ -560,23 +597,12 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 //--------------------------------------------------------------------------
 // Concurrent Segmentation with CUDA Graph
 //--------------------------------------------------------------------------
-std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_concurrent_graph(const std::string& trt_plan, torch::Tensor img_tensor_batch, int num_trials) {
+std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_concurrent_graph(const std::string& trt_plan, torch::Tensor img_tensor_batch, int num_trials, int num_contexts) {
 
 	std::cout << "STARTING measure_segmentation_trt_performance_mul_concurrent_graph (Hybrid CUDA Graph approach)" << std::endl;
 
-	// Create TensorRT runtime and deserialize the engine
-	TRTGeneration::CustomLogger myLogger;
-	IRuntime* runtime = createInferRuntime(myLogger);
-	ifstream planFile(trt_plan, ios::binary);
-	vector<char> plan((istreambuf_iterator<char>(planFile)), istreambuf_iterator<char>());
-	std::cout << "Loaded engine size: " << plan.size() / (1024 * 1024) << " MiB" << std::endl;
-
-	auto start_time = std::chrono::high_resolution_clock::now();
-	ICudaEngine* engine = runtime->deserializeCudaEngine(plan.data(), plan.size());
-	auto end_time = std::chrono::high_resolution_clock::now();
-	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-	std::cout << "Deserialization required " << duration.count() << " microseconds." << std::endl;
-
+	// Engine of the plan file, deserialized once per process (see acquire_engine)
+	std::shared_ptr<ICudaEngine> engine = acquire_engine(trt_plan);
 	if (!engine) {
 		std::cerr << "Failed to deserialize engine in graph segmentation." << std::endl;
 		exit(EXIT_FAILURE);
@@ -584,17 +610,21 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 
 	// Setup for multi-threaded processing
 	int totalBatch = img_tensor_batch.size(0);
-	int numThreads = 2;
+	int numThreads = std::max(1, num_contexts);
+	BatchBounds bounds = get_engine_batch_bounds(engine.get());
+	int padBatch = bounds.dynamic ? bounds.min_batch : bounds.max_batch;
+	if (!bounds.dynamic)
+		numThreads = std::min(numThreads, (totalBatch + padBatch - 1) / padBatch);
 	int subBatch = (totalBatch + numThreads - 1) / numThreads;
 	std::vector<cv::Mat> allResults(totalBatch);
 	std::mutex resultMutex;
-	std::vector<std::thread> threads;
+	task::group workers;
 
-	// Launch threads to process sub-batches concurrently
+	// Launch sub-batch tasks on the shared scheduler
 	for (int t = 0; t < numThreads; ++t) {
-		threads.emplace_back([&, t]() {
-			// Create execution context for this thread
-			IExecutionContext* context = engine->createExecutionContext();
+		workers.run([&, t]() {
+			// Execution context for this thread, back to the engine's pool when the task ends
+			std::shared_ptr<IExecutionContext> context = acquire_context(trt_plan);
 			if (!context) {
 				std::cerr << "Failed to create execution context for thread " << t << std::endl;
 				return;
@@ -623,31 +653,31 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 				subTensor = subTensor.squeeze(1);
 			}
 
-			// Pad the sub-batch to have exactly 4 images if needed
-			if (subTensor.size(0) < 4) {
-				int pad = 4 - subTensor.size(0);
-				torch::Tensor lastFrame = subTensor[subTensor.size(0) - 1].unsqueeze(0);
-				torch::Tensor padTensor = lastFrame.repeat({ pad, 1, 1, 1 });
-				subTensor = torch::cat({ subTensor, padTensor }, 0);
-			}
+			subTensor = subTensor.contiguous();
+			// Real sub-batch for dynamic engines; fixed-shape engines get zero-filled device slots
+			int inferBatch = std::max(validCount, padBatch);
 
 			// Set input dimensions
 			nvinfer1::Dims4 inputDims;
-			inputDims.d[0] = subTensor.size(0);
+			inputDims.d[0] = inferBatch;
 			inputDims.d[1] = subTensor.size(1);
 			inputDims.d[2] = subTensor.size(2);
 			inputDims.d[3] = subTensor.size(3);
 			context->setBindingDimensions(0, inputDims);
 
 			// Allocate memory for input and output
-			int inputSize = subTensor.numel();
+			int validInputSize = subTensor.numel();
+			int inputSize = (validInputSize / validCount) * inferBatch;
 			float* h_input = nullptr;
 			void* d_input = nullptr;
-			checkCudaErrors(cudaMallocHost((void**)&h_input, inputSize * sizeof(float)));
+			checkCudaErrors(cudaMallocHost((void**)&h_input, validInputSize * sizeof(float)));
 			checkCudaErrors(cudaMalloc(&d_input, inputSize * sizeof(float)));
 
 			// Copy input data to host pinned memory
-			std::memcpy(h_input, subTensor.data_ptr<float>(), inputSize * sizeof(float));
+			{
+				PROFILE_ZONE("preprocess");
+				std::memcpy(h_input, subTensor.data_ptr<float>(), validInputSize * sizeof(float));
+			}
 
 			// Setup bindings and allocate output memory
 			std::vector<void*> bindings;
@@ -675,17 +705,23 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 				bindings.push_back(d_output);
 			}
 
-			// Allocate device memory for post-processing
-			int batch = outputDims.d[0];
+			// Allocate device memory for post-processing; padded slots are never post-processed
+			int batch = validCount;
 			int height = outputDims.d[2];
 			int width = outputDims.d[3];
 			unsigned char* d_argmax_output = nullptr;
 			checkCudaErrors(cudaMalloc(&d_argmax_output, batch * height * width * sizeof(unsigned char)));
 
 			// Pre-processing: Copy input from host to device (not part of the graph)
-			checkCudaErrors(cudaMemcpyAsync(d_input, h_input, inputSize * sizeof(float),
-				cudaMemcpyHostToDevice, preStream));
-			checkCudaErrors(cudaStreamSynchronize(preStream));
+			{
+				PROFILE_ZONE("preprocess");
+				checkCudaErrors(cudaMemcpyAsync(d_input, h_input, validInputSize * sizeof(float),
+					cudaMemcpyHostToDevice, preStream));
+				if (inputSize > validInputSize)
+					checkCudaErrors(cudaMemsetAsync(static_cast<float*>(d_input) + validInputSize, 0,
+						(inputSize - validInputSize) * sizeof(float), preStream));
+				checkCudaErrors(cudaStreamSynchronize(preStream));
+			}
 
 			// Setup timing
 			cudaEvent_t start, stop;
@@ -755,42 +791,49 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 			cudaEventRecord(start, inferStream);
 
 			// For TensorRT inference, we always use regular execution since it's not compatible with graph capture
-			if (!context->enqueueV2(bindings.data(), inferStream, nullptr)) {
-				std::cerr << "TensorRT enqueueV2 failed" << std::endl;
-				goto cleanup; // Jump to resource cleanup
+			// (zones are scoped so that goto cleanup never jumps over one)
+			{
+				PROFILE_ZONE("inference");
+				if (!context->enqueueV2(bindings.data(), inferStream, nullptr)) {
+					std::cerr << "TensorRT enqueueV2 failed" << std::endl;
+					goto cleanup; // Jump to resource cleanup
+				}
+				checkCudaErrors(cudaStreamSynchronize(inferStream));
 			}
-			checkCudaErrors(cudaStreamSynchronize(inferStream));
 
-			// Execute post-processing (either with graph or regular method)
-			if (useGraph && postprocessGraphExec) {
-				checkCudaErrors(cudaGraphLaunch(postprocessGraphExec, postStream));
-				checkCudaErrors(cudaStreamSynchronize(postStream));
-			}
-			else {
-				// Fall back to regular kernel launch if graph capture failed
-				launchArgmaxKernel(
-					static_cast<float*>(d_outputs.back()),
+			{
+				PROFILE_ZONE("argmax");
+				// Execute post-processing (either with graph or regular method)
+				if (useGraph && postprocessGraphExec) {
+					checkCudaErrors(cudaGraphLaunch(postprocessGraphExec, postStream));
+					checkCudaErrors(cudaStreamSynchronize(postStream));
+				}
+				else {
+					// Fall back to regular kernel launch if graph capture failed
+					launchArgmaxKernel(
+						static_cast<float*>(d_outputs.back()),
+						d_argmax_output,
+						batch,
+						outputDims.d[1], // num_classes
+						height,
+						width,
+						postStream
+					);
+					checkCudaErrors(cudaStreamSynchronize(postStream));
+				}
+
+				// Copy results from device to host
+				h_argmax_output = new unsigned char[batch * height * width];
+				checkCudaErrors(cudaMemcpyAsync(
+					h_argmax_output,
 					d_argmax_output,
-					batch,
-					outputDims.d[1], // num_classes
-					height,
-					width,
+					batch * height * width * sizeof(unsigned char),
+					cudaMemcpyDeviceToHost,
 					postStream
-				);
+				));
 				checkCudaErrors(cudaStreamSynchronize(postStream));
 			}
 
-			// Copy results from device to host
-			h_argmax_output = new unsigned char[batch * height * width];
-			checkCudaErrors(cudaMemcpyAsync(
-				h_argmax_output,
-				d_argmax_output,
-				batch * height * width * sizeof(unsigned char),
-				cudaMemcpyDeviceToHost,
-				postStream
-			));
-			checkCudaErrors(cudaStreamSynchronize(postStream));
-
 			cudaEventRecord(stop, inferStream);
 			checkCudaErrors(cudaStreamSynchronize(inferStream));
 
@@ -848,18 +891,11 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_mul_conc
 			cudaStreamDestroy(preStream);
 			cudaStreamDestroy(inferStream);
 			cudaStreamDestroy(postStream);
-			context->destroy();
 			});
 	}
 
-	// Wait for all threads to complete
-	for (auto& t : threads) {
-		t.join();
-	}
-
-	// Clean up global resources
-	engine->destroy();
-	runtime->destroy();
+	// Wait for all sub-batch tasks to complete
+	workers.wait();
 
 	return allResults;
 }
@@ -899,7 +935,7 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_single_b
 	// Results container
 	std::vector<cv::Mat> results(num_images);
 	std::mutex resultMutex;
-	std::vector<std::thread> threads;
+	task::group workers;
 
 	// Calculate images per worker thread
 	int images_per_thread = (num_images + num_streams - 1) / num_streams;
@@ -909,9 +945,9 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_single_b
 	std::vector<int> frames_processed(num_streams, 0);
 	std::vector<bool> graph_usage(num_streams, false);
 
-	// Launch parallel worker threads
+	// Launch parallel worker tasks on the shared scheduler
 	for (int t = 0; t < num_streams; ++t) {
-		threads.emplace_back([&, t]() {
+		workers.run([&, t]() {
 			// Calculate the range of images for this worker
 			int start_idx = t * images_per_thread;
 			int end_idx = std::min(start_idx + images_per_thread, num_images);
@@ -1272,10 +1308,8 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_single_b
 			});
 	}
 
-	// Wait for all worker threads to complete
-	for (auto& t : threads) {
-		t.join();
-	}
+	// Wait for all worker tasks to complete
+	workers.wait();
 
 	// Summarize performance statistics
 	std::cout << "\n=== Performance Summary ===" << std::endl;
@@ -1313,6 +1347,154 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_single_b
 	return results;
 }
 
+//--------------------------------------------------------------------------
+// Engine Registry
+//--------------------------------------------------------------------------
+// One runtime, and per plan file one engine with a pool of idle execution contexts. The
+// registry lives until the process exits: the runtime is never destroyed, since engines
+// handed out may outlive release_engines().
+namespace {
+	struct EngineEntry {
+		std::shared_ptr<ICudaEngine> engine;
+		std::mutex mutex;                        // guards idle
+		std::vector<IExecutionContext*> idle;
+
+		// Runs when the registry and the last context handed out have let go, also after
+		// release_engines(); the contexts go before the engine member releases its engine.
+		~EngineEntry() {
+			for (IExecutionContext* context : idle)
+				context->destroy();
+		}
+	};
+
+	struct EngineRegistry {
+		TRTGeneration::CustomLogger logger;
+		IRuntime* runtime = nullptr;
+		std::mutex mutex;                        // guards runtime and entries
+		std::map<std::string, std::shared_ptr<EngineEntry>> entries;
+		std::atomic<uint64_t> engines_loaded{ 0 };
+		std::atomic<uint64_t> contexts_created{ 0 };
+		std::atomic<uint64_t> contexts_reused{ 0 };
+	};
+
+	EngineRegistry& engine_registry() {
+		static EngineRegistry* registry = new EngineRegistry();
+		return *registry;
+	}
+
+	// Entry of a plan, deserializing it on first use. Concurrent first uses wait for one load.
+	std::shared_ptr<EngineEntry> engine_entry(const std::string& trt_plan) {
+		EngineRegistry& registry = engine_registry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		auto it = registry.entries.find(trt_plan);
+		if (it != registry.entries.end())
+			return it->second;
+
+		if (!registry.runtime)
+			registry.runtime = createInferRuntime(registry.logger);
+		ifstream planFile(trt_plan, ios::binary);
+		vector<char> plan((istreambuf_iterator<char>(planFile)), istreambuf_iterator<char>());
+		auto start_time = std::chrono::high_resolution_clock::now();
+		ICudaEngine* engine = plan.empty() ? nullptr : registry.runtime->deserializeCudaEngine(plan.data(), plan.size());
+		if (!engine)
+			return nullptr;
+		auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start_time);
+		std::cout << "Engine registry: loaded " << trt_plan << " (" << plan.size() / (1024 * 1024) << " MiB) in "
+			<< duration.count() << " microseconds." << std::endl;
+
+		auto entry = std::make_shared<EngineEntry>();
+		entry->engine = std::shared_ptr<ICudaEngine>(engine, [](ICudaEngine* e) { e->destroy(); });
+		registry.entries[trt_plan] = entry;
+		++registry.engines_loaded;
+		return entry;
+	}
+}
+
+std::shared_ptr<ICudaEngine> TRTInference::acquire_engine(const std::string& trt_plan) {
+	std::shared_ptr<EngineEntry> entry = engine_entry(trt_plan);
+	return entry ? entry->engine : nullptr;
+}
+
+std::shared_ptr<IExecutionContext> TRTInference::acquire_context(const std::string& trt_plan) {
+	std::shared_ptr<EngineEntry> entry = engine_entry(trt_plan);
+	if (!entry)
+		return nullptr;
+	EngineRegistry& registry = engine_registry();
+	IExecutionContext* context = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(entry->mutex);
+		if (!entry->idle.empty()) {
+			context = entry->idle.back();
+			entry->idle.pop_back();
+		}
+	}
+	if (context) {
+		++registry.contexts_reused;
+	}
+	else {
+		context = entry->engine->createExecutionContext();
+		if (!context)
+			return nullptr;
+		++registry.contexts_created;
+	}
+	// The deleter keeps the entry (and its engine) alive until the context is back in the pool.
+	return std::shared_ptr<IExecutionContext>(context, [entry](IExecutionContext* c) {
+		std::lock_guard<std::mutex> lock(entry->mutex);
+		entry->idle.push_back(c);
+	});
+}
+
+void TRTInference::release_engines() {
+	EngineRegistry& registry = engine_registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	// An entry whose contexts are all idle goes now; one with contexts in use goes with the last of them.
+	registry.entries.clear();
+}
+
+EngineRegistryStats TRTInference::engine_registry_stats() {
+	EngineRegistry& registry = engine_registry();
+	EngineRegistryStats stats;
+	stats.engines_loaded = registry.engines_loaded;
+	stats.contexts_created = registry.contexts_created;
+	stats.contexts_reused = registry.contexts_reused;
+	return stats;
+}
+
+//--------------------------------------------------------------------------
+// Engine Batch Bounds
+//--------------------------------------------------------------------------
+BatchBounds TRTInference::get_engine_batch_bounds(nvinfer1::ICudaEngine* engine, int max_contexts) {
+	BatchBounds bounds;
+	bounds.max_contexts = std::max(1, max_contexts);
+	if (!engine)
+		return bounds;
+
+	nvinfer1::Dims dims = engine->getBindingDimensions(0);
+	if (dims.nbDims > 0 && dims.d[0] >= 0) {
+		// Fixed-shape engine: every context takes exactly the built batch.
+		bounds.min_batch = bounds.opt_batch = bounds.max_batch = std::max(1, dims.d[0]);
+		return bounds;
+	}
+
+	// Dynamic batch: use the limits of optimization profile 0.
+	bounds.dynamic = true;
+	bounds.min_batch = std::max(1, engine->getProfileDimensions(0, 0, nvinfer1::OptProfileSelector::kMIN).d[0]);
+	bounds.opt_batch = std::max(1, engine->getProfileDimensions(0, 0, nvinfer1::OptProfileSelector::kOPT).d[0]);
+	bounds.max_batch = std::max(bounds.min_batch, engine->getProfileDimensions(0, 0, nvinfer1::OptProfileSelector::kMAX).d[0]);
+	return bounds;
+}
+
+BatchBounds TRTInference::get_engine_batch_bounds(const std::string& trt_plan, int max_contexts) {
+	std::shared_ptr<ICudaEngine> engine = acquire_engine(trt_plan);
+	if (!engine) {
+		std::cerr << "Failed to deserialize engine while reading batch bounds." << std::endl;
+		BatchBounds bounds;
+		bounds.max_contexts = std::max(1, max_contexts);
+		return bounds;
+	}
+	return get_engine_batch_bounds(engine.get(), max_contexts);
+}
+
 //--------------------------------------------------------------------------
 // Measure Super-Resolution Inference
 //--------------------------------------------------------------------------
@@ -1477,7 +1659,7 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_single_b
 	// Results container
 	std::vector<cv::Mat> results(num_images);
 	std::mutex resultMutex;
-	std::vector<std::thread> threads;
+	task::group workers;
 
 	// Calculate images per worker thread
 	int images_per_thread = (num_images + num_streams - 1) / num_streams;
@@ -1487,9 +1669,9 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_single_b
 	std::vector<int> frames_processed(num_streams, 0);
 	std::vector<bool> graph_usage(num_streams, false);
 
-	// Launch parallel worker threads
+	// Launch parallel worker tasks on the shared scheduler
 	for (int t = 0; t < num_streams; ++t) {
-		threads.emplace_back([&, t]() {
+		workers.run([&, t]() {
 			// Calculate the range of images for this worker
 			int start_idx = t * images_per_thread;
 			int end_idx = std::min(start_idx + images_per_thread, num_images);
@@ -1850,10 +2032,8 @@ std::vector<cv::Mat> TRTInference::measure_segmentation_trt_performance_single_b
 			});
 	}
 
-	// Wait for all worker threads to complete
-	for (auto& t : threads) {
-		t.join();
-	}
+	// Wait for all worker tasks to complete
+	workers.wait();
 
 	// Summarize performance statistics
 	std::cout << "\n=== Performance Summary ===" << std::endl;
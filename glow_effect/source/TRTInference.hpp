@@ -22,6 +22,7 @@
 #include <future>       // for std::async, std::future
 #include <thread>       // for std::thread
 #include <mutex>        // for std::mutex
+#include <memory>       // for std::shared_ptr
 
 // Using declarations for brevity.
 using namespace std;
@@ -30,6 +31,16 @@ using namespace nvonnxparser;
 
 #include "TRTGeneration.hpp"
 #include "ImageProcessingUtil.hpp"
+#include "AdaptiveBatcher.hpp"
+
+/**
+ * @brief Counters of the engine registry (TRTInference::acquire_engine / acquire_context).
+ */
+struct EngineRegistryStats {
+	uint64_t engines_loaded = 0;     ///< Plans deserialized.
+	uint64_t contexts_created = 0;   ///< Execution contexts created.
+	uint64_t contexts_reused = 0;    ///< Execution contexts handed out again from the pool.
+};
 
 /**
  * @brief A class providing TensorRT inference routines for segmentation and super-resolution.
@@ -81,13 +92,16 @@ public:
 	 * This function splits the input batch into sub-batches and processes each sub-batch on its own
 	 * non-blocking CUDA stream and execution context. Pinned memory is used for fast host-device transfers.
 	 * The segmentation results from all sub-batches are merged and returned as a vector of OpenCV Mats.
+	 * Dynamic-shape engines run each sub-batch at its real size; for fixed-shape engines a short sub-batch
+	 * is zero-padded in device memory only, and padded slots are never copied back or post-processed.
 	 *
 	 * @param trt_plan         Path to the serialized TensorRT engine plan file.
 	 * @param img_tensor_batch A 4D tensor (NCHW) containing batched preprocessed images.
 	 * @param num_trials       Number of inference runs for warm-up.
+	 * @param num_contexts     Number of execution contexts (sub-batches) the batch is split across.
 	 * @return A vector of OpenCV Mats, each representing a grayscale segmentation map.
 	 */
-	static std::vector<cv::Mat> measure_segmentation_trt_performance_mul_concurrent(const std::string& trt_plan, torch::Tensor img_tensor_batch, int num_trials);
+	static std::vector<cv::Mat> measure_segmentation_trt_performance_mul_concurrent(const std::string& trt_plan, torch::Tensor img_tensor_batch, int num_trials, int num_contexts = 2);
 
 	/**
 	 * @brief Performs segmentation inference on a batch of images with CUDA Graph acceleration where possible.
@@ -104,9 +118,58 @@ public:
 	 * @param trt_plan         Path to the serialized TensorRT engine plan file.
 	 * @param img_tensor_batch A 4D tensor (NCHW) containing batched preprocessed images.
 	 * @param num_trials       Number of inference runs for warm-up.
+	 * @param num_contexts     Number of execution contexts (sub-batches) the batch is split across.
 	 * @return A vector of OpenCV Mats, each representing a grayscale segmentation map.
 	 */
-	static std::vector<cv::Mat> measure_segmentation_trt_performance_mul_concurrent_graph(const std::string& trt_plan, torch::Tensor img_tensor_batch, int num_trials);
+	static std::vector<cv::Mat> measure_segmentation_trt_performance_mul_concurrent_graph(const std::string& trt_plan, torch::Tensor img_tensor_batch, int num_trials, int num_contexts = 2);
+
+	/**
+	 * @brief Reads the per-context batch limits of an engine.
+	 *
+	 * Fixed-shape engines report their built batch as min = opt = max; dynamic-shape engines
+	 * report the batch range of optimization profile 0.
+	 *
+	 * @param engine       Deserialized TensorRT engine.
+	 * @param max_contexts Upper limit of concurrent execution contexts the caller is willing to use.
+	 * @return Bounds for AdaptiveBatcher.
+	 */
+	static BatchBounds get_engine_batch_bounds(nvinfer1::ICudaEngine* engine, int max_contexts = 4);
+
+	/**
+	 * @brief Same as above, for the engine of a plan file (see acquire_engine).
+	 */
+	static BatchBounds get_engine_batch_bounds(const std::string& trt_plan, int max_contexts = 4);
+
+	/**
+	 * @brief Engine of a plan file from the process-wide registry.
+	 *
+	 * The plan is deserialized on first use and the engine is kept until release_engines(), so
+	 * every batch of every video (and concurrent jobs on the same plan) shares one engine.
+	 *
+	 * @return nullptr if the plan cannot be read or deserialized.
+	 */
+	static std::shared_ptr<nvinfer1::ICudaEngine> acquire_engine(const std::string& trt_plan);
+
+	/**
+	 * @brief Execution context of the plan's engine, from a per-engine pool.
+	 *
+	 * Dropping the last copy of the pointer returns the context, with its activation memory,
+	 * to the pool instead of destroying it. Callers set the binding dimensions on every use.
+	 *
+	 * @return nullptr if the engine or a context cannot be created.
+	 */
+	static std::shared_ptr<nvinfer1::IExecutionContext> acquire_context(const std::string& trt_plan);
+
+	/**
+	 * @brief Drops the registry's engines and their pooled contexts. Contexts still in use are
+	 *        destroyed, before their engine, once the last of them is returned.
+	 */
+	static void release_engines();
+
+	/**
+	 * @brief Counters of the engine registry since start.
+	 */
+	static EngineRegistryStats engine_registry_stats();
 
 	/**
 	 * @brief Processes multiple images in parallel using a single-batch TRT model
@@ -150,4 +213,12 @@ public:
 		int num_streams);
 };
 
+/**
+ * @brief CPU argmax over the class dimension of [batch, num_classes, height, width] logits.
+ *
+ * @param valid_count Images of the batch to convert (a partial batch leaves the rest unused).
+ * @return One CV_8UC1 mask per image: class index * 255/21, the first maximum wins (as argmaxKernel).
+ */
+std::vector<cv::Mat> argmax_class_masks(const float* logits, int num_classes, int height, int width, int valid_count);
+
 #endif // TRT_INFERENCE_HPP
\ No newline at end of file
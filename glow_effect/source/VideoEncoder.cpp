@@ -0,0 +1,238 @@
+/**
+ * @file VideoEncoder.cpp
+ * @brief Writer thread that takes video encoding off the compositing loop.
+ */
+
+#include "VideoEncoder.hpp"
+#include "Profiler.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+//--------------------------------------------------------------------------
+// AsyncFrameEncoder
+//--------------------------------------------------------------------------
+AsyncFrameEncoder::AsyncFrameEncoder(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+AsyncFrameEncoder::~AsyncFrameEncoder() {
+	close();
+}
+
+bool AsyncFrameEncoder::open(const std::string& path, int fourcc, double fps, const cv::Size& size) {
+	if (is_open() || !writer.open(path, fourcc, fps, size))
+		return false;
+	start([this](const cv::Mat& bgr) {
+		writer.write(bgr);
+		return true;
+	});
+	return true;
+}
+
+void AsyncFrameEncoder::start(EncodeFrameFn encode_fn) {
+	if (is_open())
+		return;
+	encode = std::move(encode_fn);
+	closing = false;
+	thread = std::thread(&AsyncFrameEncoder::run, this);
+}
+
+bool AsyncFrameEncoder::push(cv::Mat frame) {
+	if (frame.channels() != 3)
+		to_encoder_frame(frame, frame);
+
+	auto wait_start = std::chrono::high_resolution_clock::now();
+	std::unique_lock<std::mutex> lock(mutex);
+	if (!thread.joinable() || closing) {
+		counters.rejected++;
+		return false;
+	}
+	if (queue.size() >= capacity) {
+		not_full.wait(lock, [&] { return queue.size() < capacity || closing; });
+		counters.wait_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - wait_start).count();
+		if (closing) {
+			counters.rejected++;
+			return false;
+		}
+	}
+	queue.push_back(std::move(frame));
+	counters.depth_sum += queue.size();
+	counters.max_depth = std::max(counters.max_depth, queue.size());
+	lock.unlock();
+	not_empty.notify_one();
+	return true;
+}
+
+size_t AsyncFrameEncoder::depth() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return queue.size();
+}
+
+FrameEncoderStats AsyncFrameEncoder::close() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+	}
+	not_empty.notify_all();
+	not_full.notify_all();
+	if (thread.joinable())
+		thread.join();
+	encode = nullptr;   // releases whatever a custom encode function owns
+	if (writer.isOpened())
+		writer.release();
+	return stats();
+}
+
+FrameEncoderStats AsyncFrameEncoder::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void AsyncFrameEncoder::report() const {
+	const FrameEncoderStats s = stats();
+	if (s.frames == 0)
+		return;
+	std::cout << "Encoder: " << s.frames << " frames, " << s.encode_ms / s.frames << " ms/frame (max "
+		<< s.max_encode_ms << " ms), queue depth " << static_cast<double>(s.depth_sum) / s.frames << " avg / "
+		<< s.max_depth << " max of " << capacity << ", compositing waited " << s.wait_ms << " ms" << std::endl;
+}
+
+void AsyncFrameEncoder::run() {
+	profiler_set_thread_name("encoder");
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		not_empty.wait(lock, [&] { return !queue.empty() || closing; });
+		if (queue.empty())
+			break;   // closing with nothing left to flush
+		cv::Mat frame = std::move(queue.front());
+		queue.pop_front();
+		lock.unlock();
+		not_full.notify_one();
+
+		auto encode_start = std::chrono::high_resolution_clock::now();
+		bool written = true;
+		try {
+			PROFILE_ZONE("encode");
+			written = encode(frame);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Error encoding frame: " << e.what() << std::endl;
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - encode_start).count();
+
+		lock.lock();
+		if (!written) {
+			std::cerr << "Error: The video output failed; " << queue.size() << " queued frame(s) dropped." << std::endl;
+			counters.failed = true;
+			counters.rejected += queue.size();
+			queue.clear();
+			closing = true;
+			not_full.notify_all();
+			break;
+		}
+		counters.frames++;
+		counters.encode_ms += ms;
+		counters.max_encode_ms = std::max(counters.max_encode_ms, ms);
+	}
+}
+
+//--------------------------------------------------------------------------
+// to_encoder_frame
+//--------------------------------------------------------------------------
+void to_encoder_frame(const cv::Mat& src, cv::Mat& dst) {
+	if (src.channels() == 4)
+		cv::cvtColor(src, dst, cv::COLOR_BGRA2BGR);
+	else if (src.channels() == 1)
+		cv::cvtColor(src, dst, cv::COLOR_GRAY2BGR);
+	else
+		dst = src;
+}
+
+//--------------------------------------------------------------------------
+// verify_frame_encoder
+//--------------------------------------------------------------------------
+bool verify_frame_encoder() {
+	// Frames carry their number in the first pixel; the encoder takes 3 ms per frame and the
+	// producer 3 ms of "compositing", so a serial loop takes about twice as long as an overlapped one.
+	const int frames = 60;
+	const size_t capacity = 4;
+	const auto work = std::chrono::milliseconds(3);
+	auto make_frame = [](int i) {
+		cv::Mat frame(8, 8, CV_8UC4, cv::Scalar(0, 0, 0, 255));
+		frame.at<cv::Vec4b>(0, 0) = cv::Vec4b(static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), 0, 255);
+		return frame;
+	};
+
+	// Serial baseline measured on this machine: sleep granularity varies too much for a nominal one.
+	auto serial_start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < frames; ++i) {
+		std::this_thread::sleep_for(work);
+		cv::Mat bgr;
+		to_encoder_frame(make_frame(i), bgr);
+		std::this_thread::sleep_for(work);
+	}
+	const double serial_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - serial_start).count();
+
+	std::vector<int> encoded;
+	bool layout_ok = true;
+	AsyncFrameEncoder encoder(capacity);
+	encoder.start([&](const cv::Mat& bgr) {
+		std::this_thread::sleep_for(work);
+		layout_ok = layout_ok && bgr.type() == CV_8UC3;
+		const cv::Vec3b p = bgr.at<cv::Vec3b>(0, 0);
+		encoded.push_back(p[0] | (p[1] << 8));
+		return true;
+	});
+	auto start = std::chrono::high_resolution_clock::now();
+	bool pushed = true;
+	for (int i = 0; i < frames; ++i) {
+		std::this_thread::sleep_for(work);
+		pushed = pushed && encoder.push(make_frame(i));
+	}
+	const FrameEncoderStats stats = encoder.close();
+	const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	bool ok = pushed && layout_ok && stats.frames == static_cast<uint64_t>(frames) &&
+		encoded.size() == static_cast<size_t>(frames) && stats.max_depth <= capacity;
+	for (int i = 0; ok && i < frames; ++i)
+		ok = encoded[i] == i;
+	// Overlap only has to beat the measured serial time clearly.
+	const bool overlap_ok = elapsed_ms < 0.8 * serial_ms;
+
+	// A stream stopped early ('q'): everything pushed before close() is flushed, later pushes are refused.
+	std::atomic<int> flushed{ 0 };
+	AsyncFrameEncoder stopped(capacity);
+	stopped.start([&](const cv::Mat&) {
+		std::this_thread::sleep_for(work);
+		flushed++;
+		return true;
+	});
+	for (int i = 0; i < 10; ++i)
+		stopped.push(make_frame(i));
+	const FrameEncoderStats stop_stats = stopped.close();
+	const bool flush_ok = flushed == 10 && stop_stats.frames == 10 && !stopped.push(make_frame(10)) &&
+		stopped.stats().rejected == 1;
+
+	// A sink that fails on its third frame (closed pipe, full disk) stops the stream and the producer.
+	int attempts = 0;
+	AsyncFrameEncoder failing(capacity);
+	failing.start([&](const cv::Mat&) {
+		std::this_thread::sleep_for(work);
+		return ++attempts < 3;
+	});
+	bool refused = false;
+	for (int i = 0; i < 20 && !refused; ++i)
+		refused = !failing.push(make_frame(i));
+	const FrameEncoderStats fail_stats = failing.close();
+	const bool fail_ok = refused && fail_stats.failed && fail_stats.frames == 2 && attempts == 3;
+
+	std::cout << "Frame encoder check: " << frames << " frames in " << elapsed_ms << " ms (serial " << serial_ms
+		<< " ms), max queue depth " << stats.max_depth << " of " << capacity << ", " << flushed
+		<< " of 10 frames flushed on stop, write error " << (fail_ok ? "stops" : "DOES NOT STOP") << " the stream: "
+		<< (ok && overlap_ok && flush_ok && fail_ok ? "PASSED" : "FAILED") << std::endl;
+	return ok && overlap_ok && flush_ok && fail_ok;
+}
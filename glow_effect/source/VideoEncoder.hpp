@@ -0,0 +1,120 @@
+#ifndef VIDEO_ENCODER_HPP
+#define VIDEO_ENCODER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+/**
+ * @brief Writes one encoder-native frame (CV_8UC3 BGR); runs on the encoder thread.
+ *        Returns false on a write error (full disk, closed pipe), which stops the stream.
+ */
+using EncodeFrameFn = std::function<bool(const cv::Mat& bgr)>;
+
+/**
+ * @brief Counters of an AsyncFrameEncoder.
+ */
+struct FrameEncoderStats {
+	uint64_t frames = 0;          ///< Frames encoded.
+	double encode_ms = 0.0;       ///< Total encode time (sum over frames).
+	double max_encode_ms = 0.0;   ///< Slowest single frame.
+	uint64_t depth_sum = 0;       ///< Sum of the queue depth seen by each push (including the pushed frame).
+	size_t max_depth = 0;         ///< Deepest queue seen by a push.
+	double wait_ms = 0.0;         ///< Time push() blocked on a full queue (encoder is the bottleneck).
+	uint64_t rejected = 0;        ///< Frames pushed after close() or a write error, or to an encoder that never started.
+	bool failed = false;          ///< The encode function reported a write error; later frames were refused.
+};
+
+/**
+ * @brief Video encoder stage on a dedicated writer thread.
+ *
+ * push() hands a frame to a bounded queue and returns, so the compositing loop never waits
+ * for the codec unless the queue is full. The writer thread owns the cv::VideoWriter (or a
+ * custom EncodeFrameFn), encodes frames in push order and measures each one. close() encodes
+ * whatever is still queued, joins the thread and releases the writer, so stopping on 'q'
+ * still flushes every composited frame. A write error stops the stream: the frames still
+ * queued are dropped and push() refuses further ones, so the producer can stop too.
+ *
+ * Frames should arrive in encoder-native BGR (see to_encoder_frame); anything else is
+ * converted on the pushing thread. A pushed cv::Mat shares its pixels with the queue, so
+ * the caller must not write into it afterwards.
+ */
+class AsyncFrameEncoder {
+public:
+	/** @param capacity Frames the queue holds before push() blocks. */
+	explicit AsyncFrameEncoder(size_t capacity = 8);
+	~AsyncFrameEncoder();
+	AsyncFrameEncoder(const AsyncFrameEncoder&) = delete;
+	AsyncFrameEncoder& operator=(const AsyncFrameEncoder&) = delete;
+
+	/**
+	 * @brief Opens a cv::VideoWriter and starts the writer thread on it.
+	 *
+	 * @return false if the writer could not be opened (nothing is started).
+	 */
+	bool open(const std::string& path, int fourcc, double fps, const cv::Size& size);
+
+	/** @brief Starts the writer thread on a custom encode function (checks, other sinks). */
+	void start(EncodeFrameFn encode);
+
+	bool is_open() const { return thread.joinable(); }
+
+	/**
+	 * @brief Queues a frame, blocking while the queue is full.
+	 *
+	 * @return false if the encoder is not running or a write failed; the frame is dropped.
+	 */
+	bool push(cv::Mat frame);
+
+	/** @brief Frames queued and not yet taken by the writer thread. */
+	size_t depth() const;
+
+	/**
+	 * @brief Encodes the queued frames, stops the thread and releases the writer (and
+	 *        whatever a custom encode function owns). Idempotent.
+	 */
+	FrameEncoderStats close();
+
+	FrameEncoderStats stats() const;
+
+	/** @brief Prints frame count, encode time per frame, queue depth and producer wait. */
+	void report() const;
+
+private:
+	void run();
+
+	size_t capacity;
+	EncodeFrameFn encode;
+	cv::VideoWriter writer;
+	mutable std::mutex mutex;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+	std::deque<cv::Mat> queue;
+	bool closing = false;
+	FrameEncoderStats counters;
+	std::thread thread;
+};
+
+/**
+ * @brief Converts a composited frame (BGRA, gray or BGR) to the BGR layout video encoders take.
+ *
+ * dst may be src; a BGR src is shared, not copied.
+ */
+void to_encoder_frame(const cv::Mat& src, cv::Mat& dst);
+
+/**
+ * @brief Headless check of AsyncFrameEncoder: frames are encoded once each and in order, the
+ *        queue never exceeds its capacity, close() flushes a stopped stream, a write error
+ *        stops the stream, and encoding overlaps the producer.
+ *
+ * @return true if the check passed.
+ */
+bool verify_frame_encoder();
+
+#endif // VIDEO_ENCODER_HPP
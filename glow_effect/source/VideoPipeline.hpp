@@ -0,0 +1,171 @@
+#ifndef VIDEO_PIPELINE_HPP
+#define VIDEO_PIPELINE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "SceneDetector.hpp"
+
+/**
+ * @brief How one batch is split across TensorRT execution contexts.
+ */
+struct BatchPlan {
+	int batch_size = 8;   ///< Frames in the batch.
+	int contexts = 2;     ///< Concurrent execution contexts the batch is split across.
+};
+
+/**
+ * @brief A group of consecutive frames that travels through segmentation and compositing together.
+ *
+ * The batch owns its frames, so its masks can only ever be composited against the frames
+ * they were computed from, no matter how many other batches are in flight.
+ */
+struct InFlightBatch {
+	uint64_t first_seq = 0;          ///< Sequence number of frames[0]; frames[i] has first_seq + i.
+	std::vector<cv::Mat> frames;     ///< Original frames, owned by the batch.
+	BatchPlan plan;                  ///< Plan the batch was read with (frames.size() may be smaller at the tail or a cut).
+	std::vector<cv::Mat> analysis;   ///< Analysis grid per frame (only filled when the pipeline has an analyze_fn).
+	std::vector<FrameChangeScore> scores;   ///< Change score per frame vs its predecessor (only with an analyze_fn).
+	std::future<void> done;          ///< Becomes ready once every frame of the batch reached the reorder buffer.
+};
+
+/**
+ * @brief Thread-safe buffer that releases items strictly in sequence order.
+ *
+ * Producers push (seq, item) pairs in any order; drain() hands items to the sink only
+ * while the next expected sequence number is available.
+ *
+ * @tparam T Payload type (typically cv::Mat).
+ */
+template<typename T>
+class ReorderBuffer {
+public:
+	explicit ReorderBuffer(uint64_t first_seq = 0) : next_seq(first_seq) {}
+
+	/**
+	 * @brief Stores an item; safe to call from any thread.
+	 */
+	void push(uint64_t seq, T item) {
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.emplace(seq, std::move(item));
+	}
+
+	/**
+	 * @brief Delivers every in-order item to the sink on the calling thread.
+	 *
+	 * @param sink Callable bool(uint64_t seq, T& item); returning false stops the drain.
+	 * @return false if the sink asked to stop, true otherwise.
+	 */
+	template<typename Sink>
+	bool drain(Sink&& sink) {
+		for (;;) {
+			T item;
+			uint64_t seq;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = pending.find(next_seq);
+				if (it == pending.end())
+					return true;
+				seq = it->first;
+				item = std::move(it->second);
+				pending.erase(it);
+				++next_seq;
+			}
+			if (!sink(seq, item))
+				return false;
+		}
+	}
+
+	/** @brief Sequence number the buffer is waiting for. */
+	uint64_t expected() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return next_seq;
+	}
+
+	/** @brief Number of items held back because an earlier sequence number is still missing. */
+	size_t held() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return pending.size();
+	}
+
+private:
+	mutable std::mutex mutex;
+	std::map<uint64_t, T> pending;
+	uint64_t next_seq;
+};
+
+/**
+ * @brief Batching parameters of the video pipeline.
+ */
+struct VideoPipelineConfig {
+	int batch_size = 8;      ///< Frames read into one InFlightBatch (ignored when plan_fn is set).
+	int max_in_flight = 2;   ///< Batches processed concurrently before the reader waits for the oldest.
+	std::function<BatchPlan()> plan_fn;   ///< Optional; asked for the plan of every batch before it is read.
+	/// Optional; runs on the reader thread for every frame in read order, fills the analysis
+	/// grid and returns the change score stored in the batch.
+	std::function<FrameChangeScore(const cv::Mat& frame, cv::Mat& analysis)> analyze_fn;
+	bool split_on_scene_cut = true;      ///< With analyze_fn: a scene cut closes the current batch early.
+};
+
+/**
+ * @brief Counters reported by run_video_pipeline.
+ */
+struct VideoPipelineStats {
+	uint64_t frames_read = 0;
+	uint64_t frames_delivered = 0;
+	uint64_t batches = 0;
+	uint64_t scene_cuts = 0;       ///< Frames reported as scene cuts by analyze_fn (excluding the first frame).
+	size_t max_reorder_held = 0;   ///< Largest number of frames parked in the reorder buffer.
+	bool stopped_by_sink = false;
+};
+
+/// Reads the next frame into a fresh cv::Mat; returns false at end of stream.
+using PipelineReadFn = std::function<bool(cv::Mat& frame)>;
+/// Processes the frames of one batch and returns exactly one output per input frame.
+using PipelineProcessFn = std::function<std::vector<cv::Mat>(const InFlightBatch& batch)>;
+/// Consumes one output frame in sequence order; returns false to stop the pipeline (e.g. 'q').
+using PipelineSinkFn = std::function<bool(uint64_t seq, const cv::Mat& frame)>;
+
+/**
+ * @brief Runs read -> process -> sink with up to config.max_in_flight batches in flight.
+ *
+ * Reading and the sink run on the calling thread (so HighGUI calls stay on the main thread);
+ * each batch is processed as one task on the shared scheduler. Outputs are routed through a
+ * ReorderBuffer, so the sink sees frames in read order even when batches finish out of order.
+ * With an analyze_fn every frame is scored while it is read, and a scene cut starts a new
+ * batch so that no batch spans two shots.
+ * If processing throws, all in-flight batches are drained before the exception is re-thrown.
+ *
+ * @param read    Frame source.
+ * @param process Per-batch processing (segmentation + compositing).
+ * @param sink    Ordered consumer (display / encode).
+ * @param config  Batch size (or per-batch plan source) and pipeline depth.
+ * @return Counters of the run.
+ */
+VideoPipelineStats run_video_pipeline(const PipelineReadFn& read, const PipelineProcessFn& process,
+	const PipelineSinkFn& sink, const VideoPipelineConfig& config);
+
+/**
+ * @brief Headless check of frame/output association and ordering.
+ *
+ * Feeds synthetic frames that carry their own sequence number through run_video_pipeline
+ * with a mock processor that finishes batches out of order, and verifies that the sink
+ * receives every frame exactly once, in order, paired with the output computed from it.
+ *
+ * @param num_frames    Number of synthetic frames (use a value that is not a multiple of batch_size to cover the tail).
+ * @param batch_size    Frames per batch.
+ * @param max_in_flight Pipeline depth.
+ * @param cut_every     If > 0, every frame whose number is a multiple of it is reported as a scene cut,
+ *                      and the check also verifies that no batch spans a cut.
+ * @return true if the check passed.
+ */
+bool verify_video_pipeline_order(int num_frames, int batch_size, int max_in_flight, int cut_every = 0);
+
+#endif // VIDEO_PIPELINE_HPP
@@ -23,7 +23,9 @@ void bar_key_scale_cb(int newValue);
 void bar_default_scale_cb(int newValue);
 
 /**
- * @brief Applies the glow effect on the current image using the loaded mask.
+ * @brief Queues the glow effect of the current image with the loaded mask on the render worker.
+ *
+ * Returns without waiting; rapid calls are coalesced and only the newest parameters are drawn.
  */
 void updateImage();
 
@@ -21,9 +21,9 @@
 
  // Global Variables
 int button_id = 0; // Currently selected button ID.
-int param_KeyScale = 600;  // Key scale parameter controlled by slider.
-int param_KeyLevel = 96;   // Key level parameter controlled by slider.
-int default_scale = 10;    // Default scale parameter controlled by slider.
+
+// Key level, key scale and default scale controlled by the sliders, plus the mipmap filter buttons.
+GlowParamBlock glow_params(GlowParams{ 96, 600, 10 });
 
 /**
 * wxwidgets gui launcher
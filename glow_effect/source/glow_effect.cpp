@@ -6,9 +6,10 @@
  *               Integrates CUDA kernels, OpenCV, and TensorRT (for segmentation in the video pipeline).
  *               Uses triple buffering with non-blocking streams (created using cudaStreamNonBlocking)
  *               to accelerate asynchronous mipmap filtering.
- * IMPORTANT:  The engine is built for a fixed input shape ([4,3,384,384]). We ensure that every batch
- *             is padded to 4 images and remove any extra singleton dimensions. Additionally, before
- *             calling cv::resize, we check that the input image has valid dimensions.
+ * IMPORTANT:  For a fixed input shape engine ([4,3,384,384]) only the device input of a short sub-batch
+ *             is padded to 4 images; masks, compositing and encoding run for real frames only. Extra
+ *             singleton dimensions are removed. Additionally, before calling cv::resize, we check that
+ *             the input image has valid dimensions.
  * VERSION     : Updated 2025 FEB 04 (with additional error-checking and exception handling)
  *******************************************************************************************************************/
 
@@ -28,16 +29,23 @@
 #include <opencv2/cudawarping.hpp>
 #include <filesystem>
 #include "mipmap.h"
+#include "VideoPipeline.hpp"
+#include "AdaptiveBatcher.hpp"
+#include "RleMask.hpp"
+#include "VideoEncoder.hpp"
+#include "FrameDecoder.hpp"
+#include "RawVideoSink.hpp"
+#include "Profiler.hpp"
+#include "LatencyHistogram.hpp"
 #include "helper_cuda.h"  // For checkCudaErrors
-#include <future>         // For std::async, std::future
+#include "movie_effect/include/tools_task.h"  // Shared work-stealing scheduler
+#include <future>         // For std::future
+#include <mutex>
 #include <exception>
 #include <chrono>
 
 namespace fs = std::filesystem;
 
-// Global boolean array indicating button states (for demonstration/testing).
-bool button_State[5] = { false, false, false, false, false };
-
 // Helper Visualization
 void visualize_segmentation_regions(const cv::Mat& original_frame, const cv::Mat& mask, int param_KeyLevel, int Delta) {
 	// Create a visualization image by blending original frame with colored regions
@@ -71,29 +79,42 @@ void visualize_segmentation_regions(const cv::Mat& original_frame, const cv::Mat
 ////////////////////////////////////////////////////////////////////////////////
 // Helper Function: convert_mask_to_rgba_buffer
 ////////////////////////////////////////////////////////////////////////////////
+// A negative param_KeyLevel takes the mask as already keyed (RleMask::key_image, glow layers):
+// every nonzero value is kept.
 void convert_mask_to_rgba_buffer(const cv::Mat& mask, uchar4* dst, int frame_width, int frame_height, int param_KeyLevel) {
-	for (int i = 0; i < frame_height; ++i) {
-		for (int j = 0; j < frame_width; ++j) {
-			unsigned char gray_value = mask.at<uchar>(i, j);
-			if (gray_value == param_KeyLevel)
-				dst[i * frame_width + j] = { gray_value, gray_value, gray_value, 255 };
-			else
-				dst[i * frame_width + j] = { 0, 0, 0, 0 };
-		}
-	}
+	task::parallel_rows(frame_height, [&](int row_begin, int row_end) {
+		for (int i = row_begin; i < row_end; ++i) {
+			const uchar* mask_row = mask.ptr<uchar>(i);
+			uchar4* dst_row = dst + i * frame_width;
+			for (int j = 0; j < frame_width; ++j) {
+				unsigned char gray_value = mask_row[j];
+				if (param_KeyLevel < 0 ? gray_value != 0 : gray_value == param_KeyLevel)
+					dst_row[j] = { gray_value, gray_value, gray_value, 255 };
+				else
+					dst_row[j] = { 0, 0, 0, 0 };
+			}
+		}
+	});
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Helper Function: triple_buffered_mipmap_pipeline
 ////////////////////////////////////////////////////////////////////////////////
+// Each mask is filtered at its own size (a glow ROI or a full frame) and blur scale, so the
+// pinned buffers are sized for the largest one; frame_width x frame_height is the minimum.
 std::vector<cv::Mat> triple_buffered_mipmap_pipeline(const std::vector<cv::Mat>& resized_masks,
 	int frame_width, int frame_height,
-	float default_scale, int param_KeyLevel) {
+	const std::vector<float>& scales, int param_KeyLevel) {
 	int N = resized_masks.size();
 	const int numBuffers = 3;
 	std::vector<cv::Mat> outputImages(N);
+	if (N == 0)
+		return outputImages;
+
+	size_t bufferPixels = static_cast<size_t>(frame_width) * frame_height;
+	for (const cv::Mat& mask : resized_masks)
+		bufferPixels = std::max(bufferPixels, mask.total());
 
-	std::vector<uchar4*> tripleSrc(numBuffers, nullptr);
 	std::vector<uchar4*> tripleDst(numBuffers, nullptr);
 	std::vector<cudaStream_t> mipmapStreams(numBuffers);
 	std::vector<cudaEvent_t> mipmapDone(numBuffers);
@@ -101,33 +122,28 @@ std::vector<cv::Mat> triple_buffered_mipmap_pipeline(const std::vector<cv::Mat>&
 	for (int i = 0; i < numBuffers; ++i) {
 		checkCudaErrors(cudaStreamCreateWithFlags(&mipmapStreams[i], cudaStreamNonBlocking));
 		checkCudaErrors(cudaEventCreate(&mipmapDone[i]));
-		checkCudaErrors(cudaMallocHost((void**)&tripleSrc[i], frame_width * frame_height * sizeof(uchar4)));
-		checkCudaErrors(cudaMallocHost((void**)&tripleDst[i], frame_width * frame_height * sizeof(uchar4)));
+		checkCudaErrors(cudaMallocHost((void**)&tripleDst[i], bufferPixels * sizeof(uchar4)));
 	}
 
 	for (int i = 0; i < N + 2; ++i) {
 		if (i < N) {
+			// apply_mipmap_async keys the mask into its own pinned source buffer.
 			int bufIdx = i % numBuffers;
-			convert_mask_to_rgba_buffer(resized_masks[i], tripleSrc[bufIdx], frame_width, frame_height, param_KeyLevel);
-			apply_mipmap_async(resized_masks[i], tripleDst[bufIdx], default_scale, param_KeyLevel, mipmapStreams[bufIdx]);
+			apply_mipmap_async(resized_masks[i], tripleDst[bufIdx], scales[i], param_KeyLevel, mipmapStreams[bufIdx]);
 			checkCudaErrors(cudaEventRecord(mipmapDone[bufIdx], mipmapStreams[bufIdx]));
 		}
 		if (i - 2 >= 0 && (i - 2) < N) {
+			// The buffer is reused by frame i + 1, so wait for it rather than dropping the result.
 			int bufIdx = (i - 2) % numBuffers;
-			cudaError_t query = cudaEventQuery(mipmapDone[bufIdx]);
-			if (query == cudaSuccess) {
-				cv::Mat mipmapResult(frame_height, frame_width, CV_8UC4);
-				memcpy(mipmapResult.data, tripleDst[bufIdx], frame_width * frame_height * sizeof(uchar4));
-				outputImages[i - 2] = mipmapResult;
-			}
-			else if (query != cudaErrorNotReady) {
-				checkCudaErrors(query);
-			}
+			const cv::Mat& mask = resized_masks[i - 2];
+			checkCudaErrors(cudaEventSynchronize(mipmapDone[bufIdx]));
+			cv::Mat mipmapResult(mask.rows, mask.cols, CV_8UC4);
+			memcpy(mipmapResult.data, tripleDst[bufIdx], mask.total() * sizeof(uchar4));
+			outputImages[i - 2] = mipmapResult;
 		}
 	}
 
 	for (int i = 0; i < numBuffers; ++i) {
-		checkCudaErrors(cudaFreeHost(tripleSrc[i]));
 		checkCudaErrors(cudaFreeHost(tripleDst[i]));
 		checkCudaErrors(cudaStreamDestroy(mipmapStreams[i]));
 		checkCudaErrors(cudaEventDestroy(mipmapDone[i]));
@@ -136,70 +152,11 @@ std::vector<cv::Mat> triple_buffered_mipmap_pipeline(const std::vector<cv::Mat>&
 	return outputImages;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// Function: glow_blow
-////////////////////////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////////////////////
-// Function: glow_blow
-////////////////////////////////////////////////////////////////////////////////
-void glow_blow(const cv::Mat& mask, cv::Mat& dst_rgba, int param_KeyLevel, int Delta) {
-	if (mask.empty()) {
-		std::cerr << "Error: Segmentation mask is empty." << std::endl;
-		return;
-	}
-	if (mask.type() != CV_8UC1) {
-		std::cerr << "Error: Mask is not of type CV_8UC1." << std::endl;
-		return;
-	}
-
-	// Create a destination image with zeros
-	dst_rgba = cv::Mat::zeros(mask.size(), CV_8UC4);
-
-	// Use a more vibrant color for better visibility
-	cv::Vec4b overlay_color = { 128, 0, 128, 255 };
-
-	// Variables to track target region information
-	bool has_target_region = false;
-	int target_pixel_count = 0;
-	int min_x = mask.cols, max_x = 0;
-	int min_y = mask.rows, max_y = 0;
-
-	// Process the mask
-	for (int i = 0; i < mask.rows; ++i) {
-		for (int j = 0; j < mask.cols; ++j) {
-			int mask_pixel = mask.at<uchar>(i, j);
-
-			if (std::abs(mask_pixel - param_KeyLevel) < Delta) {
-				has_target_region = true;
-				target_pixel_count++;
-
-				// Track bounding box of target region
-				min_x = std::min(min_x, j);
-				max_x = std::max(max_x, j);
-				min_y = std::min(min_y, i);
-				max_y = std::max(max_y, i);
-
-				// Apply overlay ONLY to pixels that match the target value
-				dst_rgba.at<cv::Vec4b>(i, j) = overlay_color;
-			}
-		}
-	}
-
-	// Print the target region information that was specifically requested
-	if (has_target_region) {
-		// Calculate percentage of frame covered
-		double coverage_percent = (static_cast<double>(target_pixel_count) / (mask.rows * mask.cols)) * 100.0;
-		std::cout << "Target region found!" << std::endl;
-		std::cout << "  - Pixels matching target: " << target_pixel_count << " (" << coverage_percent << "% of frame)" << std::endl;
-		std::cout << "  - Region bounding box: (" << min_x << "," << min_y << ") to (" << max_x << "," << max_y << ")" << std::endl;
-		std::cout << "  - Box dimensions: " << (max_x - min_x + 1) << "x" << (max_y - min_y + 1) << std::endl;
-	}
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 // Function: apply_mipmap (Synchronous Version)
 ////////////////////////////////////////////////////////////////////////////////
 void apply_mipmap(const cv::Mat& input_gray, cv::Mat& output_image, float scale, int param_KeyLevel) {
+	PROFILE_ZONE("mipmap");
 	int width = input_gray.cols;
 	int height = input_gray.rows;
 
@@ -211,25 +168,15 @@ void apply_mipmap(const cv::Mat& input_gray, cv::Mat& output_image, float scale,
 	uchar4* src_img = new uchar4[width * height];
 	uchar4* dst_img = new uchar4[width * height];
 
-	for (int i = 0; i < height; ++i) {
-		for (int j = 0; j < width; ++j) {
-			unsigned char gray_value = input_gray.at<uchar>(i, j);
-			if (gray_value == param_KeyLevel)
-				src_img[i * width + j] = { gray_value, gray_value, gray_value, 255 };
-			else
-				src_img[i * width + j] = { 0, 0, 0, 0 };
-		}
-	}
+	convert_mask_to_rgba_buffer(input_gray, src_img, width, height, param_KeyLevel);
 
 	filter_mipmap(width, height, scale, src_img, dst_img);
 
 	output_image.create(height, width, CV_8UC4);
-	for (int i = 0; i < height; ++i) {
-		for (int j = 0; j < width; ++j) {
-			uchar4 value = dst_img[i * width + j];
-			output_image.at<cv::Vec4b>(i, j) = cv::Vec4b(value.x, value.y, value.z, value.w);
-		}
-	}
+	task::parallel_rows(height, [&](int row_begin, int row_end) {
+		for (int i = row_begin; i < row_end; ++i)
+			memcpy(output_image.ptr<cv::Vec4b>(i), dst_img + i * width, width * sizeof(uchar4));
+	});
 
 	std::cout << "apply_mipmap: Completed synchronous mipmap filtering." << std::endl;
 
@@ -247,15 +194,7 @@ void apply_mipmap_async(const cv::Mat& input_gray, uchar4* dst_img, float scale,
 	uchar4* src_img = nullptr;
 	checkCudaErrors(cudaMallocHost((void**)&src_img, width * height * sizeof(uchar4)));
 
-	for (int i = 0; i < height; ++i) {
-		for (int j = 0; j < width; ++j) {
-			unsigned char gray_value = input_gray.at<uchar>(i, j);
-			if (gray_value == param_KeyLevel)
-				src_img[i * width + j] = { gray_value, gray_value, gray_value, 255 };
-			else
-				src_img[i * width + j] = { 0, 0, 0, 0 };
-		}
-	}
+	convert_mask_to_rgba_buffer(input_gray, src_img, width, height, param_KeyLevel);
 
 	filter_mipmap_async(width, height, scale, src_img, dst_img, stream);
 
@@ -270,782 +209,137 @@ void apply_mipmap_async(const cv::Mat& input_gray, uchar4* dst_img, float scale,
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// Function: mix_images
+// Class: MipmapPyramidCuda
 ////////////////////////////////////////////////////////////////////////////////
-void mix_images(const cv::Mat& src_img, const cv::Mat& dst_rgba, const cv::Mat& mipmap_result, cv::Mat& output_image, float param_KeyScale) {
-	if (src_img.empty() || dst_rgba.empty() || mipmap_result.empty()) {
-		std::cerr << "Error: One or more input images are empty." << std::endl;
-		return;
-	}
-	if (src_img.size() != dst_rgba.size() || src_img.size() != mipmap_result.size()) {
-		std::cerr << "Error: Images must have the same dimensions." << std::endl;
+MipmapPyramidCuda::MipmapPyramidCuda(const cv::Mat& key_image, int param_KeyLevel) {
+	if (key_image.empty() || key_image.type() != CV_8UC1) {
+		std::cerr << "Error: Input image must be a single-channel grayscale image." << std::endl;
 		return;
 	}
+	std::vector<uchar4> src_img(static_cast<size_t>(key_image.cols) * key_image.rows);
+	convert_mask_to_rgba_buffer(key_image, src_img.data(), key_image.cols, key_image.rows, param_KeyLevel);
+	build_mipmap_chain(key_image.cols, key_image.rows, src_img.data(), chain);
+}
 
-	cv::Mat src_rgba;
-	if (src_img.channels() != 4)
-		cv::cvtColor(src_img, src_rgba, cv::COLOR_BGR2BGRA);
-	else
-		src_rgba = src_img.clone();
-
-	cv::Mat high_lighted_rgba;
-	if (dst_rgba.channels() != 4)
-		cv::cvtColor(dst_rgba, high_lighted_rgba, cv::COLOR_BGR2BGRA);
-	else
-		high_lighted_rgba = dst_rgba.clone();
-
-	cv::Mat mipmap_gray;
-	if (mipmap_result.channels() != 1)
-		cv::cvtColor(mipmap_result, mipmap_gray, cv::COLOR_BGR2GRAY);
-	else
-		mipmap_gray = mipmap_result.clone();
-
-	output_image = src_rgba.clone();
-
-	for (int i = 0; i < src_rgba.rows; ++i) {
-		for (int j = 0; j < src_rgba.cols; ++j) {
-			uchar original_alpha = mipmap_gray.at<uchar>(i, j);
-			uchar alpha = (original_alpha * static_cast<int>(param_KeyScale)) >> 8;
-			cv::Vec4b src_pixel = src_rgba.at<cv::Vec4b>(i, j);
-			cv::Vec4b dst_pixel = high_lighted_rgba.at<cv::Vec4b>(i, j);
-			cv::Vec4b& output_pixel = output_image.at<cv::Vec4b>(i, j);
-			for (int k = 0; k < 4; ++k) {
-				int temp_pixel = (src_pixel[k] * (255 - alpha) + dst_pixel[k] * alpha) >> 8;
-				output_pixel[k] = static_cast<uchar>(std::min(255, std::max(0, temp_pixel)));
-			}
-		}
-	}
-
-	std::cout << "mix_images: Image blending completed successfully." << std::endl;
+MipmapPyramidCuda::~MipmapPyramidCuda() {
+	free_mipmap_chain(chain);
 }
 
+cv::Mat MipmapPyramidCuda::sample(float scale, const cv::Rect& region) {
+	if (!chain.array)
+		return cv::Mat();
+	const cv::Rect full(0, 0, chain.width, chain.height);
+	const cv::Rect out_rect = region.area() > 0 ? (region & full) : full;
+	if (out_rect.area() <= 0)
+		return cv::Mat();
+	cv::Mat output_image(out_rect.height, out_rect.width, CV_8UC4);
+	sample_mipmap_chain(chain, scale, out_rect.x, out_rect.y, out_rect.width, out_rect.height,
+		reinterpret_cast<uchar4*>(output_image.data));
+	return output_image;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 // Function: glow_effect_image
 ////////////////////////////////////////////////////////////////////////////////
-void glow_effect_image(const char* image_nm, const cv::Mat& grayscale_mask) {
-	cv::Mat src_img = cv::imread(image_nm);
-	if (src_img.empty()) {
-		std::cerr << "Error: Could not load source image." << std::endl;
-		return;
-	}
-
-	cv::Mat dst_rgba;
-	glow_blow(grayscale_mask, dst_rgba, param_KeyLevel, 10);
-
-	cv::Mat mipmap_result;
-	apply_mipmap(grayscale_mask, mipmap_result, static_cast<float>(default_scale), param_KeyLevel);
-
-	cv::Mat final_result;
-	mix_images(src_img, dst_rgba, mipmap_result, final_result, param_KeyScale);
-
-	cv::imshow("Final Result", final_result);
-	cv::waitKey(0);
+// Called from the render worker thread with a parameter snapshot; the cache recomputes only
+// what the changed parameter feeds (a key-scale change is a blend of the glow ROI).
+bool glow_effect_image(const char* image_nm, const cv::Mat& grayscale_mask, const GlowParams& params,
+	cv::Mat& output_image, const GlowCancelFn& cancelled) {
+	static GlowImageCache image_cache(default_glow_stages());
+
+	auto start = std::chrono::high_resolution_clock::now();
+	const GlowCacheStats before = image_cache.stats();
+	const cv::Mat& final_result = image_cache.render(image_nm, grayscale_mask, params, cancelled);
+	if (final_result.empty()) {
+		if (!cancelled || !cancelled())
+			std::cerr << "Error: Could not load source image." << std::endl;
+		return false;
+	}
+	const GlowCacheStats& after = image_cache.stats();
+	std::cout << "Glow update: " << after.keys - before.keys << " key, " << after.pyramids - before.pyramids << " pyramid, "
+		<< after.mipmaps - before.mipmaps << " mipmap, " << after.blends - before.blends << " blend pass(es) in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count()
+		<< " ms" << std::endl;
+
+	// The cache keeps final_result for the next render; HighGUI calls belong to the caller's thread.
+	output_image = final_result.clone();
+	return true;
 }
 
+// Signature shared by the concurrent TRT segmentation entry points.
+typedef std::vector<cv::Mat>(*SegmentBatchFn)(const std::string&, torch::Tensor, int, int);
+
 ////////////////////////////////////////////////////////////////////////////////
-// Function: glow_effect_video
+// Helper Function: segment_frames_trt
 ////////////////////////////////////////////////////////////////////////////////
-void glow_effect_video(const char* video_nm, std::string planFilePath) {
-	cv::String info = cv::getBuildInformation();
-	std::cout << info << std::endl;
-
-	cv::VideoCapture video;
-	if (!video.open(video_nm, cv::VideoCaptureAPIs::CAP_ANY)) {
-		std::cerr << "Error: Could not open video file: " << video_nm << std::endl;
-		return;
-	}
-
-	int frame_width = static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH));
-	int frame_height = static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
-	int fps = static_cast<int>(video.get(cv::CAP_PROP_FPS));
-
-	cv::Size defaultSize((frame_width > 0) ? frame_width : 640, (frame_height > 0) ? frame_height : 360);
-
-	if (!fs::exists("./VideoOutput/")) {
-		if (fs::create_directory("./VideoOutput/"))
-			std::cout << "Video Output Directory successfully created." << std::endl;
-		else {
-			std::cerr << "Failed to create video output folder." << std::endl;
-			return;
-		}
-	}
-	else {
-		std::cout << "Video Output Directory already exists." << std::endl;
-	}
-
-	std::string output_video_path = "./VideoOutput/processed_video.avi";
-	cv::VideoWriter output_video(output_video_path,
-		cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
-		fps, cv::Size((frame_width > 0) ? frame_width : defaultSize.width,
-			(frame_height > 0) ? frame_height : defaultSize.height));
-	if (!output_video.isOpened()) {
-		std::cerr << "Error: Could not open the output video for writing: " << output_video_path << std::endl;
-		return;
-	}
-
-	cv::cuda::GpuMat gpu_frame;
-	// Containers for 8 frames per iteration.
+// Preprocesses the frames of one batch and segments them as num_contexts concurrent
+// sub-batches. Sub-batches are padded to the engine batch inside the segmentation call;
+// the returned vector has one mask per real frame.
+static std::vector<cv::Mat> segment_frames_trt(const std::vector<cv::Mat>& frames, const std::string& planFilePath, SegmentBatchFn segment,
+	int num_contexts) {
 	std::vector<torch::Tensor> batch_frames;
-	std::vector<cv::Mat> original_frames;
-
-	// Use two futures to run segmentation concurrently on sub-batches.
-	std::future<std::vector<cv::Mat>> segFuture1, segFuture2;
-	bool segFutureValid1 = false, segFutureValid2 = false;
-
-	while (video.isOpened()) {
-		batch_frames.clear();
-		original_frames.clear();
-
-		// Read a batch of 8 frames.
-		for (int i = 0; i < 8; ++i) {
-			cv::Mat frame;
-			if (!video.read(frame) || frame.empty()) {
-				if (batch_frames.empty())
-					break;
-				// Duplicate the last valid frame if we run out.
-				batch_frames.push_back(batch_frames.back());
-				original_frames.push_back(original_frames.back().clone());
-				continue;
-			}
-			if (frame.empty() || frame.cols <= 0 || frame.rows <= 0) {
-				std::cerr << "Warning: Read frame " << i << " is invalid. Using default blank image." << std::endl;
-				frame = cv::Mat(defaultSize, CV_8UC3, cv::Scalar(0, 0, 0));
-			}
-			original_frames.push_back(frame.clone());
-
-			gpu_frame.upload(frame);
-			cv::cuda::GpuMat resized_gpu_frame;
-			try {
-				cv::cuda::resize(gpu_frame, resized_gpu_frame, cv::Size(384, 384));
-			}
-			catch (cv::Exception& e) {
-				std::cerr << "Error during GPU resize: " << e.what() << ". Using blank image instead." << std::endl;
-				cv::Mat blank(384, 384, frame.type(), cv::Scalar(0, 0, 0));
-				resized_gpu_frame.upload(blank);
-			}
-			torch::Tensor frame_tensor = ImageProcessingUtil::process_img(resized_gpu_frame, false);
-			frame_tensor = frame_tensor.to(torch::kFloat);
-			batch_frames.push_back(frame_tensor);
-		}
-		if (batch_frames.empty())
-			break;
-		while (batch_frames.size() < 8) {
-			batch_frames.push_back(batch_frames.back());
-			original_frames.push_back(original_frames.back().clone());
-		}
-
-		// Process segmentation results from the previous iteration, if available.
-		if (segFutureValid1) {
-			std::vector<cv::Mat> grayscale_masks = segFuture1.get();
-			segFutureValid1 = false;
-			// Process first sub-batch (frames 0 to 3)
-			std::vector<cv::Mat> resized_masks_batch;
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat resized_mask;
-				cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
-					? defaultSize : original_frames[i].size();
-				try {
-					cv::resize(grayscale_masks[i], resized_mask, targetSize);
-				}
-				catch (cv::Exception& e) {
-					std::cerr << "Error during segmentation mask resize for sub-batch 1 frame " << i
-						<< ": " << e.what() << ". Using blank mask." << std::endl;
-					resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-				}
-				resized_masks_batch.push_back(resized_mask);
-			}
-
-			std::vector<cv::Mat> glow_blow_results(4);
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat dst_rgba;
-				glow_blow(resized_masks_batch[i], dst_rgba, param_KeyLevel, 10);
-				if (dst_rgba.channels() != 4)
-					cv::cvtColor(dst_rgba, dst_rgba, cv::COLOR_BGR2RGBA);
-				glow_blow_results[i] = dst_rgba;
-			}
-			std::vector<cv::Mat> mipmap_results = triple_buffered_mipmap_pipeline(
-				resized_masks_batch, frame_width, frame_height, static_cast<float>(default_scale), param_KeyLevel
-			);
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat final_result;
-				mix_images(original_frames[i], glow_blow_results[i], mipmap_results[i], final_result, param_KeyScale);
-				if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
-					std::cerr << "Warning: Final blended image is empty for sub-batch 1 frame " << i
-						<< ". Creating blank output." << std::endl;
-					final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
-				}
-				cv::imshow("Processed Frame", final_result);
-				int key = cv::waitKey(30);
-				if (key == 'q') {
-					video.release();
-					cv::destroyAllWindows();
-					goto cleanup;
-				}
-				output_video.write(final_result);
-			}
-		}
-		if (segFutureValid2) {
-			std::vector<cv::Mat> grayscale_masks = segFuture2.get();
-			segFutureValid2 = false;
-			// Process second sub-batch (frames 4 to 7)
-			std::vector<cv::Mat> resized_masks_batch;
-			for (int i = 4; i < 8; ++i) {
-				cv::Mat resized_mask;
-				cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
-					? defaultSize : original_frames[i].size();
-				try {
-					cv::resize(grayscale_masks[i - 4], resized_mask, targetSize);
-				}
-				catch (cv::Exception& e) {
-					std::cerr << "Error during segmentation mask resize for sub-batch 2 frame " << i - 4
-						<< ": " << e.what() << ". Using blank mask." << std::endl;
-					resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-				}
-				resized_masks_batch.push_back(resized_mask);
-			}
-			std::vector<cv::Mat> glow_blow_results(4);
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat dst_rgba;
-				glow_blow(resized_masks_batch[i], dst_rgba, param_KeyLevel, 10);
-				if (dst_rgba.channels() != 4)
-					cv::cvtColor(dst_rgba, dst_rgba, cv::COLOR_BGR2RGBA);
-				glow_blow_results[i] = dst_rgba;
-			}
-			std::vector<cv::Mat> mipmap_results = triple_buffered_mipmap_pipeline(
-				resized_masks_batch, frame_width, frame_height, static_cast<float>(default_scale), param_KeyLevel
-			);
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat final_result;
-				mix_images(original_frames[i + 4], glow_blow_results[i], mipmap_results[i], final_result, param_KeyScale);
-				if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
-					std::cerr << "Warning: Final blended image is empty for sub-batch 2 frame " << i
-						<< ". Creating blank output." << std::endl;
-					final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
-				}
-				cv::imshow("Processed Frame", final_result);
-				int key = cv::waitKey(30);
-				if (key == 'q') {
-					video.release();
-					cv::destroyAllWindows();
-					goto cleanup;
-				}
-				output_video.write(final_result);
-			}
-		}
-
-		// Prepare segmentation input for the current batch:
-		// Create two sub-batch tensors (each containing 4 frames).
-		torch::Tensor sub_batch_tensor1 = torch::stack(
-			std::vector<torch::Tensor>(batch_frames.begin(), batch_frames.begin() + 4), 0);
-		torch::Tensor sub_batch_tensor2 = torch::stack(
-			std::vector<torch::Tensor>(batch_frames.begin() + 4, batch_frames.end()), 0);
-
-		// Launch segmentation concurrently for both sub-batches.
-		segFuture1 = std::async(std::launch::async,
-			TRTInference::measure_segmentation_trt_performance_mul_concurrent,
-			planFilePath, sub_batch_tensor1, 1);
-		segFutureValid1 = true;
-		segFuture2 = std::async(std::launch::async,
-			TRTInference::measure_segmentation_trt_performance_mul_concurrent,
-			planFilePath, sub_batch_tensor2, 1);
-		segFutureValid2 = true;
-	}
+	cv::cuda::GpuMat gpu_frame;
 
-	// If any segmentation result is still pending, process it.
-	if (segFutureValid1) {
-		std::vector<cv::Mat> grayscale_masks = segFuture1.get();
-		std::vector<cv::Mat> resized_masks_batch;
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat resized_mask;
-			cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
-				? defaultSize : original_frames[i].size();
-			try {
-				cv::resize(grayscale_masks[i], resized_mask, targetSize);
-			}
-			catch (cv::Exception& e) {
-				std::cerr << "Error during final segmentation mask resize for sub-batch 1 frame " << i
-					<< ": " << e.what() << ". Using blank mask." << std::endl;
-				resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-			}
-			resized_masks_batch.push_back(resized_mask);
-		}
-		std::vector<cv::Mat> glow_blow_results(4);
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat dst_rgba;
-			glow_blow(resized_masks_batch[i], dst_rgba, param_KeyLevel, 10);
-			if (dst_rgba.channels() != 4)
-				cv::cvtColor(dst_rgba, dst_rgba, cv::COLOR_BGR2RGBA);
-			glow_blow_results[i] = dst_rgba;
-		}
-		std::vector<cv::Mat> mipmap_results = triple_buffered_mipmap_pipeline(
-			resized_masks_batch, frame_width, frame_height, static_cast<float>(default_scale), param_KeyLevel
-		);
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat final_result;
-			mix_images(original_frames[i], glow_blow_results[i], mipmap_results[i], final_result, param_KeyScale);
-			if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
-				std::cerr << "Warning: Final blended image is empty for final sub-batch 1 frame " << i
-					<< ". Creating blank output." << std::endl;
-				final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
-			}
-			cv::imshow("Processed Frame", final_result);
-			int key = cv::waitKey(30);
-			if (key == 'q') {
-				video.release();
-				cv::destroyAllWindows();
-				goto cleanup;
-			}
-			output_video.write(final_result);
-		}
-	}
-	if (segFutureValid2) {
-		std::vector<cv::Mat> grayscale_masks = segFuture2.get();
-		std::vector<cv::Mat> resized_masks_batch;
-		for (int i = 4; i < 8; ++i) {
-			cv::Mat resized_mask;
-			cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
-				? defaultSize : original_frames[i].size();
-			try {
-				cv::resize(grayscale_masks[i - 4], resized_mask, targetSize);
-			}
-			catch (cv::Exception& e) {
-				std::cerr << "Error during final segmentation mask resize for sub-batch 2 frame " << i - 4
-					<< ": " << e.what() << ". Using blank mask." << std::endl;
-				resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-			}
-			resized_masks_batch.push_back(resized_mask);
-		}
-		std::vector<cv::Mat> glow_blow_results(4);
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat dst_rgba;
-			glow_blow(resized_masks_batch[i], dst_rgba, param_KeyLevel, 10);
-			if (dst_rgba.channels() != 4)
-				cv::cvtColor(dst_rgba, dst_rgba, cv::COLOR_BGR2RGBA);
-			glow_blow_results[i] = dst_rgba;
+	for (const cv::Mat& frame : frames) {
+		PROFILE_ZONE("preprocess");
+		gpu_frame.upload(frame);
+		cv::cuda::GpuMat resized_gpu_frame;
+		try {
+			cv::cuda::resize(gpu_frame, resized_gpu_frame, cv::Size(384, 384));
 		}
-		std::vector<cv::Mat> mipmap_results = triple_buffered_mipmap_pipeline(
-			resized_masks_batch, frame_width, frame_height, static_cast<float>(default_scale), param_KeyLevel
-		);
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat final_result;
-			mix_images(original_frames[i + 4], glow_blow_results[i], mipmap_results[i], final_result, param_KeyScale);
-			if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
-				std::cerr << "Warning: Final blended image is empty for final sub-batch 2 frame " << i
-					<< ". Creating blank output." << std::endl;
-				final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
-			}
-			cv::imshow("Processed Frame", final_result);
-			int key = cv::waitKey(30);
-			if (key == 'q') {
-				video.release();
-				cv::destroyAllWindows();
-				goto cleanup;
-			}
-			output_video.write(final_result);
+		catch (cv::Exception& e) {
+			std::cerr << "Error during GPU resize: " << e.what() << ". Using blank image instead." << std::endl;
+			cv::Mat blank(384, 384, frame.type(), cv::Scalar(0, 0, 0));
+			resized_gpu_frame.upload(blank);
 		}
+		torch::Tensor frame_tensor = ImageProcessingUtil::process_img(resized_gpu_frame, false);
+		frame_tensor = frame_tensor.to(torch::kFloat);
+		batch_frames.push_back(frame_tensor);
 	}
 
-cleanup:
-	video.release();
-	output_video.release();
-	cv::destroyAllWindows();
-	std::cout << "Video processing completed. Saved to: " << output_video_path << std::endl;
+	std::vector<cv::Mat> masks = segment(planFilePath, torch::stack(batch_frames, 0), 1, num_contexts);
+	masks.resize(frames.size());
+	return masks;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// Function: glow_effect_video_graph
-// Description: CUDA Graph accelerated version of glow_effect_video
+// GPU backends of the glow paths (GlowGpu.hpp)
 ////////////////////////////////////////////////////////////////////////////////
-void glow_effect_video_graph(const char* video_nm, std::string planFilePath) {
-	// Performance measurement
-	auto total_start = std::chrono::high_resolution_clock::now();
-
-	cv::String info = cv::getBuildInformation();
-	std::cout << info << std::endl;
-
-	// Open video
-	cv::VideoCapture video;
-	if (!video.open(video_nm, cv::VideoCaptureAPIs::CAP_ANY)) {
-		std::cerr << "Error: Could not open video file: " << video_nm << std::endl;
-		return;
-	}
-
-	int frame_width = static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH));
-	int frame_height = static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
-	int fps = static_cast<int>(video.get(cv::CAP_PROP_FPS));
-
-	cv::Size defaultSize((frame_width > 0) ? frame_width : 640, (frame_height > 0) ? frame_height : 360);
-
-	// Create output directory if needed
-	if (!fs::exists("./VideoOutput/")) {
-		if (fs::create_directory("./VideoOutput/"))
-			std::cout << "Video Output Directory successfully created." << std::endl;
-		else {
-			std::cerr << "Failed to create video output folder." << std::endl;
-			return;
-		}
-	}
-	else {
-		std::cout << "Video Output Directory already exists." << std::endl;
-	}
-
-	// Create output video writer
-	std::string output_video_path = "./VideoOutput/processed_video_graph.avi";
-	cv::VideoWriter output_video(output_video_path,
-		cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
-		fps, cv::Size((frame_width > 0) ? frame_width : defaultSize.width,
-			(frame_height > 0) ? frame_height : defaultSize.height));
-	if (!output_video.isOpened()) {
-		std::cerr << "Error: Could not open the output video for writing: " << output_video_path << std::endl;
-		return;
-	}
-
-	// Performance metrics
-	int total_frames = 0;
-	double segmentation_time = 0.0;
-	double post_processing_time = 0.0;
-
-	// Main video processing - follows same structure as original function
-	cv::cuda::GpuMat gpu_frame;
-	std::vector<torch::Tensor> batch_frames;
-	std::vector<cv::Mat> original_frames;
-
-	// Use two futures to run segmentation concurrently on sub-batches
-	std::future<std::vector<cv::Mat>> segFuture1, segFuture2;
-	bool segFutureValid1 = false, segFutureValid2 = false;
-
-	while (video.isOpened()) {
-		batch_frames.clear();
-		original_frames.clear();
-
-		// Read a batch of 8 frames - same as original function
-		for (int i = 0; i < 8; ++i) {
-			cv::Mat frame;
-			if (!video.read(frame) || frame.empty()) {
-				if (batch_frames.empty())
-					break;
-				batch_frames.push_back(batch_frames.back());
-				original_frames.push_back(original_frames.back().clone());
-				continue;
-			}
-
-			total_frames++; // Count frames for performance metrics
-
-			if (frame.empty() || frame.cols <= 0 || frame.rows <= 0) {
-				std::cerr << "Warning: Read frame " << i << " is invalid. Using default blank image." << std::endl;
-				frame = cv::Mat(defaultSize, CV_8UC3, cv::Scalar(0, 0, 0));
-			}
-			original_frames.push_back(frame.clone());
-
-			gpu_frame.upload(frame);
-			cv::cuda::GpuMat resized_gpu_frame;
-			try {
-				cv::cuda::resize(gpu_frame, resized_gpu_frame, cv::Size(384, 384));
-			}
-			catch (cv::Exception& e) {
-				std::cerr << "Error during GPU resize: " << e.what() << ". Using blank image instead." << std::endl;
-				cv::Mat blank(384, 384, frame.type(), cv::Scalar(0, 0, 0));
-				resized_gpu_frame.upload(blank);
-			}
-			torch::Tensor frame_tensor = ImageProcessingUtil::process_img(resized_gpu_frame, false);
-			frame_tensor = frame_tensor.to(torch::kFloat);
-			batch_frames.push_back(frame_tensor);
-		}
-		if (batch_frames.empty())
-			break;
-
-		while (batch_frames.size() < 8) {
-			batch_frames.push_back(batch_frames.back());
-			original_frames.push_back(original_frames.back().clone());
-		}
-
-		// Process segmentation results from the previous iteration, if available
-		if (segFutureValid1) {
-			auto pp_start = std::chrono::high_resolution_clock::now();
-
-			std::vector<cv::Mat> grayscale_masks = segFuture1.get();
-			segFutureValid1 = false;
-
-			// Process first sub-batch (frames 0 to 3) - same as original function
-			std::vector<cv::Mat> resized_masks_batch;
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat resized_mask;
-				cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
-					? defaultSize : original_frames[i].size();
-				try {
-					cv::resize(grayscale_masks[i], resized_mask, targetSize);
-				}
-				catch (cv::Exception& e) {
-					std::cerr << "Error during segmentation mask resize for sub-batch 1 frame " << i
-						<< ": " << e.what() << ". Using blank mask." << std::endl;
-					resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-				}
-				resized_masks_batch.push_back(resized_mask);
-			}
-
-			std::vector<cv::Mat> glow_blow_results(4);
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat dst_rgba;
-				glow_blow(resized_masks_batch[i], dst_rgba, param_KeyLevel, 10);
-				if (dst_rgba.channels() != 4)
-					cv::cvtColor(dst_rgba, dst_rgba, cv::COLOR_BGR2RGBA);
-				glow_blow_results[i] = dst_rgba;
-			}
-
-			std::vector<cv::Mat> mipmap_results = triple_buffered_mipmap_pipeline(
-				resized_masks_batch, frame_width, frame_height, static_cast<float>(default_scale), param_KeyLevel
-			);
-
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat final_result;
-				mix_images(original_frames[i], glow_blow_results[i], mipmap_results[i], final_result, param_KeyScale);
-				if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
-					std::cerr << "Warning: Final blended image is empty for sub-batch 1 frame " << i
-						<< ". Creating blank output." << std::endl;
-					final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
-				}
-				cv::imshow("Processed Frame (CUDA Graph)", final_result);
-				int key = cv::waitKey(30);
-				if (key == 'q') {
-					video.release();
-					cv::destroyAllWindows();
-					goto cleanup;
-				}
-				output_video.write(final_result);
-			}
-
-			auto pp_end = std::chrono::high_resolution_clock::now();
-			post_processing_time += std::chrono::duration<double>(pp_end - pp_start).count();
-		}
-
-		if (segFutureValid2) {
-			auto pp_start = std::chrono::high_resolution_clock::now();
-
-			std::vector<cv::Mat> grayscale_masks = segFuture2.get();
-			segFutureValid2 = false;
-
-			// Process second sub-batch (frames 4 to 7) - same as original function
-			std::vector<cv::Mat> resized_masks_batch;
-			for (int i = 4; i < 8; ++i) {
-				cv::Mat resized_mask;
-				cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
-					? defaultSize : original_frames[i].size();
-				try {
-					cv::resize(grayscale_masks[i - 4], resized_mask, targetSize);
-				}
-				catch (cv::Exception& e) {
-					std::cerr << "Error during segmentation mask resize for sub-batch 2 frame " << i - 4
-						<< ": " << e.what() << ". Using blank mask." << std::endl;
-					resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-				}
-				resized_masks_batch.push_back(resized_mask);
-			}
-
-			std::vector<cv::Mat> glow_blow_results(4);
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat dst_rgba;
-				glow_blow(resized_masks_batch[i], dst_rgba, param_KeyLevel, 10);
-				if (dst_rgba.channels() != 4)
-					cv::cvtColor(dst_rgba, dst_rgba, cv::COLOR_BGR2RGBA);
-				glow_blow_results[i] = dst_rgba;
-			}
-
-			std::vector<cv::Mat> mipmap_results = triple_buffered_mipmap_pipeline(
-				resized_masks_batch, frame_width, frame_height, static_cast<float>(default_scale), param_KeyLevel
-			);
-
-			for (int i = 0; i < 4; ++i) {
-				cv::Mat final_result;
-				mix_images(original_frames[i + 4], glow_blow_results[i], mipmap_results[i], final_result, param_KeyScale);
-				if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
-					std::cerr << "Warning: Final blended image is empty for sub-batch 2 frame " << i
-						<< ". Creating blank output." << std::endl;
-					final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
-				}
-				cv::imshow("Processed Frame (CUDA Graph)", final_result);
-				int key = cv::waitKey(30);
-				if (key == 'q') {
-					video.release();
-					cv::destroyAllWindows();
-					goto cleanup;
-				}
-				output_video.write(final_result);
-			}
-
-			auto pp_end = std::chrono::high_resolution_clock::now();
-			post_processing_time += std::chrono::duration<double>(pp_end - pp_start).count();
-		}
-
-		// Prepare segmentation for the current batch
-		// Create two sub-batch tensors (each containing 4 frames)
-		torch::Tensor sub_batch_tensor1 = torch::stack(
-			std::vector<torch::Tensor>(batch_frames.begin(), batch_frames.begin() + 4), 0);
-		torch::Tensor sub_batch_tensor2 = torch::stack(
-			std::vector<torch::Tensor>(batch_frames.begin() + 4, batch_frames.end()), 0);
-
-		// Launch segmentation concurrently for both sub-batches - using CUDA Graph version
-		auto seg_start = std::chrono::high_resolution_clock::now();
-
-		segFuture1 = std::async(std::launch::async,
-			TRTInference::measure_segmentation_trt_performance_mul_concurrent_graph, // Use the graph version
-			planFilePath, sub_batch_tensor1, 1);
-		segFutureValid1 = true;
-
-		segFuture2 = std::async(std::launch::async,
-			TRTInference::measure_segmentation_trt_performance_mul_concurrent_graph, // Use the graph version 
-			planFilePath, sub_batch_tensor2, 1);
-		segFutureValid2 = true;
-
-		auto seg_end = std::chrono::high_resolution_clock::now();
-		segmentation_time += std::chrono::duration<double>(seg_end - seg_start).count();
-	}
-
-	// Process any remaining segmentation results - same as original function
-	if (segFutureValid1) {
-		auto pp_start = std::chrono::high_resolution_clock::now();
-
-		std::vector<cv::Mat> grayscale_masks = segFuture1.get();
-		std::vector<cv::Mat> resized_masks_batch;
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat resized_mask;
-			cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
-				? defaultSize : original_frames[i].size();
-			try {
-				cv::resize(grayscale_masks[i], resized_mask, targetSize);
-			}
-			catch (cv::Exception& e) {
-				std::cerr << "Error during final segmentation mask resize for sub-batch 1 frame " << i
-					<< ": " << e.what() << ". Using blank mask." << std::endl;
-				resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-			}
-			resized_masks_batch.push_back(resized_mask);
-		}
-
-		std::vector<cv::Mat> glow_blow_results(4);
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat dst_rgba;
-			glow_blow(resized_masks_batch[i], dst_rgba, param_KeyLevel, 10);
-			if (dst_rgba.channels() != 4)
-				cv::cvtColor(dst_rgba, dst_rgba, cv::COLOR_BGR2RGBA);
-			glow_blow_results[i] = dst_rgba;
-		}
-
-		std::vector<cv::Mat> mipmap_results = triple_buffered_mipmap_pipeline(
-			resized_masks_batch, frame_width, frame_height, static_cast<float>(default_scale), param_KeyLevel
-		);
-
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat final_result;
-			mix_images(original_frames[i], glow_blow_results[i], mipmap_results[i], final_result, param_KeyScale);
-			if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
-				std::cerr << "Warning: Final blended image is empty for final sub-batch 1 frame " << i
-					<< ". Creating blank output." << std::endl;
-				final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
-			}
-			cv::imshow("Processed Frame (CUDA Graph)", final_result);
-			int key = cv::waitKey(30);
-			if (key == 'q') {
-				video.release();
-				cv::destroyAllWindows();
-				goto cleanup;
-			}
-			output_video.write(final_result);
-		}
-
-		auto pp_end = std::chrono::high_resolution_clock::now();
-		post_processing_time += std::chrono::duration<double>(pp_end - pp_start).count();
-	}
-
-	if (segFutureValid2) {
-		auto pp_start = std::chrono::high_resolution_clock::now();
-
-		std::vector<cv::Mat> grayscale_masks = segFuture2.get();
-		std::vector<cv::Mat> resized_masks_batch;
-		for (int i = 4; i < 8; ++i) {
-			cv::Mat resized_mask;
-			cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
-				? defaultSize : original_frames[i].size();
-			try {
-				cv::resize(grayscale_masks[i - 4], resized_mask, targetSize);
-			}
-			catch (cv::Exception& e) {
-				std::cerr << "Error during final segmentation mask resize for sub-batch 2 frame " << i - 4
-					<< ": " << e.what() << ". Using blank mask." << std::endl;
-				resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-			}
-			resized_masks_batch.push_back(resized_mask);
-		}
-
-		std::vector<cv::Mat> glow_blow_results(4);
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat dst_rgba;
-			glow_blow(resized_masks_batch[i], dst_rgba, param_KeyLevel, 10);
-			if (dst_rgba.channels() != 4)
-				cv::cvtColor(dst_rgba, dst_rgba, cv::COLOR_BGR2RGBA);
-			glow_blow_results[i] = dst_rgba;
-		}
-
-		std::vector<cv::Mat> mipmap_results = triple_buffered_mipmap_pipeline(
-			resized_masks_batch, frame_width, frame_height, static_cast<float>(default_scale), param_KeyLevel
-		);
-
-		for (int i = 0; i < 4; ++i) {
-			cv::Mat final_result;
-			mix_images(original_frames[i + 4], glow_blow_results[i], mipmap_results[i], final_result, param_KeyScale);
-			if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
-				std::cerr << "Warning: Final blended image is empty for final sub-batch 2 frame " << i
-					<< ". Creating blank output." << std::endl;
-				final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
-			}
-			cv::imshow("Processed Frame (CUDA Graph)", final_result);
-			int key = cv::waitKey(30);
-			if (key == 'q') {
-				video.release();
-				cv::destroyAllWindows();
-				goto cleanup;
-			}
-			output_video.write(final_result);
-		}
+bool gpu_backends_available() {
+	return true;
+}
 
-		auto pp_end = std::chrono::high_resolution_clock::now();
-		post_processing_time += std::chrono::duration<double>(pp_end - pp_start).count();
-	}
+std::vector<cv::Mat> gpu_glow_mipmaps(const std::vector<cv::Mat>& key_images, const std::vector<float>& scales, int key_level) {
+	// Pinned buffers sized by the largest ROI rather than the frame.
+	return triple_buffered_mipmap_pipeline(key_images, 0, 0, scales, key_level);
+}
 
-cleanup:
-	auto total_end = std::chrono::high_resolution_clock::now();
-	double total_time = std::chrono::duration<double>(total_end - total_start).count();
+std::shared_ptr<MipmapPyramid> make_gpu_mipmap_pyramid(const cv::Mat& key_image, int param_KeyLevel) {
+	return std::make_shared<MipmapPyramidCuda>(key_image, param_KeyLevel);
+}
 
-	video.release();
-	output_video.release();
-	cv::destroyAllWindows();
+bool load_trt_plan(const std::string& planFilePath) {
+	return TRTInference::acquire_engine(planFilePath) != nullptr;
+}
 
-	// Output performance metrics
-	std::cout << "---------------------------------------------------" << std::endl;
-	std::cout << "CUDA Graph Video Processing Performance" << std::endl;
-	std::cout << "---------------------------------------------------" << std::endl;
-	std::cout << "Total frames processed: " << total_frames << std::endl;
-	std::cout << "Total processing time: " << total_time << " seconds" << std::endl;
-	if (total_frames > 0) {
-		std::cout << "Average time per frame: " << (total_time * 1000.0) / total_frames << " ms" << std::endl;
-		std::cout << "Effective frame rate: " << total_frames / total_time << " fps" << std::endl;
-	}
-	std::cout << "Segmentation time: " << segmentation_time << " seconds ("
-		<< (segmentation_time / total_time) * 100.0 << "%)" << std::endl;
-	std::cout << "Post-processing time: " << post_processing_time << " seconds ("
-		<< (post_processing_time / total_time) * 100.0 << "%)" << std::endl;
-	std::cout << "Video processing completed with CUDA Graph acceleration." << std::endl;
-	std::cout << "Saved to: " << output_video_path << std::endl;
-	std::cout << "---------------------------------------------------" << std::endl;
+SegmentFramesFn make_trt_segmenter(const std::string& planFilePath, TrtSegmentation path, BatchBounds& bounds) {
+	SegmentBatchFn segment = path == TrtSegmentation::Graph
+		? TRTInference::measure_segmentation_trt_performance_mul_concurrent_graph
+		: TRTInference::measure_segmentation_trt_performance_mul_concurrent;
+	bounds = TRTInference::get_engine_batch_bounds(planFilePath);
+	return [planFilePath, segment](const std::vector<cv::Mat>& frames, int contexts) {
+		return segment_frames_trt(frames, planFilePath, segment, contexts);
+	};
 }
 
 /**
- * @brief Applies a glow effect to video with reduced latency using only 2 parallel frames
+ * @brief Applies a glow effect to video with reduced latency using a few parallel frames
  *        and a single TensorRT engine load
  *
  * This optimized version reduces latency and overhead by:
  * 1. Loading the TensorRT engine only once at the start, rather than per batch
- * 2. Processing only 2 frames in parallel instead of 4
+ * 2. Choosing the number of parallel frames/streams per batch with an AdaptiveBatcher
+ *    in latency mode (highest throughput that keeps the frame latency under target)
  * 3. Eliminating unnecessary visualization windows
  * 4. Reducing synchronization points and memory operations
  * 5. Optimizing the processing pipeline for faster throughput
@@ -1057,8 +351,9 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 	std::cout << "Starting optimized glow effect video processing with reduced latency" << std::endl;
 
 	// *** SET YOUR SPECIFIC TARGET VALUE HERE ***
-	param_KeyLevel = 56;  // Change this to your desired segmentation class value
-	param_KeyScale = 600; // Ensure we have proper intensity set for blending
+	// Applied on top of each batch's parameter snapshot; the GUI parameters are left alone.
+	const int TARGET_KEY_LEVEL = 56;  // Change this to your desired segmentation class value
+	const int TARGET_KEY_SCALE = 600; // Ensure we have proper intensity set for blending
 
 	// Set to 0 for exact matching only, or a small value (1-2) for minimal tolerance
 	const int EXACT_DETECTION_DELTA = 20;
@@ -1076,7 +371,7 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 	// Get video properties
 	int frame_width = static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH));
 	int frame_height = static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
-	int fps = static_cast<int>(video.get(cv::CAP_PROP_FPS));
+	double fps = video.get(cv::CAP_PROP_FPS);
 
 	cv::Size defaultSize((frame_width > 0) ? frame_width : 640, (frame_height > 0) ? frame_height : 360);
 
@@ -1088,17 +383,13 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 		}
 	}
 
-	// Create output video writer
+	// Create output video writer; frames are encoded on its own thread
 	std::string output_video_path = "./VideoOutput/processed_video_optimized.avi";
-	cv::VideoWriter output_video(output_video_path,
-		cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
-		fps, cv::Size((frame_width > 0) ? frame_width : defaultSize.width,
-			(frame_height > 0) ? frame_height : defaultSize.height));
-
-	if (!output_video.isOpened()) {
-		std::cerr << "Error: Could not open the output video for writing: " << output_video_path << std::endl;
+	AsyncFrameEncoder encoder;
+	if (!open_video_output(encoder, output_video_path, fps,
+		cv::Size((frame_width > 0) ? frame_width : defaultSize.width,
+			(frame_height > 0) ? frame_height : defaultSize.height)))
 		return;
-	}
 
 	// *** OPTIMIZATION: Load TensorRT engine once at the beginning ***
 	TRTGeneration::CustomLogger myLogger;
@@ -1135,9 +426,24 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 	double segmentation_time = 0.0;
 	double post_processing_time = 0.0;
 	double mipmap_time = 0.0;
+	int frames_skipped = 0;   // frames without key pixels, passed through
+
+	// Number of parallel frames/streams per batch, adapted to the measured timings.
+	const double LATENCY_TARGET_MS = 100.0;
+	const BatchBounds batch_bounds = TRTInference::get_engine_batch_bounds(engine);
+	AdaptiveBatcher batcher(batch_bounds, AdaptiveBatcher::Mode::Latency, LATENCY_TARGET_MS, fps);
+
+	// Decode ahead on its own thread into a ring of reused frames: room for the batch being
+	// processed plus the next one, so decoding overlaps segmentation and compositing.
+	PrefetchDecoder decoder(capture_decode_source(video), 2 * batch_bounds.max_batch * batch_bounds.max_contexts + 1);
 
-	// Number of parallel streams to use
-	const int NUM_PARALLEL_STREAMS = 2;
+	// Per-frame latency from the request to the decoder until the frame is queued for encoding
+	LatencyReport latency("single-batch " + fs::path(output_video_path).filename().string(), latency_options);
+	LatencyHistogram& end_to_end_latency = latency.stage(LatencyReport::kEndToEnd);
+	LatencyHistogram& decode_latency = latency.stage("decode");
+	LatencyHistogram& segment_latency = latency.stage("segment (batch)");
+	LatencyHistogram& post_latency = latency.stage("glow (batch)");
+	std::vector<std::chrono::steady_clock::time_point> read_times;   // parallel to original_frames
 
 	// Create the final result window - ONLY ONE WINDOW
 	cv::namedWindow("Final Result", cv::WINDOW_NORMAL);
@@ -1145,12 +451,13 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 	// Main processing loop
 	cv::cuda::GpuMat gpu_frame;
 	std::vector<cv::Mat> original_frames;
+	std::vector<DecodedFrame> decoded_frames;   // ring slots backing original_frames
 	std::vector<torch::Tensor> frame_tensors;
 
 	bool processing = true;
 	int batch_count = 0;
 
-	std::cout << "TARGET VALUE: " << param_KeyLevel << " (using delta: " << EXACT_DETECTION_DELTA << ")" << std::endl;
+	std::cout << "TARGET VALUE: " << TARGET_KEY_LEVEL << " (using delta: " << EXACT_DETECTION_DELTA << ")" << std::endl;
 
 	// Pre-allocate memory for triple buffering - OPTIMIZED MEMORY USAGE
 	cudaStream_t mipmapStreams[3];
@@ -1168,36 +475,42 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 	while (processing) {
 		batch_count++;
 
-		// Clear containers for this batch
+		// Clear containers for this batch and hand the previous batch's frames back to the decoder
 		original_frames.clear();
+		for (DecodedFrame& decoded : decoded_frames)
+			decoder.release(decoded);
+		decoded_frames.clear();
 		frame_tensors.clear();
-
-		// Read a batch of frames (reduced from 4 to 2)
-		for (int i = 0; i < NUM_PARALLEL_STREAMS; ++i) {
-			cv::Mat frame;
-			if (!video.read(frame) || frame.empty()) {
-				if (i == 0) {
-					// No more frames to process
+		read_times.clear();
+		BatchPlan batch_plan = batcher.next();
+		int frames_in_batch = 0;
+
+		// Read a batch of frames
+		for (int i = 0; i < batch_plan.batch_size; ++i) {
+			DecodedFrame decoded;
+			const auto read_start = std::chrono::steady_clock::now();
+			if (!decoder.next(decoded) || decoded.frame.empty()) {
+				// No more frames: an empty batch ends processing, a partial one is
+				// processed as is (the engine takes one frame per stream, nothing to pad)
+				if (i == 0)
 					processing = false;
-					break;
-				}
-				// If we have some frames but not enough to fill all streams,
-				// duplicate the last valid frame
-				if (!original_frames.empty()) {
-					frame_tensors.push_back(frame_tensors.back().clone());
-					original_frames.push_back(original_frames.back().clone());
-				}
-				continue;
+				break;
 			}
+			cv::Mat frame = decoded.frame;
+			decoded_frames.push_back(decoded);
 
 			total_frames++;
+			frames_in_batch++;
 
 			// Handle invalid frames
 			if (frame.empty() || frame.cols <= 0 || frame.rows <= 0) {
 				frame = cv::Mat(defaultSize, CV_8UC3, cv::Scalar(0, 0, 0));
 			}
 
-			original_frames.push_back(frame.clone());
+			original_frames.push_back(frame);
+			read_times.push_back(read_start);
+			decode_latency.record_ms(
+				std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - read_start).count());
 
 			try {
 				// Preprocess frame for TensorRT - OPTIMIZED PREPROCESSING
@@ -1243,7 +556,7 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 		try {
 			// Use the preloaded engine instead of loading from the plan file
 			segmentation_masks = TRTInference::measure_segmentation_trt_performance_single_batch_parallel_preloaded(
-				engine, frame_tensors, NUM_PARALLEL_STREAMS);
+				engine, frame_tensors, batch_plan.contexts);
 		}
 		catch (const std::exception& e) {
 			std::cerr << "Error in segmentation inference: " << e.what() << std::endl;
@@ -1256,58 +569,49 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 
 		auto seg_end = std::chrono::high_resolution_clock::now();
 		segmentation_time += std::chrono::duration<double>(seg_end - seg_start).count();
+		segment_latency.record_ms(std::chrono::duration<double, std::milli>(seg_end - seg_start).count());
 
 		// Post-process each frame - OPTIMIZED PIPELINE
 		auto pp_start = std::chrono::high_resolution_clock::now();
 
-		// Vector to hold all resized masks for the batch
-		std::vector<cv::Mat> resized_masks_batch;
+		// One parameter set for the whole batch (blur scale from the GUI, fixed target class)
+		GlowParams params = glow_params.snapshot().glow;
+		params.key_level = TARGET_KEY_LEVEL;
+		params.key_scale = TARGET_KEY_SCALE;
+
+		// Keyed glow ROIs of the masks with key pixels; frames without any are passed through
+		std::vector<cv::Mat> key_images;
 		std::vector<cv::Mat> glow_blow_results;
+		std::vector<cv::Rect> glow_rois;
+		std::vector<cv::Size> glow_frames;
+		std::vector<int> mipmap_index(original_frames.size(), -1);
 
-		// First pass: resize masks and apply glow_blow - OPTIMIZED TO MINIMIZE SYNCHRONIZATION
+		// First pass: scale the run-length encoded masks and apply glow_blow - OPTIMIZED TO MINIMIZE SYNCHRONIZATION
 		for (size_t i = 0; i < segmentation_masks.size() && i < original_frames.size(); ++i) {
 			try {
-				// Resize segmentation mask to match original frame size
-				cv::Mat resized_mask;
+				// Scale the segmentation mask to the original frame size on its runs
 				cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
 					? defaultSize : original_frames[i].size();
-
-				try {
-					// Handle empty or invalid masks
-					if (segmentation_masks[i].empty() || segmentation_masks[i].cols <= 0 || segmentation_masks[i].rows <= 0) {
-						resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-					}
-					else {
-						cv::resize(segmentation_masks[i], resized_mask, targetSize);
-					}
-				}
-				catch (cv::Exception& e) {
-					std::cerr << "Error during segmentation mask resize: " << e.what() << ". Using blank mask." << std::endl;
-					resized_mask = cv::Mat(targetSize, CV_8UC1, cv::Scalar(0));
-				}
-
-				// Store the resized mask for triple buffered mipmap processing
-				resized_masks_batch.push_back(resized_mask);
+				RleMask frame_mask = frame_mask_rle(segmentation_masks[i], targetSize, static_cast<int>(i));
 
 				// Apply enhanced glow blow effect with exact matching
 				cv::Mat dst_rgba;
-				glow_blow(resized_mask, dst_rgba, param_KeyLevel, EXACT_DETECTION_DELTA);
-
-				// Ensure proper RGBA format
-				if (dst_rgba.channels() != 4) {
-					cv::cvtColor(dst_rgba, dst_rgba, cv::COLOR_BGR2BGRA);
-				}
-
-				// Store the glow blow result
+				cv::Rect region;
+				if (glow_blow(frame_mask, dst_rgba, params.key_level, EXACT_DETECTION_DELTA, &region) == 0)
+					continue;
+
+				// Store the glow blow result and the keyed ROI for triple buffered mipmap processing
+				cv::Rect roi = glow_roi(region, targetSize, static_cast<float>(params.scale));
+				mipmap_index[i] = static_cast<int>(key_images.size());
+				key_images.push_back(frame_mask.key_image(params.key_level, roi));
 				glow_blow_results.push_back(dst_rgba);
+				glow_rois.push_back(roi);
+				glow_frames.push_back(targetSize);
 			}
 			catch (const std::exception& e) {
 				std::cerr << "Error in mask preprocessing for frame " << i << ": " << e.what() << std::endl;
-				// Add placeholder blank mask and rgba output
-				cv::Size targetSize = (original_frames[i].empty() || original_frames[i].cols <= 0 || original_frames[i].rows <= 0)
-					? defaultSize : original_frames[i].size();
-				resized_masks_batch.push_back(cv::Mat(targetSize, CV_8UC1, cv::Scalar(0)));
-				glow_blow_results.push_back(cv::Mat(targetSize, CV_8UC4, cv::Scalar(0, 0, 0, 0)));
+				// A blank mask has no key pixels; the frame is passed through
+				mipmap_index[i] = -1;
 			}
 		}
 
@@ -1315,22 +619,27 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 		auto mipmap_start = std::chrono::high_resolution_clock::now();
 		std::vector<cv::Mat> mipmap_results;
 
-		if (!resized_masks_batch.empty()) {
-			mipmap_results = triple_buffered_mipmap_pipeline(
-				resized_masks_batch, frame_width, frame_height,
-				static_cast<float>(default_scale), param_KeyLevel
-			);
+		if (!key_images.empty()) {
+			mipmap_results = compute_glow_mipmaps(key_images, params, glow_rois, glow_frames);
 		}
 
 		auto mipmap_end = std::chrono::high_resolution_clock::now();
 		mipmap_time += std::chrono::duration<double>(mipmap_end - mipmap_start).count();
 
 		// Now process each frame with the precomputed mipmap results - OPTIMIZED FINAL COMPOSITING
-		for (size_t i = 0; i < original_frames.size() && i < glow_blow_results.size() && i < mipmap_results.size(); ++i) {
+		for (size_t i = 0; i < original_frames.size() && i < segmentation_masks.size(); ++i) {
 			try {
-				// Blend original, glow, and mipmap
+				// Blend original, glow, and mipmap; frames without key pixels are passed through
 				cv::Mat final_result;
-				mix_images(original_frames[i], glow_blow_results[i], mipmap_results[i], final_result, param_KeyScale);
+				int m = mipmap_index[i];
+				if (m < 0) {
+					pass_through_frame(original_frames[i], final_result);
+					frames_skipped++;
+				}
+				else {
+					blend_glow_roi(original_frames[i], glow_blow_results[m], mipmap_results[m], glow_rois[m], params.key_scale,
+						final_result);
+				}
 
 				// Handle empty result
 				if (final_result.empty() || final_result.size().width <= 0 || final_result.size().height <= 0) {
@@ -1338,6 +647,7 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 						<< ". Creating blank output." << std::endl;
 					final_result = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
 				}
+				to_encoder_frame(final_result, final_result);
 
 				// Display every frame (not just the first one in each batch)
 				cv::imshow("Final Result", final_result);
@@ -1348,13 +658,21 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 					break;
 				}
 
-				output_video.write(final_result);
+				if (!encoder.push(final_result)) {
+					std::cerr << "Error: Writing the video output failed; stopping." << std::endl;
+					processing = false;
+					break;
+				}
+				end_to_end_latency.record_ms(
+					std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - read_times[i]).count());
+				latency.frame_done();
 			}
 			catch (const std::exception& e) {
 				std::cerr << "Error in final frame composition for frame " << i << ": " << e.what() << std::endl;
 				// Create a blank output frame and continue
-				cv::Mat blank_output = cv::Mat(defaultSize, CV_8UC4, cv::Scalar(0, 0, 0, 255));
-				output_video.write(blank_output);
+				cv::Mat blank_output = cv::Mat(defaultSize, CV_8UC3, cv::Scalar(0, 0, 0));
+				if (!encoder.push(blank_output))
+					processing = false;
 
 				// Also show blank frame for errors
 				cv::imshow("Final Result", blank_output);
@@ -1364,6 +682,10 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 
 		auto pp_end = std::chrono::high_resolution_clock::now();
 		post_processing_time += std::chrono::duration<double>(pp_end - pp_start).count();
+		post_latency.record_ms(std::chrono::duration<double, std::milli>(pp_end - pp_start).count());
+		if (frames_in_batch == batch_plan.batch_size)
+			batcher.record(batch_plan, std::chrono::duration<double, std::milli>(seg_end - seg_start).count(),
+				std::chrono::duration<double, std::milli>(pp_end - pp_start).count());
 
 		// Report progress every 10 batches
 		if (batch_count % 10 == 0) {
@@ -1389,6 +711,9 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 		runtime->destroy();
 	}
 
+	// Flush the frames still queued for encoding, so they count towards the total
+	encoder.close();
+
 	// Calculate and display performance metrics
 	auto total_end = std::chrono::high_resolution_clock::now();
 	double total_time = std::chrono::duration<double>(total_end - total_start).count();
@@ -1397,8 +722,8 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 	double avg_time_per_batch = total_time / batch_count;
 
 	// Clean up
+	decoder.stop();
 	video.release();
-	output_video.release();
 	cv::destroyAllWindows();
 
 	// Simplified performance metrics as requested
@@ -1418,7 +743,12 @@ void glow_effect_video_single_batch_parallel(const char* video_nm, std::string p
 			<< (mipmap_time / total_time * 100.0) << "% of total)" << std::endl;
 		std::cout << "Post-processing time: " << post_processing_time << " seconds ("
 			<< (post_processing_time / total_time * 100.0) << "% of total)" << std::endl;
+		std::cout << "Frames without key pixels (passed through): " << frames_skipped << " of "
+			<< total_frames << std::endl;
 	}
 	std::cout << "Video saved to: " << output_video_path << std::endl;
 	std::cout << "---------------------------------------------------" << std::endl;
+	batcher.report();
+	encoder.report();
+	latency.finish();
 }
\ No newline at end of file
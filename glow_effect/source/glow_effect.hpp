@@ -5,15 +5,17 @@
 #include <opencv2/core.hpp>
 #include <opencv2/core/mat.hpp>
 #include <string>
+#include <vector>
 #include <opencv2/imgproc.hpp>
 
+#include "GlowRender.hpp"
+#include "GlowGpu.hpp"
+#include "mipmap.h"
+
 /**
- * External GUI-controlled variables.
+ * External GUI-controlled variables; the glow parameters are in glow_params (GlowParamBlock.hpp).
  */
 extern int button_id;
-extern int param_KeyScale;
-extern int param_KeyLevel;
-extern int default_scale;
 extern cv::Vec3b param_KeyColor;
 
 /**
@@ -30,31 +32,19 @@ void filter_mipmap(const int width, const int height, const float scale, const u
 /**
  * @brief Applies a glow effect to an image using a provided grayscale mask.
  *
+ * Intermediates are cached across calls (GlowImageCache), so a call that only changes
+ * params recomputes what depends on them. Calls must not overlap. Nothing is shown, so it
+ * can run on a worker thread; the caller displays output_image on its GUI thread.
+ *
  * @param image_nm       Path to the input image file.
  * @param grayscale_mask A single-channel mask guiding the glow effect.
+ * @param params         Parameter snapshot to render with.
+ * @param output_image   Destination of the rendered image (CV_8UC4), a copy owned by the caller.
+ * @param cancelled      Optional; polled between stages, a true result abandons the render.
+ * @return true if the image was rendered.
  */
-void glow_effect_image(const char* image_nm, const cv::Mat& grayscale_mask);
-
-/**
- * @brief Applies a glow effect to a video file.
- *
- * @param video_nm     Path to the input video file.
- * @param planFilePath Path to the TRT plan file.
- */
-void glow_effect_video(const char* video_nm, std::string planFilePath);
-
-/**
- * @brief Applies a glow effect to a video file using CUDA Graph acceleration.
- *
- * This function maintains the same parallel processing approach as glow_effect_video,
- * but enhances the segmentation phase with CUDA Graph technology to reduce kernel
- * launch overhead and improve overall performance. The function processes frames in
- * batches of 8, dividing them into two sub-batches of 4 frames each for parallel processing.
- *
- * @param video_nm     Path to the input video file.
- * @param planFilePath Path to the TRT plan file.
- */
-void glow_effect_video_graph(const char* video_nm, std::string planFilePath);
+bool glow_effect_image(const char* image_nm, const cv::Mat& grayscale_mask, const GlowParams& params,
+	cv::Mat& output_image, const GlowCancelFn& cancelled = nullptr);
 
 /**
  * @brief Applies a glow effect to video using parallel processing of single-batch TRT model
@@ -72,17 +62,14 @@ void glow_effect_video_graph(const char* video_nm, std::string planFilePath);
 void glow_effect_video_single_batch_parallel(const char* video_nm, std::string planFilePath);
 
 /**
- * @brief Applies a "blow" (highlight) effect based on a grayscale mask.
+ * @brief Keys a grayscale mask into the RGBA buffer the mipmap filters take.
  *
- * If any pixel in the input mask is within the specified tolerance (Delta) of
- * the key level (param_KeyLevel), the entire output image is filled with a pink overlay.
+ * Pixels equal to param_KeyLevel become opaque gray, all others transparent black; a negative
+ * param_KeyLevel keeps every nonzero pixel (already keyed images).
  *
- * @param mask          A single-channel (CV_8UC1) mask.
- * @param dst_rgba      Destination RGBA image (CV_8UC4); will be created/overwritten.
- * @param param_KeyLevel Key level parameter controlling the highlight trigger.
- * @param Delta         Tolerance range around param_KeyLevel.
+ * @param dst Buffer of frame_width * frame_height pixels.
  */
-void glow_blow(const cv::Mat& mask, cv::Mat& dst_rgba, int param_KeyLevel, int Delta);
+void convert_mask_to_rgba_buffer(const cv::Mat& mask, uchar4* dst, int frame_width, int frame_height, int param_KeyLevel);
 
 /**
  * @brief Applies a mipmap filtering operation on a grayscale image and outputs an RGBA image.
@@ -109,23 +96,35 @@ void apply_mipmap(const cv::Mat& src, cv::Mat& dst, float scale, int param_KeyLe
  * @param input_gray    The source single-channel (CV_8UC1) grayscale image.
  * @param dst_img       Pointer to the preallocated pinned host memory for the output RGBA image.
  * @param scale         The scale factor used by the mipmap filter.
- * @param param_KeyLevel Grayscale value determining which pixels become opaque.
+ * @param param_KeyLevel Grayscale value determining which pixels become opaque; negative for an
+ *                      already keyed image, whose nonzero pixels all become opaque.
  * @param stream        The non-blocking CUDA stream on which to perform asynchronous mipmap filtering.
  */
 void apply_mipmap_async(const cv::Mat& input_gray, uchar4* dst_img, float scale, int param_KeyLevel, cudaStream_t stream);
 
 /**
- * @brief Blends two images using a mask and per-pixel alpha blending.
+ * @brief GPU mipmap pyramid of a keyed grayscale image, kept on the device.
  *
- * The function blends a source image with a highlighted image using a grayscale mask
- * (interpreted as alpha values scaled by param_KeyScale), producing a final blended RGBA output.
- *
- * @param src_img        First source image.
- * @param dst_rgba       Second source image (highlighted).
- * @param mipmap_result  Grayscale mask image used for alpha blending.
- * @param output_image   Destination blended image.
- * @param param_KeyScale Blending factor scaling.
+ * The chain is built once; every sample is a texture lookup kernel over the requested region
+ * (sample_mipmap_chain), so blur scale changes and several scales per mask skip the build.
+ * Samples are RGBA (CV_8UC4) like apply_mipmap.
  */
-void mix_images(const cv::Mat& src_img, const cv::Mat& dst_rgba, const cv::Mat& mipmap_result, cv::Mat& output_image, float param_KeyScale);
+class MipmapPyramidCuda : public MipmapPyramid {
+public:
+	/**
+	 * @param key_image      Source grayscale image (CV_8UC1).
+	 * @param param_KeyLevel Grayscale value that is made opaque (see convert_mask_to_rgba_buffer).
+	 */
+	MipmapPyramidCuda(const cv::Mat& key_image, int param_KeyLevel);
+	~MipmapPyramidCuda() override;
+	MipmapPyramidCuda(const MipmapPyramidCuda&) = delete;
+	MipmapPyramidCuda& operator=(const MipmapPyramidCuda&) = delete;
+
+	cv::Mat sample(float scale, const cv::Rect& region = cv::Rect()) override;
+	cv::Size size() const override { return cv::Size(chain.width, chain.height); }
+
+private:
+	MipmapChain chain;
+};
 
 #endif // GLOW_EFFECT_HPP
\ No newline at end of file
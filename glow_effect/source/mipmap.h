@@ -19,6 +19,48 @@
  */
 void filter_mipmap(const int width, const int height, const float scale, const uchar4* src_img, uchar4* dst_img);
 
+/**
+ * @brief A mipmap chain kept on the device, so several blur scales or regions can be sampled
+ *        from one build.
+ */
+struct MipmapChain {
+	cudaMipmappedArray_t array = nullptr;  ///< All levels; level 0 is the source image.
+	int width = 0;                         ///< Width of level 0.
+	int height = 0;                        ///< Height of level 0.
+	int n_level = 0;                       ///< Number of levels down to 1x1.
+};
+
+/**
+ * @brief Uploads an RGBA image and generates its complete mipmap chain on the device.
+ *
+ * @param width   The width of the input image.
+ * @param height  The height of the input image.
+ * @param src_img Pointer to the input image data in host memory (RGBA, stored as uchar4).
+ * @param chain   Receives the chain; release it with free_mipmap_chain.
+ */
+void build_mipmap_chain(const int width, const int height, const uchar4* src_img, MipmapChain& chain);
+
+/**
+ * @brief Samples a region of a built chain at a blur scale, without rebuilding any level.
+ *
+ * The result equals the same region of filter_mipmap on the chain's source image.
+ *
+ * @param chain      Chain from build_mipmap_chain.
+ * @param scale      The scale factor used for mipmap sampling.
+ * @param x0         First column of the region.
+ * @param y0         First row of the region.
+ * @param out_width  Width of the region.
+ * @param out_height Height of the region.
+ * @param dst_img    Host buffer of out_width x out_height pixels for the result.
+ */
+void sample_mipmap_chain(const MipmapChain& chain, const float scale, const int x0, const int y0, const int out_width,
+	const int out_height, uchar4* dst_img);
+
+/**
+ * @brief Frees the device memory of a chain; the chain is empty afterwards.
+ */
+void free_mipmap_chain(MipmapChain& chain);
+
 /**
  * @brief Asynchronously applies a mipmap filter to an image.
  *
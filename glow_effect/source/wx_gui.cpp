@@ -195,7 +195,7 @@ void MainFrame::OnKeyScaleChange(wxCommandEvent& event) {
 	int value = keyScaleSlider->GetValue();
 
 	// 2) Log something
-	std::clog << "Key Scale updated to: " << param_KeyScale << std::endl;
+	std::clog << "Key Scale updated to: " << value << std::endl;
 
 	// 3) update
 	bar_key_scale_cb(value);
@@ -209,7 +209,7 @@ void MainFrame::OnDefaultScaleChange(wxCommandEvent& event) {
 	int value = defaultScaleSlider->GetValue();
 
 	// 2) Log something
-	std::clog << "Default scale updated to: " << default_scale << std::endl;
+	std::clog << "Default scale updated to: " << value << std::endl;
 
 	// 3) update
 	bar_default_scale_cb(value);
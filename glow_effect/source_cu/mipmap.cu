@@ -16,7 +16,7 @@
 
 #include "old_movies.cuh"
 #include "mipmap.h"
-extern bool button_State[5];
+#include "GlowParamBlock.hpp"
 
 /**
  * @brief CUDA kernel to generate a mipmap level by downscaling an input texture.
@@ -219,28 +219,74 @@ __global__ void d_get_mipmap(
 }
 
 /**
- * @brief Retrieves a mipmap image with uniform blur using CUDA texture sampling.
+ * @brief CUDA kernel to sample a region of a mipmapped texture with a uniform LOD.
+ *
+ * Same sampling as the uniform-LOD d_get_mipmap, but only for the out_width x out_height
+ * pixels starting at (x0, y0) of the level-0 image, so one pyramid can answer any region.
+ *
+ * @param texEngine  CUDA texture object for the mipmapped texture.
+ * @param width      Width of level 0 of the texture.
+ * @param height     Height of level 0 of the texture.
+ * @param x0         First column of the region.
+ * @param y0         First row of the region.
+ * @param out_width  Width of the region and of the output buffer.
+ * @param out_height Height of the region and of the output buffer.
+ * @param scale      Scale factor used to compute the uniform LOD.
+ * @param dout       Output buffer for storing the resulting uchar4 color values.
+ */
+__global__ void d_get_mipmap_region(
+	cudaTextureObject_t texEngine,
+	const int width,
+	const int height,
+	const int x0,
+	const int y0,
+	const int out_width,
+	const int out_height,
+	const float scale,
+	uchar4* dout
+) {
+	int xi = blockIdx.x * blockDim.x + threadIdx.x;
+	int yi = blockIdx.y * blockDim.y + threadIdx.y;
+	int idx = yi * out_width + xi;
+
+	float u = (xi + x0 + 0.5f) / static_cast<float>(width);
+	float v = (yi + y0 + 0.5f) / static_cast<float>(height);
+
+	// Compute the uniform LOD based on the scale factor.
+	float lod = log2(scale);
+
+	if (xi < out_width && yi < out_height) {
+		float4 data = tex2DLod<float4>(texEngine, u, v, lod);
+		dout[idx] = to_uchar4(255.0f * data);
+	}
+}
+
+/**
+ * @brief Retrieves a region of a mipmap image with uniform blur using CUDA texture sampling.
  *
  * This function creates a texture object from a CUDA mipmapped array and launches a kernel
- * to retrieve the mipmapped image. The resulting image is copied from device to host.
+ * to retrieve the mipmapped region. The resulting image is copied from device to host.
  *
  * @param mm_array  CUDA mipmapped array containing the mipmap levels.
  * @param img_size  Dimensions of the image and number of mipmap levels (int3: {width, height, n_level}).
  * @param scale     Scale factor used to compute the LOD for mipmap sampling.
- * @param dout      Host output buffer for storing the resulting uchar4 image.
+ * @param region    Region of level 0 to retrieve (int4: {x0, y0, width, height}).
+ * @param dout      Host output buffer for storing the resulting uchar4 region.
  */
-static void get_mipmap(cudaMipmappedArray_t mm_array, const int3 img_size, const float scale, uchar4* dout) {
+static void get_mipmap(cudaMipmappedArray_t mm_array, const int3 img_size, const float scale, const int4 region, uchar4* dout) {
 	const int width = img_size.x;
 	const int height = img_size.y;
 	const int n_level = img_size.z;
-	const int asize = width * height;
+	const int asize = region.z * region.w;
 
 	// Set up the texture resource description for the mipmapped array.
 	cudaResourceDesc texResrc = {};
 	texResrc.resType = cudaResourceTypeMipmappedArray;
 	texResrc.res.mipmap.mipmap = mm_array;
 
-	// Configure texture description using button_State to control filter modes.
+	// Configure texture description using the filter buttons; one snapshot so the modes stay consistent.
+	const GlowParamSnapshot params = glow_params.snapshot();
+	const bool* button_State = params.button_state;
 	cudaTextureDesc texDescr = {};
 	texDescr.normalizedCoords = 1;
 	texDescr.filterMode = button_State[0] ? cudaFilterModeLinear : cudaFilterModePoint;
@@ -262,12 +308,12 @@ static void get_mipmap(cudaMipmappedArray_t mm_array, const int3 img_size, const
 
 	// Define kernel launch configuration.
 	dim3 blocksize(16, 16, 1);
-	dim3 gridsize((width + blocksize.x - 1) / blocksize.x,
-		(height + blocksize.y - 1) / blocksize.y,
+	dim3 gridsize((region.z + blocksize.x - 1) / blocksize.x,
+		(region.w + blocksize.y - 1) / blocksize.y,
 		1);
 
-	// Launch the kernel to retrieve the mipmap with uniform LOD.
-	d_get_mipmap << <gridsize, blocksize >> > (texEngine, width, height, scale, d_out);
+	// Launch the kernel to retrieve the region with uniform LOD.
+	d_get_mipmap_region << <gridsize, blocksize >> > (texEngine, width, height, region.x, region.y, region.z, region.w, scale, d_out);
 
 	// Copy the result from device memory to the host output buffer.
 	checkCudaErrors(cudaMemcpy(dout, d_out, asize * sizeof(uchar4), cudaMemcpyDeviceToHost));
@@ -291,6 +337,21 @@ static void get_mipmap(cudaMipmappedArray_t mm_array, const int3 img_size, const
  * @param dst_img Pointer to the output image data in host memory.
  */
 void filter_mipmap(const int width, const int height, const float scale, const uchar4* src_img, uchar4* dst_img) {
+	MipmapChain chain;
+	build_mipmap_chain(width, height, src_img, chain);
+	sample_mipmap_chain(chain, scale, 0, 0, width, height, dst_img);
+	free_mipmap_chain(chain);
+}
+
+/**
+ * @brief Builds the complete mipmap chain of an image and keeps it on the device.
+ *
+ * @param width   Width of the input image.
+ * @param height  Height of the input image.
+ * @param src_img Pointer to the input image data in host memory.
+ * @param chain   Receives the mipmapped array; release it with free_mipmap_chain.
+ */
+void build_mipmap_chain(const int width, const int height, const uchar4* src_img, MipmapChain& chain) {
 	// Calculate the number of mipmap levels based on the maximum dimension.
 	int n_level = 0;
 	int level = max(height, width);
@@ -321,11 +382,38 @@ void filter_mipmap(const int width, const int height, const float scale, const u
 	// Generate all subsequent mipmap levels.
 	gen_mipmap(mm_array, img_size);
 
-	// Retrieve the filtered (blurred) mipmap image from the mipmapped array.
-	get_mipmap(mm_array, make_int3(width, height, n_level), scale, dst_img);
+	chain.array = mm_array;
+	chain.width = width;
+	chain.height = height;
+	chain.n_level = n_level;
+}
 
-	// Free the allocated CUDA mipmapped array.
-	checkCudaErrors(cudaFreeMipmappedArray(mm_array));
+/**
+ * @brief Samples a region of a built mipmap chain at a blur scale.
+ *
+ * @param chain      Chain from build_mipmap_chain.
+ * @param scale      Scale factor used for the blur effect.
+ * @param x0         First column of the region in the chain's level 0.
+ * @param y0         First row of the region in the chain's level 0.
+ * @param out_width  Width of the region.
+ * @param out_height Height of the region.
+ * @param dst_img    Host buffer of out_width x out_height pixels.
+ */
+void sample_mipmap_chain(const MipmapChain& chain, const float scale, const int x0, const int y0, const int out_width,
+	const int out_height, uchar4* dst_img) {
+	get_mipmap(chain.array, make_int3(chain.width, chain.height, chain.n_level), scale,
+		make_int4(x0, y0, out_width, out_height), dst_img);
+}
+
+/**
+ * @brief Frees the device memory of a mipmap chain and resets it.
+ *
+ * @param chain Chain from build_mipmap_chain; may be empty.
+ */
+void free_mipmap_chain(MipmapChain& chain) {
+	if (chain.array)
+		checkCudaErrors(cudaFreeMipmappedArray(chain.array));
+	chain = MipmapChain();
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -24,6 +24,12 @@ void test_movie_kernel();
 
 int main(int argc, char* argv[])
 {
+    // CPU filter microbenchmarks, no GPU or input file needed
+    if (argc >= 2 && std::string(argv[1]) == "bench") {
+        bench_movies();
+        return 0;
+    }
+
     test_mipmap();
     //test_mipmap_short();
     //test_gaussian();
@@ -36,7 +42,8 @@ int main(int argc, char* argv[])
         printf("\n");
         printf("   usage: movie_effect.exe  image(.jpg/png/tiff)\n");
         printf("   usage: movie_effect.exe  video(.mp4/mov/mpeg)\n");
-        printf("   usage: movie_effect.exe  webcam(0, 1, ..., 9)\n\n");
+        printf("   usage: movie_effect.exe  webcam(0, 1, ..., 9)\n");
+        printf("   usage: movie_effect.exe  bench\n\n");
         printf("   click on the word button at left top corner to switch effect mode\n\n");
     };
 
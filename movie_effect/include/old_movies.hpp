@@ -17,6 +17,7 @@
 
 #include "all_common.h"
 #include "tools_video.h"
+#include "tools_task.h"
 
 #define ModePosX    4
 #define ModePosY    50
@@ -30,6 +31,7 @@ void old_movies_video(const char* video_nm, const bool is_cuda);
 void color_polarizer(cv::Mat& src_img, cv::Mat& dst_img);
 void initial_defocus(const float param_Fuzzy);
 void dynamic_defocus(cv::Mat& image);
+void bench_movies(void);
 
 void set_sliders(void);
 void set_buttons(cv::Mat&);
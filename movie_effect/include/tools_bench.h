@@ -0,0 +1,152 @@
+/*******************************************************************************************************************
+ * FILE NAME   :    tools_bench.h
+ *
+ * PROJECTION  :    general c++ lib for video processing
+ *
+ * DESCRIPTION :    microbenchmark harness for the CPU image kernels
+ *                  - bench::run      : warms a kernel up, repeats it for a minimum time, keeps every sample
+ *                  - bench::result   : best / median time per call and throughput in Mpix/s (median based)
+ *                  - bench::sizes()  : the standard frame sizes every kernel is measured at (720p, 1080p, 4K)
+ *                  - bench::report   : fixed-width table lines so runs of two builds can be diffed
+ *                  - bench::mute_cout: silences kernels that log every call while they are measured or compared
+ *
+ * VERSION HISTORY
+ * YYYY/MMM/DD      Author          Comments
+ * 2025 MAR 24      GlowEffect team Creation
+ *
+ ********************************************************************************************************************/
+#ifndef __TOOLS_BENCH_H__
+#define __TOOLS_BENCH_H__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+    //================================
+    // frame sizes of the suite
+    //================================
+    struct frame_size
+    {
+        const char* name;
+        int         width;
+        int         height;
+    };
+
+    inline const std::vector<frame_size>& sizes()
+    {
+        static const std::vector<frame_size> standard = { { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+        return standard;
+    }
+
+    //================================
+    // one measured kernel at one size
+    //================================
+    struct result
+    {
+        std::string name;
+        std::string size;
+        int         width = 0;
+        int         height = 0;
+        int         iterations = 0;
+        double      best_ms = 0.;
+        double      median_ms = 0.;
+        double      mpix_per_s = 0.;   // width * height / median
+    };
+
+    // keeps the compiler from dropping a result nobody reads
+    inline void keep(const void* p)
+    {
+        static const void* volatile sink;
+        sink = p;
+        (void)sink;
+    }
+
+    // runs fn() once to warm caches and lazy allocations, then repeats it until min_ms have passed
+    // and at least min_iters samples were taken
+    template<typename Fn>
+    result run(const std::string& name, const frame_size& size, Fn&& fn, const double min_ms = 250., const int min_iters = 5)
+    {
+        using clock = std::chrono::steady_clock;
+        fn();
+
+        std::vector<double> samples;
+        const clock::time_point bgn = clock::now();
+        while (static_cast<int>(samples.size()) < min_iters ||
+               std::chrono::duration<double, std::milli>(clock::now() - bgn).count() < min_ms)
+        {
+            const clock::time_point t0 = clock::now();
+            fn();
+            samples.push_back(std::chrono::duration<double, std::milli>(clock::now() - t0).count());
+        }
+        std::sort(samples.begin(), samples.end());
+
+        result res;
+        res.name = name;
+        res.size = size.name;
+        res.width = size.width;
+        res.height = size.height;
+        res.iterations = static_cast<int>(samples.size());
+        res.best_ms = samples.front();
+        res.median_ms = samples[samples.size() / 2];
+        res.mpix_per_s = res.median_ms > 0. ? size.width * double(size.height) / (res.median_ms * 1000.) : 0.;
+        return res;
+    }
+
+    // std::cout is muted while it lives; tables are printed with printf
+    class mute_cout
+    {
+    public:
+        mute_cout() : saved(std::cout.rdbuf(nullptr)) {}
+        ~mute_cout()
+        {
+            std::cout.rdbuf(saved);
+            std::cout.clear();
+        }
+        mute_cout(const mute_cout&) = delete;
+        mute_cout& operator=(const mute_cout&) = delete;
+
+    private:
+        std::streambuf* saved;
+    };
+
+    //================================
+    // report lines
+    //================================
+    inline void report_header(const char* title)
+    {
+        std::printf("---------------------------------------------------\n");
+        std::printf("%s\n", title);
+        std::printf("---------------------------------------------------\n");
+        std::printf("%-34s %-6s %6s %10s %10s %10s\n", "kernel", "size", "iters", "best ms", "median ms", "Mpix/s");
+    }
+
+    inline void report(const result& res)
+    {
+        std::printf("%-34s %-6s %6d %10.3f %10.3f %10.1f\n", res.name.c_str(), res.size.c_str(), res.iterations,
+            res.best_ms, res.median_ms, res.mpix_per_s);
+    }
+
+    inline void report_skipped(const char* name, const char* reason)
+    {
+        std::printf("%-34s skipped: %s\n", name, reason);
+    }
+
+    // runs and reports fn at every size of the suite; make(size) prepares the inputs and returns the kernel
+    template<typename Make>
+    void run_sizes(const std::string& name, Make&& make)
+    {
+        for (const frame_size& size : sizes()) {
+            auto fn = make(size);
+            report(run(name, size, fn));
+        }
+    }
+
+} // namespace bench
+
+#endif
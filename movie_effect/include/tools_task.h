@@ -0,0 +1,418 @@
+/*******************************************************************************************************************
+ * FILE NAME   :    tools_task.h
+ *
+ * PROJECTION  :    general c++ lib for video processing
+ *
+ * DESCRIPTION :    work-stealing task scheduler shared by every CPU-side stage
+ *                  - one pool per process (task::scheduler::global()) so concurrent stages never oversubscribe
+ *                  - per-worker deques: owner pushes/pops at the back, thieves steal from the front
+ *                  - task::group      : fork/join set of tasks, wait() helps running queued work
+ *                  - parallel_for     : splits an index range (typically image rows) into bands
+ *                  - task::graph      : small dependency graph for per-frame stages
+ *
+ * VERSION HISTORY
+ * YYYY/MMM/DD      Author          Comments
+ * 2025 MAR 10      GlowEffect team Creation
+ *
+ ********************************************************************************************************************/
+#ifndef __TOOLS_TASK_H__
+#define __TOOLS_TASK_H__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace task {
+
+    class scheduler;
+
+    //================================
+    // group: a set of tasks that can be waited on together
+    //================================
+    class group
+    {
+    public:
+        explicit group(scheduler& sched);
+        group();
+        ~group() { wait_no_throw(); }
+
+        group(const group&) = delete;
+        group& operator=(const group&) = delete;
+
+        // submits fn to the scheduler as part of this group
+        void run(std::function<void()> fn);
+
+        // blocks until every task of the group finished; the calling thread runs queued tasks meanwhile
+        // and sleeps when there are none. the first exception thrown by a task is re-thrown here.
+        void wait();
+
+    private:
+        friend class scheduler;
+
+        void finish_one(std::exception_ptr err);
+
+        void wait_no_throw()
+        {
+            try { wait(); }
+            catch (...) {}
+        }
+
+        scheduler&          sched;
+        std::atomic<int>    pending{ 0 };
+        std::mutex          err_mutex;
+        std::exception_ptr  first_error;
+    };
+
+    //================================
+    // scheduler: fixed pool of workers with one deque each
+    //================================
+    class scheduler
+    {
+    public:
+        // n_workers == 0 picks hardware_concurrency() - 1 (the submitting thread helps while waiting)
+        explicit scheduler(unsigned n_workers = 0)
+        {
+            if (n_workers == 0) {
+                unsigned hw = std::thread::hardware_concurrency();
+                n_workers = hw > 1 ? hw - 1 : 1;
+            }
+            queues.reserve(n_workers);
+            for (unsigned i = 0; i < n_workers; i++)
+                queues.emplace_back(new worker_queue);
+            workers.reserve(n_workers);
+            for (unsigned i = 0; i < n_workers; i++)
+                workers.emplace_back([this, i]() { worker_loop(i); });
+        }
+
+        ~scheduler()
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                stopping = true;
+            }
+            sleep_cv.notify_all();
+            for (auto& t : workers)
+                t.join();
+        }
+
+        scheduler(const scheduler&) = delete;
+        scheduler& operator=(const scheduler&) = delete;
+
+        // process-wide pool used by all stages
+        static scheduler& global()
+        {
+            static scheduler instance;
+            return instance;
+        }
+
+        unsigned size() const { return (unsigned)workers.size(); }
+
+        // fire-and-forget submission; prefer group::run or async when completion matters
+        void submit(std::function<void()> fn) { push(item{ std::move(fn), nullptr }); }
+
+        // submits a callable and returns a future for its result
+        template<typename F>
+        auto async(F&& fn) -> std::future<typename std::invoke_result<F>::type>
+        {
+            using R = typename std::invoke_result<F>::type;
+            auto job = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+            std::future<R> result = job->get_future();
+            submit([job]() { (*job)(); });
+            return result;
+        }
+
+        // runs one queued task on the calling thread if there is any; used by waiting threads
+        bool help_one()
+        {
+            item it;
+            if (!pop_any(tls_index(), it))
+                return false;
+            execute(it);
+            return true;
+        }
+
+        // calls body(b0, b1) on disjoint bands of [begin, end); grain <= 0 picks a band size automatically
+        void parallel_for(const int begin, const int end, int grain, const std::function<void(int, int)>& body)
+        {
+            const int count = end - begin;
+            if (count <= 0)
+                return;
+            if (grain <= 0)
+                grain = std::max(1, count / (int)(4 * (size() + 1)));
+            if (count <= grain) {
+                body(begin, end);
+                return;
+            }
+
+            group g(*this);
+            int b0 = begin;
+            // keep the last band for the calling thread
+            for (; b0 + grain < end; b0 += grain) {
+                const int b1 = b0 + grain;
+                g.run([&body, b0, b1]() { body(b0, b1); });
+            }
+            std::exception_ptr err;
+            try { body(b0, end); }
+            catch (...) { err = std::current_exception(); }
+            g.wait();
+            if (err)
+                std::rethrow_exception(err);
+        }
+
+    private:
+        friend class group;
+
+        struct item
+        {
+            std::function<void()>   fn;
+            group*                  owner = nullptr;
+        };
+
+        struct worker_queue
+        {
+            std::mutex          mutex;
+            std::deque<item>    tasks;
+        };
+
+        // worker index of the calling thread within this scheduler, -1 for foreign threads
+        int tls_index() const
+        {
+            return tls_owner() == this ? tls_worker() : -1;
+        }
+
+        static const scheduler*& tls_owner()
+        {
+            static thread_local const scheduler* owner = nullptr;
+            return owner;
+        }
+
+        static int& tls_worker()
+        {
+            static thread_local int index = -1;
+            return index;
+        }
+
+        void push(item it)
+        {
+            int idx = tls_index();
+            if (idx < 0)
+                idx = (int)(next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size());
+            {
+                std::lock_guard<std::mutex> lock(queues[idx]->mutex);
+                queues[idx]->tasks.push_back(std::move(it));
+            }
+            queued.fetch_add(1, std::memory_order_release);
+            {
+                // pairs with the predicate check in worker_loop so a wake-up is never lost
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+            }
+            sleep_cv.notify_one();
+        }
+
+        // own deque first (LIFO, cache-warm), then steal FIFO from the others
+        bool pop_any(const int self, item& out)
+        {
+            if (queued.load(std::memory_order_acquire) == 0)
+                return false;
+
+            const int n = (int)queues.size();
+            if (self >= 0) {
+                worker_queue& q = *queues[self];
+                std::lock_guard<std::mutex> lock(q.mutex);
+                if (!q.tasks.empty()) {
+                    out = std::move(q.tasks.back());
+                    q.tasks.pop_back();
+                    queued.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+
+            const int start = self >= 0 ? self + 1 : (int)(steal_seed.fetch_add(1, std::memory_order_relaxed) % n);
+            for (int k = 0; k < n; k++) {
+                const int victim = (start + k) % n;
+                if (victim == self)
+                    continue;
+                worker_queue& q = *queues[victim];
+                std::lock_guard<std::mutex> lock(q.mutex);
+                if (!q.tasks.empty()) {
+                    out = std::move(q.tasks.front());
+                    q.tasks.pop_front();
+                    queued.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static void execute(item& it)
+        {
+            std::exception_ptr err;
+            try { it.fn(); }
+            catch (...) { err = std::current_exception(); }
+            if (it.owner)
+                it.owner->finish_one(err);
+        }
+
+        void worker_loop(const int index)
+        {
+            tls_owner() = this;
+            tls_worker() = index;
+
+            for (;;) {
+                item it;
+                if (pop_any(index, it)) {
+                    execute(it);
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+                sleep_cv.wait(lock, [this]() {
+                    return stopping || queued.load(std::memory_order_acquire) > 0;
+                });
+                if (stopping && queued.load(std::memory_order_acquire) == 0)
+                    return;
+            }
+        }
+
+        std::vector<std::unique_ptr<worker_queue>>  queues;
+        std::vector<std::thread>                    workers;
+        std::atomic<int>                            queued{ 0 };
+        std::atomic<unsigned>                       next_queue{ 0 };
+        std::atomic<unsigned>                       steal_seed{ 0 };
+        std::mutex                                  sleep_mutex;
+        std::condition_variable                     sleep_cv;
+        bool                                        stopping = false;
+    };
+
+    inline group::group(scheduler& s) : sched(s) {}
+    inline group::group() : sched(scheduler::global()) {}
+
+    inline void group::run(std::function<void()> fn)
+    {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        sched.push(scheduler::item{ std::move(fn), this });
+    }
+
+    inline void group::finish_one(std::exception_ptr err)
+    {
+        if (err) {
+            std::lock_guard<std::mutex> lock(err_mutex);
+            if (!first_error)
+                first_error = err;
+        }
+        // the group may be gone once pending reaches 0, so only the scheduler is touched afterwards
+        scheduler& s = sched;
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            {
+                std::lock_guard<std::mutex> lock(s.sleep_mutex);
+            }
+            s.sleep_cv.notify_all();
+        }
+    }
+
+    inline void group::wait()
+    {
+        // waiters share the workers' condition variable: push() wakes them for new work to help with,
+        // finish_one() when the last task of a group completed
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (sched.help_one())
+                continue;
+            std::unique_lock<std::mutex> lock(sched.sleep_mutex);
+            sched.sleep_cv.wait(lock, [this]() {
+                return pending.load(std::memory_order_acquire) == 0 || sched.queued.load(std::memory_order_acquire) > 0;
+            });
+        }
+        std::exception_ptr err;
+        {
+            std::lock_guard<std::mutex> lock(err_mutex);
+            std::swap(err, first_error);
+        }
+        if (err)
+            std::rethrow_exception(err);
+    }
+
+    //================================
+    // graph: nodes run once all their predecessors completed
+    //================================
+    class graph
+    {
+    public:
+        // adds a stage and returns its node id
+        int add(std::function<void()> fn)
+        {
+            nodes.emplace_back(new node(std::move(fn)));
+            return (int)nodes.size() - 1;
+        }
+
+        // 'after' starts only when 'before' finished
+        void precede(const int before, const int after)
+        {
+            nodes[before]->successors.push_back(after);
+            nodes[after]->n_deps++;
+        }
+
+        // executes the whole graph and blocks until every node ran
+        void run(scheduler& sched = scheduler::global())
+        {
+            group g(sched);
+            for (auto& n : nodes)
+                n->remaining.store(n->n_deps, std::memory_order_relaxed);
+            for (int i = 0; i < (int)nodes.size(); i++)
+                if (nodes[i]->n_deps == 0)
+                    launch(g, i);
+            g.wait();
+        }
+
+    private:
+        struct node
+        {
+            explicit node(std::function<void()> f) : fn(std::move(f)) {}
+
+            std::function<void()>   fn;
+            std::vector<int>        successors;
+            int                     n_deps = 0;
+            std::atomic<int>        remaining{ 0 };
+        };
+
+        void launch(group& g, const int id)
+        {
+            g.run([this, &g, id]() {
+                nodes[id]->fn();
+                for (int next : nodes[id]->successors)
+                    if (nodes[next]->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        launch(g, next);
+            });
+        }
+
+        std::vector<std::unique_ptr<node>> nodes;
+    };
+
+    //================================
+    // convenience wrappers on the global pool
+    //================================
+
+    // runs body(r0, r1) over bands of image rows; bands are at least min_rows tall
+    inline void parallel_rows(const int rows, const std::function<void(int, int)>& body, const int min_rows = 16)
+    {
+        scheduler& s = scheduler::global();
+        int grain = std::max(min_rows, rows / (int)(4 * (s.size() + 1)));
+        s.parallel_for(0, rows, grain, body);
+    }
+
+    template<typename F>
+    auto async(F&& fn) -> std::future<typename std::invoke_result<F>::type>
+    {
+        return scheduler::global().async(std::forward<F>(fn));
+    }
+}
+
+#endif // __TOOLS_TASK_H__
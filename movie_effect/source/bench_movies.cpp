@@ -0,0 +1,71 @@
+/*******************************************************************************************************************
+ * FILE NAME   :    bench_movies.cpp
+ *
+ * PROJECT NAME:    Cuda Learning
+ *
+ * DESCRIPTION :    microbenchmarks of the old movie CPU filters at 720p, 1080p and 4K
+ *
+ * VERSION HISTORY
+ * YYYY/MMM/DD      Author          Comments
+ * 2025 MAR 24      GlowEffect team Creation
+ *
+ ********************************************************************************************************************/
+#include "old_movies.hpp"
+#include "tools_bench.h"
+
+#include <memory>
+
+extern int      param_Mode;
+extern float    param_Cangle;
+extern float    param_Csat;
+extern float    param_Uofs;
+extern float    param_Vofs;
+extern float    param_Yslope;
+extern float    param_Yofs;
+
+// synthetic YUV frame: diagonal luma ramp with chroma bars, so every pixel takes the full filter path
+static cv::Mat bench_yuv(const bench::frame_size& size)
+{
+    cv::Mat yuv(size.height, size.width, CV_8UC3);
+    for (int iLoop = 0; iLoop < size.height; iLoop++) {
+        uchar* row = yuv.ptr<uchar>(iLoop);
+        for (int jLoop = 0, n = 0; jLoop < size.width; jLoop++, n += 3) {
+            row[n + 0] = (uchar)((iLoop + jLoop) & 255);
+            row[n + 1] = (uchar)(64 + (jLoop * 8 / size.width) * 16);
+            row[n + 2] = (uchar)(192 - (iLoop * 8 / size.height) * 16);
+        }
+    }
+    return yuv;
+}
+
+void bench_movies(void)
+{
+    // slider defaults of set_sliders, with a visible saturation change and defocus
+    param_Cangle = 0.f;
+    param_Csat = 0.5f;
+    param_Uofs = 0.f;
+    param_Vofs = 0.f;
+    param_Yslope = 1.f;
+    param_Yofs = 0.f;
+
+    bench::report_header("old movie filter microbenchmarks (synthetic YUV frames, shared task scheduler)");
+
+    for (int mode = 0; mode < 2; mode++) {
+        param_Mode = mode;
+        bench::run_sizes(mode ? "color_polarizer (mode 1)" : "color_polarizer (mode 0)",
+            [](const bench::frame_size& size) {
+                auto src = std::make_shared<cv::Mat>(bench_yuv(size));
+                auto dst = std::make_shared<cv::Mat>(src->clone());
+                return [src, dst]() { color_polarizer(*src, *dst); };
+            });
+    }
+
+    initial_defocus(.5f * 25.f);
+    bench::run_sizes("dynamic_defocus (fuzzy 0.5)", [](const bench::frame_size& size) {
+        auto img = std::make_shared<cv::Mat>(bench_yuv(size));
+        return [img]() { dynamic_defocus(*img); };
+    });
+    initial_defocus(0.f);
+
+    std::printf("---------------------------------------------------\n");
+}
@@ -33,41 +33,43 @@ void color_polarizer(cv::Mat& src_img, cv::Mat& dst_img)
     float V_scale = param_Csat * std::sin(param_Cangle + F_PI4);
     float U_scale = param_Csat * std::cos(param_Cangle + F_PI4);
 
-    for (int iLoop = 0, m = 0; iLoop < rows; iLoop++, m += stride) {
-        for (int jLoop = 0, n = m; jLoop < cols; jLoop++, n += chnl) {
-
-            float Y = src_data[n + 0] * 1.f;
-            float U = src_data[n + 1] / 128.f - 1.f;
-            float V = src_data[n + 2] / 128.f - 1.f;
-
-            Y *= param_Yslope;
-            Y += param_Yofs;
-
-            if (param_Mode==1) {
-                // c + c*(c-1)*K
-                U += U * (U - 1) * param_Uofs;
-                V += V * (V - 1) * param_Vofs;
-                U *= U_scale;
-                V *= V_scale;
-            }
-            else if (param_Mode==0) {
-                // c * scale + offset
-                U *= U_scale;
-                V *= V_scale;
-                U += param_Uofs;
-                V += param_Vofs;
-            }
+    // rows are independent, run them as bands on the shared scheduler
+    task::parallel_rows(rows, [&](const int row_bgn, const int row_end) {
+        for (int iLoop = row_bgn, m = row_bgn * stride; iLoop < row_end; iLoop++, m += stride) {
+            for (int jLoop = 0, n = m; jLoop < cols; jLoop++, n += chnl) {
 
-            int y = std::min<int>(255, std::max<int>(0, int(Y + .5f)));
-            int u = std::min<int>(127, std::max<int>(-128, int(U * 128)));
-            int v = std::min<int>(127, std::max<int>(-128, int(V * 128)));
+                float Y = src_data[n + 0] * 1.f;
+                float U = src_data[n + 1] / 128.f - 1.f;
+                float V = src_data[n + 2] / 128.f - 1.f;
 
-            dst_data[n + 0] = y;
-            dst_data[n + 1] = u + 128;
-            dst_data[n + 2] = v + 128;
-        }
-    }
+                Y *= param_Yslope;
+                Y += param_Yofs;
+
+                if (param_Mode==1) {
+                    // c + c*(c-1)*K
+                    U += U * (U - 1) * param_Uofs;
+                    V += V * (V - 1) * param_Vofs;
+                    U *= U_scale;
+                    V *= V_scale;
+                }
+                else if (param_Mode==0) {
+                    // c * scale + offset
+                    U *= U_scale;
+                    V *= V_scale;
+                    U += param_Uofs;
+                    V += param_Vofs;
+                }
 
+                int y = std::min<int>(255, std::max<int>(0, int(Y + .5f)));
+                int u = std::min<int>(127, std::max<int>(-128, int(U * 128)));
+                int v = std::min<int>(127, std::max<int>(-128, int(V * 128)));
+
+                dst_data[n + 0] = y;
+                dst_data[n + 1] = u + 128;
+                dst_data[n + 2] = v + 128;
+            }
+        }
+    });
 }
 
 void standalone(void)
@@ -62,40 +62,44 @@ void dynamic_defocus(cv::Mat& src_img)
     const int vstride = rows;
     uchar* buffer = new uchar[rows * cols];
 
-    // horizontal filter
-    for (int iLoop = 0, m = 0; iLoop < rows; iLoop++, m += hstride) {
-        for (int jLoop = 0, n = m; jLoop < cols; jLoop++, n += chnl)
-        {
-            // horizontal dynamic curve
-            int k = jLoop * N_KERNEL / cols;
-            // initial data
-            float sum = src_img.data[n] * knl_coeff[k][0];
-            // symetric data: left & right
-            for (int kLoop = 1, p = n - chnl, q = n + chnl; kLoop < KNL_SIZE; kLoop++, p -= chnl, q += chnl)
+    // horizontal filter, bands of rows (each row writes its own column of the transposed buffer)
+    task::parallel_rows(rows, [&](const int row_bgn, const int row_end) {
+        for (int iLoop = row_bgn, m = row_bgn * hstride; iLoop < row_end; iLoop++, m += hstride) {
+            for (int jLoop = 0, n = m; jLoop < cols; jLoop++, n += chnl)
             {
-                int data_left = jLoop < kLoop ? src_img.data[m] : src_img.data[p];
-                int data_rght = jLoop + kLoop >= cols ? src_img.data[m + hstride - chnl] : src_img.data[q];
-                sum += knl_coeff[k][kLoop] * (data_left + data_rght);
+                // horizontal dynamic curve
+                int k = jLoop * N_KERNEL / cols;
+                // initial data
+                float sum = src_img.data[n] * knl_coeff[k][0];
+                // symetric data: left & right
+                for (int kLoop = 1, p = n - chnl, q = n + chnl; kLoop < KNL_SIZE; kLoop++, p -= chnl, q += chnl)
+                {
+                    int data_left = jLoop < kLoop ? src_img.data[m] : src_img.data[p];
+                    int data_rght = jLoop + kLoop >= cols ? src_img.data[m + hstride - chnl] : src_img.data[q];
+                    sum += knl_coeff[k][kLoop] * (data_left + data_rght);
+                }
+                buffer[jLoop * rows + iLoop] = (uchar)std::max<float>(0, std::min<float>(255, sum));
             }
-            buffer[jLoop * rows + iLoop] = (uchar)std::max<float>(0, std::min<float>(255, sum));
         }
-    }
+    });
 
-    // vertical filter
-    for (int jLoop = 0, m = 0; jLoop < cols; jLoop++, m += vstride) {
-        for (int iLoop = 0, n= m; iLoop < rows; iLoop++, n++)
-        {
-            int k = iLoop * N_KERNEL / rows;
-            float sum = buffer[n] * knl_coeff[k][0];
-            for (int kLoop = 1, p = n-1, q = n+1; kLoop < KNL_SIZE; kLoop++, p--, q++)
+    // vertical filter, bands of columns (rows of the transposed buffer)
+    task::parallel_rows(cols, [&](const int col_bgn, const int col_end) {
+        for (int jLoop = col_bgn, m = col_bgn * vstride; jLoop < col_end; jLoop++, m += vstride) {
+            for (int iLoop = 0, n= m; iLoop < rows; iLoop++, n++)
             {
-                int data_left = iLoop < kLoop ? buffer[m] : buffer[p];
-                int data_rght = iLoop + kLoop >= rows ? buffer[m + vstride - 1] : buffer[q];
-                sum += knl_coeff[k][kLoop] * (data_left + data_rght);
+                int k = iLoop * N_KERNEL / rows;
+                float sum = buffer[n] * knl_coeff[k][0];
+                for (int kLoop = 1, p = n-1, q = n+1; kLoop < KNL_SIZE; kLoop++, p--, q++)
+                {
+                    int data_left = iLoop < kLoop ? buffer[m] : buffer[p];
+                    int data_rght = iLoop + kLoop >= rows ? buffer[m + vstride - 1] : buffer[q];
+                    sum += knl_coeff[k][kLoop] * (data_left + data_rght);
+                }
+                src_img.data[iLoop * hstride + jLoop * chnl] = (uchar)std::max<float>(0, std::min<float>(255, sum));
             }
-            src_img.data[iLoop * hstride + jLoop * chnl] = (uchar)std::max<float>(0, std::min<float>(255, sum));
         }
-    }
+    });
 
     delete[] buffer;
 }
\ No newline at end of file
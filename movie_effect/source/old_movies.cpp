@@ -14,8 +14,6 @@
 #include "old_movies.hpp"
 #include "old_movies.cuh"
 
-#include <omp.h>
-
 extern float    param_Fuzzy;
 extern bool     button_State[5];
 
@@ -42,18 +40,14 @@ void old_movies_image(const char* file_name, const bool is_cuda)
 
     cv::Mat dst_yuv = src_yuv.clone();
     cv::Mat dst_bgr = src_bgr.clone();
- 
-    int n_threads = omp_get_max_threads();
-    omp_set_num_threads(n_threads);
+
     int key = 0;
     do {
-#pragma omp parallel //num_threads(12)
-        {
-            color_polarizer(src_yuv, dst_yuv);
-            if (!is_cuda)
-                dynamic_defocus(dst_yuv);
-            cv::cvtColor(dst_yuv, dst_bgr, cv::COLOR_YUV2BGR);
-        }
+        // both filters split their rows over the shared task scheduler
+        color_polarizer(src_yuv, dst_yuv);
+        if (!is_cuda)
+            dynamic_defocus(dst_yuv);
+        cv::cvtColor(dst_yuv, dst_bgr, cv::COLOR_YUV2BGR);
 
         if (is_cuda)
         {